@@ -0,0 +1,51 @@
+#include "lib/alloc_count.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Global operator new is replaced in the benchmarks binary to count heap allocations
+
+namespace {
+
+std::atomic<size_t> allocations(0);
+
+} // namespace
+
+size_t bench_allocations() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(const size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+// std::pmr::new_delete_resource() allocates through the aligned overloads
+void* operator new(const size_t size, const std::align_val_t alignment) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  const auto align = static_cast<size_t>(alignment);
+  if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
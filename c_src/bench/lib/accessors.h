@@ -0,0 +1,75 @@
+#pragma once
+
+#include "alloc_count.h"
+#include "bench.h"
+#include "fixtures.h"
+
+#include "wm_job.h"
+
+#include <cstdio>
+#include <vector>
+
+// Sums what the scheduler reads from every job: node ids, environment and
+// the requested resource tree.
+template <typename Jobs>
+static size_t sum_job_requests(const Jobs &jobs) {
+  size_t sum = 0;
+  for (const auto &job : jobs) {
+    for (const auto &node_id : job.get_nodes()) {
+      sum += node_id.size();
+    }
+    for (const auto &[name, value] : job.get_env()) {
+      sum += name.size() + value.size();
+    }
+    for (const auto &resource : job.get_request()) {
+      sum += resource.get_count() + resource.get_name().size();
+      for (const auto &child : resource.get_resources()) {
+        sum += child.get_count();
+      }
+    }
+  }
+  return sum;
+}
+
+// The same loop with getters that return copies, as before they returned references
+template <typename Jobs>
+static size_t sum_job_requests_by_value(const Jobs &jobs) {
+  size_t sum = 0;
+  for (const auto &job : jobs) {
+    const std::pmr::vector<std::pmr::string> nodes = job.get_nodes();
+    for (const auto &node_id : nodes) {
+      sum += node_id.size();
+    }
+    const std::pmr::vector<swm::SwmTupleStrStr> env = job.get_env();
+    for (const auto &[name, value] : env) {
+      sum += name.size() + value.size();
+    }
+    const std::pmr::vector<swm::SwmResource> request = job.get_request();
+    for (const auto &resource : request) {
+      sum += resource.get_count() + resource.get_name().size();
+      const std::pmr::vector<swm::SwmResource> children = resource.get_resources();
+      for (const auto &child : children) {
+        sum += child.get_count();
+      }
+    }
+  }
+  return sum;
+}
+
+inline void bench_accessors() {
+  const size_t count = 10000;
+  ei_x_buff x;
+  ei_x_new(&x);
+  encode_jobs(x, count);
+  int index = 0;
+  std::vector<swm::SwmJob> jobs;
+  swm::ei_buffer_to_job(x.buff, index, jobs);
+  ei_x_free(&x);
+
+  const auto by_reference = [&jobs] { bench_keep(sum_job_requests(jobs)); };
+  const auto by_value = [&jobs] { bench_keep(sum_job_requests_by_value(jobs)); };
+  run_benchmark("jobs: read requests by reference", count, by_reference);
+  run_benchmark("jobs: read requests by value", count, by_value);
+  count_allocations("jobs: read requests by reference", count, by_reference);
+  count_allocations("jobs: read requests by value", count, by_value);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+
+// Number of heap allocations made by operator new so far
+size_t bench_allocations();
+
+// Runs fun once and prints the number of allocations it made
+template <typename F>
+inline void count_allocations(const char* name, const size_t items, F &&fun) {
+  const size_t before = bench_allocations();
+  fun();
+  const size_t count = bench_allocations() - before;
+  std::printf("%-48s %10zu allocs %7.1f allocs/item\n", name, count, static_cast<double>(count) / static_cast<double>(items));
+}
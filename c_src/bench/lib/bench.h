@@ -0,0 +1,27 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Prevents the compiler from optimizing away a computed value
+template <typename T>
+inline void bench_keep(const T &value) {
+  __asm__ __volatile__("" : : "g"(&value) : "memory");
+}
+
+// Runs a benchmark several times and prints the best time per processed item
+template <typename F>
+void run_benchmark(const std::string &name, const size_t items, F &&fun, const int repeats = 5) {
+  fun();  // warm up caches and allocator
+  double best_ms = -1.0;
+  for (int i = 0; i < repeats; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    fun();
+    const auto stop = std::chrono::steady_clock::now();
+    const double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+    best_ms = best_ms < 0 ? ms : std::min(best_ms, ms);
+  }
+  std::printf("%-48s %10.3f ms %10.1f ns/item\n", name.c_str(), best_ms, best_ms * 1e6 / static_cast<double>(items));
+}
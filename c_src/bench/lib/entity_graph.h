@@ -0,0 +1,60 @@
+#pragma once
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "wm_entity_graph.h"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Walks the nodes of every job as a placement loop does: by id lookups in
+// a hash map or by the resolved node indexes.
+inline void bench_entity_graph() {
+  const size_t count = 100000;
+  ei_x_buff x;
+  ei_x_new(&x);
+  encode_jobs(x, count);
+  int index = 0;
+  std::vector<swm::SwmJob> jobs;
+  swm::ei_buffer_to_job(x.buff, index, jobs);
+  ei_x_free(&x);
+
+  std::vector<swm::SwmNode> nodes(1000);
+  std::vector<uint64_t> node_ports(nodes.size());
+  std::vector<std::string> node_ids(nodes.size());
+  std::unordered_map<std::string_view, size_t> node_positions;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    node_ids[i] = bench_uuid("n", i);
+    nodes[i].set_id(swm::SwmId(node_ids[i]));
+    node_ports[i] = i;
+  }
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    node_positions.emplace(node_ids[i], i);
+  }
+
+  swm::SwmEntityGraph graph;
+  run_benchmark("graph: resolve references of jobs", count, [&graph, &nodes, &jobs] {
+    graph.resolve(swm::SwmGrid(), {}, {}, nodes, jobs);
+  }, 1);
+  run_benchmark("graph: job nodes by id lookups", count, [&jobs, &node_positions, &node_ports] {
+    uint64_t sum = 0;
+    for (const auto &job : jobs) {
+      for (const auto &node_id : job.get_nodes()) {
+        sum += node_ports[node_positions.find(node_id)->second];
+      }
+    }
+    bench_keep(sum);
+  });
+  run_benchmark("graph: job nodes by indexes", count, [&graph, &node_ports] {
+    uint64_t sum = 0;
+    for (uint32_t job = 0; job < graph.get_job_ids().size(); ++job) {
+      for (const uint32_t node : graph.get_job_nodes(job)) {
+        sum += node_ports[node];
+      }
+    }
+    bench_keep(sum);
+  });
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "wm_decode_cache.h"
+#include "wm_entity_table.h"
+#include "wm_entity_utils.h"
+#include "wm_etf_reader.h"
+#include "wm_job.h"
+#include "wm_node.h"
+#include "wm_thread_pool.h"
+
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+// Previous implementation of swm::ei_buffer_to_str(): the term header is
+// parsed by ei_get_type() and then again by ei_decode_string(), and the
+// string goes through a temporary heap buffer.
+static int libei_buffer_to_str(const char* buf, int &index, std::string &s) {
+  int term_size = 0;
+  int term_type = 0;
+  if (ei_get_type(buf, &index, &term_type, &term_size)) {
+    return -1;
+  }
+  char *tmp = new(std::nothrow) char[term_size + 1];
+  if (term_type == ERL_BINARY_EXT) {
+    int iodata_size = 0;
+    if (ei_decode_iodata(buf, &index, &iodata_size, tmp)) {
+      delete[] tmp;
+      return -1;
+    }
+    tmp[iodata_size] = '\0';
+  } else if (term_type == ERL_STRING_EXT) {
+    if (ei_decode_string(buf, &index, tmp)) {
+      delete[] tmp;
+      return -1;
+    }
+  } else {
+    ei_skip_term(buf, &index);
+    tmp[0] = '\0';
+  }
+  s = std::string(tmp);
+  delete[] tmp;
+  return 0;
+}
+
+static int libei_buffer_to_uint64_t(const char* buf, int &index, uint64_t &n) {
+  int term_size = 0;
+  int term_type = 0;
+  if (ei_get_type(buf, &index, &term_type, &term_size)) {
+    return -1;
+  }
+  return ei_decode_ulong(buf, &index, &n);
+}
+
+inline void bench_etf_decode() {
+  static const size_t strings_count = 1000000;
+  static const size_t jobs_count = 100000;
+  static const size_t nodes_count = 10000;
+
+  std::printf("== ETF decoding ==\n");
+
+  ei_x_buff strings;
+  ei_x_new(&strings);
+  ei_x_encode_list_header(&strings, static_cast<long>(strings_count));
+  for (size_t i = 0; i < strings_count; ++i) {
+    ei_x_encode_string(&strings, bench_uuid("", i).c_str());
+  }
+  ei_x_encode_empty_list(&strings);
+
+  ei_x_buff numbers;
+  ei_x_new(&numbers);
+  ei_x_encode_list_header(&numbers, static_cast<long>(strings_count));
+  for (size_t i = 0; i < strings_count; ++i) {
+    ei_x_encode_ulonglong(&numbers, i * 977);
+  }
+  ei_x_encode_empty_list(&numbers);
+
+  run_benchmark("strings: libei get_type + decode_string", strings_count, [&]() {
+    int index = 5;  // list header
+    std::string s;
+    for (size_t i = 0; i < strings_count; ++i) {
+      libei_buffer_to_str(strings.buff, index, s);
+      bench_keep(s);
+    }
+  });
+  run_benchmark("strings: ei_buffer_to_str (etf reader)", strings_count, [&]() {
+    int index = 5;
+    std::string s;
+    for (size_t i = 0; i < strings_count; ++i) {
+      swm::ei_buffer_to_str(strings.buff, index, s);
+      bench_keep(s);
+    }
+  });
+  run_benchmark("integers: libei get_type + decode_ulong", strings_count, [&]() {
+    int index = 5;
+    uint64_t n = 0;
+    for (size_t i = 0; i < strings_count; ++i) {
+      libei_buffer_to_uint64_t(numbers.buff, index, n);
+      bench_keep(n);
+    }
+  });
+  run_benchmark("integers: ei_buffer_to_uint64_t (etf reader)", strings_count, [&]() {
+    int index = 5;
+    uint64_t n = 0;
+    for (size_t i = 0; i < strings_count; ++i) {
+      swm::ei_buffer_to_uint64_t(numbers.buff, index, n);
+      bench_keep(n);
+    }
+  });
+
+  ei_x_buff jobs;
+  ei_x_new(&jobs);
+  encode_jobs(jobs, jobs_count);
+  std::printf("job list: %zu jobs, %d bytes\n", jobs_count, jobs.index);
+
+  run_benchmark("jobs: ei_skip_term (libei)", jobs_count, [&]() {
+    int index = 0;
+    ei_skip_term(jobs.buff, &index);
+    bench_keep(index);
+  });
+  run_benchmark("jobs: etf_skip_term", jobs_count, [&]() {
+    int index = 0;
+    swm::etf_skip_term(jobs.buff, index);
+    bench_keep(index);
+  });
+  run_benchmark("jobs: ei_buffer_to_job -> std::vector<SwmJob>", jobs_count, [&]() {
+    int index = 0;
+    std::vector<swm::SwmJob> decoded;
+    swm::ei_buffer_to_job(jobs.buff, index, decoded);
+    bench_keep(decoded);
+  });
+  run_benchmark("jobs: entity_list_validate", jobs_count, [&]() {
+    int index = 0;
+    bench_keep(swm::entity_list_validate<swm::SwmJob>(jobs.buff, index));
+  });
+  run_benchmark("jobs: entity_list_decode_unchecked -> std::vector", jobs_count, [&]() {
+    int index = 0;
+    std::vector<swm::SwmJob> decoded;
+    swm::entity_list_decode_unchecked(jobs.buff, index, decoded);
+    bench_keep(decoded);
+  });
+  swm::SwmThreadPool pool;
+  run_benchmark("jobs: ei_buffer_to_job -> std::vector, " + std::to_string(pool.size()) + " threads", jobs_count, [&]() {
+    int index = 0;
+    std::vector<swm::SwmJob> decoded;
+    swm::ei_buffer_to_job(jobs.buff, index, decoded, pool);
+    bench_keep(decoded);
+  });
+  run_benchmark("jobs: SwmJob with porter field mask", jobs_count, [&]() {
+    static const uint64_t fields = swm::SwmJob::FIELD_ID | swm::SwmJob::FIELD_JOB_STDOUT |
+                                   swm::SwmJob::FIELD_JOB_STDERR | swm::SwmJob::FIELD_WORKDIR |
+                                   swm::SwmJob::FIELD_ENV | swm::SwmJob::FIELD_SCRIPT_CONTENT;
+    int index = 0;
+    int list_size = 0;
+    swm::etf_decode_list_header(jobs.buff, index, list_size);
+    std::vector<swm::SwmJob> decoded;
+    decoded.reserve(static_cast<size_t>(list_size));
+    for (int i = 0; i < list_size; ++i) {
+      decoded.emplace_back(jobs.buff, index, fields);
+    }
+    bench_keep(decoded);
+  });
+  run_benchmark("jobs: ei_buffer_to_job -> arena pmr::vector", jobs_count, [&]() {
+    int index = 0;
+    std::pmr::monotonic_buffer_resource arena(static_cast<size_t>(jobs.index) * 2);
+    std::pmr::vector<swm::SwmJob> decoded(&arena);
+    swm::ei_buffer_to_job(jobs.buff, index, decoded);
+    bench_keep(decoded);
+  });
+  run_benchmark("jobs: ei_buffer_to_job -> std::vector<SwmJobView>", jobs_count, [&]() {
+    int index = 0;
+    std::vector<swm::SwmJobView> decoded;
+    swm::ei_buffer_to_job(jobs.buff, index, decoded);
+    bench_keep(decoded);
+  });
+
+  run_benchmark("jobs: ei_buffer_to_job -> SwmJobTable", jobs_count, [&]() {
+    int index = 0;
+    swm::SwmJobTable table;
+    swm::ei_buffer_to_job(jobs.buff, index, table);
+    bench_keep(table);
+  });
+
+  // Scoring pass of a scheduler: pending jobs requesting a node
+  const swm::SwmAtom pending("Q");
+  const swm::SwmAtom node("node");
+  std::vector<swm::SwmJob> job_objects;
+  int objects_index = 0;
+  swm::ei_buffer_to_job(jobs.buff, objects_index, job_objects);
+  run_benchmark("jobs: score std::vector<SwmJob>", jobs_count, [&]() {
+    uint64_t score = 0;
+    for (const auto &job : job_objects) {
+      if (job.get_state() == pending.str()) {
+        for (const auto &resource : job.get_request()) {
+          if (resource.get_name() == node.str()) {
+            score += job.get_priority() * resource.get_count();
+          }
+        }
+      }
+    }
+    bench_keep(score);
+  });
+  swm::SwmJobTable job_table;
+  int table_index = 0;
+  swm::ei_buffer_to_job(jobs.buff, table_index, job_table);
+  run_benchmark("jobs: score SwmJobTable", jobs_count, [&]() {
+    const auto &states = job_table.get_states();
+    const auto &priorities = job_table.get_priorities();
+    const uint64_t* counts = job_table.get_request_counts(node);
+    uint64_t score = 0;
+    for (size_t i = 0; i < job_table.size(); ++i) {
+      score += states[i] == pending ? priorities[i] * counts[i] : 0;
+    }
+    bench_keep(score);
+  });
+
+  std::vector<swm::SwmJob> decoded_jobs;
+  int jobs_index = 0;
+  swm::ei_buffer_to_job(jobs.buff, jobs_index, decoded_jobs);
+  run_benchmark("jobs: ei_x_encode_* (libei)", jobs_count, [&]() {
+    ei_x_buff x;
+    ei_x_new(&x);
+    encode_jobs(x, jobs_count);
+    bench_keep(x.index);
+    ei_x_free(&x);
+  });
+  run_benchmark("jobs: encode_job, exactly sized buffer", jobs_count, [&]() {
+    ei_x_buff x;
+    ei_x_new(&x);
+    swm::encode_job(x, decoded_jobs);
+    bench_keep(x.index);
+    ei_x_free(&x);
+  });
+
+  // Nodes are sent in every cycle, but change rarely
+  ei_x_buff nodes;
+  ei_x_new(&nodes);
+  encode_nodes(nodes, nodes_count);
+  std::printf("node list: %zu nodes, %d bytes\n", nodes_count, nodes.index);
+
+  run_benchmark("nodes: ei_buffer_to_node -> std::vector<SwmNode>", nodes_count, [&]() {
+    int index = 0;
+    std::vector<swm::SwmNode> decoded;
+    swm::ei_buffer_to_node(nodes.buff, index, decoded);
+    bench_keep(decoded);
+  });
+  swm::SwmDecodeCache<swm::SwmNode> cache;
+  run_benchmark("nodes: SwmDecodeCache, unchanged revisions", nodes_count, [&]() {
+    int index = 0;
+    std::vector<swm::SwmDecodeCache<swm::SwmNode>::EntityPtr> decoded;
+    cache.decode(nodes.buff, index, decoded);
+    cache.evict_unused();
+    bench_keep(decoded);
+  });
+
+  ei_x_free(&nodes);
+  ei_x_free(&jobs);
+  ei_x_free(&numbers);
+  ei_x_free(&strings);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "bench.h"
+
+#include "wm_etf_reader.h"
+#include "wm_etf_scan.h"
+
+#include <string>
+#include <vector>
+
+// Previous byte by byte decoding of a string that is encoded as a list
+static int scalar_list_to_str(const char* buf, int &index, std::string &s) {
+  const auto list_size = swm::etf_get_uint32(buf, index + 1);
+  int i = index + 5;
+  s.clear();
+  s.reserve(list_size);
+  for (uint32_t n = 0; n < list_size; ++n, i += 2) {
+    if (swm::etf_term_tag(buf, i) != ERL_SMALL_INTEGER_EXT) {
+      return -1;
+    }
+    s.push_back(buf[i + 1]);
+  }
+  index = i + 1;
+  return 0;
+}
+
+inline void bench_etf_scan() {
+  static const size_t string_size = 1000000;
+  static const size_t strings_count = 20;
+
+#if defined(__AVX2__)
+  std::printf("== ETF scanning (AVX2) ==\n");
+#elif defined(__SSE2__)
+  std::printf("== ETF scanning (SSE2) ==\n");
+#else
+  std::printf("== ETF scanning (scalar) ==\n");
+#endif
+
+  // Strings longer than 65535 characters are encoded as lists of small integers
+  const std::string long_str(string_size, 'x');
+  ei_x_buff strings;
+  ei_x_new(&strings);
+  ei_x_encode_list_header(&strings, static_cast<long>(strings_count));
+  for (size_t i = 0; i < strings_count; ++i) {
+    ei_x_encode_string(&strings, long_str.c_str());
+  }
+  ei_x_encode_empty_list(&strings);
+  const size_t chars = string_size * strings_count;
+
+  run_benchmark("long strings: ei_skip_term (libei)", chars, [&]() {
+    int index = 0;
+    ei_skip_term(strings.buff, &index);
+    bench_keep(index);
+  });
+  run_benchmark("long strings: etf_skip_term", chars, [&]() {
+    int index = 0;
+    swm::etf_skip_term(strings.buff, index);
+    bench_keep(index);
+  });
+  run_benchmark("long strings: etf_list_offsets", chars, [&]() {
+    int index = 0;
+    std::vector<int> offsets;
+    swm::etf_list_offsets(strings.buff, index, offsets);
+    bench_keep(offsets);
+  });
+
+  std::vector<char> tmp(string_size + 1);
+  run_benchmark("long strings: ei_decode_string (libei)", chars, [&]() {
+    int index = 5;
+    for (size_t i = 0; i < strings_count; ++i) {
+      ei_decode_string(strings.buff, &index, tmp.data());
+      bench_keep(tmp);
+    }
+  });
+  run_benchmark("long strings: byte by byte decoding", chars, [&]() {
+    int index = 5;
+    std::string s;
+    for (size_t i = 0; i < strings_count; ++i) {
+      scalar_list_to_str(strings.buff, index, s);
+      bench_keep(s);
+    }
+  });
+  run_benchmark("long strings: etf_decode_str", chars, [&]() {
+    int index = 5;
+    std::string s;
+    for (size_t i = 0; i < strings_count; ++i) {
+      swm::etf_decode_str(strings.buff, index, s);
+      bench_keep(s);
+    }
+  });
+
+  ei_x_free(&strings);
+}
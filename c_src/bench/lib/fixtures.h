@@ -0,0 +1,125 @@
+#pragma once
+
+#include <ei.h>
+
+#include <cstdio>
+#include <string>
+
+// Synthetic scheduler input: erlang terms encoded the same way as wm_scheduler.erl does
+
+inline void encode_resource(ei_x_buff &x, const char* name, const uint64_t count, const int children) {
+  ei_x_encode_tuple_header(&x, 8);
+  ei_x_encode_atom(&x, "resource");
+  ei_x_encode_string(&x, name);
+  ei_x_encode_ulonglong(&x, count);
+  ei_x_encode_empty_list(&x);  // hooks
+  ei_x_encode_empty_list(&x);  // properties
+  ei_x_encode_map_header(&x, 0);  // prices
+  ei_x_encode_ulonglong(&x, 0);  // usage_time
+  if (children) {
+    ei_x_encode_list_header(&x, children);
+    for (int i = 0; i < children; ++i) {
+      encode_resource(x, i % 2 ? "cpus" : "mem", 1024ul * static_cast<uint64_t>(i + 1), 0);
+    }
+  }
+  ei_x_encode_empty_list(&x);
+}
+
+inline std::string bench_uuid(const char* prefix, const size_t n) {
+  char buf[64];
+  std::snprintf(buf, sizeof(buf), "%s%08zx-d85d-11ec-8529-6fdf37248ceb", prefix, n);
+  return buf;
+}
+
+inline void encode_job(ei_x_buff &x, const size_t n) {
+  ei_x_encode_tuple_header(&x, 34);
+  ei_x_encode_atom(&x, "job");
+  ei_x_encode_string(&x, bench_uuid("", n).c_str());  // id
+  ei_x_encode_string(&x, "benchmark job");  // name
+  ei_x_encode_string(&x, "cluster-1");  // cluster_id
+  ei_x_encode_list_header(&x, 2);  // nodes
+  ei_x_encode_string(&x, bench_uuid("n", n % 1000).c_str());
+  ei_x_encode_string(&x, bench_uuid("n", (n + 1) % 1000).c_str());
+  ei_x_encode_empty_list(&x);
+  ei_x_encode_string(&x, n % 3 ? "Q" : "R");  // state
+  ei_x_encode_string(&x, "");  // state_details
+  ei_x_encode_string(&x, "2022-05-22T20:01:48");  // start_time
+  ei_x_encode_string(&x, "2022-05-22T20:00:34");  // submit_time
+  ei_x_encode_string(&x, "");  // end_time
+  ei_x_encode_ulonglong(&x, 3600);  // duration
+  ei_x_encode_string(&x, "");  // job_stdin
+  ei_x_encode_string(&x, "job.out");  // job_stdout
+  ei_x_encode_string(&x, "job.err");  // job_stderr
+  ei_x_encode_empty_list(&x);  // input_files
+  ei_x_encode_empty_list(&x);  // output_files
+  ei_x_encode_string(&x, "/home/user/work");  // workdir
+  ei_x_encode_string(&x, bench_uuid("u", n % 50).c_str());  // user_id
+  ei_x_encode_empty_list(&x);  // hooks
+  ei_x_encode_list_header(&x, 2);  // env
+  ei_x_encode_tuple_header(&x, 2);
+  ei_x_encode_string(&x, "HOME");
+  ei_x_encode_string(&x, "/home/user");
+  ei_x_encode_tuple_header(&x, 2);
+  ei_x_encode_string(&x, "PATH");
+  ei_x_encode_string(&x, "/usr/local/bin:/usr/bin:/bin");
+  ei_x_encode_empty_list(&x);
+  ei_x_encode_empty_list(&x);  // deps
+  ei_x_encode_string(&x, bench_uuid("a", n % 10).c_str());  // account_id
+  ei_x_encode_string(&x, "");  // gang_id
+  ei_x_encode_string(&x, "/home/user/work/run.sh");  // execution_path
+  ei_x_encode_string(&x, "#!/bin/sh\n#SWM relocatable\n#SWM flavor m1.small\nsleep 120\nhostname\n");
+  ei_x_encode_list_header(&x, 1);  // request
+  encode_resource(x, "node", 2, 2);
+  ei_x_encode_empty_list(&x);
+  ei_x_encode_empty_list(&x);  // resources
+  ei_x_encode_string(&x, "");  // container
+  ei_x_encode_atom(&x, "true");  // relocatable
+  ei_x_encode_ulonglong(&x, 0);  // exitcode
+  ei_x_encode_ulonglong(&x, 0);  // signal
+  ei_x_encode_ulonglong(&x, n % 100);  // priority
+  ei_x_encode_string(&x, "");  // comment
+  ei_x_encode_ulonglong(&x, n);  // revision
+}
+
+inline void encode_jobs(ei_x_buff &x, const size_t count) {
+  ei_x_encode_list_header(&x, static_cast<long>(count));
+  for (size_t i = 0; i < count; ++i) {
+    encode_job(x, i);
+  }
+  ei_x_encode_empty_list(&x);
+}
+
+inline void encode_node(ei_x_buff &x, const size_t n) {
+  ei_x_encode_tuple_header(&x, 20);
+  ei_x_encode_atom(&x, "node");
+  ei_x_encode_string(&x, bench_uuid("n", n).c_str());  // id
+  ei_x_encode_string(&x, ("node" + std::to_string(n)).c_str());  // name
+  ei_x_encode_string(&x, ("node" + std::to_string(n) + ".cluster").c_str());  // host
+  ei_x_encode_ulonglong(&x, 10001);  // api_port
+  ei_x_encode_string(&x, "cluster-1");  // parent
+  ei_x_encode_atom(&x, "up");  // state_power
+  ei_x_encode_atom(&x, "idle");  // state_alloc
+  ei_x_encode_empty_list(&x);  // roles
+  ei_x_encode_list_header(&x, 2);  // resources
+  encode_resource(x, "cpus", 32, 0);
+  encode_resource(x, "mem", 262144, 0);
+  ei_x_encode_empty_list(&x);
+  ei_x_encode_empty_list(&x);  // properties
+  ei_x_encode_atom(&x, "partition");  // subdivision
+  ei_x_encode_string(&x, bench_uuid("p", n % 10).c_str());  // subdivision_id
+  ei_x_encode_empty_list(&x);  // malfunctions
+  ei_x_encode_string(&x, "");  // comment
+  ei_x_encode_string(&x, "");  // remote_id
+  ei_x_encode_atom(&x, "false");  // is_template
+  ei_x_encode_string(&x, "");  // gateway
+  ei_x_encode_map_header(&x, 0);  // prices
+  ei_x_encode_ulonglong(&x, 1);  // revision
+}
+
+inline void encode_nodes(ei_x_buff &x, const size_t count) {
+  ei_x_encode_list_header(&x, static_cast<long>(count));
+  for (size_t i = 0; i < count; ++i) {
+    encode_node(x, i);
+  }
+  ei_x_encode_empty_list(&x);
+}
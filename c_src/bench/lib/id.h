@@ -0,0 +1,49 @@
+#pragma once
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "wm_id.h"
+
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+inline void bench_id() {
+  const size_t count = 100000;
+  std::vector<std::string> texts(count);
+  std::vector<swm::SwmId> ids(count);
+  std::unordered_map<std::string, size_t> by_text;
+  std::unordered_map<swm::SwmId, size_t> by_id;
+  for (size_t i = 0; i < count; ++i) {
+    texts[i] = bench_uuid("", i);
+    ids[i] = swm::SwmId(texts[i]);
+    by_text.emplace(texts[i], i);
+    by_id.emplace(ids[i], i);
+  }
+  std::printf("ids: sizeof std::pmr::string %zu, sizeof SwmId %zu bytes\n", sizeof(std::pmr::string), sizeof(swm::SwmId));
+
+  run_benchmark("ids: parse UUIDs", count, [&texts] {
+    size_t sum = 0;
+    for (const auto &text : texts) {
+      sum += swm::SwmId(text).hash();
+    }
+    bench_keep(sum);
+  });
+  run_benchmark("ids: find by string keys", count, [&texts, &by_text] {
+    size_t sum = 0;
+    for (const auto &text : texts) {
+      sum += by_text.find(text)->second;
+    }
+    bench_keep(sum);
+  });
+  run_benchmark("ids: find by SwmId keys", count, [&ids, &by_id] {
+    size_t sum = 0;
+    for (const auto &id : ids) {
+      sum += by_id.find(id)->second;
+    }
+    bench_keep(sum);
+  });
+}
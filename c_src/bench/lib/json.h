@@ -0,0 +1,59 @@
+#pragma once
+
+#include "alloc_count.h"
+#include "bench.h"
+#include "fixtures.h"
+
+#include "wm_etf_stream.h"
+#include "wm_job.h"
+#include "wm_json_writer.h"
+
+#include <algorithm>
+#include <vector>
+
+inline void bench_json() {
+  const size_t count = 100000;
+  ei_x_buff x;
+  ei_x_new_with_version(&x);
+  encode_jobs(x, count);
+  int index = 1;
+  std::vector<swm::SwmJob> jobs;
+  swm::ei_buffer_to_job(x.buff, index, jobs);
+
+  // Preallocated for the whole listing, so the output is not reallocated
+  swm::SwmJsonWriter writer(count * 2048);
+  const auto transcode = [&x, &writer] {
+    writer.clear();
+    int i = 1;
+    swm::entity_list_etf_to_json<swm::SwmJob>(x.buff, i, writer);
+    bench_keep(writer.size());
+  };
+  const auto stream = [&x, &writer] {
+    writer.clear();
+    swm::SwmEtfStream decoder;
+    writer.begin_array();
+    const size_t chunk = 65536;
+    for (size_t pos = 0; pos < static_cast<size_t>(x.index); pos += chunk) {
+      const size_t size = std::min(chunk, static_cast<size_t>(x.index) - pos);
+      decoder.feed(x.buff + pos, size, [&writer](const char* buf, int i) { return swm::SwmJob::to_json(buf, i, writer); });
+    }
+    writer.end_array();
+    bench_keep(writer.size());
+  };
+  const auto from_entities = [&jobs, &writer] {
+    writer.clear();
+    writer.begin_array();
+    for (const auto &job : jobs) {
+      job.to_json(writer);
+    }
+    writer.end_array();
+    bench_keep(writer.size());
+  };
+  run_benchmark("jobs: ETF to JSON", count, transcode);
+  run_benchmark("jobs: ETF stream to JSON by 64KiB chunks", count, stream);
+  run_benchmark("jobs: decoded jobs to JSON", count, from_entities);
+  count_allocations("jobs: ETF to JSON", count, transcode);
+  count_allocations("jobs: decoded jobs to JSON", count, from_entities);
+  std::printf("%-48s %10zu bytes\n", "jobs: JSON size", writer.size());
+  ei_x_free(&x);
+}
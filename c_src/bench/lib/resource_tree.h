@@ -0,0 +1,78 @@
+#pragma once
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "wm_entity_table.h"
+#include "wm_resource.h"
+
+#include <string_view>
+#include <vector>
+
+// Sum of the resource counts with the name in nested resource lists
+template <typename Resources>
+uint64_t bench_nested_sum(const Resources &resources, const std::string_view name) {
+  uint64_t sum = 0;
+  for (const auto &resource : resources) {
+    sum += resource.get_name() == name ? resource.get_count() : 0;
+    sum += bench_nested_sum(resource.get_resources(), name);
+  }
+  return sum;
+}
+
+inline void bench_resource_tree() {
+  // Resources of nodes: two sockets with cores and memory banks, memory
+  const size_t count = 10000;
+  ei_x_buff x;
+  ei_x_new(&x);
+  for (size_t i = 0; i < count; ++i) {
+    ei_x_encode_list_header(&x, 3);
+    encode_resource(x, "socket", 1, 8);
+    encode_resource(x, "socket", 1, 8);
+    encode_resource(x, "mem", 64000, 0);
+    ei_x_encode_empty_list(&x);
+  }
+
+  run_benchmark("resources: decode nested SwmResource", count, [&x] {
+    int index = 0;
+    std::vector<std::vector<swm::SwmResource>> lists(count);
+    for (auto &list : lists) {
+      swm::ei_buffer_to_resource(x.buff, index, list);
+    }
+    bench_keep(lists);
+  }, 1);
+  run_benchmark("resources: decode SwmResourceTree", count, [&x] {
+    int index = 0;
+    swm::SwmResourceTree tree;
+    for (size_t i = 0; i < count; ++i) {
+      swm::ei_buffer_to_resource(x.buff, index, tree);
+    }
+    bench_keep(tree);
+  }, 1);
+
+  std::vector<std::vector<swm::SwmResource>> lists(count);
+  swm::SwmResourceTree tree;
+  int index = 0;
+  int tree_index = 0;
+  for (size_t i = 0; i < count; ++i) {
+    swm::ei_buffer_to_resource(x.buff, index, lists[i]);
+    swm::ei_buffer_to_resource(x.buff, tree_index, tree);
+  }
+  ei_x_free(&x);
+
+  run_benchmark("resources: nested cpus of SwmResource", count, [&lists] {
+    uint64_t sum = 0;
+    for (const auto &list : lists) {
+      sum += bench_nested_sum(list, "cpus");
+    }
+    bench_keep(sum);
+  });
+  const swm::SwmAtom cpus("cpus");
+  run_benchmark("resources: nested cpus of SwmResourceTree", count, [&tree, &cpus] {
+    uint64_t sum = 0;
+    for (size_t row = 0; row < tree.rows(); ++row) {
+      sum += tree.get_row_sum(row, cpus);
+    }
+    bench_keep(sum);
+  });
+}
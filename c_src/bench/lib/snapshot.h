@@ -0,0 +1,56 @@
+#pragma once
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "wm_job.h"
+#include "wm_snapshot_file.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Opening of a mapped snapshot does not depend on its size, the jobs are
+// then read in place instead of being decoded from ETF.
+inline void bench_snapshot() {
+  const size_t count = 100000;
+  ei_x_buff x;
+  ei_x_new(&x);
+  encode_jobs(x, count);
+
+  const std::string path = "/tmp/swm_bench_snapshot.bin";
+  swm::SwmSnapshotWriter writer(path);
+  int index = 0;
+  int arity = 0;
+  swm::etf_decode_list_header(x.buff, index, arity);
+  for (int i = 0; i < arity; ++i) {
+    writer.add(swm::SWM_SNAPSHOT_JOBS, x.buff, index);
+    swm::etf_skip_term(x.buff, index);
+  }
+  writer.finish();
+
+  run_benchmark("jobs: decode ETF", count, [&x] {
+    int i = 0;
+    std::vector<swm::SwmJob> jobs;
+    swm::ei_buffer_to_job(x.buff, i, jobs);
+    bench_keep(jobs.size());
+  });
+  run_benchmark("snapshot: open mapped file", 1, [&path] {
+    swm::SwmSnapshotFile file;
+    file.open(path);
+    bench_keep(file.count(swm::SWM_SNAPSHOT_JOBS));
+  });
+  swm::SwmSnapshotFile file;
+  file.open(path);
+  run_benchmark("snapshot: read job priorities by views", count, [&file] {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < file.count(swm::SWM_SNAPSHOT_JOBS); ++i) {
+      sum += file.view<swm::SwmJobView>(swm::SWM_SNAPSHOT_JOBS, i).get_priority();
+    }
+    bench_keep(sum);
+  });
+  std::printf("%-48s %10zu bytes\n", "snapshot: file size", file.size());
+  file.close();
+  std::remove(path.c_str());
+  ei_x_free(&x);
+}
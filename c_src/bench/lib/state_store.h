@@ -0,0 +1,53 @@
+#pragma once
+
+#include "bench.h"
+#include "fixtures.h"
+
+#include "wm_state_store.h"
+
+#include <vector>
+
+inline void bench_state_store() {
+  const size_t count = 100000;
+  ei_x_buff x;
+  ei_x_new(&x);
+  encode_jobs(x, count);
+  int index = 0;
+  std::vector<swm::SwmJob> jobs;
+  swm::ei_buffer_to_job(x.buff, index, jobs);
+  ei_x_free(&x);
+
+  swm::SwmStateStore store;
+  run_benchmark("store: index jobs", count, [&store, &jobs] {
+    store.jobs().clear();
+    for (const auto &job : jobs) {
+      store.jobs().update(job);
+    }
+  }, 1);
+
+  // One user has 2% of the jobs
+  const auto user_id = jobs[7].get_user_id();
+  run_benchmark("store: jobs of a user by index", count, [&store, &user_id] {
+    size_t sum = 0;
+    store.jobs().for_each(swm::SwmStateStore::JOB_USER_ID, user_id, [&sum](const swm::SwmJob &job) {
+      sum += job.get_priority();
+    });
+    bench_keep(sum);
+  });
+  run_benchmark("store: jobs of a user by scan", count, [&jobs, &user_id] {
+    size_t sum = 0;
+    for (const auto &job : jobs) {
+      if (job.get_user_id() == user_id) {
+        sum += job.get_priority();
+      }
+    }
+    bench_keep(sum);
+  });
+  run_benchmark("store: find jobs by id", count, [&store, &jobs] {
+    size_t found = 0;
+    for (const auto &job : jobs) {
+      found += store.jobs().find(job.get_id()) != nullptr;
+    }
+    bench_keep(found);
+  });
+}
@@ -0,0 +1,22 @@
+#include "lib/accessors.h"
+#include "lib/entity_graph.h"
+#include "lib/etf_decode.h"
+#include "lib/etf_scan.h"
+#include "lib/id.h"
+#include "lib/json.h"
+#include "lib/resource_tree.h"
+#include "lib/snapshot.h"
+#include "lib/state_store.h"
+
+int main() {
+  bench_etf_scan();
+  bench_etf_decode();
+  bench_accessors();
+  bench_id();
+  bench_json();
+  bench_snapshot();
+  bench_state_store();
+  bench_entity_graph();
+  bench_resource_tree();
+  return 0;
+}
@@ -1,219 +1,434 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_account.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmAccount> SwmAccount::FIELDS_INFO[] = {
+  field_info<SwmAccount, SwmId, &SwmAccount::id,
+             ei_buffer_to_id, encode_id,
+             SwmIdTerm>("id"),
+  field_info<SwmAccount, SwmAtom, &SwmAccount::name,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("name"),
+  field_info<SwmAccount, std::pmr::string, &SwmAccount::price_list,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("price_list"),
+  field_info<SwmAccount, std::pmr::vector<std::pmr::string>, &SwmAccount::users,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("users"),
+  field_info<SwmAccount, std::pmr::vector<std::pmr::string>, &SwmAccount::admins,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("admins"),
+  field_info<SwmAccount, std::pmr::string, &SwmAccount::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmAccount, uint64_t, &SwmAccount::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmAccount::SwmAccount() {
 }
 
-SwmAccount::SwmAccount(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmAccount: null" << std::endl;
-    return;
-  }
+SwmAccount::SwmAccount(const allocator_type &allocator)
+  : price_list(allocator),
+    users(allocator),
+    admins(allocator),
+    comment(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmAccount header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmAccount::SwmAccount(const SwmAccount &other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name),
+    price_list(other.price_list, allocator),
+    users(other.users, allocator),
+    admins(other.admins, allocator),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmAccount term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmAccount::SwmAccount(SwmAccount &&other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name),
+    price_list(std::move(other.price_list), allocator),
+    users(std::move(other.users), allocator),
+    admins(std::move(other.admins), allocator),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->id)) {
-    std::cerr << "Could not init account::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmAccount::allocator_type SwmAccount::get_allocator() const {
+  return price_list.get_allocator();
+}
 
-  if (ei_buffer_to_atom(buf, index, this->name)) {
-    std::cerr << "Could not init account::name at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmAccount::SwmAccount(const char* buf, int &index, const allocator_type &allocator)
+  : SwmAccount(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->price_list)) {
-    std::cerr << "Could not init account::price_list at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmAccount::SwmAccount(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmAccount(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_str(buf, index, this->users)) {
-    std::cerr << "Could not init account::users at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->admins)) {
-    std::cerr << "Could not init account::admins at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmAccount::SwmAccount(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmAccount(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init account::comment at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmAccount::validate(const char* buf, int &index) {
+  return entity_validate<SwmAccount>(buf, index);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init account::revision at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+void SwmAccount::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmAccount::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmAccount>(buf, index, writer);
+}
+
+SwmPatch SwmAccount::diff(const SwmAccount &old_obj, const SwmAccount &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmAccount::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmAccount::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip account::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmAccount::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmAccount::set_id(const std::string &new_val) {
+void SwmAccount::set_id(const SwmId &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmAccount::set_name(const std::string &new_val) {
+void SwmAccount::set_name(const SwmAtom &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmAccount::set_price_list(const std::string &new_val) {
+void SwmAccount::set_price_list(const std::pmr::string &new_val) {
   price_list = new_val;
+  lazy_fields &= ~FIELD_PRICE_LIST;
 }
 
-void SwmAccount::set_users(const std::vector<std::string> &new_val) {
+void SwmAccount::set_price_list(std::pmr::string &&new_val) {
+  price_list = std::move(new_val);
+  lazy_fields &= ~FIELD_PRICE_LIST;
+}
+
+void SwmAccount::set_users(const std::pmr::vector<std::pmr::string> &new_val) {
   users = new_val;
+  lazy_fields &= ~FIELD_USERS;
+}
+
+void SwmAccount::set_users(std::pmr::vector<std::pmr::string> &&new_val) {
+  users = std::move(new_val);
+  lazy_fields &= ~FIELD_USERS;
 }
 
-void SwmAccount::set_admins(const std::vector<std::string> &new_val) {
+void SwmAccount::set_admins(const std::pmr::vector<std::pmr::string> &new_val) {
   admins = new_val;
+  lazy_fields &= ~FIELD_ADMINS;
 }
 
-void SwmAccount::set_comment(const std::string &new_val) {
+void SwmAccount::set_admins(std::pmr::vector<std::pmr::string> &&new_val) {
+  admins = std::move(new_val);
+  lazy_fields &= ~FIELD_ADMINS;
+}
+
+void SwmAccount::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmAccount::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmAccount::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-std::string SwmAccount::get_id() const {
+const SwmId& SwmAccount::get_id() const {
   return id;
 }
 
-std::string SwmAccount::get_name() const {
+const SwmAtom& SwmAccount::get_name() const {
   return name;
 }
 
-std::string SwmAccount::get_price_list() const {
+const std::pmr::string& SwmAccount::get_price_list() const {
   return price_list;
 }
 
-std::vector<std::string> SwmAccount::get_users() const {
+const std::pmr::vector<std::pmr::string>& SwmAccount::get_users() const {
   return users;
 }
 
-std::vector<std::string> SwmAccount::get_admins() const {
+const std::pmr::vector<std::pmr::string>& SwmAccount::get_admins() const {
   return admins;
 }
 
-std::string SwmAccount::get_comment() const {
+const std::pmr::string& SwmAccount::get_comment() const {
   return comment;
 }
 
-uint64_t SwmAccount::get_revision() const {
+const uint64_t& SwmAccount::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_account(const char *buf, int &index, std::vector<SwmAccount> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a account list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for account at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a account list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of account list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_account(const char *buf, int &index, std::vector<SwmAccount> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_account(const char *buf, int &index, std::pmr::vector<SwmAccount> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_account(const char *buf, int &index, std::vector<SwmAccount> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a account list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmAccount(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_account(const char* buf, int &index, SwmAccount &obj) {
-  obj = SwmAccount(buf, index);
+  obj = SwmAccount(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmAccount::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmAccount::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode account" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_account(char* buf, int &index, const SwmAccount &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_account(char* buf, int &index, const std::vector<SwmAccount> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmAccount &x) { x.encode(b, i); });
+}
+
+void swm::encode_account(char* buf, int &index, const std::pmr::vector<SwmAccount> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmAccount &x) { x.encode(b, i); });
+}
+
+int swm::encode_account(ei_x_buff &x, const std::vector<SwmAccount> &array) {
+  int size = 0;
+  encode_account(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode account list" << std::endl;
+    return -1;
+  }
+  encode_account(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_account(ei_x_buff &x, const std::pmr::vector<SwmAccount> &array) {
+  int size = 0;
+  encode_account(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode account list" << std::endl;
+    return -1;
+  }
+  encode_account(x.buff, x.index, array);
   return 0;
 }
 
 void SwmAccount::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << price_list << separator;
-  if (users.empty()) {
-    std::cerr << prefix << "users: []" << separator;
-  } else {
-    std::cerr << prefix << "users" << ": [";
-    for (const auto &q: users) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
-  }
-  if (admins.empty()) {
-    std::cerr << prefix << "admins: []" << separator;
-  } else {
-    std::cerr << prefix << "admins" << ": [";
-    for (const auto &q: admins) {
-      std::cerr << q << ",";
+  entity_print(*this, prefix, separator);
+}
+
+SwmAccountView::SwmAccountView() {
+}
+
+SwmAccountView::SwmAccountView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmAccountView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 7)) {
+    std::cerr << "Could not create SwmAccountView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmAccountView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmAccountView::get_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+std::string_view SwmAccountView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[1]);
+}
+
+std::string_view SwmAccountView::get_price_list() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmAccountView::get_users() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[3]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmAccountView::get_admins() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[4]);
+}
+
+std::string_view SwmAccountView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[5]);
+}
+
+uint64_t SwmAccountView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[6]);
+}
+
+int swm::ei_buffer_to_account(const char* buf, int &index, SwmAccountView &obj) {
+  obj = SwmAccountView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_account(const char* buf, int &index, std::vector<SwmAccountView> &array) {
+  const SwmListView<SwmAccountView, ei_buffer_to_account> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmAccountView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
+    array.push_back(view);
   }
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of account at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
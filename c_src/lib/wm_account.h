@@ -2,48 +2,154 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmAccount:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 7;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_NAME = 1ull << 1;
+  static constexpr uint64_t FIELD_PRICE_LIST = 1ull << 2;
+  static constexpr uint64_t FIELD_USERS = 1ull << 3;
+  static constexpr uint64_t FIELD_ADMINS = 1ull << 4;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 5;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 6;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "account";
+  static const SwmFieldInfo<SwmAccount> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmAccount();
-  SwmAccount(const char*, int&);
+  explicit SwmAccount(const allocator_type&);
+  SwmAccount(const char*, int&, const allocator_type& = {});
+  SwmAccount(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmAccount(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmAccount(const SwmAccount&, const allocator_type&);
+  SwmAccount(SwmAccount&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmAccount &old_obj, const SwmAccount &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_id(const std::string&);
-  void set_name(const std::string&);
-  void set_price_list(const std::string&);
-  void set_users(const std::vector<std::string>&);
-  void set_admins(const std::vector<std::string>&);
-  void set_comment(const std::string&);
+  void set_id(const SwmId&);
+  void set_name(const SwmAtom&);
+  void set_price_list(const std::pmr::string&);
+  void set_price_list(std::pmr::string&&);
+  void set_users(const std::pmr::vector<std::pmr::string>&);
+  void set_users(std::pmr::vector<std::pmr::string>&&);
+  void set_admins(const std::pmr::vector<std::pmr::string>&);
+  void set_admins(std::pmr::vector<std::pmr::string>&&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  std::string get_id() const;
-  std::string get_name() const;
-  std::string get_price_list() const;
-  std::vector<std::string> get_users() const;
-  std::vector<std::string> get_admins() const;
-  std::string get_comment() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const SwmId& get_id() const;
+  const SwmAtom& get_name() const;
+  const std::pmr::string& get_price_list() const;
+  const std::pmr::vector<std::pmr::string>& get_users() const;
+  const std::pmr::vector<std::pmr::string>& get_admins() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_users(Args&&... args) {
+    return users.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_admins(Args&&... args) {
+    return admins.emplace_back(std::forward<Args>(args)...);
+  }
 
  private:
-  std::string id;
-  std::string name;
-  std::string price_list;
-  std::vector<std::string> users;
-  std::vector<std::string> admins;
-  std::string comment;
-  uint64_t revision;
+  SwmId id;
+  SwmAtom name;
+  std::pmr::string price_list;
+  std::pmr::vector<std::pmr::string> users;
+  std::pmr::vector<std::pmr::string> admins;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmAccountView;
+
 int ei_buffer_to_account(const char*, int&, std::vector<SwmAccount>&);
+int ei_buffer_to_account(const char*, int&, std::pmr::vector<SwmAccount>&);
+int ei_buffer_to_account(const char*, int&, std::vector<SwmAccount>&, SwmThreadPool&);
 int ei_buffer_to_account(const char*, int&, SwmAccount&);
+int ei_buffer_to_account(const char*, int&, std::vector<SwmAccountView>&);
+int ei_buffer_to_account(const char*, int&, SwmAccountView&);
+
+void encode_account(char*, int&, const SwmAccount&);
+void encode_account(char*, int&, const std::vector<SwmAccount>&);
+void encode_account(char*, int&, const std::pmr::vector<SwmAccount>&);
+int encode_account(ei_x_buff&, const std::vector<SwmAccount>&);
+int encode_account(ei_x_buff&, const std::pmr::vector<SwmAccount>&);
+
+class SwmAccountView {
+
+ public:
+  SwmAccountView();
+  SwmAccountView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_id() const;
+  std::string_view get_name() const;
+  std::string_view get_price_list() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_users() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_admins() const;
+  std::string_view get_comment() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 7> offsets = {};
+
+};
 
 } // namespace swm
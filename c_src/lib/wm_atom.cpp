@@ -0,0 +1,86 @@
+#include "wm_atom.h"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+
+using namespace swm;
+
+namespace {
+
+// Readers (decoding threads) take a shared lock, only new atoms are added
+// exclusively. Names are kept in a deque, so views on them remain valid.
+class SwmAtomTable {
+ public:
+  SwmAtomTable() {
+    for (const auto name : SWM_KNOWN_ATOMS) {
+      add(name);
+    }
+  }
+
+  uint32_t intern(const std::string_view name) {
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex);
+      const auto it = ids.find(name);
+      if (it != ids.end()) {
+        return it->second;
+      }
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    const auto it = ids.find(name);  // could be added by another thread
+    if (it != ids.end()) {
+      return it->second;
+    }
+    return add(name);
+  }
+
+  std::string_view name(const uint32_t id) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return id < names.size() ? std::string_view(names[id]) : std::string_view();
+  }
+
+  size_t size() {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names.size();
+  }
+
+ private:
+  uint32_t add(const std::string_view name) {
+    const auto id = static_cast<uint32_t>(names.size());
+    names.emplace_back(name);
+    ids.emplace(names.back(), id);
+    return id;
+  }
+
+  std::shared_mutex mutex;
+  std::deque<std::string> names;
+  std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+SwmAtomTable& atom_table() {
+  static SwmAtomTable table;
+  return table;
+}
+
+} // namespace
+
+SwmAtom::SwmAtom(const std::string_view name): value(atom_table().intern(name)) {
+}
+
+std::string_view SwmAtom::str() const {
+  if (value < SWM_ATOM_KNOWN_COUNT) {
+    return SWM_KNOWN_ATOMS[value];  // no lock is needed for fixed atoms
+  }
+  return atom_table().name(value);
+}
+
+size_t swm::swm_atoms_count() {
+  return atom_table().size();
+}
+
+std::ostream& swm::operator<<(std::ostream& out, const SwmAtom &atom) {
+  return out << atom.str();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "wm_atom_ids.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace swm {
+
+// Interned erlang atom: 4 bytes id in a process wide table of atom names.
+// Like in erlang atoms are never removed from the table, thus it should be
+// used only for fields with a limited set of values.
+class SwmAtom {
+ public:
+  constexpr SwmAtom() {
+  }
+  constexpr SwmAtom(const SwmAtomId id): value(id) {
+  }
+  explicit SwmAtom(std::string_view name);
+
+  uint32_t id() const { return value; }
+  std::string_view str() const;
+  bool empty() const { return value == SWM_ATOM_EMPTY; }
+
+  bool operator==(const SwmAtom &other) const { return value == other.value; }
+  bool operator!=(const SwmAtom &other) const { return value != other.value; }
+  bool operator<(const SwmAtom &other) const { return value < other.value; }
+  bool operator==(std::string_view name) const { return str() == name; }
+  bool operator!=(std::string_view name) const { return str() != name; }
+
+ private:
+  uint32_t value = SWM_ATOM_EMPTY;
+};
+
+size_t swm_atoms_count();
+
+std::ostream& operator<<(std::ostream& out, const SwmAtom &atom);
+
+} // namespace swm
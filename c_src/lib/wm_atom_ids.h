@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+namespace swm {
+
+// Atoms known in advance (schema defaults and states used by the core)
+// have fixed ids, so fields can be compared with them as integers.
+enum SwmAtomId : uint32_t {
+  SWM_ATOM_EMPTY = 0,
+  SWM_ATOM_UP = 1,
+  SWM_ATOM_DOWN = 2,
+  SWM_ATOM_IDLE = 3,
+  SWM_ATOM_BUSY = 4,
+  SWM_ATOM_STOPPED = 5,
+  SWM_ATOM_OFFLINE = 6,
+  SWM_ATOM_CREATING = 7,
+  SWM_ATOM_FORWARDED = 8,
+  SWM_ATOM_ENABLED = 9,
+  SWM_ATOM_DISABLED = 10,
+  SWM_ATOM_TRUE = 11,
+  SWM_ATOM_FALSE = 12,
+  SWM_ATOM_GRID = 13,
+  SWM_ATOM_CLUSTER = 14,
+  SWM_ATOM_PARTITION = 15,
+  SWM_ATOM_LOCAL = 16,
+  SWM_ATOM_CLOUD = 17,
+  SWM_ATOM_CONTAINER = 18,
+  SWM_ATOM_KNOWN_COUNT = 19
+};
+
+inline constexpr const char* SWM_KNOWN_ATOMS[] = {
+  "",
+  "up",
+  "down",
+  "idle",
+  "busy",
+  "stopped",
+  "offline",
+  "creating",
+  "forwarded",
+  "enabled",
+  "disabled",
+  "true",
+  "false",
+  "grid",
+  "cluster",
+  "partition",
+  "local",
+  "cloud",
+  "container",
+};
+
+} // namespace swm
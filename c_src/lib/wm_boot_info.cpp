@@ -1,155 +1,368 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_boot_info.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmBootInfo> SwmBootInfo::FIELDS_INFO[] = {
+  field_info<SwmBootInfo, std::pmr::string, &SwmBootInfo::node_host,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("node_host"),
+  field_info<SwmBootInfo, uint64_t, &SwmBootInfo::node_port,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("node_port"),
+  field_info<SwmBootInfo, std::pmr::string, &SwmBootInfo::parent_host,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("parent_host"),
+  field_info<SwmBootInfo, uint64_t, &SwmBootInfo::parent_port,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("parent_port"),
+};
+
 SwmBootInfo::SwmBootInfo() {
 }
 
-SwmBootInfo::SwmBootInfo(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmBootInfo: null" << std::endl;
-    return;
-  }
+SwmBootInfo::SwmBootInfo(const allocator_type &allocator)
+  : node_host(allocator),
+    parent_host(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmBootInfo header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmBootInfo::SwmBootInfo(const SwmBootInfo &other, const allocator_type &allocator)
+  : node_host(other.node_host, allocator),
+    node_port(other.node_port),
+    parent_host(other.parent_host, allocator),
+    parent_port(other.parent_port),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmBootInfo term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmBootInfo::SwmBootInfo(SwmBootInfo &&other, const allocator_type &allocator)
+  : node_host(std::move(other.node_host), allocator),
+    node_port(other.node_port),
+    parent_host(std::move(other.parent_host), allocator),
+    parent_port(other.parent_port),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->node_host)) {
-    std::cerr << "Could not init boot_info::node_host at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmBootInfo::allocator_type SwmBootInfo::get_allocator() const {
+  return node_host.get_allocator();
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->node_port)) {
-    std::cerr << "Could not init boot_info::node_port at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmBootInfo::SwmBootInfo(const char* buf, int &index, const allocator_type &allocator)
+  : SwmBootInfo(buf, index, FIELD_ALL, allocator) {
+}
+
+SwmBootInfo::SwmBootInfo(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmBootInfo(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
+  }
+}
 
-  if (ei_buffer_to_str(buf, index, this->parent_host)) {
-    std::cerr << "Could not init boot_info::parent_host at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmBootInfo::SwmBootInfo(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmBootInfo(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->parent_port)) {
-    std::cerr << "Could not init boot_info::parent_port at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmBootInfo::validate(const char* buf, int &index) {
+  return entity_validate<SwmBootInfo>(buf, index);
+}
+
+void SwmBootInfo::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmBootInfo::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmBootInfo>(buf, index, writer);
+}
+
+SwmPatch SwmBootInfo::diff(const SwmBootInfo &old_obj, const SwmBootInfo &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmBootInfo::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmBootInfo::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip boot_info::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmBootInfo::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmBootInfo::set_node_host(const std::string &new_val) {
+void SwmBootInfo::set_node_host(const std::pmr::string &new_val) {
   node_host = new_val;
+  lazy_fields &= ~FIELD_NODE_HOST;
+}
+
+void SwmBootInfo::set_node_host(std::pmr::string &&new_val) {
+  node_host = std::move(new_val);
+  lazy_fields &= ~FIELD_NODE_HOST;
 }
 
 void SwmBootInfo::set_node_port(const uint64_t &new_val) {
   node_port = new_val;
+  lazy_fields &= ~FIELD_NODE_PORT;
 }
 
-void SwmBootInfo::set_parent_host(const std::string &new_val) {
+void SwmBootInfo::set_parent_host(const std::pmr::string &new_val) {
   parent_host = new_val;
+  lazy_fields &= ~FIELD_PARENT_HOST;
+}
+
+void SwmBootInfo::set_parent_host(std::pmr::string &&new_val) {
+  parent_host = std::move(new_val);
+  lazy_fields &= ~FIELD_PARENT_HOST;
 }
 
 void SwmBootInfo::set_parent_port(const uint64_t &new_val) {
   parent_port = new_val;
+  lazy_fields &= ~FIELD_PARENT_PORT;
 }
 
-std::string SwmBootInfo::get_node_host() const {
+const std::pmr::string& SwmBootInfo::get_node_host() const {
   return node_host;
 }
 
-uint64_t SwmBootInfo::get_node_port() const {
+const uint64_t& SwmBootInfo::get_node_port() const {
   return node_port;
 }
 
-std::string SwmBootInfo::get_parent_host() const {
+const std::pmr::string& SwmBootInfo::get_parent_host() const {
   return parent_host;
 }
 
-uint64_t SwmBootInfo::get_parent_port() const {
+const uint64_t& SwmBootInfo::get_parent_port() const {
   return parent_port;
 }
 
-int swm::ei_buffer_to_boot_info(const char *buf, int &index, std::vector<SwmBootInfo> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a boot_info list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for boot_info at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a boot_info list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of boot_info list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_boot_info(const char *buf, int &index, std::vector<SwmBootInfo> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_boot_info(const char *buf, int &index, std::pmr::vector<SwmBootInfo> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_boot_info(const char *buf, int &index, std::vector<SwmBootInfo> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a boot_info list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmBootInfo(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_boot_info(const char* buf, int &index, SwmBootInfo &obj) {
-  obj = SwmBootInfo(buf, index);
+  obj = SwmBootInfo(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmBootInfo::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmBootInfo::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode boot_info" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_boot_info(char* buf, int &index, const SwmBootInfo &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_boot_info(char* buf, int &index, const std::vector<SwmBootInfo> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmBootInfo &x) { x.encode(b, i); });
+}
+
+void swm::encode_boot_info(char* buf, int &index, const std::pmr::vector<SwmBootInfo> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmBootInfo &x) { x.encode(b, i); });
+}
+
+int swm::encode_boot_info(ei_x_buff &x, const std::vector<SwmBootInfo> &array) {
+  int size = 0;
+  encode_boot_info(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode boot_info list" << std::endl;
+    return -1;
+  }
+  encode_boot_info(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_boot_info(ei_x_buff &x, const std::pmr::vector<SwmBootInfo> &array) {
+  int size = 0;
+  encode_boot_info(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode boot_info list" << std::endl;
+    return -1;
+  }
+  encode_boot_info(x.buff, x.index, array);
   return 0;
 }
 
 void SwmBootInfo::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << node_host << separator;
-  std::cerr << prefix << node_port << separator;
-  std::cerr << prefix << parent_host << separator;
-  std::cerr << prefix << parent_port << separator;
-  std::cerr << std::endl;
+  entity_print(*this, prefix, separator);
+}
+
+SwmBootInfoView::SwmBootInfoView() {
+}
+
+SwmBootInfoView::SwmBootInfoView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmBootInfoView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 4)) {
+    std::cerr << "Could not create SwmBootInfoView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmBootInfoView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmBootInfoView::get_node_host() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+uint64_t SwmBootInfoView::get_node_port() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[1]);
+}
+
+std::string_view SwmBootInfoView::get_parent_host() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+uint64_t SwmBootInfoView::get_parent_port() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[3]);
+}
+
+int swm::ei_buffer_to_boot_info(const char* buf, int &index, SwmBootInfoView &obj) {
+  obj = SwmBootInfoView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_boot_info(const char* buf, int &index, std::vector<SwmBootInfoView> &array) {
+  const SwmListView<SwmBootInfoView, ei_buffer_to_boot_info> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmBootInfoView at " << index << std::endl;
+      return -1;
+    }
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of boot_info at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
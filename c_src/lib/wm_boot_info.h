@@ -2,39 +2,127 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmBootInfo:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 4;
+  static constexpr uint64_t FIELD_NODE_HOST = 1ull << 0;
+  static constexpr uint64_t FIELD_NODE_PORT = 1ull << 1;
+  static constexpr uint64_t FIELD_PARENT_HOST = 1ull << 2;
+  static constexpr uint64_t FIELD_PARENT_PORT = 1ull << 3;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "boot_info";
+  static const SwmFieldInfo<SwmBootInfo> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmBootInfo();
-  SwmBootInfo(const char*, int&);
+  explicit SwmBootInfo(const allocator_type&);
+  SwmBootInfo(const char*, int&, const allocator_type& = {});
+  SwmBootInfo(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmBootInfo(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmBootInfo(const SwmBootInfo&, const allocator_type&);
+  SwmBootInfo(SwmBootInfo&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmBootInfo &old_obj, const SwmBootInfo &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_node_host(const std::string&);
+  void set_node_host(const std::pmr::string&);
+  void set_node_host(std::pmr::string&&);
   void set_node_port(const uint64_t&);
-  void set_parent_host(const std::string&);
+  void set_parent_host(const std::pmr::string&);
+  void set_parent_host(std::pmr::string&&);
   void set_parent_port(const uint64_t&);
 
-  std::string get_node_host() const;
-  uint64_t get_node_port() const;
-  std::string get_parent_host() const;
-  uint64_t get_parent_port() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const std::pmr::string& get_node_host() const;
+  const uint64_t& get_node_port() const;
+  const std::pmr::string& get_parent_host() const;
+  const uint64_t& get_parent_port() const;
 
  private:
-  std::string node_host;
-  uint64_t node_port;
-  std::string parent_host;
-  uint64_t parent_port;
+  std::pmr::string node_host;
+  uint64_t node_port = 0;
+  std::pmr::string parent_host;
+  uint64_t parent_port = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmBootInfoView;
+
 int ei_buffer_to_boot_info(const char*, int&, std::vector<SwmBootInfo>&);
+int ei_buffer_to_boot_info(const char*, int&, std::pmr::vector<SwmBootInfo>&);
+int ei_buffer_to_boot_info(const char*, int&, std::vector<SwmBootInfo>&, SwmThreadPool&);
 int ei_buffer_to_boot_info(const char*, int&, SwmBootInfo&);
+int ei_buffer_to_boot_info(const char*, int&, std::vector<SwmBootInfoView>&);
+int ei_buffer_to_boot_info(const char*, int&, SwmBootInfoView&);
+
+void encode_boot_info(char*, int&, const SwmBootInfo&);
+void encode_boot_info(char*, int&, const std::vector<SwmBootInfo>&);
+void encode_boot_info(char*, int&, const std::pmr::vector<SwmBootInfo>&);
+int encode_boot_info(ei_x_buff&, const std::vector<SwmBootInfo>&);
+int encode_boot_info(ei_x_buff&, const std::pmr::vector<SwmBootInfo>&);
+
+class SwmBootInfoView {
+
+ public:
+  SwmBootInfoView();
+  SwmBootInfoView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_node_host() const;
+  uint64_t get_node_port() const;
+  std::string_view get_parent_host() const;
+  uint64_t get_parent_port() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 4> offsets = {};
+
+};
 
 } // namespace swm
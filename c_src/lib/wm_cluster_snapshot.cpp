@@ -0,0 +1,25 @@
+#include "wm_cluster_snapshot.h"
+
+
+using namespace swm;
+
+uint64_t swm::swm_next_snapshot_generation() {
+  static std::atomic<uint64_t> last(0);
+  return ++last;
+}
+
+SwmSnapshotPublisher::SwmSnapshotPublisher()
+  : latest(std::make_shared<const SwmClusterSnapshot>()) {
+}
+
+std::shared_ptr<const SwmClusterSnapshot> SwmSnapshotPublisher::load() const {
+  return std::atomic_load(&latest);
+}
+
+uint64_t SwmSnapshotPublisher::publish(SwmClusterSnapshot &&snapshot) {
+  const std::lock_guard<std::mutex> lock(publish_mutex);
+  snapshot.version = std::atomic_load(&latest)->version + 1;
+  const uint64_t version = snapshot.version;
+  std::atomic_store(&latest, std::shared_ptr<const SwmClusterSnapshot>(std::make_shared<SwmClusterSnapshot>(std::move(snapshot))));
+  return version;
+}
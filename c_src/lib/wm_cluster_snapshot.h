@@ -0,0 +1,270 @@
+#pragma once
+
+#include "wm_cluster.h"
+#include "wm_grid.h"
+#include "wm_id.h"
+#include "wm_job.h"
+#include "wm_node.h"
+#include "wm_partition.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace swm {
+
+// Unique number of a snapshot list that stamps the chunks it creates
+uint64_t swm_next_snapshot_generation();
+
+// List of immutable entities with lookup by id.
+//
+// Entities and the id index are kept in fixed size chunks behind shared
+// pointers that are never modified once published. A copy of the list is
+// cheap and its modification copies only the touched chunks, so all other
+// copies keep seeing their own version. Different copies can be used by
+// different threads without locks, one copy can not.
+template <typename Entity>
+class SwmSnapshotList {
+ public:
+  typedef std::shared_ptr<const Entity> EntityPtr;
+
+  SwmSnapshotList() = default;
+
+  // Both lists get new generations, so neither updates the shared chunks
+  SwmSnapshotList(const SwmSnapshotList &other)
+    : chunks(other.chunks), buckets(other.buckets), count(other.count) {
+    other.generation = swm_next_snapshot_generation();
+  }
+  SwmSnapshotList(SwmSnapshotList &&other)
+    : chunks(std::move(other.chunks)), buckets(std::move(other.buckets)), count(other.count),
+      generation(other.generation.load()) {
+    other.clear();
+  }
+  SwmSnapshotList& operator=(const SwmSnapshotList &other) {
+    if (this != &other) {
+      chunks = other.chunks;
+      buckets = other.buckets;
+      count = other.count;
+      generation = swm_next_snapshot_generation();
+      other.generation = swm_next_snapshot_generation();
+    }
+    return *this;
+  }
+  SwmSnapshotList& operator=(SwmSnapshotList &&other) {
+    if (this != &other) {
+      chunks = std::move(other.chunks);
+      buckets = std::move(other.buckets);
+      count = other.count;
+      generation = other.generation.load();
+      other.clear();
+    }
+    return *this;
+  }
+
+  // Entities with the same id replace the previous ones
+  explicit SwmSnapshotList(const std::vector<EntityPtr> &entities) {
+    for (const auto &entity : entities) {
+      set(entity);
+    }
+  }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  const Entity& operator[](const size_t pos) const {
+    return *ptr(pos);
+  }
+
+  const EntityPtr& ptr(const size_t pos) const {
+    return chunks[pos / chunk_size]->entities[pos % chunk_size];
+  }
+
+  const Entity* find(const SwmId &id) const {
+    const auto &bucket = buckets[bucket_pos(id)];
+    if (!bucket) {
+      return nullptr;
+    }
+    const auto it = bucket->ids.find(id);
+    return it == bucket->ids.end() ? nullptr : &(*this)[it->second];
+  }
+
+  const Entity* find(const std::string_view id) const {
+    SwmId key;
+    return SwmId::find(id, key) ? find(key) : nullptr;
+  }
+
+  template <typename F>
+  void for_each(F &&fun) const {
+    for (const auto &chunk : chunks) {
+      for (const auto &entity : chunk->entities) {
+        fun(*entity);
+      }
+    }
+  }
+
+  // Replaces the entity with the same id or appends the entity
+  void set(EntityPtr entity) {
+    const SwmId &id = entity->get_id();
+    auto &bucket = bucket_for_update(id);
+    const auto it = bucket.find(id);
+    if (it != bucket.end()) {
+      const size_t pos = it->second;
+      chunk_for_update(pos)[pos % chunk_size] = std::move(entity);
+      return;
+    }
+    bucket.emplace(id, count);
+    if (count % chunk_size == 0) {
+      chunks.push_back(std::make_shared<Chunk>(Chunk{{}, generation}));
+    }
+    chunk_for_update(count).push_back(std::move(entity));
+    ++count;
+  }
+
+  // Removes the entity, the last entity takes its position
+  bool erase(const SwmId &id) {
+    if (!find(id)) {
+      return false;
+    }
+    auto &bucket = bucket_for_update(id);
+    const auto it = bucket.find(id);
+    const size_t pos = it->second;
+    bucket.erase(it);
+    const size_t last = count - 1;
+    if (pos != last) {
+      EntityPtr moved = ptr(last);
+      const SwmId &moved_id = moved->get_id();
+      bucket_for_update(moved_id).find(moved_id)->second = pos;
+      chunk_for_update(pos)[pos % chunk_size] = std::move(moved);
+    }
+    chunk_for_update(last).pop_back();
+    if (chunks.back()->entities.empty()) {
+      chunks.pop_back();
+    }
+    --count;
+    return true;
+  }
+
+  bool erase(const std::string_view id) {
+    SwmId key;
+    return SwmId::find(id, key) && erase(key);
+  }
+
+  // True if the entity at pos is stored in the same chunk as in other
+  bool shares_chunk(const SwmSnapshotList &other, const size_t pos) const {
+    const size_t chunk = pos / chunk_size;
+    return chunk < chunks.size() && chunk < other.chunks.size() && chunks[chunk] == other.chunks[chunk];
+  }
+
+ private:
+  static constexpr size_t chunk_size = 64;
+  static constexpr size_t buckets_count = 64;
+
+  typedef std::unordered_map<SwmId, size_t> Ids;
+
+  // Chunks and buckets are stamped with the generation of the list that
+  // created them
+  struct Chunk {
+    std::vector<EntityPtr> entities;
+    uint64_t generation = 0;
+  };
+  struct Bucket {
+    Ids ids;  // positions of the entities
+    uint64_t generation = 0;
+  };
+
+  static size_t bucket_pos(const SwmId &id) {
+    return id.hash() % buckets_count;
+  }
+
+  // Leaves an empty list with a new generation
+  void clear() {
+    chunks.clear();
+    buckets = {};
+    count = 0;
+    generation = swm_next_snapshot_generation();
+  }
+
+  // Chunks and buckets are copied before an update unless this list has
+  // created them since it was last copied. Other lists never update them.
+  // They are allocated mutable and shared as const, so the const_cast only
+  // restores the access of the list that created them.
+  std::vector<EntityPtr>& chunk_for_update(const size_t pos) {
+    auto &chunk = chunks[pos / chunk_size];
+    if (chunk->generation != generation) {
+      auto copy = std::make_shared<Chunk>(Chunk{chunk->entities, generation});
+      copy->entities.reserve(chunk_size);
+      chunk = std::move(copy);
+    }
+    return const_cast<Chunk&>(*chunk).entities;
+  }
+
+  Ids& bucket_for_update(const SwmId &id) {
+    auto &bucket = buckets[bucket_pos(id)];
+    if (!bucket) {
+      bucket = std::make_shared<Bucket>(Bucket{{}, generation});
+    } else if (bucket->generation != generation) {
+      bucket = std::make_shared<Bucket>(Bucket{bucket->ids, generation});
+    }
+    return const_cast<Bucket&>(*bucket).ids;
+  }
+
+  std::vector<std::shared_ptr<const Chunk>> chunks;
+  std::array<std::shared_ptr<const Bucket>, buckets_count> buckets;
+  size_t count = 0;
+  mutable std::atomic<uint64_t> generation{swm_next_snapshot_generation()};  // renewed by copies
+};
+
+// Version of the cluster state: the grid, clusters, partitions, nodes and
+// jobs. A snapshot is never changed after it is published, the writer
+// modifies a copy of the latest snapshot and publishes it as a new version,
+// while readers keep using the versions they have loaded.
+class SwmClusterSnapshot {
+ public:
+  uint64_t get_version() const { return version; }
+  const std::shared_ptr<const SwmGrid>& get_grid() const { return grid; }
+  const SwmSnapshotList<SwmCluster>& get_clusters() const { return clusters; }
+  const SwmSnapshotList<SwmPartition>& get_partitions() const { return partitions; }
+  const SwmSnapshotList<SwmNode>& get_nodes() const { return nodes; }
+  const SwmSnapshotList<SwmJob>& get_jobs() const { return jobs; }
+
+  void set_grid(std::shared_ptr<const SwmGrid> new_grid) { grid = std::move(new_grid); }
+  SwmSnapshotList<SwmCluster>& update_clusters() { return clusters; }
+  SwmSnapshotList<SwmPartition>& update_partitions() { return partitions; }
+  SwmSnapshotList<SwmNode>& update_nodes() { return nodes; }
+  SwmSnapshotList<SwmJob>& update_jobs() { return jobs; }
+
+ private:
+  friend class SwmSnapshotPublisher;
+
+  uint64_t version = 0;
+  std::shared_ptr<const SwmGrid> grid;
+  SwmSnapshotList<SwmCluster> clusters;
+  SwmSnapshotList<SwmPartition> partitions;
+  SwmSnapshotList<SwmNode> nodes;
+  SwmSnapshotList<SwmJob> jobs;
+};
+
+// Latest published snapshot. Loading does not wait for writers, concurrent
+// publishing is serialized.
+class SwmSnapshotPublisher {
+ public:
+  SwmSnapshotPublisher();
+
+  std::shared_ptr<const SwmClusterSnapshot> load() const;
+
+  // Publishes the snapshot with the next version number, returns the version
+  uint64_t publish(SwmClusterSnapshot &&snapshot);
+
+ private:
+  std::shared_ptr<const SwmClusterSnapshot> latest;  // accessed by std::atomic_load/store
+  std::mutex publish_mutex;
+};
+
+} // namespace swm
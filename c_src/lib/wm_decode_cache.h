@@ -0,0 +1,162 @@
+#pragma once
+
+#include "wm_entity.h"
+#include "wm_etf_reader.h"
+#include "wm_hash_index.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace swm {
+
+// Cache of decoded entities that are kept between scheduling cycles.
+//
+// Entities with FIELD_ID and FIELD_REVISION are looked up by the encoded id
+// and revision peeked from the ETF term (the rest of the term is skipped),
+// an entity is validated and decoded again only if it is new or its
+// revision changed. So the revision must change with every update of the
+// entity, the cache is meant for nodes and partitions. It does not help for
+// jobs: wm_scheduler increments revisions of all jobs in every cycle.
+// Decoded entities are shared and immutable, so results of the previous
+// cycles remain valid while the cache is updated. Not thread safe.
+template <typename Entity>
+class SwmDecodeCache {
+ public:
+  typedef std::shared_ptr<const Entity> EntityPtr;
+
+  int decode(const char* buf, int &index, EntityPtr &entity) {
+    std::string_view id;
+    uint64_t revision = 0;
+    int peek_index = index;
+    if (peek(buf, peek_index, id, revision)) {
+      std::cerr << "Could not peek id and revision at " << index << std::endl;
+      return -1;
+    }
+    Entry* cached = entries.find(id);
+    if (cached && cached->revision == revision) {
+      if (skip_fields(buf, peek_index)) {
+        return -1;
+      }
+      index = peek_index;
+      cached->used = true;
+      entity = cached->entity;
+      ++hits_count;
+      return 0;
+    }
+
+    // A new entity or a new revision. Only a valid term is decoded and cached,
+    // otherwise a malformed entity would be returned as a hit for its id and
+    // revision in later cycles.
+    int check_index = index;
+    if (Entity::validate(buf, check_index)) {
+      std::cerr << "Could not validate " << Entity::ENTITY_NAME << " at " << check_index << std::endl;
+      index = check_index;
+      return -1;
+    }
+    auto decoded = std::make_shared<const Entity>(buf, index, swm_unchecked);
+    ++misses_count;
+    auto &entry = cached ? *cached : entries.insert(std::string(id));
+    entry.revision = revision;
+    entry.used = true;
+    entry.entity = decoded;
+    entity = std::move(decoded);
+    return 0;
+  }
+
+  int decode(const char* buf, int &index, std::vector<EntityPtr> &array) {
+    int list_size = 0;
+    if (etf_decode_list_header(buf, index, list_size)) {
+      std::cerr << "Could not parse eterm " << index << ": not a list" << std::endl;
+      return -1;
+    }
+    if (list_size == 0) {
+      return 0;
+    }
+    array.reserve(array.size() + static_cast<size_t>(list_size));
+    for (int i = 0; i < list_size; ++i) {
+      EntityPtr entity;
+      if (decode(buf, index, entity)) {
+        return -1;
+      }
+      array.push_back(std::move(entity));
+    }
+    return etf_decode_list_tail(buf, index);
+  }
+
+  // Ends a cycle: removes entities that were not decoded since the previous
+  // call (deleted ones), returns number of removed entities.
+  size_t evict_unused() {
+    return entries.erase_if([](const std::string&, Entry &entry) {
+      if (!entry.used) {
+        return true;
+      }
+      entry.used = false;
+      return false;
+    });
+  }
+
+  void clear() {
+    entries.clear();
+  }
+
+  size_t size() const { return entries.size(); }
+  uint64_t hits() const { return hits_count; }
+  uint64_t misses() const { return misses_count; }
+
+ private:
+  struct Entry {
+    uint64_t revision = 0;
+    bool used = false;
+    EntityPtr entity;
+  };
+
+  static constexpr int id_pos = entity_field_pos(Entity::FIELD_ID);
+  static constexpr int revision_pos = entity_field_pos(Entity::FIELD_REVISION);
+  static constexpr int last_pos = id_pos > revision_pos ? id_pos : revision_pos;
+
+  // Reads fields up to the id and revision, the index is moved after them
+  static int peek(const char* buf, int &index, std::string_view &id, uint64_t &revision) {
+    int arity = 0;
+    if (etf_decode_tuple_header(buf, index, arity) || arity != Entity::FIELDS_COUNT + 1) {
+      return -1;
+    }
+    if (etf_skip_term(buf, index)) {  // record name
+      return -1;
+    }
+    for (int pos = 0; pos <= last_pos; ++pos) {
+      if (pos == id_pos) {
+        const int begin = index;
+        if (etf_skip_term(buf, index)) {
+          return -1;
+        }
+        id = std::string_view(buf + begin, static_cast<size_t>(index - begin));
+      } else if (pos == revision_pos) {
+        if (etf_decode_uint64(buf, index, revision)) {
+          return -1;
+        }
+      } else if (etf_skip_term(buf, index)) {
+        return -1;
+      }
+    }
+    return 0;
+  }
+
+  // Skips the fields after the peeked ones
+  static int skip_fields(const char* buf, int &index) {
+    for (int pos = last_pos + 1; pos < Entity::FIELDS_COUNT; ++pos) {
+      if (etf_skip_term(buf, index)) {
+        return -1;
+      }
+    }
+    return 0;
+  }
+
+  SwmHashIndex<std::string, Entry> entries;  // by the encoded id term
+  uint64_t hits_count = 0;
+  uint64_t misses_count = 0;
+};
+
+} // namespace swm
@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace swm {
@@ -10,4 +11,20 @@ class SwmEntity {
     virtual void print(const std::string &prefix, const char separator) const = 0;
 };
 
+// Tag of the decoding constructors for terms that were validated before
+// (by Entity::validate()), such terms are decoded without any checks.
+struct SwmUnchecked {};
+constexpr SwmUnchecked swm_unchecked{};
+
+// Position of a field in the entity tuple (not counting the record name)
+// by its generated FIELD_* mask.
+constexpr int entity_field_pos(uint64_t field) {
+  int pos = 0;
+  while (field > 1) {
+    field >>= 1;
+    ++pos;
+  }
+  return pos;
+}
+
 } // namespace swm
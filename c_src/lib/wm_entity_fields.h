@@ -0,0 +1,359 @@
+#pragma once
+
+#include "wm_entity.h"
+#include "wm_entity_terms.h"
+#include "wm_entity_utils.h"
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
+#include "wm_json_writer.h"
+
+#include <ei.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace swm {
+
+// Every generated entity has a table of descriptors of its fields in the
+// tuple order (Entity::FIELDS_INFO). Decoding, encoding and printing of all
+// entities is done by the loops below over that table instead of code that
+// is repeated for every field of every entity. Only the accessor is specific
+// to a field, the other functions are shared by all fields of the same type.
+template <typename Entity>
+struct SwmFieldInfo {
+  const char* name;
+  const void* (*value)(const Entity &obj);
+  int (*decode)(const char* buf, int &index, void* value);
+  void (*encode)(char* buf, int &index, const void* value);
+  void (*print)(const char* name, const void* value, const std::string &prefix, char separator);
+  int (*validate)(const char* buf, int &index);
+  void (*decode_unchecked)(const char* buf, int &index, void* value);
+  void (*json)(SwmJsonWriter &writer, const void* value);
+  int (*transcode)(const char* buf, int &index, SwmJsonWriter &writer);  // the term to JSON
+};
+
+template <typename T>
+struct is_vector_field: std::false_type {};
+
+template <typename T, typename Allocator>
+struct is_vector_field<std::vector<T, Allocator>>: std::true_type {};
+
+template <typename T>
+struct is_pair_field: std::false_type {};
+
+template <typename First, typename Second>
+struct is_pair_field<std::pair<First, Second>>: std::true_type {};
+
+template <typename T>
+void write_json(SwmJsonWriter &writer, const T &x) {
+  if constexpr (is_vector_field<T>::value) {
+    writer.begin_array();
+    for (const auto &element : x) {
+      write_json(writer, element);
+    }
+    writer.end_array();
+  } else if constexpr (is_pair_field<T>::value) {
+    writer.begin_array();
+    write_json(writer, x.first);
+    write_json(writer, x.second);
+    writer.end_array();
+  } else if constexpr (std::is_base_of_v<SwmEntity, T>) {
+    x.to_json(writer);
+  } else if constexpr (std::is_same_v<T, SwmAtom>) {
+    writer.value_atom(x.str());
+  } else if constexpr (std::is_same_v<T, SwmId>) {
+    SwmId::Buffer buf;
+    writer.value_str(x.str(buf));
+  } else if constexpr (std::is_same_v<T, SwmTermRef>) {
+    int index = 0;
+    if (x.empty() || etf_to_json(x.data(), index, writer)) {
+      writer.value_null();
+    }
+  } else if constexpr (std::is_same_v<T, SwmPriceMap>) {
+    writer.begin_object();
+    SwmId::Buffer buf;
+    for (const auto &[account, price] : x) {
+      writer.key(account.str(buf));
+      if (price.is_integer()) {
+        writer.value_int64(price.get_int());
+      } else {
+        writer.value_double(price.get());
+      }
+    }
+    writer.end_object();
+  } else if constexpr (std::is_same_v<T, SwmMapStrStr>) {
+    writer.begin_object();
+    for (const auto &[key, value] : x) {
+      writer.key(key);
+      writer.value_str(value);
+    }
+    writer.end_object();
+  } else if constexpr (std::is_same_v<T, uint64_t>) {
+    writer.value_uint64(x);
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    writer.value_int64(x);
+  } else if constexpr (std::is_same_v<T, double>) {
+    writer.value_double(x);
+  } else {
+    writer.value_str(x);
+  }
+}
+
+template <typename T>
+void json_value(SwmJsonWriter &writer, const void* value) {
+  write_json(writer, *static_cast<const T*>(value));
+}
+
+template <typename Entity, typename T, T Entity::*Member>
+const void* field_value(const Entity &obj) {
+  return &(obj.*Member);
+}
+
+template <typename T, int (*Decode)(const char*, int&, T&)>
+int decode_value(const char* buf, int &index, void* value) {
+  return Decode(buf, index, *static_cast<T*>(value));
+}
+
+template <typename T, void (*Encode)(char*, int&, const T&)>
+void encode_value(char* buf, int &index, const void* value) {
+  Encode(buf, index, *static_cast<const T*>(value));
+}
+
+template <typename T, typename Term>
+void decode_term(const char* buf, int &index, void* value) {
+  Term::decode(buf, index, *static_cast<T*>(value));
+}
+
+template <typename T>
+void print_value(const char* name, const void* value, const std::string &prefix, const char separator) {
+  const T &x = *static_cast<const T*>(value);
+  if constexpr (is_vector_field<T>::value) {
+    if (x.empty()) {
+      std::cerr << prefix << name << ": []" << separator;
+      return;
+    }
+    std::cerr << prefix << name << ": [";
+    for (const auto &element : x) {
+      if constexpr (std::is_base_of_v<SwmEntity, typename T::value_type>) {
+        element.print(prefix, separator);
+      } else {
+        std::cerr << element << ",";
+      }
+    }
+    std::cerr << "]" << separator;
+  } else if constexpr (std::is_base_of_v<SwmEntity, T>) {
+    x.print(prefix, separator);
+  } else {
+    std::cerr << prefix << x << separator;
+  }
+}
+
+// Descriptor of field Member that is decoded and encoded by the given
+// functions (the overloads are selected by the field type) and has schema
+// type Term (see wm_entity_terms.h).
+template <typename Entity, typename T, T Entity::*Member,
+          int (*Decode)(const char*, int&, T&), void (*Encode)(char*, int&, const T&), typename Term>
+constexpr SwmFieldInfo<Entity> field_info(const char* name) {
+  return {name, field_value<Entity, T, Member>, decode_value<T, Decode>, encode_value<T, Encode>, print_value<T>,
+          Term::validate, decode_term<T, Term>, json_value<T>, Term::json};
+}
+
+template <typename Entity>
+int entity_decode_field(const char* buf, int &index, const int pos, Entity &obj) {
+  const auto &info = Entity::FIELDS_INFO[pos];
+  if (info.decode(buf, index, const_cast<void*>(info.value(obj)))) {
+    std::cerr << "Could not init " << Entity::ENTITY_NAME << "::" << info.name << " at pos " << pos + 2 << ": ";
+    ei_print_term(stderr, buf, &index);
+    std::cerr << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// Decodes fields of the mask from a field tuple starting at index (after the
+// record name), the other fields are skipped.
+template <typename Entity>
+int entity_decode_fields(const char* buf, int &index, const uint64_t fields, Entity &obj) {
+  for (int pos = 0; pos < Entity::FIELDS_COUNT; ++pos) {
+    if (fields & (1ull << pos)) {
+      if (entity_decode_field(buf, index, pos, obj)) {
+        return -1;
+      }
+    } else if (etf_skip_term(buf, index)) {
+      std::cerr << "Could not skip " << Entity::ENTITY_NAME << "::" << Entity::FIELDS_INFO[pos].name
+                << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Decodes the entity tuple, first_field is set to the index of its first field
+template <typename Entity>
+int entity_decode(const char* buf, int &index, const uint64_t fields, Entity &obj, int &first_field) {
+  if (!buf) {
+    std::cerr << "Could not decode " << Entity::ENTITY_NAME << ": null buffer" << std::endl;
+    return -1;
+  }
+  int term_size = 0;
+  if (etf_decode_tuple_header(buf, index, term_size)) {
+    std::cerr << "Could not decode " << Entity::ENTITY_NAME << " header from ei buffer: ";
+    ei_print_term(stderr, buf, &index);
+    std::cerr << std::endl;
+    return -1;
+  }
+  if (etf_skip_term(buf, index)) {  // first atom is the term name
+    std::cerr << "Could not skip " << Entity::ENTITY_NAME << " term first atom: ";
+    ei_print_term(stderr, buf, &index);
+    std::cerr << std::endl;
+    return -1;
+  }
+  first_field = index;
+  return entity_decode_fields(buf, index, fields, obj);
+}
+
+// Checks that the term at index is an Entity record with fields of the
+// schema types. On failure the index is set to the offset of the first
+// unexpected term and the path to it is printed.
+template <typename Entity>
+int entity_validate(const char* buf, int &index) {
+  int i = index;
+  int arity = 0;
+  if (etf_decode_tuple_header(buf, i, arity) || arity != Entity::FIELDS_COUNT + 1) {
+    std::cerr << "Not a " << Entity::ENTITY_NAME << " tuple at " << index << std::endl;
+    return -1;
+  }
+  const char* name = nullptr;
+  int name_size = 0;
+  const int name_index = i;
+  if (etf_decode_atom_bytes(buf, i, name, name_size) ||
+      std::string_view(name, static_cast<size_t>(name_size)) != Entity::ENTITY_NAME) {
+    std::cerr << "Not a " << Entity::ENTITY_NAME << " record name at " << name_index << std::endl;
+    index = name_index;
+    return -1;
+  }
+  for (const auto &info : Entity::FIELDS_INFO) {
+    if (info.validate(buf, i)) {
+      std::cerr << "Unexpected term of " << Entity::ENTITY_NAME << "::" << info.name << " at " << i
+                << ", type " << etf_term_tag(buf, i) << std::endl;
+      index = i;
+      return -1;
+    }
+  }
+  index = i;
+  return 0;
+}
+
+// Decodes fields of the mask from an entity tuple that passed entity_validate(),
+// returns index of the first field.
+template <typename Entity>
+int entity_decode_unchecked(const char* buf, int &index, const uint64_t fields, Entity &obj) {
+  index += etf_term_tag(buf, index) == ERL_SMALL_TUPLE_EXT ? 2 : 5;
+  etf_skip_term(buf, index);  // record name
+  const int first_field = index;
+  for (int pos = 0; pos < Entity::FIELDS_COUNT; ++pos) {
+    const auto &info = Entity::FIELDS_INFO[pos];
+    if (fields & (1ull << pos)) {
+      info.decode_unchecked(buf, index, const_cast<void*>(info.value(obj)));
+    } else {
+      etf_skip_term(buf, index);
+    }
+  }
+  return first_field;
+}
+
+template <typename Entity>
+struct SwmEntityTerm {
+  static constexpr bool small_ints = false;
+
+  static int validate(const char* buf, int &index) {
+    return entity_validate<Entity>(buf, index);
+  }
+
+  static void decode(const char* buf, int &index, Entity &obj) {
+    entity_decode_unchecked(buf, index, Entity::FIELD_ALL, obj);
+  }
+
+  static int json(const char* buf, int &index, SwmJsonWriter &writer);
+};
+
+// Two phase decoding of entity lists
+template <typename Entity>
+int entity_list_validate(const char* buf, int &index) {
+  return SwmListTerm<SwmEntityTerm<Entity>>::validate(buf, index);
+}
+
+template <typename Array>
+void entity_list_decode_unchecked(const char* buf, int &index, Array &array) {
+  SwmListTerm<SwmEntityTerm<typename Array::value_type>>::decode(buf, index, array);
+}
+
+template <typename Entity>
+void entity_encode(char* buf, int &index, const Entity &obj) {
+  etf_encode_tuple_header(buf, index, Entity::FIELDS_COUNT + 1);
+  etf_encode_atom(buf, index, Entity::ENTITY_NAME);
+  for (const auto &info : Entity::FIELDS_INFO) {
+    info.encode(buf, index, info.value(obj));
+  }
+}
+
+template <typename Entity>
+void entity_print(const Entity &obj, const std::string &prefix, const char separator) {
+  for (const auto &info : Entity::FIELDS_INFO) {
+    info.print(info.name, info.value(obj), prefix, separator);
+  }
+  std::cerr << std::endl;
+}
+
+// Entities are written as JSON objects with the field names as keys
+template <typename Entity>
+void entity_json(const Entity &obj, SwmJsonWriter &writer) {
+  writer.begin_object();
+  for (const auto &info : Entity::FIELDS_INFO) {
+    writer.key(info.name);
+    info.json(writer, info.value(obj));
+  }
+  writer.end_object();
+}
+
+// Writes the entity tuple at index as JSON without decoding it, the JSON is
+// the same as entity_json() of the decoded entity.
+template <typename Entity>
+int entity_etf_to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  int i = index;
+  int arity = 0;
+  if (etf_decode_tuple_header(buf, i, arity) || arity != Entity::FIELDS_COUNT + 1 ||
+      !etf_is_atom_tag(etf_term_tag(buf, i)) || etf_skip_term(buf, i)) {
+    std::cerr << "Not a " << Entity::ENTITY_NAME << " tuple at " << index << std::endl;
+    return -1;
+  }
+  writer.begin_object();
+  for (const auto &info : Entity::FIELDS_INFO) {
+    writer.key(info.name);
+    if (info.transcode(buf, i, writer)) {
+      std::cerr << "Could not write " << Entity::ENTITY_NAME << "::" << info.name << " at " << i
+                << " to JSON, type " << etf_term_tag(buf, i) << std::endl;
+      return -1;
+    }
+  }
+  writer.end_object();
+  index = i;
+  return 0;
+}
+
+template <typename Entity>
+int SwmEntityTerm<Entity>::json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<Entity>(buf, index, writer);
+}
+
+template <typename Entity>
+int entity_list_etf_to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return SwmListTerm<SwmEntityTerm<Entity>>::json(buf, index, writer);
+}
+
+} // namespace swm
@@ -0,0 +1,139 @@
+#include "wm_entity_graph.h"
+
+#include <iostream>
+
+
+using namespace swm;
+
+namespace {
+
+template <typename Entity>
+int add_ids(const std::vector<Entity> &entities, SwmSymbolTable &symbols) {
+  SwmId::Buffer buf;
+  for (const auto &entity : entities) {
+    const uint32_t index = symbols.add(entity.get_id().str(buf));
+    if (index + 1 != symbols.size()) {
+      std::cerr << "Duplicated " << Entity::ENTITY_NAME << " id: " << entity.get_id() << std::endl;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+uint32_t SwmSymbolTable::add(const std::string_view s) {
+  if (const auto index = indexes.find(s)) {
+    return *index;
+  }
+  const auto index = static_cast<uint32_t>(strings.size());
+  strings.emplace_back(s);
+  indexes.insert(strings.back()) = index;
+  return index;
+}
+
+uint32_t SwmSymbolTable::find(const std::string_view s) const {
+  const auto index = indexes.find(s);
+  return index ? *index : SWM_NO_INDEX;
+}
+
+void SwmSymbolTable::clear() {
+  indexes.clear();
+  strings.clear();
+}
+
+void SwmIndexLists::clear() {
+  indexes.clear();
+  ends.clear();
+}
+
+template <typename Ids>
+void SwmEntityGraph::resolve_list(const Ids &ids, const SwmSymbolTable &symbols, SwmIndexLists &lists) {
+  for (const auto &id : ids) {
+    const uint32_t index = symbols.find(id);
+    if (index == SWM_NO_INDEX) {
+      ++unresolved;
+    } else {
+      lists.push_back(index);
+    }
+  }
+  lists.end_row();
+}
+
+int SwmEntityGraph::resolve(const SwmGrid &grid,
+                            const std::vector<SwmCluster> &clusters,
+                            const std::vector<SwmPartition> &partitions,
+                            const std::vector<SwmNode> &nodes,
+                            const std::vector<SwmJob> &jobs,
+                            const std::vector<SwmTimetable> &timetable) {
+  clear();
+  if (add_ids(clusters, cluster_ids) || add_ids(partitions, partition_ids) ||
+      add_ids(nodes, node_ids) || add_ids(jobs, job_ids)) {
+    clear();
+    return -1;
+  }
+
+  for (const auto &id : grid.get_clusters()) {
+    const uint32_t index = cluster_ids.find(id);
+    if (index == SWM_NO_INDEX) {
+      ++unresolved;
+    } else {
+      grid_clusters.push_back(index);
+    }
+  }
+  for (const auto &cluster : clusters) {
+    resolve_list(cluster.get_partitions(), partition_ids, cluster_partitions);
+  }
+  for (const auto &partition : partitions) {
+    resolve_list(partition.get_partitions(), partition_ids, partition_partitions);
+    resolve_list(partition.get_nodes(), node_ids, partition_nodes);
+  }
+
+  // Parents are node names, the first node with the name is taken
+  SwmHashIndex<std::string_view, uint32_t> node_names;
+  for (uint32_t index = 0; index < nodes.size(); ++index) {
+    const std::string_view name = nodes[index].get_name();
+    if (!node_names.find(name)) {
+      node_names.insert(name) = index;
+    }
+  }
+  node_parents.reserve(nodes.size());
+  for (const auto &node : nodes) {
+    const auto &parent = node.get_parent();
+    const auto index = parent.empty() ? nullptr : node_names.find(parent);
+    if (!parent.empty() && !index) {
+      ++unresolved;
+    }
+    node_parents.push_back(index ? *index : SWM_NO_INDEX);
+  }
+
+  for (const auto &job : jobs) {
+    resolve_list(job.get_nodes(), node_ids, job_nodes);
+  }
+  timetable_jobs.reserve(timetable.size());
+  for (const auto &row : timetable) {
+    const uint32_t index = job_ids.find(row.get_job_id());
+    if (index == SWM_NO_INDEX) {
+      ++unresolved;
+    }
+    timetable_jobs.push_back(index);
+    resolve_list(row.get_job_nodes(), node_ids, timetable_nodes);
+  }
+  return 0;
+}
+
+void SwmEntityGraph::clear() {
+  cluster_ids.clear();
+  partition_ids.clear();
+  node_ids.clear();
+  job_ids.clear();
+  grid_clusters.clear();
+  cluster_partitions.clear();
+  partition_partitions.clear();
+  partition_nodes.clear();
+  node_parents.clear();
+  job_nodes.clear();
+  timetable_jobs.clear();
+  timetable_nodes.clear();
+  unresolved = 0;
+}
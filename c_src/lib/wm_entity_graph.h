@@ -0,0 +1,122 @@
+#pragma once
+
+#include "wm_cluster.h"
+#include "wm_entity_table.h"
+#include "wm_grid.h"
+#include "wm_hash_index.h"
+#include "wm_job.h"
+#include "wm_node.h"
+#include "wm_partition.h"
+#include "wm_timetable.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace swm {
+
+// Dense indexes of strings (e.g. entity ids) and the strings back by index
+class SwmSymbolTable {
+ public:
+  size_t size() const { return strings.size(); }
+  uint32_t add(std::string_view s);  // index of the string, a new one for an unknown string
+  uint32_t find(std::string_view s) const;  // SWM_NO_INDEX for unknown strings
+  std::string_view str(const uint32_t index) const { return strings[index]; }
+  void clear();
+
+ private:
+  std::deque<std::string> strings;  // never move, so the index refers to them
+  SwmHashIndex<std::string_view, uint32_t> indexes;
+};
+
+class SwmIndexRange {
+ public:
+  SwmIndexRange(const uint32_t* first, const uint32_t* last): first(first), last(last) {
+  }
+
+  const uint32_t* begin() const { return first; }
+  const uint32_t* end() const { return last; }
+  size_t size() const { return static_cast<size_t>(last - first); }
+  bool empty() const { return first == last; }
+  uint32_t operator[](const size_t pos) const { return first[pos]; }
+
+ private:
+  const uint32_t* first;
+  const uint32_t* last;
+};
+
+// Index lists of all rows kept in one array
+class SwmIndexLists {
+ public:
+  size_t size() const { return ends.size(); }
+  SwmIndexRange get(const size_t row) const {
+    const uint32_t begin = row ? ends[row - 1] : 0;
+    return SwmIndexRange(indexes.data() + begin, indexes.data() + ends[row]);
+  }
+  void push_back(uint32_t index) { indexes.push_back(index); }
+  void end_row() { ends.push_back(static_cast<uint32_t>(indexes.size())); }
+  void clear();
+
+ private:
+  std::vector<uint32_t> indexes;
+  std::vector<uint32_t> ends;
+};
+
+// Entities linked by dense 32 bit indexes instead of string ids.
+//
+// An entity gets the index of its position in the list it is resolved
+// from, so the entity lists and the arrays of the graph are indexed the
+// same way. References to ids (and node parents, that refer to node names)
+// are rewritten into index lists, references to unknown entities are
+// dropped and counted.
+class SwmEntityGraph {
+ public:
+  int resolve(const SwmGrid &grid,
+              const std::vector<SwmCluster> &clusters,
+              const std::vector<SwmPartition> &partitions,
+              const std::vector<SwmNode> &nodes,
+              const std::vector<SwmJob> &jobs,
+              const std::vector<SwmTimetable> &timetable = {});
+
+  const SwmSymbolTable& get_cluster_ids() const { return cluster_ids; }
+  const SwmSymbolTable& get_partition_ids() const { return partition_ids; }
+  const SwmSymbolTable& get_node_ids() const { return node_ids; }
+  const SwmSymbolTable& get_job_ids() const { return job_ids; }
+
+  SwmIndexRange get_grid_clusters() const {
+    return SwmIndexRange(grid_clusters.data(), grid_clusters.data() + grid_clusters.size());
+  }
+  SwmIndexRange get_cluster_partitions(const uint32_t cluster) const { return cluster_partitions.get(cluster); }
+  SwmIndexRange get_partition_partitions(const uint32_t partition) const { return partition_partitions.get(partition); }
+  SwmIndexRange get_partition_nodes(const uint32_t partition) const { return partition_nodes.get(partition); }
+  uint32_t get_node_parent(const uint32_t node) const { return node_parents[node]; }  // SWM_NO_INDEX for roots
+  SwmIndexRange get_job_nodes(const uint32_t job) const { return job_nodes.get(job); }
+  uint32_t get_timetable_job(const size_t row) const { return timetable_jobs[row]; }  // SWM_NO_INDEX if unknown
+  SwmIndexRange get_timetable_nodes(const size_t row) const { return timetable_nodes.get(row); }
+
+  size_t get_unresolved() const { return unresolved; }
+  void clear();
+
+ private:
+  template <typename Ids>
+  void resolve_list(const Ids &ids, const SwmSymbolTable &symbols, SwmIndexLists &lists);
+
+  SwmSymbolTable cluster_ids;
+  SwmSymbolTable partition_ids;
+  SwmSymbolTable node_ids;
+  SwmSymbolTable job_ids;
+
+  std::vector<uint32_t> grid_clusters;
+  SwmIndexLists cluster_partitions;
+  SwmIndexLists partition_partitions;
+  SwmIndexLists partition_nodes;
+  std::vector<uint32_t> node_parents;
+  SwmIndexLists job_nodes;
+  std::vector<uint32_t> timetable_jobs;
+  SwmIndexLists timetable_nodes;
+  size_t unresolved = 0;
+};
+
+} // namespace swm
@@ -0,0 +1,85 @@
+#include "wm_entity_patch.h"
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
+
+#include <iostream>
+
+
+using namespace swm;
+
+SwmPatch::SwmPatch(const std::string_view entity, const uint64_t revision)
+  : entity(entity), revision(revision) {
+}
+
+void SwmPatch::add(const std::string_view field, const std::string_view value) {
+  int size = 0;
+  etf_encode_tuple_header(nullptr, size, 2);
+  etf_encode_atom(nullptr, size, field);
+  const size_t begin = changes.size();
+  changes.resize(begin + static_cast<size_t>(size));
+  int index = 0;
+  etf_encode_tuple_header(changes.data() + begin, index, 2);
+  etf_encode_atom(changes.data() + begin, index, field);
+  changes.append(value);
+  ++count;
+}
+
+void SwmPatch::encode(char* buf, int &index) const {
+  etf_encode_tuple_header(buf, index, 4);
+  etf_encode_atom(buf, index, "patch");
+  etf_encode_atom(buf, index, entity);
+  etf_encode_uint64(buf, index, revision);
+  if (count) {
+    etf_encode_list_header(buf, index, count);
+    etf_put_bytes(buf, index, changes.data(), changes.size());
+  }
+  etf_encode_empty_list(buf, index);
+}
+
+int SwmPatch::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode " << entity << " patch" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+int SwmPatch::decode(const char* buf, int &index) {
+  int arity = 0;
+  std::string tag;
+  if (etf_decode_tuple_header(buf, index, arity) || arity != 4 ||
+      etf_decode_atom(buf, index, tag) || tag != "patch") {
+    std::cerr << "Could not decode patch at " << index << ": not a patch tuple" << std::endl;
+    return -1;
+  }
+  if (etf_decode_atom(buf, index, entity) || etf_decode_uint64(buf, index, revision)) {
+    std::cerr << "Could not decode patch entity name or revision at " << index << std::endl;
+    return -1;
+  }
+  int list_size = 0;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not decode " << entity << " patch at " << index << ": not a list" << std::endl;
+    return -1;
+  }
+  const int begin = index;
+  for (int n = 0; n < list_size; ++n) {
+    int size = 0;
+    const char* name = nullptr;
+    int name_size = 0;
+    if (etf_term_tag(buf, index) != ERL_SMALL_TUPLE_EXT || etf_decode_tuple_header(buf, index, size) || size != 2 ||
+        etf_decode_atom_bytes(buf, index, name, name_size) || etf_skip_term(buf, index)) {
+      std::cerr << "Could not decode " << entity << " patch field at " << index << std::endl;
+      return -1;
+    }
+  }
+  changes.assign(buf + begin, static_cast<size_t>(index - begin));
+  count = static_cast<size_t>(list_size);
+  if (list_size && etf_decode_list_tail(buf, index)) {
+    std::cerr << "Could not decode " << entity << " patch at " << index << ": improper list" << std::endl;
+    return -1;
+  }
+  return 0;
+}
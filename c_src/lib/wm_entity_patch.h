@@ -0,0 +1,159 @@
+#pragma once
+
+#include "wm_entity_fields.h"
+
+#include <ei.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace swm {
+
+// Field level change set of an entity, encoded as the erlang term
+//
+//   {patch, EntityName, BaseRevision, [{FieldName, Value}]}
+//
+// where BaseRevision is the revision of the entity the patch was made
+// against (0 for entities without revision) and values are encoded the same
+// way as in the entity tuple.
+class SwmPatch {
+ public:
+  SwmPatch() = default;
+  SwmPatch(std::string_view entity, uint64_t revision);
+
+  const std::string& get_entity() const { return entity; }
+  uint64_t get_revision() const { return revision; }
+  size_t size() const { return count; }  // number of changed fields
+  bool empty() const { return count == 0; }
+
+  // Appends the field, value is an encoded term
+  void add(std::string_view field, std::string_view value);
+
+  // Calls fun(field_name, buf, index) for every changed field with the index
+  // of the field value, the function must move the index past the value.
+  template <typename F>
+  int for_each(F &&fun) const {
+    int index = 0;
+    for (size_t n = 0; n < count; ++n) {
+      const char* name = nullptr;
+      int name_size = 0;
+      index += 2;  // tuple header of arity 2
+      etf_decode_atom_bytes(changes.data(), index, name, name_size);
+      if (fun(std::string_view(name, static_cast<size_t>(name_size)), changes.data(), index)) {
+        return -1;
+      }
+    }
+    return 0;
+  }
+
+  void encode(char* buf, int &index) const;
+  int encode(ei_x_buff &x) const;
+  int decode(const char* buf, int &index);
+
+ private:
+  std::string entity;
+  uint64_t revision = 0;
+  size_t count = 0;
+  std::string changes;  // encoded {FieldName, Value} tuples
+};
+
+template <typename Entity, typename = void>
+struct has_revision_field: std::false_type {};
+
+template <typename Entity>
+struct has_revision_field<Entity, std::void_t<decltype(Entity::FIELD_REVISION)>>: std::true_type {};
+
+template <typename Entity>
+uint64_t entity_revision(const Entity &obj) {
+  if constexpr (has_revision_field<Entity>::value) {
+    return obj.get_revision();
+  } else {
+    return 0;
+  }
+}
+
+template <typename Entity>
+void entity_encode_field(const SwmFieldInfo<Entity> &info, const Entity &obj, std::string &value) {
+  int size = 0;
+  info.encode(nullptr, size, info.value(obj));
+  value.resize(static_cast<size_t>(size));
+  int index = 0;
+  info.encode(value.data(), index, info.value(obj));
+}
+
+// Decodes all lazy fields of the entity, the buffer it was decoded from
+// must still be alive
+template <typename Entity>
+int entity_decode_lazy_fields(Entity &obj) {
+  if (obj.get_lazy_fields() && obj.decode_fields(Entity::FIELD_ALL)) {
+    std::cerr << "Could not decode lazy fields of " << Entity::ENTITY_NAME << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// Fields are compared by their encoded values, so lazy fields are decoded
+// first. If they can not be decoded the patch has no entity name and can
+// not be applied.
+template <typename Entity>
+SwmPatch entity_diff(const Entity &old_obj, const Entity &new_obj) {
+  if (old_obj.get_lazy_fields() || new_obj.get_lazy_fields()) {
+    Entity old_copy(old_obj, old_obj.get_allocator());
+    Entity new_copy(new_obj, new_obj.get_allocator());
+    if (entity_decode_lazy_fields(old_copy) || entity_decode_lazy_fields(new_copy)) {
+      return SwmPatch();
+    }
+    return entity_diff(old_copy, new_copy);
+  }
+  SwmPatch patch(Entity::ENTITY_NAME, entity_revision(old_obj));
+  std::string old_value;
+  std::string new_value;
+  for (const auto &info : Entity::FIELDS_INFO) {
+    entity_encode_field(info, old_obj, old_value);
+    entity_encode_field(info, new_obj, new_value);
+    if (old_value != new_value) {
+      patch.add(info.name, new_value);
+    }
+  }
+  return patch;
+}
+
+// Applies the patch if it was made against the current revision of the
+// entity. Either all fields are changed or, on error, none of them. Lazy
+// fields are decoded first, so none of them is replaced by the buffer value
+// after it is patched.
+template <typename Entity>
+int entity_apply(Entity &obj, const SwmPatch &patch) {
+  if (patch.get_entity() != Entity::ENTITY_NAME) {
+    std::cerr << "Could not apply " << patch.get_entity() << " patch to " << Entity::ENTITY_NAME << std::endl;
+    return -1;
+  }
+  if (patch.get_revision() != entity_revision(obj)) {
+    std::cerr << "Could not apply " << Entity::ENTITY_NAME << " patch of revision " << patch.get_revision()
+              << " to revision " << entity_revision(obj) << std::endl;
+    return -1;
+  }
+  Entity result(obj, obj.get_allocator());
+  if (entity_decode_lazy_fields(result)) {
+    return -1;
+  }
+  const int ret = patch.for_each([&result](const std::string_view name, const char* buf, int &index) {
+    for (int pos = 0; pos < Entity::FIELDS_COUNT; ++pos) {
+      if (name == Entity::FIELDS_INFO[pos].name) {
+        return entity_decode_field(buf, index, pos, result);
+      }
+    }
+    std::cerr << "Unknown field in " << Entity::ENTITY_NAME << " patch: " << name << std::endl;
+    return -1;
+  });
+  if (ret) {
+    return -1;
+  }
+  obj = std::move(result);
+  return 0;
+}
+
+} // namespace swm
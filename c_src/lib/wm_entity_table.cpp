@@ -0,0 +1,400 @@
+#include "wm_entity_table.h"
+
+#include "wm_entity_utils.h"
+#include "wm_etf_reader.h"
+#include "wm_job.h"
+#include "wm_node.h"
+#include "wm_resource.h"
+
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <utility>
+
+
+using namespace swm;
+
+namespace {
+
+// Strings longer than 65535 characters are not contiguous in the buffer
+int decode_str_view(const char* buf, int &index, std::string_view &s, std::string &tmp) {
+  const char* data = nullptr;
+  int size = 0;
+  if (etf_decode_bytes(buf, index, data, size) == 0) {
+    s = std::string_view(data, static_cast<size_t>(size));
+    return 0;
+  }
+  if (etf_decode_str_field(buf, index, tmp)) {
+    return -1;
+  }
+  s = tmp;
+  return 0;
+}
+
+int decode_interned_str(const char* buf, int &index, SwmAtom &a) {
+  std::string_view s;
+  std::string tmp;
+  if (decode_str_view(buf, index, s, tmp)) {
+    return -1;
+  }
+  a = SwmAtom(s);
+  return 0;
+}
+
+int64_t days_from_civil(int64_t y, const int64_t m, const int64_t d) {
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const int64_t yoe = y - era * 400;
+  const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// Reads the digits of a time field up to the separator, at least one digit
+bool parse_time_field(const std::string_view s, size_t &pos, const char separator, int64_t &value) {
+  const size_t begin = pos;
+  value = 0;
+  while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9' && pos - begin < 4) {
+    value = value * 10 + (s[pos++] - '0');
+  }
+  if (pos == begin) {
+    return false;
+  }
+  if (separator) {
+    return pos < s.size() && s[pos++] == separator;
+  }
+  return pos == s.size() || s[pos] == '.';  // milliseconds are ignored
+}
+
+// Times written by wm_utils:now_iso8601/1: "Y-M-DTH:M:S" with optional
+// milliseconds ".MS". Fields are not zero padded (e.g. "2026-1-5T3:4:5")
+// and the time is local, it is converted to unix time with the UTC offset
+// of the same hour, which is cached since submit times of jobs are close.
+class SwmTimeParser {
+ public:
+  int64_t parse(const std::string_view s) {  // 0 if the time is unknown
+    int64_t parts[6] = {};
+    const char separators[6] = {'-', '-', 'T', ':', ':', 0};
+    size_t pos = 0;
+    for (size_t i = 0; i < 6; ++i) {
+      if (!parse_time_field(s, pos, separators[i], parts[i])) {
+        return 0;
+      }
+    }
+    if (parts[1] < 1 || parts[1] > 12 || parts[2] < 1 || parts[2] > 31 ||
+        parts[3] > 23 || parts[4] > 59 || parts[5] > 60) {
+      return 0;
+    }
+    const int64_t local_hour = days_from_civil(parts[0], parts[1], parts[2]) * 24 + parts[3];
+    if (!has_offset || local_hour != cached_hour) {
+      struct tm local = {};
+      local.tm_year = static_cast<int>(parts[0] - 1900);
+      local.tm_mon = static_cast<int>(parts[1] - 1);
+      local.tm_mday = static_cast<int>(parts[2]);
+      local.tm_hour = static_cast<int>(parts[3]);
+      local.tm_isdst = -1;
+      const time_t utc = mktime(&local);
+      if (utc == static_cast<time_t>(-1)) {
+        return 0;
+      }
+      has_offset = true;
+      cached_hour = local_hour;
+      utc_offset = local_hour * 3600 - static_cast<int64_t>(utc);
+    }
+    return local_hour * 3600 + parts[4] * 60 + parts[5] - utc_offset;
+  }
+
+ private:
+  bool has_offset = false;
+  int64_t cached_hour = 0;
+  int64_t utc_offset = 0;  // seconds east of UTC
+};
+
+// Calls decode(pos) for every field of an entity tuple
+template <typename Entity, typename Decode>
+int decode_entity_fields(const char* buf, int &index, Decode decode) {
+  int arity = 0;
+  if (etf_decode_tuple_header(buf, index, arity) || arity != Entity::FIELDS_COUNT + 1) {
+    std::cerr << "Could not parse entity tuple at " << index << std::endl;
+    return -1;
+  }
+  if (etf_skip_term(buf, index)) {  // record name
+    return -1;
+  }
+  for (int pos = 0; pos < Entity::FIELDS_COUNT; ++pos) {
+    if (decode(pos)) {
+      std::cerr << "Could not decode field " << pos << " at " << index << std::endl;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Resource names repeat in every row, so the few ones met are interned
+// once per decoded list instead of taking the lock of the atom table
+class SwmNameCache {
+ public:
+  SwmAtom get(const std::string_view name) {
+    for (const auto &entry : entries) {
+      if (entry.first == name) {
+        return entry.second;
+      }
+    }
+    const SwmAtom atom(name);
+    if (entries.size() < max_size) {
+      entries.emplace_back(name, atom);
+    }
+    return atom;
+  }
+
+ private:
+  static constexpr size_t max_size = 16;
+  std::vector<std::pair<std::string, SwmAtom>> entries;
+};
+
+// Appends the resources of a list and their nested resources in pre-order
+int decode_resource_list(const char* buf, int &index, const uint32_t parent, SwmResourceTree &tree, SwmNameCache &names) {
+  constexpr int name_pos = entity_field_pos(SwmResource::FIELD_NAME);
+  constexpr int count_pos = entity_field_pos(SwmResource::FIELD_COUNT);
+  constexpr int resources_pos = entity_field_pos(SwmResource::FIELD_RESOURCES);
+  static_assert(name_pos < resources_pos && count_pos < resources_pos, "nested resources are the last");
+
+  int list_size = 0;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    return -1;
+  }
+  if (list_size == 0) {
+    return 0;
+  }
+  std::string tmp;
+  for (int i = 0; i < list_size; ++i) {
+    std::string_view name;
+    uint64_t count = 0;
+    uint32_t resource = SWM_NO_INDEX;
+    const auto ret = decode_entity_fields<SwmResource>(buf, index, [&](const int pos) {
+      switch (pos) {
+        case name_pos: return decode_str_view(buf, index, name, tmp);
+        case count_pos: return etf_decode_uint64(buf, index, count);
+        case resources_pos:
+          resource = tree.add(parent, names.get(name), count);
+          return decode_resource_list(buf, index, resource, tree, names);
+        default: return etf_skip_term(buf, index);
+      }
+    });
+    if (ret) {
+      return -1;
+    }
+    tree.end_resource(resource);
+  }
+  return etf_decode_list_tail(buf, index);
+}
+
+// Adds the resources of a list to the tree and counts of the top level ones
+// to the columns
+int decode_resources(const char* buf, int &index, const size_t row, SwmResourceTree &tree, SwmResourceColumns &columns,
+                     SwmNameCache &names) {
+  if (decode_resource_list(buf, index, SWM_NO_INDEX, tree, names)) {
+    return -1;
+  }
+  tree.end_row();
+  const auto &atoms = tree.get_names();
+  const auto &counts = tree.get_counts();
+  for (uint32_t resource = tree.get_row_begin(row); resource < tree.get_row_end(row); resource = tree.get_end(resource)) {
+    columns.add(row, atoms[resource], counts[resource]);
+  }
+  return 0;
+}
+
+template <typename Table, typename DecodeRow>
+int decode_rows(const char* buf, int &index, Table &table, DecodeRow decode_row) {
+  int list_size = 0;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse eterm " << index << ": not a list" << std::endl;
+    table.clear();
+    return -1;
+  }
+  for (int i = 0; i < list_size; ++i) {
+    if (decode_row(table.size())) {
+      table.clear();
+      return -1;
+    }
+  }
+  if (list_size && etf_decode_list_tail(buf, index)) {
+    table.clear();
+    return -1;
+  }
+  return 0;
+}
+
+} // namespace
+
+void SwmStringColumn::push_back(const std::string_view s) {
+  chars.append(s);
+  ends.push_back(static_cast<uint32_t>(chars.size()));
+}
+
+void SwmStringColumn::clear() {
+  chars.clear();
+  ends.clear();
+}
+
+const uint64_t* SwmResourceColumns::get_counts(const SwmAtom &name) const {
+  const auto it = std::find(names.begin(), names.end(), name);
+  return it != names.end() ? counts[static_cast<size_t>(it - names.begin())].data() : nullptr;
+}
+
+void SwmResourceColumns::add(const size_t row, const SwmAtom &name, const uint64_t count) {
+  const auto it = std::find(names.begin(), names.end(), name);
+  const auto n = static_cast<size_t>(it - names.begin());
+  if (it == names.end()) {
+    names.push_back(name);
+    counts.emplace_back();
+  }
+  auto &column = counts[n];
+  if (column.size() <= row) {
+    column.resize(row + 1, 0);
+  }
+  column[row] += count;
+}
+
+void SwmResourceColumns::resize(const size_t rows) {
+  for (auto &column : counts) {
+    column.resize(rows, 0);
+  }
+}
+
+void SwmResourceColumns::clear() {
+  names.clear();
+  counts.clear();
+}
+
+uint64_t SwmResourceTree::sum(const uint32_t first, const uint32_t last, const SwmAtom &name) const {
+  uint64_t total = 0;
+  for (uint32_t resource = first; resource < last; ++resource) {
+    total += names[resource] == name ? counts[resource] : 0;
+  }
+  return total;
+}
+
+uint32_t SwmResourceTree::add(const uint32_t parent, const SwmAtom &name, const uint64_t count) {
+  const auto resource = static_cast<uint32_t>(names.size());
+  names.push_back(name);
+  counts.push_back(count);
+  parents.push_back(parent);
+  ends.push_back(resource + 1);
+  return resource;
+}
+
+void SwmResourceTree::clear() {
+  names.clear();
+  counts.clear();
+  parents.clear();
+  ends.clear();
+  row_ends.clear();
+}
+
+void SwmJobTable::clear() {
+  ids.clear();
+  states.clear();
+  priorities.clear();
+  submit_times.clear();
+  requests.clear();
+  request_tree.clear();
+}
+
+void SwmNodeTable::clear() {
+  ids.clear();
+  names.clear();
+  states_power.clear();
+  states_alloc.clear();
+  resources.clear();
+  resource_tree.clear();
+}
+
+int swm::ei_buffer_to_job(const char* buf, int &index, SwmJobTable &table) {
+  constexpr int id_pos = entity_field_pos(SwmJob::FIELD_ID);
+  constexpr int state_pos = entity_field_pos(SwmJob::FIELD_STATE);
+  constexpr int submit_time_pos = entity_field_pos(SwmJob::FIELD_SUBMIT_TIME);
+  constexpr int request_pos = entity_field_pos(SwmJob::FIELD_REQUEST);
+  constexpr int priority_pos = entity_field_pos(SwmJob::FIELD_PRIORITY);
+
+  std::string tmp_id;
+  std::string tmp_time;
+  SwmTimeParser time_parser;
+  SwmNameCache name_cache;
+  const auto ret = decode_rows(buf, index, table, [&](const size_t row) {
+    std::string_view id;
+    SwmAtom state;
+    std::string_view submit_time;
+    uint64_t priority = 0;
+    const auto row_ret = decode_entity_fields<SwmJob>(buf, index, [&](const int pos) {
+      switch (pos) {
+        case id_pos: return decode_str_view(buf, index, id, tmp_id);
+        case state_pos: return decode_interned_str(buf, index, state);
+        case submit_time_pos: return decode_str_view(buf, index, submit_time, tmp_time);
+        case request_pos: return decode_resources(buf, index, row, table.request_tree, table.requests, name_cache);
+        case priority_pos: return etf_decode_uint64(buf, index, priority);
+        default: return etf_skip_term(buf, index);
+      }
+    });
+    if (row_ret) {
+      return -1;
+    }
+    table.ids.push_back(id);
+    table.states.push_back(state);
+    table.submit_times.push_back(time_parser.parse(submit_time));
+    table.priorities.push_back(priority);
+    return 0;
+  });
+  table.requests.resize(table.size());
+  return ret;
+}
+
+int swm::ei_buffer_to_node(const char* buf, int &index, SwmNodeTable &table) {
+  constexpr int id_pos = entity_field_pos(SwmNode::FIELD_ID);
+  constexpr int name_pos = entity_field_pos(SwmNode::FIELD_NAME);
+  constexpr int state_power_pos = entity_field_pos(SwmNode::FIELD_STATE_POWER);
+  constexpr int state_alloc_pos = entity_field_pos(SwmNode::FIELD_STATE_ALLOC);
+  constexpr int resources_pos = entity_field_pos(SwmNode::FIELD_RESOURCES);
+
+  std::string tmp_id;
+  std::string tmp_name;
+  SwmNameCache name_cache;
+  const auto ret = decode_rows(buf, index, table, [&](const size_t row) {
+    std::string_view id;
+    std::string_view name;
+    SwmAtom state_power;
+    SwmAtom state_alloc;
+    const auto row_ret = decode_entity_fields<SwmNode>(buf, index, [&](const int pos) {
+      switch (pos) {
+        case id_pos: return decode_str_view(buf, index, id, tmp_id);
+        case name_pos: return decode_str_view(buf, index, name, tmp_name);
+        case state_power_pos: return ei_buffer_to_atom(buf, index, state_power);
+        case state_alloc_pos: return ei_buffer_to_atom(buf, index, state_alloc);
+        case resources_pos: return decode_resources(buf, index, row, table.resource_tree, table.resources, name_cache);
+        default: return etf_skip_term(buf, index);
+      }
+    });
+    if (row_ret) {
+      return -1;
+    }
+    table.ids.push_back(id);
+    table.names.push_back(name);
+    table.states_power.push_back(state_power);
+    table.states_alloc.push_back(state_alloc);
+    return 0;
+  });
+  table.resources.resize(table.size());
+  return ret;
+}
+
+int swm::ei_buffer_to_resource(const char* buf, int &index, SwmResourceTree &tree) {
+  SwmNameCache name_cache;
+  if (decode_resource_list(buf, index, SWM_NO_INDEX, tree, name_cache)) {
+    std::cerr << "Could not decode resource list at " << index << std::endl;
+    tree.clear();
+    return -1;
+  }
+  tree.end_row();
+  return 0;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "wm_atom.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace swm {
+
+static constexpr uint32_t SWM_NO_INDEX = UINT32_MAX;
+
+// Column-oriented tables of the fields a scheduler filters and scores
+// candidates by. A list of entities is decoded straight into contiguous
+// per-field arrays (all other fields are skipped), so loops over one field
+// of all rows touch only that field and can be vectorized.
+
+// Strings of all rows kept in one buffer
+class SwmStringColumn {
+ public:
+  size_t size() const { return ends.size(); }
+  std::string_view get(size_t row) const {
+    const uint32_t begin = row ? ends[row - 1] : 0;
+    return std::string_view(chars.data() + begin, ends[row] - begin);
+  }
+  void push_back(std::string_view s);
+  void clear();
+
+ private:
+  std::string chars;
+  std::vector<uint32_t> ends;
+};
+
+// Resource counts: one column per resource name with a count for every
+// row, rows without the resource have zero count.
+class SwmResourceColumns {
+ public:
+  const std::vector<SwmAtom>& get_names() const { return names; }
+  const uint64_t* get_counts(const SwmAtom &name) const;  // nullptr for unknown names
+  void add(size_t row, const SwmAtom &name, uint64_t count);
+  void resize(size_t rows);
+  void clear();
+
+ private:
+  std::vector<SwmAtom> names;
+  std::vector<std::vector<uint64_t>> counts;
+};
+
+// Nested resources of all rows (e.g. sockets with cores, nodes with gpus)
+// in contiguous arrays. Resources are kept in pre-order, so the subtree of
+// a resource is the range from it to its end and sums over nested resources
+// are linear scans. Children follow their parent, one after the end of the
+// previous one. Only names (interned) and counts are kept.
+class SwmResourceTree {
+ public:
+  size_t size() const { return names.size(); }
+  size_t rows() const { return row_ends.size(); }
+  uint32_t get_row_begin(size_t row) const { return row ? row_ends[row - 1] : 0; }
+  uint32_t get_row_end(size_t row) const { return row_ends[row]; }
+  const std::vector<SwmAtom>& get_names() const { return names; }
+  const std::vector<uint64_t>& get_counts() const { return counts; }
+  uint32_t get_parent(uint32_t resource) const { return parents[resource]; }  // SWM_NO_INDEX for top level
+  uint32_t get_end(uint32_t resource) const { return ends[resource]; }  // end of the subtree
+
+  template <typename F>
+  void for_each_child(const uint32_t resource, F &&fun) const {
+    for (uint32_t child = resource + 1; child < ends[resource]; child = ends[child]) {
+      fun(child);
+    }
+  }
+
+  // Counts of the resources with the name in the range, as they are, i.e.
+  // counts of nested resources are not multiplied by the parent counts
+  uint64_t sum(uint32_t first, uint32_t last, const SwmAtom &name) const;
+  uint64_t get_row_sum(size_t row, const SwmAtom &name) const {
+    return sum(get_row_begin(row), get_row_end(row), name);
+  }
+  uint64_t get_subtree_sum(uint32_t resource, const SwmAtom &name) const {
+    return sum(resource, ends[resource], name);
+  }
+
+  uint32_t add(uint32_t parent, const SwmAtom &name, uint64_t count);  // ended by end_resource()
+  void end_resource(uint32_t resource) { ends[resource] = static_cast<uint32_t>(names.size()); }
+  void end_row() { row_ends.push_back(static_cast<uint32_t>(names.size())); }
+  void clear();
+
+ private:
+  std::vector<SwmAtom> names;
+  std::vector<uint64_t> counts;
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> ends;
+  std::vector<uint32_t> row_ends;
+};
+
+class SwmJobTable {
+ public:
+  size_t size() const { return ids.size(); }
+  std::string_view get_id(size_t row) const { return ids.get(row); }
+  const std::vector<SwmAtom>& get_states() const { return states; }
+  const std::vector<uint64_t>& get_priorities() const { return priorities; }
+  const std::vector<int64_t>& get_submit_times() const { return submit_times; }  // unix time, 0 if unknown
+  const std::vector<SwmAtom>& get_request_names() const { return requests.get_names(); }
+  const uint64_t* get_request_counts(const SwmAtom &name) const { return requests.get_counts(name); }
+  const SwmResourceTree& get_request_tree() const { return request_tree; }
+  void clear();
+
+ private:
+  friend int ei_buffer_to_job(const char*, int&, SwmJobTable&);
+
+  SwmStringColumn ids;
+  std::vector<SwmAtom> states;
+  std::vector<uint64_t> priorities;
+  std::vector<int64_t> submit_times;
+  SwmResourceColumns requests;
+  SwmResourceTree request_tree;
+};
+
+class SwmNodeTable {
+ public:
+  size_t size() const { return ids.size(); }
+  std::string_view get_id(size_t row) const { return ids.get(row); }
+  std::string_view get_name(size_t row) const { return names.get(row); }
+  const std::vector<SwmAtom>& get_states_power() const { return states_power; }
+  const std::vector<SwmAtom>& get_states_alloc() const { return states_alloc; }
+  const std::vector<SwmAtom>& get_resource_names() const { return resources.get_names(); }
+  const uint64_t* get_resource_counts(const SwmAtom &name) const { return resources.get_counts(name); }
+  const SwmResourceTree& get_resource_tree() const { return resource_tree; }
+  void clear();
+
+ private:
+  friend int ei_buffer_to_node(const char*, int&, SwmNodeTable&);
+
+  SwmStringColumn ids;
+  SwmStringColumn names;
+  std::vector<SwmAtom> states_power;
+  std::vector<SwmAtom> states_alloc;
+  SwmResourceColumns resources;
+  SwmResourceTree resource_tree;
+};
+
+// Rows are appended to the table
+int ei_buffer_to_job(const char* buf, int &index, SwmJobTable &table);
+int ei_buffer_to_node(const char* buf, int &index, SwmNodeTable &table);
+
+// A list of resources is appended to the tree as a row
+int ei_buffer_to_resource(const char* buf, int &index, SwmResourceTree &tree);
+
+} // namespace swm
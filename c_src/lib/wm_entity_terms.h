@@ -0,0 +1,452 @@
+#pragma once
+
+#include "wm_entity_utils.h"
+#include "wm_etf_reader.h"
+#include "wm_json_writer.h"
+
+#include <ei.h>
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+// Schema types of entity fields for the two phase decoding of trusted input.
+//
+// validate() checks that the term at index has the schema type. On success
+// the index is moved past the term, otherwise it is set to the offset of
+// the first term (the term itself or a nested one) of an unexpected type.
+// decode() reads a term that was validated before, so it neither checks
+// tags and sizes nor reports errors. json() transcodes the term to JSON
+// without decoding it into the field type, it returns -1 on unexpected terms.
+
+namespace swm {
+
+// Other terms in string fields (undefined or integer defaults of unset
+// record fields) are decoded as empty strings, see etf_decode_str_field().
+struct SwmStrTerm {
+  static constexpr bool small_ints = false;
+
+  static int validate(const char* buf, int &index) {
+    return etf_is_str_tag(etf_term_tag(buf, index)) ? validate_str(buf, index) : etf_skip_term(buf, index);
+  }
+
+  // Only a string, e.g. a map key
+  static int validate_str(const char* buf, int &index) {
+    switch (etf_term_tag(buf, index)) {
+      case ERL_STRING_EXT:
+      case ERL_BINARY_EXT:
+      case ERL_NIL_EXT:
+        return etf_skip_term(buf, index);
+      case ERL_LIST_EXT: {  // long string
+        const size_t size = etf_get_uint32(buf, index + 1);
+        const int i = index + 5;
+        const size_t valid = etf_scan_small_ints(buf + i, size);
+        if (valid != size) {
+          index = i + 2 * static_cast<int>(valid);  // the first element that is not a character
+          return -1;
+        }
+        const int tail = i + 2 * static_cast<int>(size);
+        if (etf_term_tag(buf, tail) != ERL_NIL_EXT) {
+          index = tail;
+          return -1;
+        }
+        index = tail + 1;
+        return 0;
+      }
+    }
+    return -1;
+  }
+
+  template <typename String>
+  static void decode(const char* buf, int &index, String &s) {
+    const char* data = nullptr;
+    int size = 0;
+    if (etf_decode_bytes(buf, index, data, size)) {
+      etf_decode_str_field(buf, index, s);
+      return;
+    }
+    s.assign(data, static_cast<size_t>(size));
+  }
+
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    const char* data = nullptr;
+    int size = 0;
+    if (etf_decode_bytes(buf, index, data, size) == 0) {
+      writer.value_str(std::string_view(data, static_cast<size_t>(size)));
+      return 0;
+    }
+    std::string s;
+    if (etf_decode_str_field(buf, index, s)) {
+      return -1;
+    }
+    writer.value_str(s);
+    return 0;
+  }
+};
+
+// Strings decoded into SwmId
+struct SwmIdTerm {
+  static constexpr bool small_ints = false;
+
+  static int validate(const char* buf, int &index) {
+    return SwmStrTerm::validate(buf, index);
+  }
+
+  static void decode(const char* buf, int &index, SwmId &id) {
+    ei_buffer_to_id(buf, index, id);
+  }
+
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    return SwmStrTerm::json(buf, index, writer);
+  }
+};
+
+struct SwmAtomTerm {
+  static constexpr bool small_ints = false;
+
+  static int validate(const char* buf, int &index) {
+    return etf_is_atom_tag(etf_term_tag(buf, index)) ? etf_skip_term(buf, index) : -1;
+  }
+
+  static void decode(const char* buf, int &index, SwmAtom &a) {
+    a = SwmAtom(name(buf, index));
+  }
+
+  template <typename String>
+  static void decode(const char* buf, int &index, String &a) {
+    const auto s = name(buf, index);
+    a.assign(s.data(), s.size());
+  }
+
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    if (!etf_is_atom_tag(etf_term_tag(buf, index))) {
+      return -1;
+    }
+    writer.value_atom(name(buf, index));
+    return 0;
+  }
+
+ private:
+  static std::string_view name(const char* buf, int &index) {
+    const bool small = etf_term_tag(buf, index) == ERL_SMALL_ATOM_UTF8_EXT ||
+                       etf_term_tag(buf, index) == ERL_SMALL_ATOM_EXT;
+    const int header = small ? 2 : 3;
+    const auto size = small ? etf_get_uint8(buf, index + 1) : etf_get_uint16(buf, index + 1);
+    const std::string_view s(buf + index + header, size);
+    index += header + static_cast<int>(size);
+    return s;
+  }
+};
+
+struct SwmUint64Term {
+  static constexpr bool small_ints = true;
+
+  static int validate(const char* buf, int &index) {
+    uint64_t n = 0;
+    return etf_decode_uint64(buf, index, n);
+  }
+
+  static void decode(const char* buf, int &index, uint64_t &n) {
+    bool negative = false;
+    etf_decode_big(buf, index, n, negative);
+  }
+
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    uint64_t n = 0;
+    if (etf_decode_uint64(buf, index, n)) {
+      return -1;
+    }
+    writer.value_uint64(n);
+    return 0;
+  }
+};
+
+struct SwmInt64Term {
+  static constexpr bool small_ints = true;
+
+  static int validate(const char* buf, int &index) {
+    int64_t n = 0;
+    return etf_decode_int64(buf, index, n);
+  }
+
+  static void decode(const char* buf, int &index, int64_t &n) {
+    uint64_t magnitude = 0;
+    bool negative = false;
+    etf_decode_big(buf, index, magnitude, negative);
+    n = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+  }
+
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    int64_t n = 0;
+    if (etf_decode_int64(buf, index, n)) {
+      return -1;
+    }
+    writer.value_int64(n);
+    return 0;
+  }
+};
+
+struct SwmDoubleTerm {
+  static constexpr bool small_ints = false;
+
+  static int validate(const char* buf, int &index) {
+    const int tag = etf_term_tag(buf, index);
+    return tag == NEW_FLOAT_EXT || tag == ERL_FLOAT_EXT ? etf_skip_term(buf, index) : -1;
+  }
+
+  static void decode(const char* buf, int &index, double &d) {
+    etf_decode_double(buf, index, d);
+  }
+
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    double d = 0.0;
+    if (etf_decode_double(buf, index, d)) {
+      return -1;
+    }
+    writer.value_double(d);
+    return 0;
+  }
+};
+
+// Generic maps and price maps are rare and small, so their (checked)
+// decoders are used for the decoding of validated terms too.
+struct SwmMapTerm {
+  static constexpr bool small_ints = false;
+
+  static int validate(const char* buf, int &index) {
+    int i = index;
+    int arity = 0;
+    if (etf_decode_map_header(buf, i, arity)) {
+      return -1;
+    }
+    for (int n = 0; n < arity; ++n) {
+      if (SwmStrTerm::validate_str(buf, i)) {
+        index = i;
+        return -1;
+      }
+      const int tag = etf_term_tag(buf, i);
+      const int ret = etf_is_atom_tag(tag) ? SwmAtomTerm::validate(buf, i)
+                    : etf_is_integer_tag(tag) ? SwmInt64Term::validate(buf, i)
+                    : tag == NEW_FLOAT_EXT || tag == ERL_FLOAT_EXT ? SwmDoubleTerm::validate(buf, i)
+                    : SwmStrTerm::validate_str(buf, i);
+      if (ret) {
+        index = i;
+        return -1;
+      }
+    }
+    index = i;
+    return 0;
+  }
+
+  static void decode(const char* buf, int &index, SwmMapStrStr &data) {
+    ei_buffer_to_map(buf, index, data);
+  }
+
+  // Values are written as the strings they are decoded to, so the JSON is
+  // the same as the one of the decoded entity
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    SwmMapStrStr data;
+    if (etf_term_tag(buf, index) != ERL_MAP_EXT || ei_buffer_to_map(buf, index, data)) {
+      return -1;
+    }
+    writer.begin_object();
+    for (const auto &[key, value] : data) {
+      writer.key(key);
+      writer.value_str(value);
+    }
+    writer.end_object();
+    return 0;
+  }
+};
+
+struct SwmPriceMapTerm {
+  static constexpr bool small_ints = false;
+
+  static int validate(const char* buf, int &index) {
+    int i = index;
+    int arity = 0;
+    if (etf_decode_map_header(buf, i, arity)) {
+      return -1;
+    }
+    for (int n = 0; n < arity; ++n) {  // the same alternatives as ei_buffer_to_price_map()
+      const int key = etf_is_atom_tag(etf_term_tag(buf, i)) ? SwmAtomTerm::validate(buf, i)
+                    : SwmStrTerm::validate_str(buf, i);
+      if (key) {
+        index = i;
+        return -1;
+      }
+      const int value = etf_is_integer_tag(etf_term_tag(buf, i)) ? SwmInt64Term::validate(buf, i)
+                      : SwmDoubleTerm::validate(buf, i);
+      if (value) {
+        index = i;
+        return -1;
+      }
+    }
+    index = i;
+    return 0;
+  }
+
+  static void decode(const char* buf, int &index, SwmPriceMap &data) {
+    ei_buffer_to_price_map(buf, index, data);
+  }
+
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    return etf_term_tag(buf, index) == ERL_MAP_EXT ? etf_to_json(buf, index, writer) : -1;
+  }
+};
+
+// Any term, it is referenced in the input buffer (see SwmSharedBufferScope)
+struct SwmAnyTerm {
+  static constexpr bool small_ints = false;
+
+  static int validate(const char* buf, int &index) {
+    return etf_skip_term(buf, index);
+  }
+
+  static void decode(const char* buf, int &index, SwmTermRef &term) {
+    term.assign(buf, index);
+  }
+
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    return etf_to_json(buf, index, writer);
+  }
+};
+
+template <typename First, typename Second>
+struct SwmTupleTerm {
+  static constexpr bool small_ints = false;
+
+  // Only the small tuple form is accepted, as decode() skips its header
+  static int validate(const char* buf, int &index) {
+    if (etf_term_tag(buf, index) != ERL_SMALL_TUPLE_EXT || etf_get_uint8(buf, index + 1) != 2) {
+      return -1;
+    }
+    int i = index + 2;
+    if (First::validate(buf, i) || Second::validate(buf, i)) {
+      index = i;
+      return -1;
+    }
+    index = i;
+    return 0;
+  }
+
+  template <typename Pair>
+  static void decode(const char* buf, int &index, Pair &tuple) {
+    index += 2;  // small tuple header of arity 2
+    First::decode(buf, index, tuple.first);
+    Second::decode(buf, index, tuple.second);
+  }
+
+  // Tuples are written as arrays of two elements
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    int i = index;
+    int arity = 0;
+    if (etf_decode_tuple_header(buf, i, arity) || arity != 2) {
+      return -1;
+    }
+    writer.begin_array();
+    if (First::json(buf, i, writer) || Second::json(buf, i, writer)) {
+      return -1;
+    }
+    writer.end_array();
+    index = i;
+    return 0;
+  }
+};
+
+// Lists of small integers are encoded by erlang as strings
+template <typename Element>
+struct SwmListTerm {
+  static constexpr bool small_ints = false;
+
+  static int validate(const char* buf, int &index) {
+    switch (etf_term_tag(buf, index)) {
+      case ERL_NIL_EXT:
+        index += 1;
+        return 0;
+      case ERL_STRING_EXT:
+        return Element::small_ints ? etf_skip_term(buf, index) : -1;
+      case ERL_LIST_EXT:
+        break;
+      default:
+        return -1;
+    }
+    const auto size = etf_get_uint32(buf, index + 1);
+    int i = index + 5;
+    for (uint32_t n = 0; n < size; ++n) {
+      if (Element::validate(buf, i)) {
+        index = i;
+        return -1;
+      }
+    }
+    if (etf_term_tag(buf, i) != ERL_NIL_EXT) {
+      index = i;
+      return -1;
+    }
+    index = i + 1;
+    return 0;
+  }
+
+  // Elements are created by the vector allocator like in the checked decoders
+  template <typename Array>
+  static void decode(const char* buf, int &index, Array &array) {
+    array.clear();
+    const int tag = etf_term_tag(buf, index);
+    if (tag == ERL_NIL_EXT) {
+      index += 1;
+      return;
+    }
+    if constexpr (Element::small_ints) {
+      if (tag == ERL_STRING_EXT) {
+        const auto size = etf_get_uint16(buf, index + 1);
+        array.reserve(size);
+        for (unsigned n = 0; n < size; ++n) {
+          array.emplace_back(etf_get_uint8(buf, index + 3 + static_cast<int>(n)));
+        }
+        index += 3 + static_cast<int>(size);
+        return;
+      }
+    }
+    const auto size = etf_get_uint32(buf, index + 1);
+    index += 5;
+    array.reserve(size);
+    for (uint32_t n = 0; n < size; ++n) {
+      Element::decode(buf, index, array.emplace_back());
+    }
+    index += 1;  // list tail
+  }
+
+  static int json(const char* buf, int &index, SwmJsonWriter &writer) {
+    int i = index;
+    if constexpr (Element::small_ints) {
+      if (etf_term_tag(buf, i) == ERL_STRING_EXT) {
+        const auto size = etf_get_uint16(buf, i + 1);
+        writer.begin_array();
+        for (unsigned n = 0; n < size; ++n) {
+          writer.value_uint64(etf_get_uint8(buf, i + 3 + static_cast<int>(n)));
+        }
+        writer.end_array();
+        index = i + 3 + static_cast<int>(size);
+        return 0;
+      }
+    }
+    int size = 0;
+    if (etf_decode_list_header(buf, i, size)) {
+      return -1;
+    }
+    writer.begin_array();
+    for (int n = 0; n < size; ++n) {
+      if (Element::json(buf, i, writer)) {
+        return -1;
+      }
+    }
+    writer.end_array();
+    if (size && etf_decode_list_tail(buf, i)) {
+      return -1;
+    }
+    index = i;
+    return 0;
+  }
+};
+
+} // namespace swm
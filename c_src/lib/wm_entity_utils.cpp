@@ -1,55 +1,131 @@
 
 #include "wm_entity_utils.h"
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 #include <iostream>
-#include <new>
 
 
 using namespace swm;
 
-int get_term_type(const char* buf, const int &index) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
+namespace {
+
+// Common part of list decoders for std and std::pmr vectors, elements are
+// created by the vector allocator, so pmr vectors propagate their resource.
+template <typename Array, typename Decode>
+int buffer_to_array(const char* buf, int &index, Array &array, Decode decode, const char* what) {
+  int list_size = 0;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse eterm " << index << ": not a list, type=" << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
-  return term_type;
-}
+  if (list_size == 0) {
+    return 0;
+  }
+  array.resize(list_size);
 
-int get_term_buf_size(const char* buf, const int &index) {
-  // Get buffer size with the term header
-  int tmp_index = index;
-  if (ei_skip_term(buf, &tmp_index)) {
-    std::cerr << "Could not skip ei buffer term to get its size" << std::endl;
+  for (auto &x : array) {
+    if (decode(buf, index, x)) {
+      std::cerr << "Could not init array of " << what << " at " << index << std::endl;
+      return -1;
+    }
+  }
+  if (etf_decode_list_tail(buf, index)) {
+    std::cerr << "Could not parse eterm " << index << ": not a proper list" << std::endl;
     return -1;
   }
-  return tmp_index - index;
+
+  return 0;
 }
 
-int get_term_size(const char* buf, const int &index) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
+template <typename Array>
+int buffer_to_uint64_array(const char* buf, int &index, Array &array) {
+  if (etf_term_tag(buf, index) == ERL_STRING_EXT) {  // list of integers that is incoded by erlang as string
+    const char* data = nullptr;
+    int term_size = 0;
+    etf_decode_bytes(buf, index, data, term_size);
+    array.resize(term_size);
+    for (int i = 0; i < term_size; ++i) {
+      array[i] = static_cast<unsigned char>(data[i]);
+    }
+    return 0;
   }
-  return term_size;
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, uint64_t &x) {
+    return swm::ei_buffer_to_uint64_t(b, i, x);
+  }, "integers");
 }
 
-int swm::ei_buffer_to_tuple_str_str(const char* buf, int &index, SwmTupleStrStr &tuple) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_SMALL_TUPLE_EXT && term_type != ERL_LARGE_TUPLE_EXT) {
-    std::cerr << "Could not parse eterm at (index=" << index << "): not a tuple: " << term_type << std::endl;
+template <typename Map>
+int buffer_to_map(const char* buf, int &index, Map &data) {
+  typedef typename Map::key_type String;
+
+  int map_size = 0;
+  if (etf_decode_map_header(buf, index, map_size)) {
+    std::cerr << "Could not decode map at pos " << index << std::endl;
     return -1;
   }
+
+  for (int i=0; i< map_size; ++i) {
+    String x1(data.get_allocator());
+    if (etf_decode_str(buf, index, x1)) {
+      std::cerr << "Could not decode map key at " << index << ", term type: " << etf_term_tag(buf, index) << std::endl;
+      return -1;
+    }
+    String x2(data.get_allocator());
+    double d_tmp = 0.0;
+    int64_t i_tmp = 0;
+    const auto term_type = etf_term_tag(buf, index);
+    switch (term_type) {
+        case ERL_ATOM_UTF8_EXT:
+        case ERL_SMALL_ATOM_UTF8_EXT:
+        case ERL_ATOM_EXT:
+        case ERL_SMALL_ATOM_EXT:
+          if (etf_decode_atom(buf, index, x2)) {
+            return -1;
+          }
+          break;
+        case NEW_FLOAT_EXT:
+        case ERL_FLOAT_EXT:
+          if (swm::ei_buffer_to_double(buf, index, d_tmp)) {
+            return -1;
+          }
+          x2 = std::to_string(d_tmp);
+          break;
+        case ERL_SMALL_INTEGER_EXT:
+        case ERL_INTEGER_EXT:
+        case ERL_SMALL_BIG_EXT:
+        case ERL_LARGE_BIG_EXT:
+          if (swm::ei_buffer_to_int64_t(buf, index, i_tmp)) {
+            return -1;
+          }
+          x2 = std::to_string(i_tmp);
+          break;
+        case ERL_LIST_EXT:
+        case ERL_STRING_EXT:
+          if (etf_decode_str(buf, index, x2)) {
+            std::cerr << "Could not decode map value at " << index << std::endl;
+            return -1;
+          }
+          break;
+        case ERL_NIL_EXT:
+          index += 1;
+          break;
+        default:
+          // unsupported or empty
+          std::cerr << "Unsupported type of map value: " << term_type << std::endl;
+    }
+    data.emplace(std::move(x1), std::move(x2));
+  }
+
+  return 0;
+}
+
+} // namespace
+
+int swm::ei_buffer_to_tuple_str_str(const char* buf, int &index, SwmTupleStrStr &tuple) {
   int tuple_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &tuple_size)) {
-    std::cerr << "Could not decode tuple header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
+  if (etf_decode_tuple_header(buf, index, tuple_size)) {
+    std::cerr << "Could not parse eterm at (index=" << index << "): not a tuple: " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (ei_buffer_to_str(buf, index, std::get<0>(tuple))) {
@@ -62,16 +138,9 @@ int swm::ei_buffer_to_tuple_str_str(const char* buf, int &index, SwmTupleStrStr
 }
 
 int swm::ei_buffer_to_tuple_atom_str(const char* buf, int &index, SwmTupleAtomStr &tuple) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_SMALL_TUPLE_EXT && term_type != ERL_LARGE_TUPLE_EXT) {
-    std::cerr << "Could not parse eterm (index=" << index << "): not a tuple: " << term_type << std::endl;
-    return -1;
-  }
   int tuple_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &tuple_size)) {
-    std::cerr << "Could not decode tuple header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
+  if (etf_decode_tuple_header(buf, index, tuple_size)) {
+    std::cerr << "Could not parse eterm at (index=" << index << "): not a tuple: " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (tuple_size != 2) {
@@ -88,132 +157,40 @@ int swm::ei_buffer_to_tuple_atom_str(const char* buf, int &index, SwmTupleAtomSt
 }
 
 int swm::ei_buffer_to_tuple_atom_buff(const char* buf, int &index, SwmTupleAtomBuff &tuple) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_SMALL_TUPLE_EXT && term_type != ERL_LARGE_TUPLE_EXT) {
-    std::cerr << "Could not parse eterm at (index=" << index << "): not a tuple: " << term_type << std::endl;
-    return -1;
-  }
   int tuple_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &tuple_size)) {
-    std::cerr << "Could not decode tuple header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
+  if (etf_decode_tuple_header(buf, index, tuple_size)) {
+    std::cerr << "Could not parse eterm at (index=" << index << "): not a tuple: " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (ei_buffer_to_atom(buf, index, std::get<0>(tuple))) {
     return -1;
   }
-  auto &x = std::get<1>(tuple);
-  if (ei_x_new(&x)) {
-    std::cerr << "Could not create ei buffer for SwmTupleAtomBuff" << std::endl;
-    return -1;
-  }
-
-  if (ei_x_append_buf(&x, &buf[index], get_term_buf_size(buf, index))) {
-    std::cerr << "Could not append ei buffer for SwmTupleAtomBuff" << std::endl;
-    return -1;
-  }
-  x.index = 0;
-  ei_skip_term(buf, &index);
-  return 0;
+  return std::get<1>(tuple).assign(buf, index);
 }
 
 
 int swm::ei_buffer_to_tuple_str_str(const char* buf, int &index, std::vector<SwmTupleStrStr> &array) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-    std::cerr << "Could not parse eterm " << index << ": not a list" << std::endl;
-    return -1;
-  }
-
-  int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size)) {
-    std::cerr << "Could not decode ei list header at " << index << std::endl;
-    return -1;
-  }
-  if (list_size == 0) {
-    return 0;
-  }
-  array.resize(list_size);
-
-  for (auto &ss : array) {
-    if (swm::ei_buffer_to_tuple_str_str(buf, index, ss)) {
-      std::cerr << "Could not init array of SwmTupleStrStr at " << index << std::endl;
-      return -1;
-    }
-  }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
-
-  return 0;
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, SwmTupleStrStr &x) {
+    return swm::ei_buffer_to_tuple_str_str(b, i, x);
+  }, "SwmTupleStrStr");
 }
 
 int swm::ei_buffer_to_tuple_atom_str(const char* buf, int &index, std::vector<SwmTupleAtomStr> &array) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-    std::cerr << "Could not parse eterm " << index << ": not a list" << std::endl;
-    return -1;
-  }
-
-  int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size)) {
-    std::cerr << "Could not decode ei list header at " << index << std::endl;
-    return -1;
-  }
-  if (list_size == 0) {
-    return 0;
-  }
-  array.resize(list_size);
-
-  for (auto &ss : array) {
-    if (swm::ei_buffer_to_tuple_atom_str(buf, index, ss)) {
-      std::cerr << "Could not init array of SwmTupleAtomStr at " << index << std::endl;
-      return -1;
-    }
-  }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
-
-  return 0;
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, SwmTupleAtomStr &x) {
+    return swm::ei_buffer_to_tuple_atom_str(b, i, x);
+  }, "SwmTupleAtomStr");
 }
 
 int swm::ei_buffer_to_tuple_atom_buff(const char* buf, int &index, std::vector<SwmTupleAtomBuff> &array) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-    std::cerr << "Could not parse eterm " << index << ": not a list" << std::endl;
-    return -1;
-  }
-
-  int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size)) {
-    std::cerr << "Could not decode ei list header at " << index << std::endl;
-    return -1;
-  }
-  if (list_size == 0) {
-    return 0;
-  }
-  array.resize(list_size);
-
-  for (auto &ss : array) {
-    if (swm::ei_buffer_to_tuple_atom_buff(buf, index, ss)) {
-      std::cerr << "Could not init array of SwmTupleAtomStr at " << index << std::endl;
-      return -1;
-    }
-  }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
-
-  return 0;
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, SwmTupleAtomBuff &x) {
+    return swm::ei_buffer_to_tuple_atom_buff(b, i, x);
+  }, "SwmTupleAtomBuff");
 }
 
 int swm::ei_buffer_to_tuple_atom_uint64(const char* buf, int &index, SwmTupleAtomUint64 &tuple) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_SMALL_TUPLE_EXT && term_type != ERL_LARGE_TUPLE_EXT) {
-    std::cerr << "Could not parse eterm at (index=" << index << "): not a tuple: " << term_type << std::endl;
-    return -1;
-  }
   int tuple_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &tuple_size)) {
-    std::cerr << "Could not decode tuple header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
+  if (etf_decode_tuple_header(buf, index, tuple_size)) {
+    std::cerr << "Could not parse eterm at (index=" << index << "): not a tuple: " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (ei_buffer_to_atom(buf, index, std::get<0>(tuple))) {
@@ -226,52 +203,17 @@ int swm::ei_buffer_to_tuple_atom_uint64(const char* buf, int &index, SwmTupleAto
 }
 
 int swm::ei_buffer_to_atom(const char* buf, int &index, std::string &a) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_ATOM_EXT) {
-    std::cerr << "Could not parse eterm " << index << ": not an atom, but " << term_type << std::endl;
+  if (etf_decode_atom(buf, index, a)) {
+    std::cerr << "Could not parse eterm " << index << ": not an atom, but " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
-  const auto term_size = get_term_size(buf, index);
-  char *tmp = new(std::nothrow) char[term_size + 1];
-  if (ei_decode_atom(buf, &index, tmp)) {
-    std::cerr << "Could not decode atom at " << index << std::endl;
-    return -1;
-  }
-  if (tmp == nullptr) {
-    std::cerr << "Could not decode atom at " << index << ": empty pointer" << std::endl;
-    return -1;
-  }
-  a = std::string(tmp);
-  delete tmp;
   return 0;
 }
 
 int swm::ei_buffer_to_atom(const char* buf, int &index, std::vector<std::string> &array) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-    std::cerr << "Could not parse eterm " << index << ": not a list" << std::endl;
-    return -1;
-  }
-
-  int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size)) {
-    std::cerr << "Could not decode ei list header at " << index << std::endl;
-    return -1;
-  }
-  if (list_size == 0) {
-    return 0;
-  }
-  array.resize(list_size);
-
-  for (auto &a : array) {
-    if (swm::ei_buffer_to_atom(buf, index, a)) {
-      std::cerr << "Could not init array of atoms at " << index << std::endl;
-      return -1;
-    }
-  }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
-
-  return 0;
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, std::string &x) {
+    return swm::ei_buffer_to_atom(b, i, x);
+  }, "atoms");
 }
 
 int swm::ei_buffer_to_str(ei_x_buff &x, std::vector<std::string> &array) {
@@ -279,31 +221,9 @@ int swm::ei_buffer_to_str(ei_x_buff &x, std::vector<std::string> &array) {
 }
 
 int swm::ei_buffer_to_str(const char* buf, int &index, std::vector<std::string> &array) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-    std::cerr << "Could not parse eterm " << index << ": not a list" << std::endl;
-    return -1;
-  }
-
-  int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size)) {
-    std::cerr << "Could not decode ei list header at " << index << std::endl;
-    return -1;
-  }
-  if (list_size == 0) {
-    return 0;
-  }
-  array.resize(list_size);
-
-  for (auto &a : array) {
-    if (swm::ei_buffer_to_str(buf, index, a)) {
-      std::cerr << "Could not init array of strings at " << index << std::endl;
-      return -1;
-    }
-  }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
-
-  return 0;
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, std::string &x) {
+    return swm::ei_buffer_to_str(b, i, x);
+  }, "strings");
 }
 
 int swm::ei_buffer_to_str(ei_x_buff &x, std::string &s) {
@@ -311,267 +231,336 @@ int swm::ei_buffer_to_str(ei_x_buff &x, std::string &s) {
 }
 
 int swm::ei_buffer_to_str(const char* buf, int &index, std::string &s) {
-  int term_size = 0;
-  int term_type = 0;
-  if (ei_get_type(buf, &index, &term_type, &term_size)) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
-  char *tmp = new(std::nothrow) char[term_size + 1];
-
-  if (term_type == ERL_BINARY_EXT) {
-    int iodata_size = 0;
-    if (ei_decode_iodata(buf, &index, &iodata_size, tmp)) {
-      std::cerr << "Could not decode iodata at " << index << std::endl;
-      return -1;
-    }
-    tmp[iodata_size] = '\0';
-  } else if (term_type == ERL_STRING_EXT) {
-    if (ei_decode_string(buf, &index, tmp)) {
-      std::cerr << "Could not decode string at " << index << std::endl;
-      return -1;
-    }
-  } else {  // assume empty string or iodata
-    ei_skip_term(buf, &index);  // last element of a list is empty list
-    return 0;
-  }
-  if (tmp == nullptr) {
-    std::cerr << "Could not decode string (nullptr) at " << index << std::endl;
+  if (etf_decode_str_field(buf, index, s)) {
+    std::cerr << "Could not decode string at " << index << ", term type: " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
-  s = std::string(tmp);
-  delete tmp;
   return 0;
 }
 
 int swm::ei_buffer_to_uint64_t(const char* buf, int &index, uint64_t &n) {
-  const auto term_type = get_term_type(buf, index);
-  if (term_type != ERL_INTEGER_EXT && term_type != ERL_SMALL_INTEGER_EXT && term_type != ERL_SMALL_BIG_EXT) {
-    std::cerr << "Wrong eterm type at " << index << ": not a ulong integer, type is " << term_type << std::endl;
-    return -1;
-  }
-  if (ei_decode_ulong(buf, &index, &n)) {
-    std::cerr << "Could not parse eterm " << index << ": not a ulong integer" << std::endl;
+  if (etf_decode_uint64(buf, index, n)) {
+    std::cerr << "Wrong eterm type at " << index << ": not a ulong integer, type is " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   return 0;
 }
 
 int swm::ei_buffer_to_int64_t(const char* buf, int &index, int64_t &n) {
-  const auto term_type = get_term_type(buf, index);
-  if (term_type != ERL_INTEGER_EXT && term_type != ERL_SMALL_INTEGER_EXT && term_type != ERL_SMALL_BIG_EXT) {
-    std::cerr << "Wrong eterm type " << index << ": not a long integer, type is " << term_type << std::endl;
-    return -1;
-  }
-  if (ei_decode_long(buf, &index, &n)) {
-    std::cerr << "Could not parse eterm " << index << ": not a long integer" << std::endl;
+  if (etf_decode_int64(buf, index, n)) {
+    std::cerr << "Wrong eterm type " << index << ": not a long integer, type is " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   return 0;
 }
 
 int swm::ei_buffer_to_uint64_t(const char* buf, int &index, std::vector<uint64_t> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  if (ei_get_type(buf, &index, &term_type, &term_size)) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+  return buffer_to_uint64_array(buf, index, array);
+}
 
-  if (term_type == ERL_STRING_EXT) {  // list of integers that is incoded by erlang as string
-    array.resize(term_size);
-    char *tmp = new(std::nothrow) char[term_size + 1];
-    if (ei_decode_string(buf, &index, tmp)) {
-      std::cerr << "Could not decode string at " << index << std::endl;
-      return -1;
-    }
-    for (int i = 0; i < term_size; ++i) {
-      array[i] = tmp[i];
-    }
-    delete tmp;
-    return 0;
-  }
+int swm::ei_buffer_to_int64_t(const char* buf, int &index, std::vector<int64_t> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, int64_t &x) {
+    return swm::ei_buffer_to_int64_t(b, i, x);
+  }, "integers");
+}
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-    std::cerr << "Could not parse eterm " << index << ": not a list, type=" << term_type << std::endl;
-    return -1;
-  }
 
-  int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size)) {
-    std::cerr << "Could not decode ei list header at " << index << std::endl;
+int swm::ei_buffer_to_double(const char* buf, int &index, double &n) {
+  if (etf_decode_double(buf, index, n)) {
+    std::cerr << "Wrong eterm type " << index << ": not a float, type is " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
-  if (list_size == 0) {
-    return 0;
-  }
+  return 0;
+}
 
-  array.resize(list_size);
+int swm::ei_buffer_to_double(const char* buf, int &index, std::vector<double> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, double &x) {
+    return swm::ei_buffer_to_double(b, i, x);
+  }, "floats");
+}
 
-  for (auto &a : array) {
-    if (swm::ei_buffer_to_uint64_t(buf, index, a)) {
-      std::cerr << "Could not init array of integers at " << index << std::endl;
-      return -1;
-    }
-  }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+int swm::ei_buffer_to_map(const char* buf, int &index, std::map<std::string, std::string> &data) {
+  return buffer_to_map(buf, index, data);
+}
 
-  return 0;
+int swm::ei_buffer_to_map(const char* buf, int &index, std::vector<std::map<std::string, std::string>> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, std::map<std::string, std::string> &x) {
+    return swm::ei_buffer_to_map(b, i, x);
+  }, "maps");
 }
 
-int swm::ei_buffer_to_int64_t(const char* buf, int &index, std::vector<int64_t> &array) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-    std::cerr << "Could not parse eterm " << index << ": not a list" << std::endl;
+int swm::ei_buffer_to_atom(const char* buf, int &index, std::pmr::string &a) {
+  if (etf_decode_atom(buf, index, a)) {
+    std::cerr << "Could not parse eterm " << index << ": not an atom, but " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
+  return 0;
+}
 
-  int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size)) {
-    std::cerr << "Could not decode ei list header at " << index << std::endl;
+int swm::ei_buffer_to_atom(const char* buf, int &index, SwmAtom &a) {
+  const char* data = nullptr;
+  int size = 0;
+  if (etf_decode_atom_bytes(buf, index, data, size)) {
+    std::cerr << "Could not parse eterm " << index << ": not an atom, but " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
-  if (list_size == 0) {
-    return 0;
-  }
-  array.resize(list_size);
+  a = SwmAtom(std::string_view(data, static_cast<size_t>(size)));
+  return 0;
+}
 
-  for (auto &a : array) {
-    if (swm::ei_buffer_to_int64_t(buf, index, a)) {
-      std::cerr << "Could not init array of integers at " << index << std::endl;
+int swm::ei_buffer_to_id(const char* buf, int &index, SwmId &id) {
+  const char* data = nullptr;
+  int size = 0;
+  if (etf_decode_bytes(buf, index, data, size)) {
+    std::string s;  // ids are short, but could come as a list or be undefined
+    if (etf_decode_str_field(buf, index, s)) {
+      std::cerr << "Could not decode id at " << index << ", term type: " << etf_term_tag(buf, index) << std::endl;
       return -1;
     }
+    id = s.empty() ? SwmId() : SwmId(s);
+    return 0;
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
-
+  id = SwmId(std::string_view(data, static_cast<size_t>(size)));
   return 0;
 }
 
-
-int swm::ei_buffer_to_double(const char* buf, int &index, double &n) {
-
-  const auto term_type = get_term_type(buf, index);
-  if (term_type != ERL_FLOAT_EXT) {
-    std::cerr << "Wrong eterm type " << index << ": not a float, type is " << term_type << std::endl;
-    return -1;
-  }
-  if (ei_decode_double(buf, &index, &n)) {
-    std::cerr << "Could not parse eterm " << index << ": not a float" << std::endl;
+int swm::ei_buffer_to_str(const char* buf, int &index, std::pmr::string &s) {
+  if (etf_decode_str_field(buf, index, s)) {
+    std::cerr << "Could not decode string at " << index << ", term type: " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   return 0;
 }
 
-int swm::ei_buffer_to_double(const char* buf, int &index, std::vector<double> &array) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-    std::cerr << "Could not parse eterm " << index << ": not a list" << std::endl;
-    return -1;
-  }
+int swm::ei_buffer_to_uint64_t(const char* buf, int &index, std::pmr::vector<uint64_t> &array) {
+  return buffer_to_uint64_array(buf, index, array);
+}
 
-  int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size)) {
-    std::cerr << "Could not decode ei list header at " << index << std::endl;
-    return -1;
-  }
-  if (list_size == 0) {
-    return 0;
-  }
-  array.resize(list_size);
+int swm::ei_buffer_to_map(const char* buf, int &index, SwmMapStrStr &data) {
+  return buffer_to_map(buf, index, data);
+}
 
-  for (auto &d : array) {
-    if (swm::ei_buffer_to_double(buf, index, d)) {
-      std::cerr << "Could not init array of floats at " << index << std::endl;
-      return -1;
-    }
-  }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+int swm::ei_buffer_to_tuple_str_str(const char* buf, int &index, std::pmr::vector<SwmTupleStrStr> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, SwmTupleStrStr &x) {
+    return swm::ei_buffer_to_tuple_str_str(b, i, x);
+  }, "SwmTupleStrStr");
+}
 
-  return 0;
+int swm::ei_buffer_to_tuple_atom_str(const char* buf, int &index, std::pmr::vector<SwmTupleAtomStr> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, SwmTupleAtomStr &x) {
+    return swm::ei_buffer_to_tuple_atom_str(b, i, x);
+  }, "SwmTupleAtomStr");
 }
 
-int swm::ei_buffer_to_map(const char* buf, int &index, std::map<std::string, std::string> &data) {
-  int map_size = 0;
-  if (ei_decode_map_header(buf, &index, &map_size)) {
-    std::cerr << "Could not decode map at pos " << index << std::endl;
-    return -1;
-  }
+int swm::ei_buffer_to_tuple_atom_buff(const char* buf, int &index, std::pmr::vector<SwmTupleAtomBuff> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, SwmTupleAtomBuff &x) {
+    return swm::ei_buffer_to_tuple_atom_buff(b, i, x);
+  }, "SwmTupleAtomBuff");
+}
 
-  for (int i=0; i< map_size; ++i) {
-    std::string x1;
-    if (ei_buffer_to_str(buf, index, x1)) {
-      return -1;
+int swm::ei_buffer_to_atom(const char* buf, int &index, std::pmr::vector<std::pmr::string> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, std::pmr::string &x) {
+    return swm::ei_buffer_to_atom(b, i, x);
+  }, "atoms");
+}
+
+int swm::ei_buffer_to_atom(const char* buf, int &index, std::vector<SwmAtom> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, SwmAtom &x) {
+    return swm::ei_buffer_to_atom(b, i, x);
+  }, "atoms");
+}
+
+int swm::ei_buffer_to_atom(const char* buf, int &index, std::pmr::vector<SwmAtom> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, SwmAtom &x) {
+    return swm::ei_buffer_to_atom(b, i, x);
+  }, "atoms");
+}
+
+int swm::ei_buffer_to_str(const char* buf, int &index, std::pmr::vector<std::pmr::string> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, std::pmr::string &x) {
+    return swm::ei_buffer_to_str(b, i, x);
+  }, "strings");
+}
+
+int swm::ei_buffer_to_int64_t(const char* buf, int &index, std::pmr::vector<int64_t> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, int64_t &x) {
+    return swm::ei_buffer_to_int64_t(b, i, x);
+  }, "integers");
+}
+
+int swm::ei_buffer_to_double(const char* buf, int &index, std::pmr::vector<double> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, double &x) {
+    return swm::ei_buffer_to_double(b, i, x);
+  }, "floats");
+}
+
+int swm::ei_buffer_to_map(const char* buf, int &index, std::pmr::vector<SwmMapStrStr> &array) {
+  return buffer_to_array(buf, index, array, [](const char* b, int &i, SwmMapStrStr &x) {
+    return swm::ei_buffer_to_map(b, i, x);
+  }, "maps");
+}
+
+int swm::ei_buffer_to_price_map(const char* buf, int &index, SwmPriceMap &data) {
+  int map_size = 0;
+  if (etf_decode_map_header(buf, index, map_size)) {
+    std::cerr << "Could not decode price map at pos " << index << std::endl;
+    return -1;
+  }
+
+  data.clear();
+  data.reserve(static_cast<size_t>(map_size));
+  std::string long_key;
+  for (int i = 0; i < map_size; ++i) {
+    const char* key = nullptr;
+    int key_size = 0;
+    if (etf_decode_bytes(buf, index, key, key_size) && etf_decode_atom_bytes(buf, index, key, key_size)) {
+      if (etf_decode_str(buf, index, long_key)) {
+        std::cerr << "Could not decode price map key at " << index << ", term type: " << etf_term_tag(buf, index) << std::endl;
+        return -1;
+      }
+      key = long_key.data();
+      key_size = static_cast<int>(long_key.size());
     }
-    std::string x2;
-    double d_tmp = 0.0;
-    int64_t i_tmp = 0;
-    const auto term_type = get_term_type(buf, index);
-    switch (term_type) {
-        case ERL_ATOM_EXT:
-          if (ei_buffer_to_atom(buf, index, x2)) {
-            return -1;
-          }
-          break;
-        case ERL_FLOAT_EXT:
-          if (swm::ei_buffer_to_double(buf, index, d_tmp)) {
-            return -1;
-          }
-          x2 = std::to_string(d_tmp);
-          break;
-        case ERL_SMALL_INTEGER_EXT:
-        case ERL_INTEGER_EXT:
-        case ERL_SMALL_BIG_EXT:
-        case ERL_LARGE_BIG_EXT:
-          if (ei_buffer_to_int64_t(buf, index, i_tmp)) {
-            return -1;
-          }
-          x2 = std::to_string(i_tmp);
-          break;
-        case ERL_LIST_EXT:
-        case ERL_STRING_EXT:
-          if (ei_buffer_to_str(buf, index, x2)) {
-            return -1;
-          }
-          break;
-        case ERL_NIL_EXT:
-          ei_skip_term(buf, &index);
-          break;
-        default:
-          // unsupported or empty
-          std::cerr << "Unsupported type of map value: " << term_type << std::endl;
+    const SwmId account(std::string_view(key, static_cast<size_t>(key_size)));
+
+    SwmPrice price;
+    if (etf_is_integer_tag(etf_term_tag(buf, index))) {
+      int64_t n = 0;
+      if (etf_decode_int64(buf, index, n)) {
+        std::cerr << "Could not decode price map value at " << index << std::endl;
+        return -1;
+      }
+      price = SwmPrice::from_int(n);
+    } else {
+      double x = 0.0;
+      if (etf_decode_double(buf, index, x)) {
+        std::cerr << "Unsupported type of price map value: " << etf_term_tag(buf, index) << std::endl;
+        return -1;
+      }
+      price = SwmPrice::from_double(x);
     }
-    data.emplace(std::move(x1), std::move(x2));
+    data.append(account, price);
   }
+  data.sort();
 
   return 0;
 }
 
-int swm::ei_buffer_to_map(const char* buf, int &index, std::vector<std::map<std::string, std::string>> &array) {
-  const int term_type = get_term_type(buf, index);
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-    std::cerr << "Could not parse eterm " << index << ": not a list" << std::endl;
-    return -1;
-  }
+void swm::encode_atom(char* buf, int &index, const SwmAtom &a) {
+  etf_encode_atom(buf, index, a.str());
+}
 
-  int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size)) {
-    std::cerr << "Could not decode ei list header at " << index << std::endl;
-    return -1;
-  }
-  if (list_size == 0) {
-    return 0;
+void swm::encode_atom(char* buf, int &index, const std::string_view a) {
+  etf_encode_atom(buf, index, a);
+}
+
+void swm::encode_str(char* buf, int &index, const std::string_view s) {
+  etf_encode_str(buf, index, s);
+}
+
+void swm::encode_str(char* buf, int &index, const std::pmr::string &s) {
+  etf_encode_str(buf, index, s);
+}
+
+void swm::encode_id(char* buf, int &index, const SwmId &id) {
+  SwmId::Buffer text;
+  etf_encode_str(buf, index, id.str(text));
+}
+
+void swm::encode_uint64_t(char* buf, int &index, const uint64_t &x) {
+  etf_encode_uint64(buf, index, x);
+}
+
+void swm::encode_int64_t(char* buf, int &index, const int64_t &x) {
+  etf_encode_int64(buf, index, x);
+}
+
+void swm::encode_double(char* buf, int &index, const double &x) {
+  etf_encode_double(buf, index, x);
+}
+
+// Numeric values of generic maps are kept as strings, so they are encoded as strings
+void swm::encode_map(char* buf, int &index, const SwmMapStrStr &data) {
+  etf_encode_map_header(buf, index, data.size());
+  for (const auto &[key, value] : data) {
+    etf_encode_str(buf, index, key);
+    etf_encode_str(buf, index, value);
   }
-  array.resize(list_size);
+}
 
-  for (auto &c : array) {
-    if (swm::ei_buffer_to_map(buf, index, c)) {
-      std::cerr << "Could not parse eterm list element at " << index << std::endl;
-      return -1;
+void swm::encode_price_map(char* buf, int &index, const SwmPriceMap &data) {
+  etf_encode_map_header(buf, index, data.size());
+  SwmId::Buffer text;
+  for (const auto &[account, price] : data) {
+    etf_encode_str(buf, index, account.str(text));
+    if (price.is_integer()) {
+      etf_encode_int64(buf, index, price.get_int());
+    } else {
+      etf_encode_double(buf, index, price.get());
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+}
 
-  return 0;
+void swm::encode_tuple_atom_uint64(char* buf, int &index, const SwmTupleAtomUint64 &tuple) {
+  etf_encode_tuple_header(buf, index, 2);
+  etf_encode_atom(buf, index, tuple.first);
+  etf_encode_uint64(buf, index, tuple.second);
+}
+
+void swm::encode_tuple_str_str(char* buf, int &index, const SwmTupleStrStr &tuple) {
+  etf_encode_tuple_header(buf, index, 2);
+  etf_encode_str(buf, index, tuple.first);
+  etf_encode_str(buf, index, tuple.second);
+}
+
+void swm::encode_tuple_atom_str(char* buf, int &index, const SwmTupleAtomStr &tuple) {
+  etf_encode_tuple_header(buf, index, 2);
+  etf_encode_atom(buf, index, tuple.first);
+  etf_encode_str(buf, index, tuple.second);
+}
+
+// The second element is an already encoded term, a missing one is encoded as undefined
+void swm::encode_tuple_atom_buff(char* buf, int &index, const SwmTupleAtomBuff &tuple) {
+  etf_encode_tuple_header(buf, index, 2);
+  etf_encode_atom(buf, index, tuple.first);
+  const auto &term = tuple.second;
+  if (term.empty()) {
+    etf_encode_atom(buf, index, "undefined");
+  } else {
+    etf_put_bytes(buf, index, term.data(), static_cast<size_t>(term.size()));
+  }
+}
+
+void swm::encode_atom(char* buf, int &index, const std::pmr::vector<SwmAtom> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmAtom &x) { encode_atom(b, i, x); });
+}
+
+void swm::encode_str(char* buf, int &index, const std::pmr::vector<std::pmr::string> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const std::pmr::string &x) { etf_encode_str(b, i, x); });
+}
+
+void swm::encode_uint64_t(char* buf, int &index, const std::pmr::vector<uint64_t> &array) {
+  etf_encode_list(buf, index, array, etf_encode_uint64);
+}
+
+void swm::encode_int64_t(char* buf, int &index, const std::pmr::vector<int64_t> &array) {
+  etf_encode_list(buf, index, array, etf_encode_int64);
+}
+
+void swm::encode_double(char* buf, int &index, const std::pmr::vector<double> &array) {
+  etf_encode_list(buf, index, array, etf_encode_double);
+}
+
+void swm::encode_tuple_str_str(char* buf, int &index, const std::pmr::vector<SwmTupleStrStr> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmTupleStrStr &x) { encode_tuple_str_str(b, i, x); });
+}
+
+void swm::encode_tuple_atom_str(char* buf, int &index, const std::pmr::vector<SwmTupleAtomStr> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmTupleAtomStr &x) { encode_tuple_atom_str(b, i, x); });
+}
+
+void swm::encode_tuple_atom_buff(char* buf, int &index, const std::pmr::vector<SwmTupleAtomBuff> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmTupleAtomBuff &x) { encode_tuple_atom_buff(b, i, x); });
 }
 
 void swm::print_uint64_t(const uint64_t &x, const std::string &prefix, const char separator) {
@@ -595,29 +584,24 @@ void swm::print_tuple_atom_buff(const SwmTupleAtomBuff &x, const std::string &pr
 }
 
 void swm::print_tuple_str_str(const SwmTupleStrStr &x, const std::string &prefix, const char separator) {
-  std::cout << prefix + "{" + std::get<0>(x) + ", " << std::get<1>(x) + "}" + separator;
+  std::cout << prefix << "{" << std::get<0>(x) << ", " << std::get<1>(x) << "}" << separator;
 }
 
 void swm::print_tuple_atom_str(const SwmTupleAtomStr &x, const std::string &prefix, const char separator) {
-  std::cout << prefix + "{" + std::get<0>(x) + ", " << std::get<1>(x) + "}" + separator;
+  std::cout << prefix << "{" << std::get<0>(x) << ", " << std::get<1>(x) << "}" << separator;
 }
 
-std::ostream& operator<<(std::ostream& out, const std::pair<std::string, std::string> &x) {
+std::ostream& operator<<(std::ostream& out, const std::pair<std::pmr::string, std::pmr::string> &x) {
   out << std::string("(") << std::get<0>(x) << std::string(", ") << std::get<1>(x) << std::string(")");
   return out;
 }
 
-std::ostream& operator<<(std::ostream& out, const std::pair<std::string, ei_x_buff> &x) {
-  char* term_str = nullptr;
-  int index = 0;
-  ei_s_print_term(&term_str, std::get<1>(x).buff, &index);
-  out << std::string("(") << std::get<0>(x) << std::string(", ") + term_str + ")";
-  delete[] term_str;
-  return out;
+std::ostream& operator<<(std::ostream& out, const std::pair<std::pmr::string, swm::SwmTermRef> &x) {
+  return out << "(" << std::get<0>(x) << ", " << std::get<1>(x) << ")";
 }
 
-std::ostream& operator<<(std::ostream& out, const std::pair<std::string, uint64_t> &x) {
-  return out << std::string("(") + std::get<0>(x) + ", " + std::to_string(std::get<1>(x)) + ")";
+std::ostream& operator<<(std::ostream& out, const std::pair<std::pmr::string, uint64_t> &x) {
+  return out << "(" << std::get<0>(x) << ", " << std::get<1>(x) << ")";
 }
 
 std::ostream& operator<<(std::ostream& out, const std::map<std::string, std::string> &x) {
@@ -629,3 +613,11 @@ std::ostream& operator<<(std::ostream& out, const std::map<std::string, std::str
   return out;
 }
 
+std::ostream& operator<<(std::ostream& out, const std::pmr::map<std::pmr::string, std::pmr::string> &x) {
+  out << "{";
+  for (const auto &[first, second] : x) {
+    out << first << ": " << second << ", ";
+  }
+  out << "}" << std::endl;
+  return out;
+}
@@ -3,22 +3,38 @@
 
 #include <ei.h>
 
+#include "wm_atom.h"
+#include "wm_id.h"
+#include "wm_price_map.h"
+#include "wm_shared_buffer.h"
+
 #include <cstring>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory_resource>
+#include <string_view>
 
-std::ostream& operator<<(std::ostream& out, const std::pair<std::string, std::string> &x);
-std::ostream& operator<<(std::ostream& out, const std::pair<std::string, ei_x_buff> &x);
-std::ostream& operator<<(std::ostream& out, const std::pair<std::string, uint64_t> &x);
+std::ostream& operator<<(std::ostream& out, const std::pair<std::pmr::string, std::pmr::string> &x);
+std::ostream& operator<<(std::ostream& out, const std::pair<std::pmr::string, swm::SwmTermRef> &x);
+std::ostream& operator<<(std::ostream& out, const std::pair<std::pmr::string, uint64_t> &x);
 std::ostream& operator<<(std::ostream& out, const std::map<std::string, std::string> &x);
+std::ostream& operator<<(std::ostream& out, const std::pmr::map<std::pmr::string, std::pmr::string> &x);
 
 namespace swm {
 
-typedef std::pair<std::string, ei_x_buff> SwmTupleAtomBuff;
-typedef std::pair<std::string, uint64_t> SwmTupleAtomUint64;
-typedef std::pair<std::string, std::string> SwmTupleStrStr;
-typedef std::pair<std::string, std::string> SwmTupleAtomStr;
+using ::operator<<;  // not hidden by operator<<(std::ostream&, const SwmAtom&)
+
+// Entities keep their data in std::pmr containers, so a whole entity tree
+// can be decoded into one memory resource (e.g. a monotonic arena) and
+// released at once. Without an explicit allocator the default resource
+// (new/delete) is used.
+
+typedef std::pair<std::pmr::string, SwmTermRef> SwmTupleAtomBuff;  // any term is referenced in the input buffer
+typedef std::pair<std::pmr::string, uint64_t> SwmTupleAtomUint64;
+typedef std::pair<std::pmr::string, std::pmr::string> SwmTupleStrStr;
+typedef std::pair<std::pmr::string, std::pmr::string> SwmTupleAtomStr;
+typedef std::pmr::map<std::pmr::string, std::pmr::string> SwmMapStrStr;
 
 int ei_buffer_to_tuple_atom_uint64(const char* buf, int &index, SwmTupleAtomUint64 &tuple);
 int ei_buffer_to_tuple_str_str(const char* buf, int &index, SwmTupleStrStr &tuple);
@@ -27,6 +43,9 @@ int ei_buffer_to_tuple_atom_buff(const char* buf, int &index, SwmTupleAtomBuff &
 int ei_buffer_to_tuple_str_str(const char* buf, int &index, std::vector<SwmTupleStrStr> &array);
 int ei_buffer_to_tuple_atom_str(const char* buf, int &index, std::vector<SwmTupleAtomStr> &array);
 int ei_buffer_to_tuple_atom_buff(const char* buf, int &index, std::vector<SwmTupleAtomBuff> &array);
+int ei_buffer_to_tuple_str_str(const char* buf, int &index, std::pmr::vector<SwmTupleStrStr> &array);
+int ei_buffer_to_tuple_atom_str(const char* buf, int &index, std::pmr::vector<SwmTupleAtomStr> &array);
+int ei_buffer_to_tuple_atom_buff(const char* buf, int &index, std::pmr::vector<SwmTupleAtomBuff> &array);
 
 int ei_buffer_to_atom(const char* buf, int &index, std::string& a);
 int ei_buffer_to_atom(const char* buf, int &index, std::vector<std::string> &array);
@@ -41,8 +60,47 @@ int ei_buffer_to_int64_t(const char* buf, int &index, std::vector<int64_t> &arra
 int ei_buffer_to_double(const char* buf, int &index, double &x);
 int ei_buffer_to_double(const char* buf, int &index, std::vector<double> &array);
 
+int ei_buffer_to_atom(const char* buf, int &index, std::pmr::string& a);
+int ei_buffer_to_atom(const char* buf, int &index, SwmAtom &a);
+int ei_buffer_to_id(const char* buf, int &index, SwmId &id);
+int ei_buffer_to_atom(const char* buf, int &index, std::vector<SwmAtom> &array);
+int ei_buffer_to_atom(const char* buf, int &index, std::pmr::vector<SwmAtom> &array);
+int ei_buffer_to_atom(const char* buf, int &index, std::pmr::vector<std::pmr::string> &array);
+int ei_buffer_to_str(const char* buf, int &index, std::pmr::vector<std::pmr::string> &array);
+int ei_buffer_to_str(const char* buf, int &index, std::pmr::string &s);
+int ei_buffer_to_uint64_t(const char* buf, int &index, std::pmr::vector<uint64_t> &array);
+int ei_buffer_to_int64_t(const char* buf, int &index, std::pmr::vector<int64_t> &array);
+int ei_buffer_to_double(const char* buf, int &index, std::pmr::vector<double> &array);
+
 int ei_buffer_to_map(const char* buf, int &index, std::map<std::string, std::string> &data);
 int ei_buffer_to_map(const char* buf, int &index, std::vector<std::map<std::string, std::string>> &array);
+int ei_buffer_to_map(const char* buf, int &index, SwmMapStrStr &data);
+int ei_buffer_to_map(const char* buf, int &index, std::pmr::vector<SwmMapStrStr> &array);
+int ei_buffer_to_price_map(const char* buf, int &index, SwmPriceMap &data);
+
+// Encoders of field values, a null buffer only advances the index (see wm_etf_writer.h)
+void encode_atom(char* buf, int &index, const SwmAtom &a);
+void encode_atom(char* buf, int &index, const std::string_view a);
+void encode_str(char* buf, int &index, const std::string_view s);
+void encode_str(char* buf, int &index, const std::pmr::string &s);
+void encode_id(char* buf, int &index, const SwmId &id);
+void encode_uint64_t(char* buf, int &index, const uint64_t &x);
+void encode_int64_t(char* buf, int &index, const int64_t &x);
+void encode_double(char* buf, int &index, const double &x);
+void encode_map(char* buf, int &index, const SwmMapStrStr &data);
+void encode_price_map(char* buf, int &index, const SwmPriceMap &data);
+void encode_tuple_atom_uint64(char* buf, int &index, const SwmTupleAtomUint64 &tuple);
+void encode_tuple_str_str(char* buf, int &index, const SwmTupleStrStr &tuple);
+void encode_tuple_atom_str(char* buf, int &index, const SwmTupleAtomStr &tuple);
+void encode_tuple_atom_buff(char* buf, int &index, const SwmTupleAtomBuff &tuple);
+void encode_atom(char* buf, int &index, const std::pmr::vector<SwmAtom> &array);
+void encode_str(char* buf, int &index, const std::pmr::vector<std::pmr::string> &array);
+void encode_uint64_t(char* buf, int &index, const std::pmr::vector<uint64_t> &array);
+void encode_int64_t(char* buf, int &index, const std::pmr::vector<int64_t> &array);
+void encode_double(char* buf, int &index, const std::pmr::vector<double> &array);
+void encode_tuple_str_str(char* buf, int &index, const std::pmr::vector<SwmTupleStrStr> &array);
+void encode_tuple_atom_str(char* buf, int &index, const std::pmr::vector<SwmTupleAtomStr> &array);
+void encode_tuple_atom_buff(char* buf, int &index, const std::pmr::vector<SwmTupleAtomBuff> &array);
 
 void print_uint64_t(const uint64_t&, const std::string &prefix, const char separator);
 void print_int64_t(const int64_t&, const std::string &prefix, const char separator);
@@ -0,0 +1,106 @@
+#include "wm_entity_view.h"
+#include "wm_etf_reader.h"
+
+#include <iostream>
+
+
+using namespace swm;
+
+int swm::ei_buffer_to_str(const char* buf, int &index, std::string_view &s) {
+  const char* data = nullptr;
+  int size = 0;
+  if (!etf_is_str_tag(etf_term_tag(buf, index))) {  // a string field that was not set
+    s = std::string_view();
+    return etf_skip_term(buf, index);
+  }
+  if (etf_decode_bytes(buf, index, data, size)) {
+    // Long strings are encoded as lists of integers that are not contiguous
+    std::cerr << "Could not get string view at " << index << ", term type: " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+  s = std::string_view(data, size);
+  return 0;
+}
+
+int swm::ei_buffer_to_atom(const char* buf, int &index, std::string_view &a) {
+  const char* data = nullptr;
+  int size = 0;
+  if (etf_decode_atom_bytes(buf, index, data, size)) {
+    std::cerr << "Could not parse eterm " << index << ": not an atom, but " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+  a = std::string_view(data, size);
+  return 0;
+}
+
+int swm::ei_buffer_to_term(const char* buf, int &index, SwmTermView &term) {
+  term.buf = buf;
+  term.index = index;
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip term at " << index << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+int swm::ei_buffer_to_map(const char* buf, int &index, SwmTermView &term) {
+  return ei_buffer_to_term(buf, index, term);
+}
+
+int swm::ei_buffer_to_tuple_str_str(const char* buf, int &index, SwmTupleStrStrView &tuple) {
+  int tuple_size = 0;
+  if (etf_decode_tuple_header(buf, index, tuple_size) || tuple_size != 2) {
+    std::cerr << "Could not decode pair tuple at " << index << std::endl;
+    return -1;
+  }
+  if (ei_buffer_to_str(buf, index, std::get<0>(tuple))) {
+    return -1;
+  }
+  return ei_buffer_to_str(buf, index, std::get<1>(tuple));
+}
+
+int swm::ei_buffer_to_tuple_atom_str(const char* buf, int &index, SwmTupleAtomStrView &tuple) {
+  int tuple_size = 0;
+  if (etf_decode_tuple_header(buf, index, tuple_size) || tuple_size != 2) {
+    std::cerr << "Could not decode pair tuple at " << index << std::endl;
+    return -1;
+  }
+  if (ei_buffer_to_atom(buf, index, std::get<0>(tuple))) {
+    return -1;
+  }
+  return ei_buffer_to_str(buf, index, std::get<1>(tuple));
+}
+
+int swm::ei_buffer_to_tuple_atom_buff(const char* buf, int &index, SwmTupleAtomBuffView &tuple) {
+  int tuple_size = 0;
+  if (etf_decode_tuple_header(buf, index, tuple_size) || tuple_size != 2) {
+    std::cerr << "Could not decode pair tuple at " << index << std::endl;
+    return -1;
+  }
+  if (ei_buffer_to_atom(buf, index, std::get<0>(tuple))) {
+    return -1;
+  }
+  return ei_buffer_to_term(buf, index, std::get<1>(tuple));
+}
+
+int swm::skip_entity_fields(const char* buf, int &index, int *offsets, const int fields_count) {
+  int term_size = 0;
+  if (etf_decode_tuple_header(buf, index, term_size)) {
+    std::cerr << "Could not decode entity view header at " << index << std::endl;
+    return -1;
+  }
+  if (term_size < fields_count + 1) {
+    std::cerr << "Entity tuple is too short for the view: " << term_size << std::endl;
+    return -1;
+  }
+  for (int i = 0; i < term_size; ++i) {
+    if (i > 0 && i <= fields_count) {  // first atom is the term name
+      offsets[i - 1] = index;
+    }
+    if (etf_skip_term(buf, index)) {
+      std::cerr << "Could not skip entity field " << i << " at " << index << std::endl;
+      return -1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "wm_etf_reader.h"
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace swm {
+
+// Read-only views are thin handles into an ETF buffer owned by the caller.
+// They never copy strings or nested terms, so the buffer must outlive them.
+
+struct SwmTermView {
+  const char* buf = nullptr;
+  int index = 0;
+};
+
+typedef std::pair<std::string_view, std::string_view> SwmTupleStrStrView;
+typedef std::pair<std::string_view, std::string_view> SwmTupleAtomStrView;
+typedef std::pair<std::string_view, SwmTermView> SwmTupleAtomBuffView;
+
+int ei_buffer_to_str(const char* buf, int &index, std::string_view &s);
+int ei_buffer_to_atom(const char* buf, int &index, std::string_view &a);
+int ei_buffer_to_term(const char* buf, int &index, SwmTermView &term);
+int ei_buffer_to_map(const char* buf, int &index, SwmTermView &term);
+int ei_buffer_to_tuple_str_str(const char* buf, int &index, SwmTupleStrStrView &tuple);
+int ei_buffer_to_tuple_atom_str(const char* buf, int &index, SwmTupleAtomStrView &tuple);
+int ei_buffer_to_tuple_atom_buff(const char* buf, int &index, SwmTupleAtomBuffView &tuple);
+
+int skip_entity_fields(const char* buf, int &index, int *offsets, const int fields_count);
+
+template <typename T, int (*Decode)(const char*, int&, T&)>
+T get_view_value(const char* buf, int index) {
+  T value{};
+  if (buf) {
+    Decode(buf, index, value);
+  }
+  return value;
+}
+
+// Lazy list over ETF list elements. Lists of small integers are encoded by
+// erlang as STRING_EXT, such lists are iterated byte by byte.
+template <typename T, int (*Decode)(const char*, int&, T&)>
+class SwmListView {
+ public:
+  class iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef T reference;
+
+    iterator(const char* buf, int index, int left, bool packed)
+      : buf(buf), index(index), left(left), packed(packed) {
+    }
+
+    T operator*() const {
+      T value{};
+      if constexpr (std::is_arithmetic_v<T>) {
+        if (packed) {
+          return static_cast<T>(static_cast<unsigned char>(buf[index]));
+        }
+      }
+      int tmp_index = index;
+      Decode(buf, tmp_index, value);
+      return value;
+    }
+
+    iterator& operator++() {
+      if (packed) {
+        ++index;
+      } else if (etf_skip_term(buf, index)) {
+        left = 1;  // stop iteration on broken buffer
+      }
+      --left;
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const iterator &other) const { return left == other.left; }
+    bool operator!=(const iterator &other) const { return left != other.left; }
+
+   private:
+    const char* buf;
+    int index;
+    int left;
+    bool packed;
+  };
+
+  SwmListView() {
+  }
+
+  SwmListView(const char* buf, int index): buf(buf) {
+    if (!buf) {
+      return;
+    }
+    if (etf_term_tag(buf, index) == ERL_STRING_EXT) {
+      packed = true;
+      count = static_cast<int>(etf_get_uint16(buf, index + 1));
+      first = index + 3;  // tag and 2 bytes of length
+    } else if (etf_decode_list_header(buf, index, count) == 0) {
+      first = index;
+    }
+  }
+
+  int size() const { return count; }
+  bool empty() const { return count == 0; }
+  iterator begin() const { return iterator(buf, first, count, packed); }
+  iterator end() const { return iterator(buf, first, 0, packed); }
+
+ private:
+  const char* buf = nullptr;
+  int first = 0;
+  int count = 0;
+  bool packed = false;
+};
+
+} // namespace swm
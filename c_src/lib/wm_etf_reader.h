@@ -0,0 +1,360 @@
+#pragma once
+
+#include <ei.h>
+
+#include "wm_etf_scan.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Header-only reader of the erlang external term format.
+//
+// Unlike the ei_get_type() + ei_decode_*() pair each function looks at the
+// term tag once and decodes the term directly into the destination, so no
+// term header is parsed twice and no temporary buffers are allocated.
+// Functions return 0 on success and -1 if the term has an unexpected type,
+// the index is moved past the term only on success.
+
+namespace swm {
+
+inline unsigned etf_get_uint8(const char* buf, const int index) {
+  return static_cast<unsigned char>(buf[index]);
+}
+
+inline unsigned etf_get_uint16(const char* buf, const int index) {
+  return (etf_get_uint8(buf, index) << 8) | etf_get_uint8(buf, index + 1);
+}
+
+inline uint32_t etf_get_uint32(const char* buf, const int index) {
+  return (static_cast<uint32_t>(etf_get_uint8(buf, index)) << 24) |
+         (static_cast<uint32_t>(etf_get_uint8(buf, index + 1)) << 16) |
+         (static_cast<uint32_t>(etf_get_uint8(buf, index + 2)) << 8) |
+         static_cast<uint32_t>(etf_get_uint8(buf, index + 3));
+}
+
+inline int etf_term_tag(const char* buf, const int index) {
+  return static_cast<int>(etf_get_uint8(buf, index));
+}
+
+inline bool etf_is_atom_tag(const int tag) {
+  return tag == ERL_ATOM_UTF8_EXT || tag == ERL_SMALL_ATOM_UTF8_EXT || tag == ERL_ATOM_EXT || tag == ERL_SMALL_ATOM_EXT;
+}
+
+inline bool etf_is_integer_tag(const int tag) {
+  return tag == ERL_SMALL_INTEGER_EXT || tag == ERL_INTEGER_EXT || tag == ERL_SMALL_BIG_EXT;
+}
+
+inline bool etf_is_str_tag(const int tag) {
+  return tag == ERL_STRING_EXT || tag == ERL_BINARY_EXT || tag == ERL_NIL_EXT || tag == ERL_LIST_EXT;
+}
+
+// Contiguous payload of STRING_EXT, BINARY_EXT or NIL_EXT (empty string)
+inline int etf_decode_bytes(const char* buf, int &index, const char* &data, int &size) {
+  switch (etf_term_tag(buf, index)) {
+    case ERL_STRING_EXT:
+      size = static_cast<int>(etf_get_uint16(buf, index + 1));
+      data = buf + index + 3;
+      index += 3 + size;
+      return 0;
+    case ERL_BINARY_EXT:
+      size = static_cast<int>(etf_get_uint32(buf, index + 1));
+      data = buf + index + 5;
+      index += 5 + size;
+      return 0;
+    case ERL_NIL_EXT:
+      size = 0;
+      data = buf + index;
+      index += 1;
+      return 0;
+  }
+  return -1;
+}
+
+inline int etf_decode_atom_bytes(const char* buf, int &index, const char* &data, int &size) {
+  switch (etf_term_tag(buf, index)) {
+    case ERL_SMALL_ATOM_UTF8_EXT:
+    case ERL_SMALL_ATOM_EXT:
+      size = static_cast<int>(etf_get_uint8(buf, index + 1));
+      data = buf + index + 2;
+      index += 2 + size;
+      return 0;
+    case ERL_ATOM_UTF8_EXT:
+    case ERL_ATOM_EXT:
+      size = static_cast<int>(etf_get_uint16(buf, index + 1));
+      data = buf + index + 3;
+      index += 3 + size;
+      return 0;
+  }
+  return -1;
+}
+
+// Strings longer than 65535 characters are encoded by erlang as lists of
+// small integers, they are unpacked by etf_unpack_small_ints().
+template <typename String>
+int etf_decode_str(const char* buf, int &index, String &s) {
+  const char* data = nullptr;
+  int size = 0;
+  if (etf_decode_bytes(buf, index, data, size) == 0) {
+    s.assign(data, static_cast<size_t>(size));
+    return 0;
+  }
+  if (etf_term_tag(buf, index) != ERL_LIST_EXT) {
+    return -1;
+  }
+  const size_t list_size = etf_get_uint32(buf, index + 1);
+  const int i = index + 5;
+  s.resize(list_size);
+  if (etf_unpack_small_ints(buf + i, list_size, &s[0]) != list_size) {
+    s.clear();
+    return -1;
+  }
+  const int tail = i + 2 * static_cast<int>(list_size);
+  if (etf_term_tag(buf, tail) != ERL_NIL_EXT) {
+    s.clear();
+    return -1;
+  }
+  index = tail + 1;
+  return 0;
+}
+
+template <typename String>
+int etf_decode_atom(const char* buf, int &index, String &a) {
+  const char* data = nullptr;
+  int size = 0;
+  if (etf_decode_atom_bytes(buf, index, data, size)) {
+    return -1;
+  }
+  a.assign(data, static_cast<size_t>(size));
+  return 0;
+}
+
+// Small big integers are accepted if they fit into 64 bits
+inline int etf_decode_big(const char* buf, int &index, uint64_t &magnitude, bool &negative) {
+  switch (etf_term_tag(buf, index)) {
+    case ERL_SMALL_INTEGER_EXT:
+      magnitude = etf_get_uint8(buf, index + 1);
+      negative = false;
+      index += 2;
+      return 0;
+    case ERL_INTEGER_EXT: {
+      const auto n = static_cast<int32_t>(etf_get_uint32(buf, index + 1));
+      negative = n < 0;
+      magnitude = negative ? static_cast<uint64_t>(-static_cast<int64_t>(n)) : static_cast<uint64_t>(n);
+      index += 5;
+      return 0;
+    }
+    case ERL_SMALL_BIG_EXT: {
+      const auto arity = etf_get_uint8(buf, index + 1);
+      if (arity > sizeof(uint64_t)) {
+        return -1;
+      }
+      negative = etf_get_uint8(buf, index + 2) != 0;
+      magnitude = 0;
+      for (unsigned i = 0; i < arity; ++i) {
+        magnitude |= static_cast<uint64_t>(etf_get_uint8(buf, index + 3 + static_cast<int>(i))) << (8 * i);
+      }
+      index += 3 + static_cast<int>(arity);
+      return 0;
+    }
+  }
+  return -1;
+}
+
+inline int etf_decode_uint64(const char* buf, int &index, uint64_t &n) {
+  int tmp_index = index;
+  uint64_t magnitude = 0;
+  bool negative = false;
+  if (etf_decode_big(buf, tmp_index, magnitude, negative) || (negative && magnitude)) {
+    return -1;
+  }
+  n = magnitude;
+  index = tmp_index;
+  return 0;
+}
+
+inline int etf_decode_int64(const char* buf, int &index, int64_t &n) {
+  int tmp_index = index;
+  uint64_t magnitude = 0;
+  bool negative = false;
+  if (etf_decode_big(buf, tmp_index, magnitude, negative)) {
+    return -1;
+  }
+  if (negative) {
+    if (magnitude > static_cast<uint64_t>(INT64_MAX) + 1) {
+      return -1;
+    }
+    n = static_cast<int64_t>(0 - magnitude);
+  } else {
+    if (magnitude > static_cast<uint64_t>(INT64_MAX)) {
+      return -1;
+    }
+    n = static_cast<int64_t>(magnitude);
+  }
+  index = tmp_index;
+  return 0;
+}
+
+inline int etf_decode_double(const char* buf, int &index, double &d) {
+  switch (etf_term_tag(buf, index)) {
+    case NEW_FLOAT_EXT: {
+      const uint64_t bits = (static_cast<uint64_t>(etf_get_uint32(buf, index + 1)) << 32) |
+                            etf_get_uint32(buf, index + 5);
+      std::memcpy(&d, &bits, sizeof(d));
+      index += 9;
+      return 0;
+    }
+    case ERL_FLOAT_EXT:  // textual float of old erlang versions
+      return ei_decode_double(buf, &index, &d) < 0 ? -1 : 0;
+  }
+  return -1;
+}
+
+inline int etf_decode_tuple_header(const char* buf, int &index, int &arity) {
+  switch (etf_term_tag(buf, index)) {
+    case ERL_SMALL_TUPLE_EXT:
+      arity = static_cast<int>(etf_get_uint8(buf, index + 1));
+      index += 2;
+      return 0;
+    case ERL_LARGE_TUPLE_EXT:
+      arity = static_cast<int>(etf_get_uint32(buf, index + 1));
+      index += 5;
+      return 0;
+  }
+  return -1;
+}
+
+// Empty list is decoded completely, a non-empty list must be finished
+// with etf_decode_list_tail() after its elements.
+inline int etf_decode_list_header(const char* buf, int &index, int &arity) {
+  switch (etf_term_tag(buf, index)) {
+    case ERL_LIST_EXT:
+      arity = static_cast<int>(etf_get_uint32(buf, index + 1));
+      index += 5;
+      return 0;
+    case ERL_NIL_EXT:
+      arity = 0;
+      index += 1;
+      return 0;
+  }
+  return -1;
+}
+
+inline int etf_decode_list_tail(const char* buf, int &index) {
+  if (etf_term_tag(buf, index) != ERL_NIL_EXT) {
+    return -1;  // improper lists are not used by swm entities
+  }
+  index += 1;
+  return 0;
+}
+
+inline int etf_decode_map_header(const char* buf, int &index, int &arity) {
+  if (etf_term_tag(buf, index) != ERL_MAP_EXT) {
+    return -1;
+  }
+  arity = static_cast<int>(etf_get_uint32(buf, index + 1));
+  index += 5;
+  return 0;
+}
+
+// Skips terms used by swm entities without libei, other terms
+// (pids, references, funs) are delegated to ei_skip_term().
+inline int etf_skip_term(const char* buf, int &index) {
+  const int tag = etf_term_tag(buf, index);
+  switch (tag) {
+    case ERL_SMALL_INTEGER_EXT:
+      index += 2;
+      return 0;
+    case ERL_INTEGER_EXT:
+      index += 5;
+      return 0;
+    case NEW_FLOAT_EXT:
+      index += 9;
+      return 0;
+    case ERL_NIL_EXT:
+      index += 1;
+      return 0;
+    case ERL_SMALL_ATOM_UTF8_EXT:
+    case ERL_SMALL_ATOM_EXT:
+      index += 2 + static_cast<int>(etf_get_uint8(buf, index + 1));
+      return 0;
+    case ERL_ATOM_UTF8_EXT:
+    case ERL_ATOM_EXT:
+    case ERL_STRING_EXT:
+      index += 3 + static_cast<int>(etf_get_uint16(buf, index + 1));
+      return 0;
+    case ERL_BINARY_EXT:
+      index += 5 + static_cast<int>(etf_get_uint32(buf, index + 1));
+      return 0;
+    case ERL_SMALL_BIG_EXT:
+      index += 3 + static_cast<int>(etf_get_uint8(buf, index + 1));
+      return 0;
+    case ERL_SMALL_TUPLE_EXT:
+    case ERL_LARGE_TUPLE_EXT:
+    case ERL_LIST_EXT:
+    case ERL_MAP_EXT: {
+      int i = index;
+      int arity = 0;
+      if (tag == ERL_SMALL_TUPLE_EXT || tag == ERL_LARGE_TUPLE_EXT) {
+        etf_decode_tuple_header(buf, i, arity);
+      } else if (tag == ERL_LIST_EXT) {
+        etf_decode_list_header(buf, i, arity);
+        const auto small_ints = static_cast<int>(etf_scan_small_ints(buf + i, static_cast<size_t>(arity)));
+        i += 2 * small_ints;
+        arity -= small_ints;
+        ++arity;  // list tail
+      } else {
+        etf_decode_map_header(buf, i, arity);
+        arity *= 2;
+      }
+      for (int n = 0; n < arity; ++n) {
+        if (etf_skip_term(buf, i)) {
+          return -1;
+        }
+      }
+      index = i;
+      return 0;
+    }
+  }
+  return ei_skip_term(buf, &index) < 0 ? -1 : 0;
+}
+
+// String fields of erlang records that were never set hold other terms,
+// e.g. undefined or an integer default. Such a term is skipped and the
+// string is left empty.
+template <typename String>
+int etf_decode_str_field(const char* buf, int &index, String &s) {
+  if (etf_is_str_tag(etf_term_tag(buf, index))) {
+    return etf_decode_str(buf, index, s);
+  }
+  s.clear();
+  return etf_skip_term(buf, index);
+}
+
+// Records the start of every element of a list without decoding them, so
+// the elements can be decoded independently. The index is moved past the list.
+inline int etf_list_offsets(const char* buf, int &index, std::vector<int> &offsets) {
+  int i = index;
+  int arity = 0;
+  if (etf_decode_list_header(buf, i, arity)) {
+    return -1;
+  }
+  if (arity == 0) {
+    index = i;
+    return 0;
+  }
+  offsets.reserve(offsets.size() + static_cast<size_t>(arity));
+  for (int n = 0; n < arity; ++n) {
+    offsets.push_back(i);
+    if (etf_skip_term(buf, i)) {
+      return -1;
+    }
+  }
+  if (etf_decode_list_tail(buf, i)) {
+    return -1;
+  }
+  index = i;
+  return 0;
+}
+
+} // namespace swm
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <ei.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Vectorized scanning of flat ETF lists of SMALL_INTEGER_EXT elements.
+//
+// Erlang encodes strings longer than 65535 characters (and other long lists
+// of bytes) as LIST_EXT where every element is two bytes: the tag and the
+// value. Such lists are checked and unpacked 8 (SSE2) or 16 (AVX2) elements
+// per instruction. AVX2 is used when the code is built with -mavx2, SSE2 is
+// always available on x86-64, other platforms use the scalar loop.
+//
+// Every remaining list element takes at least one byte and the list is
+// followed by its tail, so a vector load is done only while there are more
+// elements left than bytes loaded, and never reads past the list.
+
+namespace swm {
+
+// Returns number of consecutive SMALL_INTEGER_EXT elements at the start of
+// the list elements, at most count.
+inline size_t etf_scan_small_ints(const char* p, const size_t count) {
+  size_t n = 0;
+#if defined(__AVX2__)
+  const __m256i tags = _mm256_set1_epi8(ERL_SMALL_INTEGER_EXT);
+  for (; count - n >= 32; n += 16) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 2 * n));
+    const auto eq = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, tags)));
+    if ((eq & 0x55555555u) != 0x55555555u) {
+      break;
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i tags_128 = _mm_set1_epi8(ERL_SMALL_INTEGER_EXT);
+  for (; count - n >= 16; n += 8) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2 * n));
+    const auto eq = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, tags_128)));
+    if ((eq & 0x5555u) != 0x5555u) {
+      break;
+    }
+  }
+#endif
+  while (n < count && static_cast<unsigned char>(p[2 * n]) == ERL_SMALL_INTEGER_EXT) {
+    ++n;
+  }
+  return n;
+}
+
+// Copies values of consecutive SMALL_INTEGER_EXT elements into out, returns
+// number of copied values (see etf_scan_small_ints()).
+inline size_t etf_unpack_small_ints(const char* p, const size_t count, char* out) {
+  size_t n = 0;
+#if defined(__SSE2__)
+  const __m128i tags = _mm_set1_epi8(ERL_SMALL_INTEGER_EXT);
+  for (; count - n >= 32; n += 16) {
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2 * n));
+    const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2 * n + 16));
+    const auto eq = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lo, tags))) |
+                    (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(hi, tags))) << 16);
+    if ((eq & 0x55555555u) != 0x55555555u) {
+      break;
+    }
+    // Values are the high bytes of 16-bit lanes
+    const __m128i values = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), values);
+  }
+#endif
+  while (n < count && static_cast<unsigned char>(p[2 * n]) == ERL_SMALL_INTEGER_EXT) {
+    out[n] = p[2 * n + 1];
+    ++n;
+  }
+  return n;
+}
+
+} // namespace swm
@@ -0,0 +1,233 @@
+#include "wm_etf_stream.h"
+#include "wm_etf_reader.h"
+#include "wm_io.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+#define INFLATE_STEP_SIZE 4096
+
+
+using namespace swm;
+
+namespace {
+
+// Finds the end of the term at index if all its bytes are within size.
+// Returns 0 if the term is complete, 1 if it is not (end is then set to
+// the buffer size known to be needed) and -1 for unsupported terms.
+int scan_term(const char* buf, const size_t size, const size_t index, size_t &end) {
+  const auto need = [&](const size_t n) {
+    end = index + n;
+    return end <= size;
+  };
+  if (!need(1)) {
+    return 1;
+  }
+  const int tag = etf_term_tag(buf, static_cast<int>(index));
+  size_t header = 0;
+  size_t arity = 0;
+  switch (tag) {
+    case ERL_SMALL_INTEGER_EXT:
+      return need(2) ? 0 : 1;
+    case ERL_INTEGER_EXT:
+      return need(5) ? 0 : 1;
+    case NEW_FLOAT_EXT:
+      return need(9) ? 0 : 1;
+    case ERL_FLOAT_EXT:
+      return need(32) ? 0 : 1;
+    case ERL_NIL_EXT:
+      return 0;
+    case ERL_SMALL_ATOM_UTF8_EXT:
+    case ERL_SMALL_ATOM_EXT:
+      return need(2) && need(2 + etf_get_uint8(buf, static_cast<int>(index) + 1)) ? 0 : 1;
+    case ERL_SMALL_BIG_EXT:
+      return need(2) && need(3 + etf_get_uint8(buf, static_cast<int>(index) + 1)) ? 0 : 1;
+    case ERL_ATOM_UTF8_EXT:
+    case ERL_ATOM_EXT:
+    case ERL_STRING_EXT:
+      return need(3) && need(3 + etf_get_uint16(buf, static_cast<int>(index) + 1)) ? 0 : 1;
+    case ERL_BINARY_EXT:
+      return need(5) && need(5 + static_cast<size_t>(etf_get_uint32(buf, static_cast<int>(index) + 1))) ? 0 : 1;
+    case ERL_LARGE_BIG_EXT:
+      return need(5) && need(6 + static_cast<size_t>(etf_get_uint32(buf, static_cast<int>(index) + 1))) ? 0 : 1;
+    case ERL_SMALL_TUPLE_EXT:
+      if (!need(2)) {
+        return 1;
+      }
+      header = 2;
+      arity = etf_get_uint8(buf, static_cast<int>(index) + 1);
+      break;
+    case ERL_LARGE_TUPLE_EXT:
+    case ERL_LIST_EXT:
+    case ERL_MAP_EXT:
+      if (!need(5)) {
+        return 1;
+      }
+      header = 5;
+      arity = etf_get_uint32(buf, static_cast<int>(index) + 1);
+      arity = tag == ERL_LIST_EXT ? arity + 1 : tag == ERL_MAP_EXT ? 2 * arity : arity;
+      break;
+    default:
+      std::cerr << "Unsupported term in ETF stream at " << index << ", type " << tag << std::endl;
+      return -1;
+  }
+  size_t i = index + header;
+  for (size_t n = 0; n < arity; ++n) {
+    if (const int ret = scan_term(buf, size, i, end)) {
+      return ret;
+    }
+    i = end;
+  }
+  end = i;
+  return 0;
+}
+
+} // namespace
+
+SwmEtfStream::SwmEtfStream() = default;
+
+SwmEtfStream::~SwmEtfStream() {
+  if (zs) {
+    inflateEnd(zs.get());
+  }
+}
+
+void SwmEtfStream::compact() {
+  if (consumed) {  // only the incomplete element is kept
+    pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(consumed));
+    needed -= consumed < needed ? consumed : needed;
+    consumed = 0;
+  }
+}
+
+int SwmEtfStream::push(const char* data, size_t size) {
+  compact();
+  if (state == State::VERSION) {
+    while (size && (prefix.size() < 2 || (prefix[1] == ERLANG_COMPRESSED_TAG && prefix.size() < 6))) {
+      prefix.push_back(*data++);
+      --size;
+    }
+    if (prefix.size() < 2 || (prefix[1] == ERLANG_COMPRESSED_TAG && prefix.size() < 6)) {
+      return 0;
+    }
+    if (static_cast<unsigned char>(prefix[0]) != ERLANG_BINARY_FORMAT_VERSION) {
+      std::cerr << "Wrong erlang binary format version in ETF stream: " << static_cast<unsigned>(static_cast<unsigned char>(prefix[0])) << std::endl;
+      return -1;
+    }
+    if (prefix[1] == ERLANG_COMPRESSED_TAG) {
+      zs.reset(new z_stream_s());
+      if (inflateInit(zs.get()) != Z_OK) {
+        std::cerr << "Could not initialize inflating of ETF stream" << std::endl;
+        return -1;
+      }
+    } else {
+      pending.push_back(prefix[1]);
+    }
+    state = State::HEADER;
+  }
+  if (zs) {  // inflated by next() when its bytes are needed
+    zs->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs->avail_in = static_cast<uInt>(size);
+    return 0;
+  }
+  pending.insert(pending.end(), data, data + size);
+  return 0;
+}
+
+bool SwmEtfStream::can_inflate() const {
+  return zs && zs->avail_in && !inflated;
+}
+
+int SwmEtfStream::inflate_until(const size_t size) {
+  while (pending.size() < size && can_inflate()) {
+    const size_t begin = pending.size();
+    const size_t step = std::min<size_t>(size - begin, UINT_MAX);
+    pending.resize(begin + step);
+    zs->next_out = reinterpret_cast<Bytef*>(pending.data() + begin);
+    zs->avail_out = static_cast<uInt>(step);
+    const int ret = inflate(zs.get(), Z_NO_FLUSH);
+    pending.resize(pending.size() - zs->avail_out);
+    if (ret == Z_STREAM_END) {
+      inflated = true;
+    } else if (ret != Z_OK) {
+      std::cerr << "Could not inflate ETF stream: " << ret << std::endl;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int SwmEtfStream::next(int &index) {
+  int ret = 0;
+  while ((ret = next_buffered(index)) == 0 && state != State::DONE && can_inflate()) {
+    compact();
+    if (inflate_until(std::max(needed, pending.size() + INFLATE_STEP_SIZE))) {
+      return -1;
+    }
+  }
+  return ret;
+}
+
+int SwmEtfStream::next_buffered(int &index) {
+  const char* buf = pending.data();
+  const size_t size = pending.size();
+  if (state == State::HEADER) {
+    if (size - consumed < 1) {
+      return 0;
+    }
+    switch (etf_term_tag(buf, static_cast<int>(consumed))) {
+      case ERL_LIST_EXT:
+        if (size - consumed < 5) {
+          return 0;
+        }
+        list = true;
+        remaining = etf_get_uint32(buf, static_cast<int>(consumed) + 1);
+        consumed += 5;
+        break;
+      case ERL_NIL_EXT:
+        consumed += 1;
+        state = State::DONE;
+        return 0;
+      default:
+        remaining = 1;
+    }
+    state = State::ELEMENTS;
+  }
+  if (state == State::ELEMENTS) {
+    if (remaining == 0) {
+      state = list ? State::TAIL : State::DONE;
+    } else {
+      if (size < needed) {
+        return 0;
+      }
+      size_t end = 0;
+      const int ret = scan_term(buf, size, consumed, end);
+      if (ret) {
+        needed = end;
+        return ret > 0 ? 0 : -1;
+      }
+      index = static_cast<int>(consumed);
+      consumed = end;
+      needed = 0;
+      --remaining;
+      ++count;
+      return 1;
+    }
+  }
+  if (state == State::TAIL) {
+    if (size - consumed < 1) {
+      return 0;
+    }
+    if (etf_term_tag(buf, static_cast<int>(consumed)) != ERL_NIL_EXT) {
+      std::cerr << "Improper list in ETF stream" << std::endl;
+      return -1;
+    }
+    consumed += 1;
+    state = State::DONE;
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+struct z_stream_s;
+
+namespace swm {
+
+// Push decoder of an erlang external term format binary that arrives in
+// chunks of any size, e.g. from a pipe.
+//
+// Elements of a top level list are handed out as soon as all their bytes
+// have arrived, any other top level term is handed out as one element.
+// Only the bytes of the incomplete element are kept, so the memory does not
+// grow with the payload size. Compressed binaries (term_to_binary(T,
+// [compressed])) are inflated only as far as the next element needs, so
+// the memory is bounded by the largest element there too.
+class SwmEtfStream {
+ public:
+  SwmEtfStream();
+  ~SwmEtfStream();
+
+  SwmEtfStream(const SwmEtfStream&) = delete;
+  SwmEtfStream& operator=(const SwmEtfStream&) = delete;
+
+  // Consumes the chunk and calls fun(buf, index) for every completed element
+  // at index of buf, the buffer is valid until the next call, so it is not
+  // shared and terms of any type decoded from it are copied. Returns -1 on
+  // malformed input or if fun returns non zero.
+  template <typename F>
+  int feed(const char* data, const size_t size, F &&fun) {
+    if (push(data, size)) {
+      return -1;
+    }
+    int index = 0;
+    int ret = 0;
+    while ((ret = next(index)) == 1) {
+      if (fun(static_cast<const char*>(pending.data()), index)) {
+        return -1;
+      }
+    }
+    return ret;
+  }
+
+  bool done() const { return state == State::DONE; }
+  size_t elements() const { return count; }  // handed out so far
+  size_t buffered() const { return pending.size() - consumed; }
+
+ private:
+  enum class State { VERSION, HEADER, ELEMENTS, TAIL, DONE };
+
+  int push(const char* data, size_t size);
+  void compact();  // drops the handed out bytes
+  bool can_inflate() const;
+  int inflate_until(size_t size);  // inflates the fed bytes until pending has size bytes
+  int next(int &index);  // 1 if an element is ready at index, 0 if more bytes are needed
+  int next_buffered(int &index);  // the same without inflating
+
+  State state = State::VERSION;
+  std::vector<char> prefix;  // version and compressed header
+  std::vector<char> pending;  // bytes of the term without the version
+  size_t consumed = 0;  // bytes of pending that were handed out
+  size_t needed = 0;  // pending size that is known to be needed for the next element
+  uint32_t remaining = 0;  // elements left
+  bool list = false;
+  size_t count = 0;
+  std::unique_ptr<z_stream_s> zs;
+  bool inflated = false;  // the end of the compressed stream is reached
+};
+
+// Reads len bytes from the stream by chunks and feeds them to the decoder
+template <typename F>
+int swm_read_etf_stream(std::istream *stream, size_t len, SwmEtfStream &decoder, F &&fun) {
+  std::vector<char> chunk(len < 65536 ? len : 65536);
+  while (len > 0) {
+    const size_t size = len < chunk.size() ? len : chunk.size();
+    if (!stream->read(chunk.data(), static_cast<std::streamsize>(size))) {
+      std::cerr << "Could not read " << size << " bytes of ETF stream" << std::endl;
+      return -1;
+    }
+    len -= size;
+    if (decoder.feed(chunk.data(), size, fun)) {
+      return -1;
+    }
+  }
+  return decoder.done() ? 0 : -1;
+}
+
+} // namespace swm
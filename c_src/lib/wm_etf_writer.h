@@ -0,0 +1,182 @@
+#pragma once
+
+#include <ei.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+// Writer of the erlang external term format, the counterpart of
+// wm_etf_reader.h. Like in libei, a null buffer only advances the index, so
+// the same code first computes the encoded size and then writes the terms
+// into a buffer that is allocated once.
+
+namespace swm {
+
+inline void etf_put_uint8(char* buf, int &index, const unsigned n) {
+  if (buf) {
+    buf[index] = static_cast<char>(n & 0xff);
+  }
+  index += 1;
+}
+
+inline void etf_put_uint16(char* buf, int &index, const unsigned n) {
+  if (buf) {
+    buf[index] = static_cast<char>((n >> 8) & 0xff);
+    buf[index + 1] = static_cast<char>(n & 0xff);
+  }
+  index += 2;
+}
+
+inline void etf_put_uint32(char* buf, int &index, const uint32_t n) {
+  if (buf) {
+    buf[index] = static_cast<char>((n >> 24) & 0xff);
+    buf[index + 1] = static_cast<char>((n >> 16) & 0xff);
+    buf[index + 2] = static_cast<char>((n >> 8) & 0xff);
+    buf[index + 3] = static_cast<char>(n & 0xff);
+  }
+  index += 4;
+}
+
+inline void etf_put_bytes(char* buf, int &index, const char* data, const size_t size) {
+  if (buf && size) {
+    std::memcpy(buf + index, data, size);
+  }
+  index += static_cast<int>(size);
+}
+
+inline void etf_encode_tuple_header(char* buf, int &index, const size_t arity) {
+  if (arity < 256) {
+    etf_put_uint8(buf, index, ERL_SMALL_TUPLE_EXT);
+    etf_put_uint8(buf, index, static_cast<unsigned>(arity));
+  } else {
+    etf_put_uint8(buf, index, ERL_LARGE_TUPLE_EXT);
+    etf_put_uint32(buf, index, static_cast<uint32_t>(arity));
+  }
+}
+
+// A non empty list header must be followed by the elements and the tail
+inline void etf_encode_list_header(char* buf, int &index, const size_t arity) {
+  etf_put_uint8(buf, index, ERL_LIST_EXT);
+  etf_put_uint32(buf, index, static_cast<uint32_t>(arity));
+}
+
+inline void etf_encode_empty_list(char* buf, int &index) {
+  etf_put_uint8(buf, index, ERL_NIL_EXT);
+}
+
+inline void etf_encode_map_header(char* buf, int &index, const size_t arity) {
+  etf_put_uint8(buf, index, ERL_MAP_EXT);
+  etf_put_uint32(buf, index, static_cast<uint32_t>(arity));
+}
+
+inline void etf_encode_atom(char* buf, int &index, const std::string_view a) {
+  if (a.size() < 256) {
+    etf_put_uint8(buf, index, ERL_SMALL_ATOM_UTF8_EXT);
+    etf_put_uint8(buf, index, static_cast<unsigned>(a.size()));
+  } else {
+    etf_put_uint8(buf, index, ERL_ATOM_UTF8_EXT);
+    etf_put_uint16(buf, index, static_cast<unsigned>(a.size()));
+  }
+  etf_put_bytes(buf, index, a.data(), a.size());
+}
+
+// Encodes a string the same way as erlang term_to_binary/1 does: as an empty
+// list, as STRING_EXT or, if it is longer than 65535 bytes, as a list.
+inline void etf_encode_str(char* buf, int &index, const std::string_view s) {
+  if (s.empty()) {
+    etf_encode_empty_list(buf, index);
+  } else if (s.size() <= 0xffff) {
+    etf_put_uint8(buf, index, ERL_STRING_EXT);
+    etf_put_uint16(buf, index, static_cast<unsigned>(s.size()));
+    etf_put_bytes(buf, index, s.data(), s.size());
+  } else {
+    etf_encode_list_header(buf, index, s.size());
+    for (const auto c : s) {
+      etf_put_uint8(buf, index, ERL_SMALL_INTEGER_EXT);
+      etf_put_uint8(buf, index, static_cast<unsigned char>(c));
+    }
+    etf_encode_empty_list(buf, index);
+  }
+}
+
+inline void etf_encode_binary(char* buf, int &index, const std::string_view data) {
+  etf_put_uint8(buf, index, ERL_BINARY_EXT);
+  etf_put_uint32(buf, index, static_cast<uint32_t>(data.size()));
+  etf_put_bytes(buf, index, data.data(), data.size());
+}
+
+inline void etf_encode_big(char* buf, int &index, uint64_t magnitude, const bool negative) {
+  unsigned digits = 0;
+  for (uint64_t n = magnitude; n; n >>= 8) {
+    ++digits;
+  }
+  etf_put_uint8(buf, index, ERL_SMALL_BIG_EXT);
+  etf_put_uint8(buf, index, digits);
+  etf_put_uint8(buf, index, negative ? 1 : 0);
+  for (; magnitude; magnitude >>= 8) {  // little endian digits
+    etf_put_uint8(buf, index, static_cast<unsigned>(magnitude & 0xff));
+  }
+}
+
+inline void etf_encode_uint64(char* buf, int &index, const uint64_t n) {
+  if (n < 256) {
+    etf_put_uint8(buf, index, ERL_SMALL_INTEGER_EXT);
+    etf_put_uint8(buf, index, static_cast<unsigned>(n));
+  } else if (n <= INT32_MAX) {
+    etf_put_uint8(buf, index, ERL_INTEGER_EXT);
+    etf_put_uint32(buf, index, static_cast<uint32_t>(n));
+  } else {
+    etf_encode_big(buf, index, n, false);
+  }
+}
+
+inline void etf_encode_int64(char* buf, int &index, const int64_t n) {
+  if (n >= 0) {
+    etf_encode_uint64(buf, index, static_cast<uint64_t>(n));
+  } else if (n >= INT32_MIN) {
+    etf_put_uint8(buf, index, ERL_INTEGER_EXT);
+    etf_put_uint32(buf, index, static_cast<uint32_t>(n));
+  } else {
+    etf_encode_big(buf, index, 0 - static_cast<uint64_t>(n), true);
+  }
+}
+
+inline void etf_encode_double(char* buf, int &index, const double d) {
+  uint64_t bits = 0;
+  std::memcpy(&bits, &d, sizeof(d));
+  etf_put_uint8(buf, index, NEW_FLOAT_EXT);
+  etf_put_uint32(buf, index, static_cast<uint32_t>(bits >> 32));
+  etf_put_uint32(buf, index, static_cast<uint32_t>(bits));
+}
+
+// Proper list of elements that are encoded by encode(buf, index, element)
+template <typename Array, typename Encode>
+void etf_encode_list(char* buf, int &index, const Array &array, Encode encode) {
+  if (!array.empty()) {
+    etf_encode_list_header(buf, index, array.size());
+    for (const auto &x : array) {
+      encode(buf, index, x);
+    }
+  }
+  etf_encode_empty_list(buf, index);
+}
+
+// Makes room for size more bytes in x at once. Buffers of ei_x_buff are
+// allocated by libei with malloc(), so they are grown with realloc().
+inline int etf_x_reserve(ei_x_buff &x, const int size) {
+  if (x.index + size <= x.buffsz) {
+    return 0;
+  }
+  const int new_size = x.index + size;
+  char* data = static_cast<char*>(std::realloc(x.buff, static_cast<size_t>(new_size)));
+  if (!data) {
+    return -1;
+  }
+  x.buff = data;
+  x.buffsz = new_size;
+  return 0;
+}
+
+} // namespace swm
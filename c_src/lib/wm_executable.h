@@ -2,42 +2,134 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmExecutable:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 5;
+  static constexpr uint64_t FIELD_NAME = 1ull << 0;
+  static constexpr uint64_t FIELD_PATH = 1ull << 1;
+  static constexpr uint64_t FIELD_USER = 1ull << 2;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 3;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 4;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "executable";
+  static const SwmFieldInfo<SwmExecutable> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmExecutable();
-  SwmExecutable(const char*, int&);
+  explicit SwmExecutable(const allocator_type&);
+  SwmExecutable(const char*, int&, const allocator_type& = {});
+  SwmExecutable(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmExecutable(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmExecutable(const SwmExecutable&, const allocator_type&);
+  SwmExecutable(SwmExecutable&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmExecutable &old_obj, const SwmExecutable &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_name(const std::string&);
-  void set_path(const std::string&);
-  void set_user(const std::string&);
-  void set_comment(const std::string&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_path(const std::pmr::string&);
+  void set_path(std::pmr::string&&);
+  void set_user(const std::pmr::string&);
+  void set_user(std::pmr::string&&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  std::string get_name() const;
-  std::string get_path() const;
-  std::string get_user() const;
-  std::string get_comment() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const std::pmr::string& get_name() const;
+  const std::pmr::string& get_path() const;
+  const std::pmr::string& get_user() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
 
  private:
-  std::string name;
-  std::string path;
-  std::string user;
-  std::string comment;
-  uint64_t revision;
+  std::pmr::string name;
+  std::pmr::string path;
+  std::pmr::string user;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmExecutableView;
+
 int ei_buffer_to_executable(const char*, int&, std::vector<SwmExecutable>&);
+int ei_buffer_to_executable(const char*, int&, std::pmr::vector<SwmExecutable>&);
+int ei_buffer_to_executable(const char*, int&, std::vector<SwmExecutable>&, SwmThreadPool&);
 int ei_buffer_to_executable(const char*, int&, SwmExecutable&);
+int ei_buffer_to_executable(const char*, int&, std::vector<SwmExecutableView>&);
+int ei_buffer_to_executable(const char*, int&, SwmExecutableView&);
+
+void encode_executable(char*, int&, const SwmExecutable&);
+void encode_executable(char*, int&, const std::vector<SwmExecutable>&);
+void encode_executable(char*, int&, const std::pmr::vector<SwmExecutable>&);
+int encode_executable(ei_x_buff&, const std::vector<SwmExecutable>&);
+int encode_executable(ei_x_buff&, const std::pmr::vector<SwmExecutable>&);
+
+class SwmExecutableView {
+
+ public:
+  SwmExecutableView();
+  SwmExecutableView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_name() const;
+  std::string_view get_path() const;
+  std::string_view get_user() const;
+  std::string_view get_comment() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 5> offsets = {};
+
+};
 
 } // namespace swm
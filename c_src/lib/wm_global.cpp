@@ -1,155 +1,368 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_global.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmGlobal> SwmGlobal::FIELDS_INFO[] = {
+  field_info<SwmGlobal, SwmAtom, &SwmGlobal::name,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("name"),
+  field_info<SwmGlobal, std::pmr::string, &SwmGlobal::value,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("value"),
+  field_info<SwmGlobal, std::pmr::string, &SwmGlobal::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmGlobal, uint64_t, &SwmGlobal::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmGlobal::SwmGlobal() {
 }
 
-SwmGlobal::SwmGlobal(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmGlobal: null" << std::endl;
-    return;
-  }
+SwmGlobal::SwmGlobal(const allocator_type &allocator)
+  : value(allocator),
+    comment(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmGlobal header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmGlobal::SwmGlobal(const SwmGlobal &other, const allocator_type &allocator)
+  : name(other.name),
+    value(other.value, allocator),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmGlobal term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmGlobal::SwmGlobal(SwmGlobal &&other, const allocator_type &allocator)
+  : name(other.name),
+    value(std::move(other.value), allocator),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_atom(buf, index, this->name)) {
-    std::cerr << "Could not init global::name at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmGlobal::allocator_type SwmGlobal::get_allocator() const {
+  return value.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->value)) {
-    std::cerr << "Could not init global::value at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmGlobal::SwmGlobal(const char* buf, int &index, const allocator_type &allocator)
+  : SwmGlobal(buf, index, FIELD_ALL, allocator) {
+}
+
+SwmGlobal::SwmGlobal(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmGlobal(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
+  }
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init global::comment at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmGlobal::SwmGlobal(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmGlobal(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init global::revision at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmGlobal::validate(const char* buf, int &index) {
+  return entity_validate<SwmGlobal>(buf, index);
+}
+
+void SwmGlobal::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmGlobal::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmGlobal>(buf, index, writer);
+}
+
+SwmPatch SwmGlobal::diff(const SwmGlobal &old_obj, const SwmGlobal &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmGlobal::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmGlobal::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip global::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmGlobal::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmGlobal::set_name(const std::string &new_val) {
+void SwmGlobal::set_name(const SwmAtom &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmGlobal::set_value(const std::string &new_val) {
+void SwmGlobal::set_value(const std::pmr::string &new_val) {
   value = new_val;
+  lazy_fields &= ~FIELD_VALUE;
+}
+
+void SwmGlobal::set_value(std::pmr::string &&new_val) {
+  value = std::move(new_val);
+  lazy_fields &= ~FIELD_VALUE;
 }
 
-void SwmGlobal::set_comment(const std::string &new_val) {
+void SwmGlobal::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmGlobal::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmGlobal::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-std::string SwmGlobal::get_name() const {
+const SwmAtom& SwmGlobal::get_name() const {
   return name;
 }
 
-std::string SwmGlobal::get_value() const {
+const std::pmr::string& SwmGlobal::get_value() const {
   return value;
 }
 
-std::string SwmGlobal::get_comment() const {
+const std::pmr::string& SwmGlobal::get_comment() const {
   return comment;
 }
 
-uint64_t SwmGlobal::get_revision() const {
+const uint64_t& SwmGlobal::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_global(const char *buf, int &index, std::vector<SwmGlobal> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a global list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for global at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a global list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of global list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_global(const char *buf, int &index, std::vector<SwmGlobal> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_global(const char *buf, int &index, std::pmr::vector<SwmGlobal> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_global(const char *buf, int &index, std::vector<SwmGlobal> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a global list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmGlobal(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_global(const char* buf, int &index, SwmGlobal &obj) {
-  obj = SwmGlobal(buf, index);
+  obj = SwmGlobal(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmGlobal::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmGlobal::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode global" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_global(char* buf, int &index, const SwmGlobal &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_global(char* buf, int &index, const std::vector<SwmGlobal> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmGlobal &x) { x.encode(b, i); });
+}
+
+void swm::encode_global(char* buf, int &index, const std::pmr::vector<SwmGlobal> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmGlobal &x) { x.encode(b, i); });
+}
+
+int swm::encode_global(ei_x_buff &x, const std::vector<SwmGlobal> &array) {
+  int size = 0;
+  encode_global(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode global list" << std::endl;
+    return -1;
+  }
+  encode_global(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_global(ei_x_buff &x, const std::pmr::vector<SwmGlobal> &array) {
+  int size = 0;
+  encode_global(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode global list" << std::endl;
+    return -1;
+  }
+  encode_global(x.buff, x.index, array);
   return 0;
 }
 
 void SwmGlobal::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << value << separator;
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  entity_print(*this, prefix, separator);
+}
+
+SwmGlobalView::SwmGlobalView() {
+}
+
+SwmGlobalView::SwmGlobalView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmGlobalView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 4)) {
+    std::cerr << "Could not create SwmGlobalView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmGlobalView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmGlobalView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[0]);
+}
+
+std::string_view SwmGlobalView::get_value() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmGlobalView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+uint64_t SwmGlobalView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[3]);
+}
+
+int swm::ei_buffer_to_global(const char* buf, int &index, SwmGlobalView &obj) {
+  obj = SwmGlobalView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_global(const char* buf, int &index, std::vector<SwmGlobalView> &array) {
+  const SwmListView<SwmGlobalView, ei_buffer_to_global> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmGlobalView at " << index << std::endl;
+      return -1;
+    }
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of global at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
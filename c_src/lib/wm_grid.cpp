@@ -1,300 +1,525 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_grid.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 #include "wm_resource.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmGrid> SwmGrid::FIELDS_INFO[] = {
+  field_info<SwmGrid, SwmId, &SwmGrid::id,
+             ei_buffer_to_id, encode_id,
+             SwmIdTerm>("id"),
+  field_info<SwmGrid, std::pmr::string, &SwmGrid::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmGrid, SwmAtom, &SwmGrid::state,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("state"),
+  field_info<SwmGrid, std::pmr::string, &SwmGrid::manager,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("manager"),
+  field_info<SwmGrid, std::pmr::vector<std::pmr::string>, &SwmGrid::clusters,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("clusters"),
+  field_info<SwmGrid, std::pmr::vector<std::pmr::string>, &SwmGrid::hooks,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("hooks"),
+  field_info<SwmGrid, uint64_t, &SwmGrid::scheduler,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("scheduler"),
+  field_info<SwmGrid, std::pmr::vector<SwmResource>, &SwmGrid::resources,
+             ei_buffer_to_resource, encode_resource,
+             SwmListTerm<SwmEntityTerm<SwmResource>>>("resources"),
+  field_info<SwmGrid, std::pmr::vector<SwmTupleAtomBuff>, &SwmGrid::properties,
+             ei_buffer_to_tuple_atom_buff, encode_tuple_atom_buff,
+             SwmListTerm<SwmTupleTerm<SwmAtomTerm, SwmAnyTerm>>>("properties"),
+  field_info<SwmGrid, std::pmr::string, &SwmGrid::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmGrid, uint64_t, &SwmGrid::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmGrid::SwmGrid() {
 }
 
-SwmGrid::SwmGrid(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmGrid: null" << std::endl;
-    return;
-  }
+SwmGrid::SwmGrid(const allocator_type &allocator)
+  : name(allocator),
+    manager(allocator),
+    clusters(allocator),
+    hooks(allocator),
+    resources(allocator),
+    properties(allocator),
+    comment(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmGrid header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmGrid::SwmGrid(const SwmGrid &other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name, allocator),
+    state(other.state),
+    manager(other.manager, allocator),
+    clusters(other.clusters, allocator),
+    hooks(other.hooks, allocator),
+    scheduler(other.scheduler),
+    resources(other.resources, allocator),
+    properties(other.properties, allocator),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmGrid term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmGrid::SwmGrid(SwmGrid &&other, const allocator_type &allocator)
+  : id(other.id),
+    name(std::move(other.name), allocator),
+    state(other.state),
+    manager(std::move(other.manager), allocator),
+    clusters(std::move(other.clusters), allocator),
+    hooks(std::move(other.hooks), allocator),
+    scheduler(other.scheduler),
+    resources(std::move(other.resources), allocator),
+    properties(std::move(other.properties), allocator),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->id)) {
-    std::cerr << "Could not init grid::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmGrid::allocator_type SwmGrid::get_allocator() const {
+  return name.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init grid::name at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmGrid::SwmGrid(const char* buf, int &index, const allocator_type &allocator)
+  : SwmGrid(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_atom(buf, index, this->state)) {
-    std::cerr << "Could not init grid::state at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmGrid::SwmGrid(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmGrid(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_str(buf, index, this->manager)) {
-    std::cerr << "Could not init grid::manager at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->clusters)) {
-    std::cerr << "Could not init grid::clusters at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmGrid::SwmGrid(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmGrid(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->hooks)) {
-    std::cerr << "Could not init grid::hooks at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmGrid::validate(const char* buf, int &index) {
+  return entity_validate<SwmGrid>(buf, index);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->scheduler)) {
-    std::cerr << "Could not init grid::scheduler at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+void SwmGrid::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
 
-  if (ei_buffer_to_resource(buf, index, this->resources)) {
-    std::cerr << "Could not init grid::resources at pos 9: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmGrid::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmGrid>(buf, index, writer);
+}
 
-  if (ei_buffer_to_tuple_atom_buff(buf, index, this->properties)) {
-    std::cerr << "Could not init grid::properties at pos 10: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmPatch SwmGrid::diff(const SwmGrid &old_obj, const SwmGrid &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init grid::comment at pos 11: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmGrid::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init grid::revision at pos 12: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmGrid::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip grid::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmGrid::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmGrid::set_id(const std::string &new_val) {
+void SwmGrid::set_id(const SwmId &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmGrid::set_name(const std::string &new_val) {
+void SwmGrid::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmGrid::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmGrid::set_state(const std::string &new_val) {
+void SwmGrid::set_state(const SwmAtom &new_val) {
   state = new_val;
+  lazy_fields &= ~FIELD_STATE;
 }
 
-void SwmGrid::set_manager(const std::string &new_val) {
+void SwmGrid::set_manager(const std::pmr::string &new_val) {
   manager = new_val;
+  lazy_fields &= ~FIELD_MANAGER;
 }
 
-void SwmGrid::set_clusters(const std::vector<std::string> &new_val) {
+void SwmGrid::set_manager(std::pmr::string &&new_val) {
+  manager = std::move(new_val);
+  lazy_fields &= ~FIELD_MANAGER;
+}
+
+void SwmGrid::set_clusters(const std::pmr::vector<std::pmr::string> &new_val) {
   clusters = new_val;
+  lazy_fields &= ~FIELD_CLUSTERS;
 }
 
-void SwmGrid::set_hooks(const std::vector<std::string> &new_val) {
+void SwmGrid::set_clusters(std::pmr::vector<std::pmr::string> &&new_val) {
+  clusters = std::move(new_val);
+  lazy_fields &= ~FIELD_CLUSTERS;
+}
+
+void SwmGrid::set_hooks(const std::pmr::vector<std::pmr::string> &new_val) {
   hooks = new_val;
+  lazy_fields &= ~FIELD_HOOKS;
+}
+
+void SwmGrid::set_hooks(std::pmr::vector<std::pmr::string> &&new_val) {
+  hooks = std::move(new_val);
+  lazy_fields &= ~FIELD_HOOKS;
 }
 
 void SwmGrid::set_scheduler(const uint64_t &new_val) {
   scheduler = new_val;
+  lazy_fields &= ~FIELD_SCHEDULER;
 }
 
-void SwmGrid::set_resources(const std::vector<SwmResource> &new_val) {
+void SwmGrid::set_resources(const std::pmr::vector<SwmResource> &new_val) {
   resources = new_val;
+  lazy_fields &= ~FIELD_RESOURCES;
+}
+
+void SwmGrid::set_resources(std::pmr::vector<SwmResource> &&new_val) {
+  resources = std::move(new_val);
+  lazy_fields &= ~FIELD_RESOURCES;
 }
 
-void SwmGrid::set_properties(const std::vector<SwmTupleAtomBuff> &new_val) {
+void SwmGrid::set_properties(const std::pmr::vector<SwmTupleAtomBuff> &new_val) {
   properties = new_val;
+  lazy_fields &= ~FIELD_PROPERTIES;
 }
 
-void SwmGrid::set_comment(const std::string &new_val) {
+void SwmGrid::set_properties(std::pmr::vector<SwmTupleAtomBuff> &&new_val) {
+  properties = std::move(new_val);
+  lazy_fields &= ~FIELD_PROPERTIES;
+}
+
+void SwmGrid::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmGrid::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmGrid::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-std::string SwmGrid::get_id() const {
+const SwmId& SwmGrid::get_id() const {
   return id;
 }
 
-std::string SwmGrid::get_name() const {
+const std::pmr::string& SwmGrid::get_name() const {
   return name;
 }
 
-std::string SwmGrid::get_state() const {
+const SwmAtom& SwmGrid::get_state() const {
   return state;
 }
 
-std::string SwmGrid::get_manager() const {
+const std::pmr::string& SwmGrid::get_manager() const {
   return manager;
 }
 
-std::vector<std::string> SwmGrid::get_clusters() const {
+const std::pmr::vector<std::pmr::string>& SwmGrid::get_clusters() const {
   return clusters;
 }
 
-std::vector<std::string> SwmGrid::get_hooks() const {
+const std::pmr::vector<std::pmr::string>& SwmGrid::get_hooks() const {
   return hooks;
 }
 
-uint64_t SwmGrid::get_scheduler() const {
+const uint64_t& SwmGrid::get_scheduler() const {
   return scheduler;
 }
 
-std::vector<SwmResource> SwmGrid::get_resources() const {
+const std::pmr::vector<SwmResource>& SwmGrid::get_resources() const {
   return resources;
 }
 
-std::vector<SwmTupleAtomBuff> SwmGrid::get_properties() const {
+const std::pmr::vector<SwmTupleAtomBuff>& SwmGrid::get_properties() const {
   return properties;
 }
 
-std::string SwmGrid::get_comment() const {
+const std::pmr::string& SwmGrid::get_comment() const {
   return comment;
 }
 
-uint64_t SwmGrid::get_revision() const {
+const uint64_t& SwmGrid::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_grid(const char *buf, int &index, std::vector<SwmGrid> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a grid list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for grid at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a grid list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of grid list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_grid(const char *buf, int &index, std::vector<SwmGrid> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_grid(const char *buf, int &index, std::pmr::vector<SwmGrid> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_grid(const char *buf, int &index, std::vector<SwmGrid> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a grid list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmGrid(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_grid(const char* buf, int &index, SwmGrid &obj) {
-  obj = SwmGrid(buf, index);
+  obj = SwmGrid(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmGrid::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmGrid::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode grid" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_grid(char* buf, int &index, const SwmGrid &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_grid(char* buf, int &index, const std::vector<SwmGrid> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmGrid &x) { x.encode(b, i); });
+}
+
+void swm::encode_grid(char* buf, int &index, const std::pmr::vector<SwmGrid> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmGrid &x) { x.encode(b, i); });
+}
+
+int swm::encode_grid(ei_x_buff &x, const std::vector<SwmGrid> &array) {
+  int size = 0;
+  encode_grid(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode grid list" << std::endl;
+    return -1;
+  }
+  encode_grid(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_grid(ei_x_buff &x, const std::pmr::vector<SwmGrid> &array) {
+  int size = 0;
+  encode_grid(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode grid list" << std::endl;
+    return -1;
+  }
+  encode_grid(x.buff, x.index, array);
   return 0;
 }
 
 void SwmGrid::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << state << separator;
-  std::cerr << prefix << manager << separator;
-  if (clusters.empty()) {
-    std::cerr << prefix << "clusters: []" << separator;
-  } else {
-    std::cerr << prefix << "clusters" << ": [";
-    for (const auto &q: clusters) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  entity_print(*this, prefix, separator);
+}
+
+SwmGridView::SwmGridView() {
+}
+
+SwmGridView::SwmGridView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmGridView: null" << std::endl;
+    return;
   }
-  if (hooks.empty()) {
-    std::cerr << prefix << "hooks: []" << separator;
-  } else {
-    std::cerr << prefix << "hooks" << ": [";
-    for (const auto &q: hooks) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  if (skip_entity_fields(buf, index, offsets.data(), 11)) {
+    std::cerr << "Could not create SwmGridView at " << index << std::endl;
+    this->buf = nullptr;
   }
-  std::cerr << prefix << scheduler << separator;
-  if (resources.empty()) {
-    std::cerr << prefix << "resources: []" << separator;
-  } else {
-    std::cerr << prefix << "resources" << ": [";
-    for (const auto &q: resources) {
-      q.print(prefix, separator);
+}
+
+bool SwmGridView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmGridView::get_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+std::string_view SwmGridView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmGridView::get_state() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[2]);
+}
+
+std::string_view SwmGridView::get_manager() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[3]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmGridView::get_clusters() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[4]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmGridView::get_hooks() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[5]);
+}
+
+uint64_t SwmGridView::get_scheduler() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[6]);
+}
+
+SwmListView<SwmResourceView, ei_buffer_to_resource> SwmGridView::get_resources() const {
+  return SwmListView<SwmResourceView, ei_buffer_to_resource>(buf, offsets[7]);
+}
+
+SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff> SwmGridView::get_properties() const {
+  return SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff>(buf, offsets[8]);
+}
+
+std::string_view SwmGridView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[9]);
+}
+
+uint64_t SwmGridView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[10]);
+}
+
+int swm::ei_buffer_to_grid(const char* buf, int &index, SwmGridView &obj) {
+  obj = SwmGridView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_grid(const char* buf, int &index, std::vector<SwmGridView> &array) {
+  const SwmListView<SwmGridView, ei_buffer_to_grid> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmGridView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
+    array.push_back(view);
   }
-  if (properties.empty()) {
-    std::cerr << prefix << "properties: []" << separator;
-  } else {
-    std::cerr << prefix << "properties" << ": [";
-    for (const auto &q: properties) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of grid at " << index << std::endl;
+    return -1;
   }
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  return 0;
 }
 
@@ -2,9 +2,14 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 #include "wm_resource.h"
 
 namespace swm {
@@ -12,51 +17,171 @@ namespace swm {
 class SwmGrid:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 11;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_NAME = 1ull << 1;
+  static constexpr uint64_t FIELD_STATE = 1ull << 2;
+  static constexpr uint64_t FIELD_MANAGER = 1ull << 3;
+  static constexpr uint64_t FIELD_CLUSTERS = 1ull << 4;
+  static constexpr uint64_t FIELD_HOOKS = 1ull << 5;
+  static constexpr uint64_t FIELD_SCHEDULER = 1ull << 6;
+  static constexpr uint64_t FIELD_RESOURCES = 1ull << 7;
+  static constexpr uint64_t FIELD_PROPERTIES = 1ull << 8;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 9;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 10;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "grid";
+  static const SwmFieldInfo<SwmGrid> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmGrid();
-  SwmGrid(const char*, int&);
+  explicit SwmGrid(const allocator_type&);
+  SwmGrid(const char*, int&, const allocator_type& = {});
+  SwmGrid(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmGrid(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmGrid(const SwmGrid&, const allocator_type&);
+  SwmGrid(SwmGrid&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmGrid &old_obj, const SwmGrid &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_id(const std::string&);
-  void set_name(const std::string&);
-  void set_state(const std::string&);
-  void set_manager(const std::string&);
-  void set_clusters(const std::vector<std::string>&);
-  void set_hooks(const std::vector<std::string>&);
+  void set_id(const SwmId&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_state(const SwmAtom&);
+  void set_manager(const std::pmr::string&);
+  void set_manager(std::pmr::string&&);
+  void set_clusters(const std::pmr::vector<std::pmr::string>&);
+  void set_clusters(std::pmr::vector<std::pmr::string>&&);
+  void set_hooks(const std::pmr::vector<std::pmr::string>&);
+  void set_hooks(std::pmr::vector<std::pmr::string>&&);
   void set_scheduler(const uint64_t&);
-  void set_resources(const std::vector<SwmResource>&);
-  void set_properties(const std::vector<SwmTupleAtomBuff>&);
-  void set_comment(const std::string&);
+  void set_resources(const std::pmr::vector<SwmResource>&);
+  void set_resources(std::pmr::vector<SwmResource>&&);
+  void set_properties(const std::pmr::vector<SwmTupleAtomBuff>&);
+  void set_properties(std::pmr::vector<SwmTupleAtomBuff>&&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  std::string get_id() const;
-  std::string get_name() const;
-  std::string get_state() const;
-  std::string get_manager() const;
-  std::vector<std::string> get_clusters() const;
-  std::vector<std::string> get_hooks() const;
-  uint64_t get_scheduler() const;
-  std::vector<SwmResource> get_resources() const;
-  std::vector<SwmTupleAtomBuff> get_properties() const;
-  std::string get_comment() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const SwmId& get_id() const;
+  const std::pmr::string& get_name() const;
+  const SwmAtom& get_state() const;
+  const std::pmr::string& get_manager() const;
+  const std::pmr::vector<std::pmr::string>& get_clusters() const;
+  const std::pmr::vector<std::pmr::string>& get_hooks() const;
+  const uint64_t& get_scheduler() const;
+  const std::pmr::vector<SwmResource>& get_resources() const;
+  const std::pmr::vector<SwmTupleAtomBuff>& get_properties() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_clusters(Args&&... args) {
+    return clusters.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_hooks(Args&&... args) {
+    return hooks.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_resources(Args&&... args) {
+    return resources.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_properties(Args&&... args) {
+    return properties.emplace_back(std::forward<Args>(args)...);
+  }
 
  private:
-  std::string id;
-  std::string name;
-  std::string state;
-  std::string manager;
-  std::vector<std::string> clusters;
-  std::vector<std::string> hooks;
-  uint64_t scheduler;
-  std::vector<SwmResource> resources;
-  std::vector<SwmTupleAtomBuff> properties;
-  std::string comment;
-  uint64_t revision;
+  SwmId id;
+  std::pmr::string name;
+  SwmAtom state;
+  std::pmr::string manager;
+  std::pmr::vector<std::pmr::string> clusters;
+  std::pmr::vector<std::pmr::string> hooks;
+  uint64_t scheduler = 0;
+  std::pmr::vector<SwmResource> resources;
+  std::pmr::vector<SwmTupleAtomBuff> properties;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmGridView;
+
 int ei_buffer_to_grid(const char*, int&, std::vector<SwmGrid>&);
+int ei_buffer_to_grid(const char*, int&, std::pmr::vector<SwmGrid>&);
+int ei_buffer_to_grid(const char*, int&, std::vector<SwmGrid>&, SwmThreadPool&);
 int ei_buffer_to_grid(const char*, int&, SwmGrid&);
+int ei_buffer_to_grid(const char*, int&, std::vector<SwmGridView>&);
+int ei_buffer_to_grid(const char*, int&, SwmGridView&);
+
+void encode_grid(char*, int&, const SwmGrid&);
+void encode_grid(char*, int&, const std::vector<SwmGrid>&);
+void encode_grid(char*, int&, const std::pmr::vector<SwmGrid>&);
+int encode_grid(ei_x_buff&, const std::vector<SwmGrid>&);
+int encode_grid(ei_x_buff&, const std::pmr::vector<SwmGrid>&);
+
+class SwmGridView {
+
+ public:
+  SwmGridView();
+  SwmGridView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_id() const;
+  std::string_view get_name() const;
+  std::string_view get_state() const;
+  std::string_view get_manager() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_clusters() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_hooks() const;
+  uint64_t get_scheduler() const;
+  SwmListView<SwmResourceView, ei_buffer_to_resource> get_resources() const;
+  SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff> get_properties() const;
+  std::string_view get_comment() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 11> offsets = {};
+
+};
 
 } // namespace swm
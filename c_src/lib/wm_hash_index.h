@@ -0,0 +1,157 @@
+#pragma once
+
+#include "wm_id.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace swm {
+
+// String keys are looked up by views, other keys by themselves
+template <typename Key>
+struct SwmHashLookup {
+  typedef std::string_view type;
+};
+
+template <>
+struct SwmHashLookup<SwmId> {
+  typedef SwmId type;
+};
+
+// Open addressing hash table with linear probing. Key is std::string for
+// owned keys, std::string_view for keys that are stored elsewhere (e.g.
+// strings in a symbol table) or SwmId.
+template <typename Key, typename Value>
+class SwmHashIndex {
+  typedef typename SwmHashLookup<Key>::type Lookup;
+
+ public:
+  size_t size() const { return count; }
+
+  Value* find(const Lookup &key) {
+    const size_t pos = find_pos(key);
+    return pos < entries.size() ? &entries[pos].value : nullptr;
+  }
+
+  const Value* find(const Lookup &key) const {
+    const size_t pos = find_pos(key);
+    return pos < entries.size() ? &entries[pos].value : nullptr;
+  }
+
+  // Returns the value of the key, a new key gets a default value
+  Value& insert(const Key &key) {
+    if ((count + deleted + 1) * 4 > entries.size() * 3) {
+      rehash(count * 2 + 1 > entries.size() / 2 ? entries.size() * 2 : entries.size());
+    }
+    const size_t hash = std::hash<Lookup>()(key);
+    size_t free = entries.size();
+    size_t pos = hash & mask();
+    for (;; pos = (pos + 1) & mask()) {
+      auto &entry = entries[pos];
+      if (entry.state == EMPTY) {
+        break;
+      }
+      if (entry.state == DELETED) {
+        free = free < entries.size() ? free : pos;
+      } else if (entry.hash == hash && Lookup(entry.key) == Lookup(key)) {
+        return entry.value;
+      }
+    }
+    if (free < entries.size()) {
+      pos = free;
+      --deleted;
+    }
+    auto &entry = entries[pos];
+    entry = Entry{key, hash, Value(), USED};
+    ++count;
+    return entry.value;
+  }
+
+  bool erase(const Lookup &key) {
+    const size_t pos = find_pos(key);
+    if (pos == entries.size()) {
+      return false;
+    }
+    entries[pos] = Entry{Key(), 0, Value(), DELETED};
+    --count;
+    ++deleted;
+    return true;
+  }
+
+  // Erases entries for which pred(key, value) is true, pred may change values
+  // of the kept entries. Returns number of erased entries.
+  template <typename Predicate>
+  size_t erase_if(Predicate pred) {
+    size_t erased = 0;
+    for (auto &entry : entries) {
+      if (entry.state == USED && pred(static_cast<const Key&>(entry.key), entry.value)) {
+        entry = Entry{Key(), 0, Value(), DELETED};
+        ++erased;
+      }
+    }
+    count -= erased;
+    deleted += erased;
+    return erased;
+  }
+
+  void clear() {
+    entries.clear();
+    count = 0;
+    deleted = 0;
+  }
+
+ private:
+  enum State: uint8_t { EMPTY, USED, DELETED };
+
+  struct Entry {
+    Key key;
+    size_t hash = 0;
+    Value value;
+    State state = EMPTY;
+  };
+
+  size_t mask() const { return entries.size() - 1; }
+
+  // Position of the key or the number of entries if there is no such key
+  size_t find_pos(const Lookup &key) const {
+    if (entries.empty()) {
+      return 0;
+    }
+    const size_t hash = std::hash<Lookup>()(key);
+    for (size_t pos = hash & mask();; pos = (pos + 1) & mask()) {
+      const auto &entry = entries[pos];
+      if (entry.state == EMPTY) {
+        return entries.size();
+      }
+      if (entry.state == USED && entry.hash == hash && Lookup(entry.key) == key) {
+        return pos;
+      }
+    }
+  }
+
+  // Capacity is a power of two, deleted entries are dropped
+  void rehash(const size_t capacity) {
+    std::vector<Entry> old(capacity < 16 ? 16 : capacity);
+    old.swap(entries);
+    for (auto &entry : old) {
+      if (entry.state == USED) {
+        size_t pos = entry.hash & mask();
+        while (entries[pos].state != EMPTY) {
+          pos = (pos + 1) & mask();
+        }
+        entries[pos] = std::move(entry);
+      }
+    }
+    deleted = 0;
+  }
+
+  std::vector<Entry> entries;
+  size_t count = 0;
+  size_t deleted = 0;
+};
+
+} // namespace swm
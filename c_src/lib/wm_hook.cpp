@@ -1,204 +1,429 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_hook.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 #include "wm_executable.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmHook> SwmHook::FIELDS_INFO[] = {
+  field_info<SwmHook, SwmId, &SwmHook::id,
+             ei_buffer_to_id, encode_id,
+             SwmIdTerm>("id"),
+  field_info<SwmHook, std::pmr::string, &SwmHook::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmHook, SwmAtom, &SwmHook::event,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("event"),
+  field_info<SwmHook, SwmAtom, &SwmHook::state,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("state"),
+  field_info<SwmHook, SwmExecutable, &SwmHook::executable,
+             ei_buffer_to_executable, encode_executable,
+             SwmEntityTerm<SwmExecutable>>("executable"),
+  field_info<SwmHook, std::pmr::string, &SwmHook::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmHook, uint64_t, &SwmHook::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmHook::SwmHook() {
 }
 
-SwmHook::SwmHook(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmHook: null" << std::endl;
-    return;
-  }
+SwmHook::SwmHook(const allocator_type &allocator)
+  : name(allocator),
+    executable(allocator),
+    comment(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmHook header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmHook::SwmHook(const SwmHook &other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name, allocator),
+    event(other.event),
+    state(other.state),
+    executable(other.executable, allocator),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmHook term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmHook::SwmHook(SwmHook &&other, const allocator_type &allocator)
+  : id(other.id),
+    name(std::move(other.name), allocator),
+    event(other.event),
+    state(other.state),
+    executable(std::move(other.executable), allocator),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->id)) {
-    std::cerr << "Could not init hook::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmHook::allocator_type SwmHook::get_allocator() const {
+  return name.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init hook::name at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmHook::SwmHook(const char* buf, int &index, const allocator_type &allocator)
+  : SwmHook(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_atom(buf, index, this->event)) {
-    std::cerr << "Could not init hook::event at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmHook::SwmHook(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmHook(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_atom(buf, index, this->state)) {
-    std::cerr << "Could not init hook::state at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_executable(buf, index, this->executable)) {
-    std::cerr << "Could not init hook::executable at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmHook::SwmHook(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmHook(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init hook::comment at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmHook::validate(const char* buf, int &index) {
+  return entity_validate<SwmHook>(buf, index);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init hook::revision at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+void SwmHook::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmHook::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmHook>(buf, index, writer);
+}
+
+SwmPatch SwmHook::diff(const SwmHook &old_obj, const SwmHook &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmHook::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmHook::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip hook::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmHook::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmHook::set_id(const std::string &new_val) {
+void SwmHook::set_id(const SwmId &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmHook::set_name(const std::string &new_val) {
+void SwmHook::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmHook::set_event(const std::string &new_val) {
+void SwmHook::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmHook::set_event(const SwmAtom &new_val) {
   event = new_val;
+  lazy_fields &= ~FIELD_EVENT;
 }
 
-void SwmHook::set_state(const std::string &new_val) {
+void SwmHook::set_state(const SwmAtom &new_val) {
   state = new_val;
+  lazy_fields &= ~FIELD_STATE;
 }
 
 void SwmHook::set_executable(const SwmExecutable &new_val) {
   executable = new_val;
+  lazy_fields &= ~FIELD_EXECUTABLE;
+}
+
+void SwmHook::set_executable(SwmExecutable &&new_val) {
+  executable = std::move(new_val);
+  lazy_fields &= ~FIELD_EXECUTABLE;
 }
 
-void SwmHook::set_comment(const std::string &new_val) {
+void SwmHook::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmHook::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmHook::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-std::string SwmHook::get_id() const {
+const SwmId& SwmHook::get_id() const {
   return id;
 }
 
-std::string SwmHook::get_name() const {
+const std::pmr::string& SwmHook::get_name() const {
   return name;
 }
 
-std::string SwmHook::get_event() const {
+const SwmAtom& SwmHook::get_event() const {
   return event;
 }
 
-std::string SwmHook::get_state() const {
+const SwmAtom& SwmHook::get_state() const {
   return state;
 }
 
-SwmExecutable SwmHook::get_executable() const {
+const SwmExecutable& SwmHook::get_executable() const {
   return executable;
 }
 
-std::string SwmHook::get_comment() const {
+const std::pmr::string& SwmHook::get_comment() const {
   return comment;
 }
 
-uint64_t SwmHook::get_revision() const {
+const uint64_t& SwmHook::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_hook(const char *buf, int &index, std::vector<SwmHook> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a hook list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for hook at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a hook list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of hook list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_hook(const char *buf, int &index, std::vector<SwmHook> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_hook(const char *buf, int &index, std::pmr::vector<SwmHook> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_hook(const char *buf, int &index, std::vector<SwmHook> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a hook list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmHook(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_hook(const char* buf, int &index, SwmHook &obj) {
-  obj = SwmHook(buf, index);
+  obj = SwmHook(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmHook::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmHook::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode hook" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_hook(char* buf, int &index, const SwmHook &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_hook(char* buf, int &index, const std::vector<SwmHook> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmHook &x) { x.encode(b, i); });
+}
+
+void swm::encode_hook(char* buf, int &index, const std::pmr::vector<SwmHook> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmHook &x) { x.encode(b, i); });
+}
+
+int swm::encode_hook(ei_x_buff &x, const std::vector<SwmHook> &array) {
+  int size = 0;
+  encode_hook(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode hook list" << std::endl;
+    return -1;
+  }
+  encode_hook(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_hook(ei_x_buff &x, const std::pmr::vector<SwmHook> &array) {
+  int size = 0;
+  encode_hook(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode hook list" << std::endl;
+    return -1;
+  }
+  encode_hook(x.buff, x.index, array);
   return 0;
 }
 
 void SwmHook::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << event << separator;
-  std::cerr << prefix << state << separator;
-  executable.print(prefix, separator);
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  entity_print(*this, prefix, separator);
+}
+
+SwmHookView::SwmHookView() {
+}
+
+SwmHookView::SwmHookView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmHookView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 7)) {
+    std::cerr << "Could not create SwmHookView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmHookView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmHookView::get_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+std::string_view SwmHookView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmHookView::get_event() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[2]);
+}
+
+std::string_view SwmHookView::get_state() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[3]);
+}
+
+SwmExecutableView SwmHookView::get_executable() const {
+  return get_view_value<SwmExecutableView, ei_buffer_to_executable>(buf, offsets[4]);
+}
+
+std::string_view SwmHookView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[5]);
+}
+
+uint64_t SwmHookView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[6]);
+}
+
+int swm::ei_buffer_to_hook(const char* buf, int &index, SwmHookView &obj) {
+  obj = SwmHookView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_hook(const char* buf, int &index, std::vector<SwmHookView> &array) {
+  const SwmListView<SwmHookView, ei_buffer_to_hook> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmHookView at " << index << std::endl;
+      return -1;
+    }
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of hook at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
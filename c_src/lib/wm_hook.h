@@ -2,9 +2,14 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 #include "wm_executable.h"
 
 namespace swm {
@@ -12,39 +17,129 @@ namespace swm {
 class SwmHook:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 7;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_NAME = 1ull << 1;
+  static constexpr uint64_t FIELD_EVENT = 1ull << 2;
+  static constexpr uint64_t FIELD_STATE = 1ull << 3;
+  static constexpr uint64_t FIELD_EXECUTABLE = 1ull << 4;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 5;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 6;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "hook";
+  static const SwmFieldInfo<SwmHook> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmHook();
-  SwmHook(const char*, int&);
+  explicit SwmHook(const allocator_type&);
+  SwmHook(const char*, int&, const allocator_type& = {});
+  SwmHook(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmHook(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmHook(const SwmHook&, const allocator_type&);
+  SwmHook(SwmHook&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmHook &old_obj, const SwmHook &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_id(const std::string&);
-  void set_name(const std::string&);
-  void set_event(const std::string&);
-  void set_state(const std::string&);
+  void set_id(const SwmId&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_event(const SwmAtom&);
+  void set_state(const SwmAtom&);
   void set_executable(const SwmExecutable&);
-  void set_comment(const std::string&);
+  void set_executable(SwmExecutable&&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  std::string get_id() const;
-  std::string get_name() const;
-  std::string get_event() const;
-  std::string get_state() const;
-  SwmExecutable get_executable() const;
-  std::string get_comment() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const SwmId& get_id() const;
+  const std::pmr::string& get_name() const;
+  const SwmAtom& get_event() const;
+  const SwmAtom& get_state() const;
+  const SwmExecutable& get_executable() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
 
  private:
-  std::string id;
-  std::string name;
-  std::string event;
-  std::string state;
+  SwmId id;
+  std::pmr::string name;
+  SwmAtom event;
+  SwmAtom state;
   SwmExecutable executable;
-  std::string comment;
-  uint64_t revision;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmHookView;
+
 int ei_buffer_to_hook(const char*, int&, std::vector<SwmHook>&);
+int ei_buffer_to_hook(const char*, int&, std::pmr::vector<SwmHook>&);
+int ei_buffer_to_hook(const char*, int&, std::vector<SwmHook>&, SwmThreadPool&);
 int ei_buffer_to_hook(const char*, int&, SwmHook&);
+int ei_buffer_to_hook(const char*, int&, std::vector<SwmHookView>&);
+int ei_buffer_to_hook(const char*, int&, SwmHookView&);
+
+void encode_hook(char*, int&, const SwmHook&);
+void encode_hook(char*, int&, const std::vector<SwmHook>&);
+void encode_hook(char*, int&, const std::pmr::vector<SwmHook>&);
+int encode_hook(ei_x_buff&, const std::vector<SwmHook>&);
+int encode_hook(ei_x_buff&, const std::pmr::vector<SwmHook>&);
+
+class SwmHookView {
+
+ public:
+  SwmHookView();
+  SwmHookView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_id() const;
+  std::string_view get_name() const;
+  std::string_view get_event() const;
+  std::string_view get_state() const;
+  SwmExecutableView get_executable() const;
+  std::string_view get_comment() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 7> offsets = {};
+
+};
 
 } // namespace swm
@@ -0,0 +1,161 @@
+#include "wm_id.h"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+
+using namespace swm;
+
+namespace {
+
+// Non UUID ids, the same as the atom table: readers take a shared lock and
+// names are kept in a deque, so views on them remain valid. The empty id
+// has index 0.
+class SwmIdTable {
+ public:
+  SwmIdTable() {
+    add("");
+  }
+
+  uint64_t intern(const std::string_view name) {
+    uint64_t index = 0;
+    if (find(name, index)) {
+      return index;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    const auto it = indexes.find(name);  // could be added by another thread
+    if (it != indexes.end()) {
+      return it->second;
+    }
+    return add(name);
+  }
+
+  bool find(const std::string_view name, uint64_t &index) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const auto it = indexes.find(name);
+    if (it == indexes.end()) {
+      return false;
+    }
+    index = it->second;
+    return true;
+  }
+
+  std::string_view name(const uint64_t index) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return index < names.size() ? std::string_view(names[index]) : std::string_view();
+  }
+
+  size_t size() {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names.size();
+  }
+
+ private:
+  uint64_t add(const std::string_view name) {
+    const auto index = static_cast<uint64_t>(names.size());
+    names.emplace_back(name);
+    indexes.emplace(names.back(), index);
+    return index;
+  }
+
+  std::shared_mutex mutex;
+  std::deque<std::string> names;
+  std::unordered_map<std::string_view, uint64_t> indexes;
+};
+
+SwmIdTable& id_table() {
+  static SwmIdTable table;
+  return table;
+}
+
+int hex_digit(const char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;  // uppercase digits are not packed, so the text is kept as it is
+}
+
+// Hex digits of a UUID without the dashes
+constexpr size_t digit_positions[32] = {
+  0, 1, 2, 3, 4, 5, 6, 7, 9, 10, 11, 12, 14, 15, 16, 17,
+  19, 20, 21, 22, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35
+};
+
+bool parse_uuid(const std::string_view s, uint64_t &hi, uint64_t &lo) {
+  if (s.size() != 36 || s[8] != '-' || s[13] != '-' || s[18] != '-' || s[23] != '-') {
+    return false;
+  }
+  uint64_t words[2] = {0, 0};
+  for (size_t n = 0; n < 32; ++n) {
+    const int digit = hex_digit(s[digit_positions[n]]);
+    if (digit < 0) {
+      return false;
+    }
+    words[n / 16] = (words[n / 16] << 4) | static_cast<uint64_t>(digit);
+  }
+  if ((words[1] >> 62) != 2) {  // not the RFC 4122 variant
+    return false;
+  }
+  hi = words[0];
+  lo = words[1];
+  return true;
+}
+
+} // namespace
+
+SwmId::SwmId(const std::string_view s) {
+  if (!parse_uuid(s, hi, lo)) {
+    hi = id_table().intern(s);
+    lo = 0;
+  }
+}
+
+bool SwmId::find(const std::string_view s, SwmId &id) {
+  if (parse_uuid(s, id.hi, id.lo)) {
+    return true;
+  }
+  uint64_t index = 0;
+  if (!id_table().find(s, index)) {
+    return false;
+  }
+  id.hi = index;
+  id.lo = 0;
+  return true;
+}
+
+std::string_view SwmId::str(Buffer &buf) const {
+  if (!is_uuid()) {
+    return id_table().name(hi);
+  }
+  static const char hex[] = "0123456789abcdef";
+  buf.fill('-');
+  const uint64_t words[2] = {hi, lo};
+  for (size_t n = 0; n < 32; ++n) {
+    buf[digit_positions[n]] = hex[(words[n / 16] >> (60 - 4 * (n % 16))) & 0xf];
+  }
+  return std::string_view(buf.data(), buf.size());
+}
+
+std::string SwmId::str() const {
+  Buffer buf;
+  return std::string(str(buf));
+}
+
+bool SwmId::operator==(const std::string_view s) const {
+  Buffer buf;
+  return str(buf) == s;
+}
+
+size_t swm::swm_ids_count() {
+  return id_table().size();
+}
+
+std::ostream& swm::operator<<(std::ostream& out, const SwmId &id) {
+  SwmId::Buffer buf;
+  return out << id.str(buf);
+}
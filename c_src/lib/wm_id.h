@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace swm {
+
+// Entity id in 16 bytes. Ids in the lowercase UUID format that erlang
+// generates (8-4-4-4-12 hex digits with the RFC 4122 variant) are kept as
+// 128 bit numbers, any other id is interned in a process wide table (like
+// SwmAtom) and kept as its index. Such ids have the variant bits zero, so
+// the two forms never collide and the id is compared and hashed as two
+// integers. The text of the id is restored exactly.
+class SwmId {
+ public:
+  typedef std::array<char, 36> Buffer;  // for the text of a UUID
+
+  constexpr SwmId() {
+  }
+  explicit SwmId(std::string_view s);
+
+  // Id of the string if the string can be an id already made, i.e. it is a
+  // UUID or is interned. Lookups of arbitrary strings do not grow the table.
+  static bool find(std::string_view s, SwmId &id);
+
+  bool is_uuid() const { return (lo >> 62) == 2; }
+  bool empty() const { return hi == 0 && lo == 0; }
+
+  // Text of the id, UUIDs are formatted into the buffer
+  std::string_view str(Buffer &buf) const;
+  std::string str() const;
+
+  // UUIDs of one node often differ only in the first digits, so the high
+  // bits are folded into the low ones that hash tables take
+  size_t hash() const {
+    uint64_t h = hi ^ (lo * 0x9e3779b97f4a7c15ull);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+
+  bool operator==(const SwmId &other) const { return hi == other.hi && lo == other.lo; }
+  bool operator!=(const SwmId &other) const { return !(*this == other); }
+  bool operator<(const SwmId &other) const { return hi < other.hi || (hi == other.hi && lo < other.lo); }
+  bool operator==(std::string_view s) const;
+  bool operator!=(std::string_view s) const { return !(*this == s); }
+
+ private:
+  uint64_t hi = 0;  // first 16 hex digits of a UUID or the index of an interned id
+  uint64_t lo = 0;  // last 16 hex digits of a UUID or 0
+};
+
+size_t swm_ids_count();  // interned ids
+
+std::ostream& operator<<(std::ostream& out, const SwmId &id);
+
+} // namespace swm
+
+namespace std {
+
+template <>
+struct hash<swm::SwmId> {
+  size_t operator()(const swm::SwmId &id) const { return id.hash(); }
+};
+
+} // namespace std
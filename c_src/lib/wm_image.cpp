@@ -1,275 +1,524 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_image.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmImage> SwmImage::FIELDS_INFO[] = {
+  field_info<SwmImage, std::pmr::string, &SwmImage::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmImage, SwmId, &SwmImage::id,
+             ei_buffer_to_id, encode_id,
+             SwmIdTerm>("id"),
+  field_info<SwmImage, std::pmr::vector<std::pmr::string>, &SwmImage::tags,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("tags"),
+  field_info<SwmImage, uint64_t, &SwmImage::size,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("size"),
+  field_info<SwmImage, SwmAtom, &SwmImage::kind,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("kind"),
+  field_info<SwmImage, std::pmr::string, &SwmImage::status,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("status"),
+  field_info<SwmImage, std::pmr::string, &SwmImage::remote_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("remote_id"),
+  field_info<SwmImage, std::pmr::string, &SwmImage::created,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("created"),
+  field_info<SwmImage, std::pmr::string, &SwmImage::updated,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("updated"),
+  field_info<SwmImage, std::pmr::string, &SwmImage::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmImage, uint64_t, &SwmImage::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmImage::SwmImage() {
 }
 
-SwmImage::SwmImage(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmImage: null" << std::endl;
-    return;
-  }
+SwmImage::SwmImage(const allocator_type &allocator)
+  : name(allocator),
+    tags(allocator),
+    status(allocator),
+    remote_id(allocator),
+    created(allocator),
+    updated(allocator),
+    comment(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmImage header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmImage::SwmImage(const SwmImage &other, const allocator_type &allocator)
+  : name(other.name, allocator),
+    id(other.id),
+    tags(other.tags, allocator),
+    size(other.size),
+    kind(other.kind),
+    status(other.status, allocator),
+    remote_id(other.remote_id, allocator),
+    created(other.created, allocator),
+    updated(other.updated, allocator),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmImage term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmImage::SwmImage(SwmImage &&other, const allocator_type &allocator)
+  : name(std::move(other.name), allocator),
+    id(other.id),
+    tags(std::move(other.tags), allocator),
+    size(other.size),
+    kind(other.kind),
+    status(std::move(other.status), allocator),
+    remote_id(std::move(other.remote_id), allocator),
+    created(std::move(other.created), allocator),
+    updated(std::move(other.updated), allocator),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init image::name at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmImage::allocator_type SwmImage::get_allocator() const {
+  return name.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->id)) {
-    std::cerr << "Could not init image::id at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmImage::SwmImage(const char* buf, int &index, const allocator_type &allocator)
+  : SwmImage(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->tags)) {
-    std::cerr << "Could not init image::tags at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmImage::SwmImage(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmImage(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->size)) {
-    std::cerr << "Could not init image::size at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_atom(buf, index, this->kind)) {
-    std::cerr << "Could not init image::kind at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmImage::SwmImage(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmImage(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->status)) {
-    std::cerr << "Could not init image::status at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmImage::validate(const char* buf, int &index) {
+  return entity_validate<SwmImage>(buf, index);
+}
 
-  if (ei_buffer_to_str(buf, index, this->remote_id)) {
-    std::cerr << "Could not init image::remote_id at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+void SwmImage::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
 
-  if (ei_buffer_to_str(buf, index, this->created)) {
-    std::cerr << "Could not init image::created at pos 9: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmImage::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmImage>(buf, index, writer);
+}
 
-  if (ei_buffer_to_str(buf, index, this->updated)) {
-    std::cerr << "Could not init image::updated at pos 10: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmPatch SwmImage::diff(const SwmImage &old_obj, const SwmImage &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init image::comment at pos 11: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmImage::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init image::revision at pos 12: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmImage::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip image::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmImage::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmImage::set_name(const std::string &new_val) {
+void SwmImage::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmImage::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmImage::set_id(const std::string &new_val) {
+void SwmImage::set_id(const SwmId &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmImage::set_tags(const std::vector<std::string> &new_val) {
+void SwmImage::set_tags(const std::pmr::vector<std::pmr::string> &new_val) {
   tags = new_val;
+  lazy_fields &= ~FIELD_TAGS;
+}
+
+void SwmImage::set_tags(std::pmr::vector<std::pmr::string> &&new_val) {
+  tags = std::move(new_val);
+  lazy_fields &= ~FIELD_TAGS;
 }
 
 void SwmImage::set_size(const uint64_t &new_val) {
   size = new_val;
+  lazy_fields &= ~FIELD_SIZE;
 }
 
-void SwmImage::set_kind(const std::string &new_val) {
+void SwmImage::set_kind(const SwmAtom &new_val) {
   kind = new_val;
+  lazy_fields &= ~FIELD_KIND;
 }
 
-void SwmImage::set_status(const std::string &new_val) {
+void SwmImage::set_status(const std::pmr::string &new_val) {
   status = new_val;
+  lazy_fields &= ~FIELD_STATUS;
 }
 
-void SwmImage::set_remote_id(const std::string &new_val) {
+void SwmImage::set_status(std::pmr::string &&new_val) {
+  status = std::move(new_val);
+  lazy_fields &= ~FIELD_STATUS;
+}
+
+void SwmImage::set_remote_id(const std::pmr::string &new_val) {
   remote_id = new_val;
+  lazy_fields &= ~FIELD_REMOTE_ID;
 }
 
-void SwmImage::set_created(const std::string &new_val) {
+void SwmImage::set_remote_id(std::pmr::string &&new_val) {
+  remote_id = std::move(new_val);
+  lazy_fields &= ~FIELD_REMOTE_ID;
+}
+
+void SwmImage::set_created(const std::pmr::string &new_val) {
   created = new_val;
+  lazy_fields &= ~FIELD_CREATED;
+}
+
+void SwmImage::set_created(std::pmr::string &&new_val) {
+  created = std::move(new_val);
+  lazy_fields &= ~FIELD_CREATED;
 }
 
-void SwmImage::set_updated(const std::string &new_val) {
+void SwmImage::set_updated(const std::pmr::string &new_val) {
   updated = new_val;
+  lazy_fields &= ~FIELD_UPDATED;
 }
 
-void SwmImage::set_comment(const std::string &new_val) {
+void SwmImage::set_updated(std::pmr::string &&new_val) {
+  updated = std::move(new_val);
+  lazy_fields &= ~FIELD_UPDATED;
+}
+
+void SwmImage::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmImage::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmImage::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-std::string SwmImage::get_name() const {
+const std::pmr::string& SwmImage::get_name() const {
   return name;
 }
 
-std::string SwmImage::get_id() const {
+const SwmId& SwmImage::get_id() const {
   return id;
 }
 
-std::vector<std::string> SwmImage::get_tags() const {
+const std::pmr::vector<std::pmr::string>& SwmImage::get_tags() const {
   return tags;
 }
 
-uint64_t SwmImage::get_size() const {
+const uint64_t& SwmImage::get_size() const {
   return size;
 }
 
-std::string SwmImage::get_kind() const {
+const SwmAtom& SwmImage::get_kind() const {
   return kind;
 }
 
-std::string SwmImage::get_status() const {
+const std::pmr::string& SwmImage::get_status() const {
   return status;
 }
 
-std::string SwmImage::get_remote_id() const {
+const std::pmr::string& SwmImage::get_remote_id() const {
   return remote_id;
 }
 
-std::string SwmImage::get_created() const {
+const std::pmr::string& SwmImage::get_created() const {
   return created;
 }
 
-std::string SwmImage::get_updated() const {
+const std::pmr::string& SwmImage::get_updated() const {
   return updated;
 }
 
-std::string SwmImage::get_comment() const {
+const std::pmr::string& SwmImage::get_comment() const {
   return comment;
 }
 
-uint64_t SwmImage::get_revision() const {
+const uint64_t& SwmImage::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_image(const char *buf, int &index, std::vector<SwmImage> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a image list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for image at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a image list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of image list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_image(const char *buf, int &index, std::vector<SwmImage> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_image(const char *buf, int &index, std::pmr::vector<SwmImage> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_image(const char *buf, int &index, std::vector<SwmImage> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a image list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmImage(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_image(const char* buf, int &index, SwmImage &obj) {
-  obj = SwmImage(buf, index);
+  obj = SwmImage(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmImage::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmImage::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode image" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_image(char* buf, int &index, const SwmImage &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_image(char* buf, int &index, const std::vector<SwmImage> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmImage &x) { x.encode(b, i); });
+}
+
+void swm::encode_image(char* buf, int &index, const std::pmr::vector<SwmImage> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmImage &x) { x.encode(b, i); });
+}
+
+int swm::encode_image(ei_x_buff &x, const std::vector<SwmImage> &array) {
+  int size = 0;
+  encode_image(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode image list" << std::endl;
+    return -1;
+  }
+  encode_image(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_image(ei_x_buff &x, const std::pmr::vector<SwmImage> &array) {
+  int size = 0;
+  encode_image(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode image list" << std::endl;
+    return -1;
+  }
+  encode_image(x.buff, x.index, array);
   return 0;
 }
 
 void SwmImage::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << id << separator;
-  if (tags.empty()) {
-    std::cerr << prefix << "tags: []" << separator;
-  } else {
-    std::cerr << prefix << "tags" << ": [";
-    for (const auto &q: tags) {
-      std::cerr << q << ",";
+  entity_print(*this, prefix, separator);
+}
+
+SwmImageView::SwmImageView() {
+}
+
+SwmImageView::SwmImageView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmImageView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 11)) {
+    std::cerr << "Could not create SwmImageView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmImageView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmImageView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+std::string_view SwmImageView::get_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmImageView::get_tags() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+uint64_t SwmImageView::get_size() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[3]);
+}
+
+std::string_view SwmImageView::get_kind() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[4]);
+}
+
+std::string_view SwmImageView::get_status() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[5]);
+}
+
+std::string_view SwmImageView::get_remote_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[6]);
+}
+
+std::string_view SwmImageView::get_created() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[7]);
+}
+
+std::string_view SwmImageView::get_updated() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[8]);
+}
+
+std::string_view SwmImageView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[9]);
+}
+
+uint64_t SwmImageView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[10]);
+}
+
+int swm::ei_buffer_to_image(const char* buf, int &index, SwmImageView &obj) {
+  obj = SwmImageView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_image(const char* buf, int &index, std::vector<SwmImageView> &array) {
+  const SwmListView<SwmImageView, ei_buffer_to_image> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmImageView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of image at " << index << std::endl;
+    return -1;
   }
-  std::cerr << prefix << size << separator;
-  std::cerr << prefix << kind << separator;
-  std::cerr << prefix << status << separator;
-  std::cerr << prefix << remote_id << separator;
-  std::cerr << prefix << created << separator;
-  std::cerr << prefix << updated << separator;
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  return 0;
 }
 
@@ -2,60 +2,173 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmImage:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 11;
+  static constexpr uint64_t FIELD_NAME = 1ull << 0;
+  static constexpr uint64_t FIELD_ID = 1ull << 1;
+  static constexpr uint64_t FIELD_TAGS = 1ull << 2;
+  static constexpr uint64_t FIELD_SIZE = 1ull << 3;
+  static constexpr uint64_t FIELD_KIND = 1ull << 4;
+  static constexpr uint64_t FIELD_STATUS = 1ull << 5;
+  static constexpr uint64_t FIELD_REMOTE_ID = 1ull << 6;
+  static constexpr uint64_t FIELD_CREATED = 1ull << 7;
+  static constexpr uint64_t FIELD_UPDATED = 1ull << 8;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 9;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 10;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "image";
+  static const SwmFieldInfo<SwmImage> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmImage();
-  SwmImage(const char*, int&);
+  explicit SwmImage(const allocator_type&);
+  SwmImage(const char*, int&, const allocator_type& = {});
+  SwmImage(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmImage(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmImage(const SwmImage&, const allocator_type&);
+  SwmImage(SwmImage&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmImage &old_obj, const SwmImage &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_name(const std::string&);
-  void set_id(const std::string&);
-  void set_tags(const std::vector<std::string>&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_id(const SwmId&);
+  void set_tags(const std::pmr::vector<std::pmr::string>&);
+  void set_tags(std::pmr::vector<std::pmr::string>&&);
   void set_size(const uint64_t&);
-  void set_kind(const std::string&);
-  void set_status(const std::string&);
-  void set_remote_id(const std::string&);
-  void set_created(const std::string&);
-  void set_updated(const std::string&);
-  void set_comment(const std::string&);
+  void set_kind(const SwmAtom&);
+  void set_status(const std::pmr::string&);
+  void set_status(std::pmr::string&&);
+  void set_remote_id(const std::pmr::string&);
+  void set_remote_id(std::pmr::string&&);
+  void set_created(const std::pmr::string&);
+  void set_created(std::pmr::string&&);
+  void set_updated(const std::pmr::string&);
+  void set_updated(std::pmr::string&&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  std::string get_name() const;
-  std::string get_id() const;
-  std::vector<std::string> get_tags() const;
-  uint64_t get_size() const;
-  std::string get_kind() const;
-  std::string get_status() const;
-  std::string get_remote_id() const;
-  std::string get_created() const;
-  std::string get_updated() const;
-  std::string get_comment() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const std::pmr::string& get_name() const;
+  const SwmId& get_id() const;
+  const std::pmr::vector<std::pmr::string>& get_tags() const;
+  const uint64_t& get_size() const;
+  const SwmAtom& get_kind() const;
+  const std::pmr::string& get_status() const;
+  const std::pmr::string& get_remote_id() const;
+  const std::pmr::string& get_created() const;
+  const std::pmr::string& get_updated() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_tags(Args&&... args) {
+    return tags.emplace_back(std::forward<Args>(args)...);
+  }
 
  private:
-  std::string name;
-  std::string id;
-  std::vector<std::string> tags;
-  uint64_t size;
-  std::string kind;
-  std::string status;
-  std::string remote_id;
-  std::string created;
-  std::string updated;
-  std::string comment;
-  uint64_t revision;
+  std::pmr::string name;
+  SwmId id;
+  std::pmr::vector<std::pmr::string> tags;
+  uint64_t size = 0;
+  SwmAtom kind;
+  std::pmr::string status;
+  std::pmr::string remote_id;
+  std::pmr::string created;
+  std::pmr::string updated;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmImageView;
+
 int ei_buffer_to_image(const char*, int&, std::vector<SwmImage>&);
+int ei_buffer_to_image(const char*, int&, std::pmr::vector<SwmImage>&);
+int ei_buffer_to_image(const char*, int&, std::vector<SwmImage>&, SwmThreadPool&);
 int ei_buffer_to_image(const char*, int&, SwmImage&);
+int ei_buffer_to_image(const char*, int&, std::vector<SwmImageView>&);
+int ei_buffer_to_image(const char*, int&, SwmImageView&);
+
+void encode_image(char*, int&, const SwmImage&);
+void encode_image(char*, int&, const std::vector<SwmImage>&);
+void encode_image(char*, int&, const std::pmr::vector<SwmImage>&);
+int encode_image(ei_x_buff&, const std::vector<SwmImage>&);
+int encode_image(ei_x_buff&, const std::pmr::vector<SwmImage>&);
+
+class SwmImageView {
+
+ public:
+  SwmImageView();
+  SwmImageView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_name() const;
+  std::string_view get_id() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_tags() const;
+  uint64_t get_size() const;
+  std::string_view get_kind() const;
+  std::string_view get_status() const;
+  std::string_view get_remote_id() const;
+  std::string_view get_created() const;
+  std::string_view get_updated() const;
+  std::string_view get_comment() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 11> offsets = {};
+
+};
 
 } // namespace swm
@@ -2,13 +2,16 @@
 #include "wm_io.h"
 
 #include <cstring>
+#include <new>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
+#include <zlib.h>
 
 #define LOG_OUT_STREAM stderr
+#define INFLATE_CHUNK_SIZE 65536
 
 static int g_log_level = SWM_LOG_LEVEL_INFO;
 static FILE *g_log_stream = nullptr;
@@ -120,6 +123,73 @@ bool swm_write_exact(std::ostream *stream, char *buf, size_t len) {
   return stream->good();
 }
 
+// Inflates the zlib stream of a compressed binary directly into out while
+// the stream is read by chunks.
+static bool inflate_exact(std::istream *stream, size_t len, char *out, size_t out_size) {
+  z_stream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  if (inflateInit(&zs) != Z_OK) {
+    return false;
+  }
+  char chunk[INFLATE_CHUNK_SIZE];
+  zs.next_out = reinterpret_cast<Bytef*>(out);
+  zs.avail_out = static_cast<uInt>(out_size);
+  int ret = Z_OK;
+  while (len > 0 && ret == Z_OK) {
+    const size_t chunk_size = len < sizeof(chunk) ? len : sizeof(chunk);
+    if (!swm_read_exact(stream, chunk, chunk_size)) {
+      break;
+    }
+    len -= chunk_size;
+    zs.next_in = reinterpret_cast<Bytef*>(chunk);
+    zs.avail_in = static_cast<uInt>(chunk_size);
+    ret = inflate(&zs, Z_NO_FLUSH);
+  }
+  const bool done = ret == Z_STREAM_END && len == 0 && zs.avail_in == 0 && zs.avail_out == 0;
+  inflateEnd(&zs);
+  return done;
+}
+
+// Reads len bytes of an erlang external term format binary. A compressed
+// binary (term_to_binary(T, [compressed])) is inflated while it is read, so
+// the returned buffer always starts with the version followed by the term.
+// The buffer size is put into size, the buffer must be deleted with delete[].
+char* swm_read_etf(std::istream *stream, uint32_t len, uint32_t *size) {
+  char header[2];
+  if (len < 2 || !swm_read_exact(stream, header, 2)) {
+    return nullptr;
+  }
+  if (static_cast<unsigned char>(header[1]) != ERLANG_COMPRESSED_TAG) {
+    char *buf = new (std::nothrow) char[len];
+    if (!buf) {
+      return nullptr;
+    }
+    std::memcpy(buf, header, 2);
+    if (!swm_read_exact(stream, buf + 2, len - 2)) {
+      delete[] buf;
+      return nullptr;
+    }
+    *size = len;
+    return buf;
+  }
+
+  uint32_t term_size = 0;
+  if (len < 6 || !swm_read_length(stream, &term_size) || term_size == UINT32_MAX) {
+    return nullptr;
+  }
+  char *buf = new (std::nothrow) char[term_size + 1ul];
+  if (!buf) {
+    return nullptr;
+  }
+  buf[0] = header[0];
+  if (!inflate_exact(stream, len - 6, buf + 1, term_size)) {
+    delete[] buf;
+    return nullptr;
+  }
+  *size = term_size + 1;
+  return buf;
+}
+
 void print_ei_buf(const char* buf, int index) {
   ei_print_term(LOG_OUT_STREAM, buf, &index);
   fprintf(LOG_OUT_STREAM, "\n");
@@ -13,6 +13,7 @@
 #define SWM_LOG_LEVEL_DEBUG2 2
 
 #define ERLANG_BINARY_FORMAT_VERSION 131
+#define ERLANG_COMPRESSED_TAG 80
 
 void swm_log_init(int level, FILE *stream);
 int swm_get_log_level();
@@ -24,6 +25,7 @@ void swm_logdd(const char* message, ...);
 bool swm_read_length(std::istream *stream, uint32_t *len);
 bool swm_read_exact(std::istream *stream, char *buf, size_t len);
 bool swm_write_exact(std::ostream *stream, char *buf, size_t len);
+char* swm_read_etf(std::istream *stream, uint32_t len, uint32_t *size);
 
 void print_ei_buf(const char* buf, int index);
 
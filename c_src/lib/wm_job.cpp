@@ -1,684 +1,1035 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_job.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 #include "wm_resource.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmJob> SwmJob::FIELDS_INFO[] = {
+  field_info<SwmJob, SwmId, &SwmJob::id,
+             ei_buffer_to_id, encode_id,
+             SwmIdTerm>("id"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::cluster_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("cluster_id"),
+  field_info<SwmJob, std::pmr::vector<std::pmr::string>, &SwmJob::nodes,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("nodes"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::state,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("state"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::state_details,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("state_details"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::start_time,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("start_time"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::submit_time,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("submit_time"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::end_time,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("end_time"),
+  field_info<SwmJob, uint64_t, &SwmJob::duration,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("duration"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::job_stdin,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("job_stdin"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::job_stdout,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("job_stdout"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::job_stderr,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("job_stderr"),
+  field_info<SwmJob, std::pmr::vector<std::pmr::string>, &SwmJob::input_files,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("input_files"),
+  field_info<SwmJob, std::pmr::vector<std::pmr::string>, &SwmJob::output_files,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("output_files"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::workdir,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("workdir"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::user_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("user_id"),
+  field_info<SwmJob, std::pmr::vector<std::pmr::string>, &SwmJob::hooks,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("hooks"),
+  field_info<SwmJob, std::pmr::vector<SwmTupleStrStr>, &SwmJob::env,
+             ei_buffer_to_tuple_str_str, encode_tuple_str_str,
+             SwmListTerm<SwmTupleTerm<SwmStrTerm, SwmStrTerm>>>("env"),
+  field_info<SwmJob, std::pmr::vector<SwmTupleAtomStr>, &SwmJob::deps,
+             ei_buffer_to_tuple_atom_str, encode_tuple_atom_str,
+             SwmListTerm<SwmTupleTerm<SwmAtomTerm, SwmStrTerm>>>("deps"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::account_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("account_id"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::gang_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("gang_id"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::execution_path,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("execution_path"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::script_content,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("script_content"),
+  field_info<SwmJob, std::pmr::vector<SwmResource>, &SwmJob::request,
+             ei_buffer_to_resource, encode_resource,
+             SwmListTerm<SwmEntityTerm<SwmResource>>>("request"),
+  field_info<SwmJob, std::pmr::vector<SwmResource>, &SwmJob::resources,
+             ei_buffer_to_resource, encode_resource,
+             SwmListTerm<SwmEntityTerm<SwmResource>>>("resources"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::container,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("container"),
+  field_info<SwmJob, SwmAtom, &SwmJob::relocatable,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("relocatable"),
+  field_info<SwmJob, uint64_t, &SwmJob::exitcode,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("exitcode"),
+  field_info<SwmJob, uint64_t, &SwmJob::signal,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("signal"),
+  field_info<SwmJob, uint64_t, &SwmJob::priority,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("priority"),
+  field_info<SwmJob, std::pmr::string, &SwmJob::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmJob, uint64_t, &SwmJob::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmJob::SwmJob() {
 }
 
-SwmJob::SwmJob(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmJob: null" << std::endl;
-    return;
-  }
-
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmJob header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmJob term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->id)) {
-    std::cerr << "Could not init job::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init job::name at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->cluster_id)) {
-    std::cerr << "Could not init job::cluster_id at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->nodes)) {
-    std::cerr << "Could not init job::nodes at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->state)) {
-    std::cerr << "Could not init job::state at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->state_details)) {
-    std::cerr << "Could not init job::state_details at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->start_time)) {
-    std::cerr << "Could not init job::start_time at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->submit_time)) {
-    std::cerr << "Could not init job::submit_time at pos 9: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->end_time)) {
-    std::cerr << "Could not init job::end_time at pos 10: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->duration)) {
-    std::cerr << "Could not init job::duration at pos 11: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->job_stdin)) {
-    std::cerr << "Could not init job::job_stdin at pos 12: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->job_stdout)) {
-    std::cerr << "Could not init job::job_stdout at pos 13: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->job_stderr)) {
-    std::cerr << "Could not init job::job_stderr at pos 14: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->input_files)) {
-    std::cerr << "Could not init job::input_files at pos 15: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->output_files)) {
-    std::cerr << "Could not init job::output_files at pos 16: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->workdir)) {
-    std::cerr << "Could not init job::workdir at pos 17: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->user_id)) {
-    std::cerr << "Could not init job::user_id at pos 18: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->hooks)) {
-    std::cerr << "Could not init job::hooks at pos 19: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_tuple_str_str(buf, index, this->env)) {
-    std::cerr << "Could not init job::env at pos 20: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_tuple_atom_str(buf, index, this->deps)) {
-    std::cerr << "Could not init job::deps at pos 21: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->account_id)) {
-    std::cerr << "Could not init job::account_id at pos 22: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->gang_id)) {
-    std::cerr << "Could not init job::gang_id at pos 23: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmJob::SwmJob(const allocator_type &allocator)
+  : name(allocator),
+    cluster_id(allocator),
+    nodes(allocator),
+    state(allocator),
+    state_details(allocator),
+    start_time(allocator),
+    submit_time(allocator),
+    end_time(allocator),
+    job_stdin(allocator),
+    job_stdout(allocator),
+    job_stderr(allocator),
+    input_files(allocator),
+    output_files(allocator),
+    workdir(allocator),
+    user_id(allocator),
+    hooks(allocator),
+    env(allocator),
+    deps(allocator),
+    account_id(allocator),
+    gang_id(allocator),
+    execution_path(allocator),
+    script_content(allocator),
+    request(allocator),
+    resources(allocator),
+    container(allocator),
+    comment(allocator) {
+}
+
+SwmJob::SwmJob(const SwmJob &other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name, allocator),
+    cluster_id(other.cluster_id, allocator),
+    nodes(other.nodes, allocator),
+    state(other.state, allocator),
+    state_details(other.state_details, allocator),
+    start_time(other.start_time, allocator),
+    submit_time(other.submit_time, allocator),
+    end_time(other.end_time, allocator),
+    duration(other.duration),
+    job_stdin(other.job_stdin, allocator),
+    job_stdout(other.job_stdout, allocator),
+    job_stderr(other.job_stderr, allocator),
+    input_files(other.input_files, allocator),
+    output_files(other.output_files, allocator),
+    workdir(other.workdir, allocator),
+    user_id(other.user_id, allocator),
+    hooks(other.hooks, allocator),
+    env(other.env, allocator),
+    deps(other.deps, allocator),
+    account_id(other.account_id, allocator),
+    gang_id(other.gang_id, allocator),
+    execution_path(other.execution_path, allocator),
+    script_content(other.script_content, allocator),
+    request(other.request, allocator),
+    resources(other.resources, allocator),
+    container(other.container, allocator),
+    relocatable(other.relocatable),
+    exitcode(other.exitcode),
+    signal(other.signal),
+    priority(other.priority),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
+
+SwmJob::SwmJob(SwmJob &&other, const allocator_type &allocator)
+  : id(other.id),
+    name(std::move(other.name), allocator),
+    cluster_id(std::move(other.cluster_id), allocator),
+    nodes(std::move(other.nodes), allocator),
+    state(std::move(other.state), allocator),
+    state_details(std::move(other.state_details), allocator),
+    start_time(std::move(other.start_time), allocator),
+    submit_time(std::move(other.submit_time), allocator),
+    end_time(std::move(other.end_time), allocator),
+    duration(other.duration),
+    job_stdin(std::move(other.job_stdin), allocator),
+    job_stdout(std::move(other.job_stdout), allocator),
+    job_stderr(std::move(other.job_stderr), allocator),
+    input_files(std::move(other.input_files), allocator),
+    output_files(std::move(other.output_files), allocator),
+    workdir(std::move(other.workdir), allocator),
+    user_id(std::move(other.user_id), allocator),
+    hooks(std::move(other.hooks), allocator),
+    env(std::move(other.env), allocator),
+    deps(std::move(other.deps), allocator),
+    account_id(std::move(other.account_id), allocator),
+    gang_id(std::move(other.gang_id), allocator),
+    execution_path(std::move(other.execution_path), allocator),
+    script_content(std::move(other.script_content), allocator),
+    request(std::move(other.request), allocator),
+    resources(std::move(other.resources), allocator),
+    container(std::move(other.container), allocator),
+    relocatable(other.relocatable),
+    exitcode(other.exitcode),
+    signal(other.signal),
+    priority(other.priority),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
+
+SwmJob::allocator_type SwmJob::get_allocator() const {
+  return name.get_allocator();
+}
+
+SwmJob::SwmJob(const char* buf, int &index, const allocator_type &allocator)
+  : SwmJob(buf, index, FIELD_ALL, allocator) {
+}
+
+SwmJob::SwmJob(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmJob(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_str(buf, index, this->execution_path)) {
-    std::cerr << "Could not init job::execution_path at pos 24: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->script_content)) {
-    std::cerr << "Could not init job::script_content at pos 25: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_resource(buf, index, this->request)) {
-    std::cerr << "Could not init job::request at pos 26: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_resource(buf, index, this->resources)) {
-    std::cerr << "Could not init job::resources at pos 27: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmJob::SwmJob(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmJob(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->container)) {
-    std::cerr << "Could not init job::container at pos 28: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmJob::validate(const char* buf, int &index) {
+  return entity_validate<SwmJob>(buf, index);
+}
 
-  if (ei_buffer_to_atom(buf, index, this->relocatable)) {
-    std::cerr << "Could not init job::relocatable at pos 29: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+void SwmJob::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->exitcode)) {
-    std::cerr << "Could not init job::exitcode at pos 30: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmJob::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmJob>(buf, index, writer);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->signal)) {
-    std::cerr << "Could not init job::signal at pos 31: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmPatch SwmJob::diff(const SwmJob &old_obj, const SwmJob &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->priority)) {
-    std::cerr << "Could not init job::priority at pos 32: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmJob::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init job::comment at pos 33: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmJob::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip job::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
   }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init job::revision at pos 34: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmJob::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmJob::set_id(const std::string &new_val) {
+void SwmJob::set_id(const SwmId &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmJob::set_name(const std::string &new_val) {
+void SwmJob::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmJob::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmJob::set_cluster_id(const std::string &new_val) {
+void SwmJob::set_cluster_id(const std::pmr::string &new_val) {
   cluster_id = new_val;
+  lazy_fields &= ~FIELD_CLUSTER_ID;
 }
 
-void SwmJob::set_nodes(const std::vector<std::string> &new_val) {
+void SwmJob::set_cluster_id(std::pmr::string &&new_val) {
+  cluster_id = std::move(new_val);
+  lazy_fields &= ~FIELD_CLUSTER_ID;
+}
+
+void SwmJob::set_nodes(const std::pmr::vector<std::pmr::string> &new_val) {
   nodes = new_val;
+  lazy_fields &= ~FIELD_NODES;
+}
+
+void SwmJob::set_nodes(std::pmr::vector<std::pmr::string> &&new_val) {
+  nodes = std::move(new_val);
+  lazy_fields &= ~FIELD_NODES;
 }
 
-void SwmJob::set_state(const std::string &new_val) {
+void SwmJob::set_state(const std::pmr::string &new_val) {
   state = new_val;
+  lazy_fields &= ~FIELD_STATE;
+}
+
+void SwmJob::set_state(std::pmr::string &&new_val) {
+  state = std::move(new_val);
+  lazy_fields &= ~FIELD_STATE;
 }
 
-void SwmJob::set_state_details(const std::string &new_val) {
+void SwmJob::set_state_details(const std::pmr::string &new_val) {
   state_details = new_val;
+  lazy_fields &= ~FIELD_STATE_DETAILS;
 }
 
-void SwmJob::set_start_time(const std::string &new_val) {
+void SwmJob::set_state_details(std::pmr::string &&new_val) {
+  state_details = std::move(new_val);
+  lazy_fields &= ~FIELD_STATE_DETAILS;
+}
+
+void SwmJob::set_start_time(const std::pmr::string &new_val) {
   start_time = new_val;
+  lazy_fields &= ~FIELD_START_TIME;
+}
+
+void SwmJob::set_start_time(std::pmr::string &&new_val) {
+  start_time = std::move(new_val);
+  lazy_fields &= ~FIELD_START_TIME;
 }
 
-void SwmJob::set_submit_time(const std::string &new_val) {
+void SwmJob::set_submit_time(const std::pmr::string &new_val) {
   submit_time = new_val;
+  lazy_fields &= ~FIELD_SUBMIT_TIME;
 }
 
-void SwmJob::set_end_time(const std::string &new_val) {
+void SwmJob::set_submit_time(std::pmr::string &&new_val) {
+  submit_time = std::move(new_val);
+  lazy_fields &= ~FIELD_SUBMIT_TIME;
+}
+
+void SwmJob::set_end_time(const std::pmr::string &new_val) {
   end_time = new_val;
+  lazy_fields &= ~FIELD_END_TIME;
+}
+
+void SwmJob::set_end_time(std::pmr::string &&new_val) {
+  end_time = std::move(new_val);
+  lazy_fields &= ~FIELD_END_TIME;
 }
 
 void SwmJob::set_duration(const uint64_t &new_val) {
   duration = new_val;
+  lazy_fields &= ~FIELD_DURATION;
 }
 
-void SwmJob::set_job_stdin(const std::string &new_val) {
+void SwmJob::set_job_stdin(const std::pmr::string &new_val) {
   job_stdin = new_val;
+  lazy_fields &= ~FIELD_JOB_STDIN;
 }
 
-void SwmJob::set_job_stdout(const std::string &new_val) {
+void SwmJob::set_job_stdin(std::pmr::string &&new_val) {
+  job_stdin = std::move(new_val);
+  lazy_fields &= ~FIELD_JOB_STDIN;
+}
+
+void SwmJob::set_job_stdout(const std::pmr::string &new_val) {
   job_stdout = new_val;
+  lazy_fields &= ~FIELD_JOB_STDOUT;
+}
+
+void SwmJob::set_job_stdout(std::pmr::string &&new_val) {
+  job_stdout = std::move(new_val);
+  lazy_fields &= ~FIELD_JOB_STDOUT;
 }
 
-void SwmJob::set_job_stderr(const std::string &new_val) {
+void SwmJob::set_job_stderr(const std::pmr::string &new_val) {
   job_stderr = new_val;
+  lazy_fields &= ~FIELD_JOB_STDERR;
+}
+
+void SwmJob::set_job_stderr(std::pmr::string &&new_val) {
+  job_stderr = std::move(new_val);
+  lazy_fields &= ~FIELD_JOB_STDERR;
 }
 
-void SwmJob::set_input_files(const std::vector<std::string> &new_val) {
+void SwmJob::set_input_files(const std::pmr::vector<std::pmr::string> &new_val) {
   input_files = new_val;
+  lazy_fields &= ~FIELD_INPUT_FILES;
+}
+
+void SwmJob::set_input_files(std::pmr::vector<std::pmr::string> &&new_val) {
+  input_files = std::move(new_val);
+  lazy_fields &= ~FIELD_INPUT_FILES;
 }
 
-void SwmJob::set_output_files(const std::vector<std::string> &new_val) {
+void SwmJob::set_output_files(const std::pmr::vector<std::pmr::string> &new_val) {
   output_files = new_val;
+  lazy_fields &= ~FIELD_OUTPUT_FILES;
+}
+
+void SwmJob::set_output_files(std::pmr::vector<std::pmr::string> &&new_val) {
+  output_files = std::move(new_val);
+  lazy_fields &= ~FIELD_OUTPUT_FILES;
 }
 
-void SwmJob::set_workdir(const std::string &new_val) {
+void SwmJob::set_workdir(const std::pmr::string &new_val) {
   workdir = new_val;
+  lazy_fields &= ~FIELD_WORKDIR;
 }
 
-void SwmJob::set_user_id(const std::string &new_val) {
+void SwmJob::set_workdir(std::pmr::string &&new_val) {
+  workdir = std::move(new_val);
+  lazy_fields &= ~FIELD_WORKDIR;
+}
+
+void SwmJob::set_user_id(const std::pmr::string &new_val) {
   user_id = new_val;
+  lazy_fields &= ~FIELD_USER_ID;
+}
+
+void SwmJob::set_user_id(std::pmr::string &&new_val) {
+  user_id = std::move(new_val);
+  lazy_fields &= ~FIELD_USER_ID;
 }
 
-void SwmJob::set_hooks(const std::vector<std::string> &new_val) {
+void SwmJob::set_hooks(const std::pmr::vector<std::pmr::string> &new_val) {
   hooks = new_val;
+  lazy_fields &= ~FIELD_HOOKS;
 }
 
-void SwmJob::set_env(const std::vector<SwmTupleStrStr> &new_val) {
+void SwmJob::set_hooks(std::pmr::vector<std::pmr::string> &&new_val) {
+  hooks = std::move(new_val);
+  lazy_fields &= ~FIELD_HOOKS;
+}
+
+void SwmJob::set_env(const std::pmr::vector<SwmTupleStrStr> &new_val) {
   env = new_val;
+  lazy_fields &= ~FIELD_ENV;
 }
 
-void SwmJob::set_deps(const std::vector<SwmTupleAtomStr> &new_val) {
+void SwmJob::set_env(std::pmr::vector<SwmTupleStrStr> &&new_val) {
+  env = std::move(new_val);
+  lazy_fields &= ~FIELD_ENV;
+}
+
+void SwmJob::set_deps(const std::pmr::vector<SwmTupleAtomStr> &new_val) {
   deps = new_val;
+  lazy_fields &= ~FIELD_DEPS;
 }
 
-void SwmJob::set_account_id(const std::string &new_val) {
+void SwmJob::set_deps(std::pmr::vector<SwmTupleAtomStr> &&new_val) {
+  deps = std::move(new_val);
+  lazy_fields &= ~FIELD_DEPS;
+}
+
+void SwmJob::set_account_id(const std::pmr::string &new_val) {
   account_id = new_val;
+  lazy_fields &= ~FIELD_ACCOUNT_ID;
+}
+
+void SwmJob::set_account_id(std::pmr::string &&new_val) {
+  account_id = std::move(new_val);
+  lazy_fields &= ~FIELD_ACCOUNT_ID;
 }
 
-void SwmJob::set_gang_id(const std::string &new_val) {
+void SwmJob::set_gang_id(const std::pmr::string &new_val) {
   gang_id = new_val;
+  lazy_fields &= ~FIELD_GANG_ID;
 }
 
-void SwmJob::set_execution_path(const std::string &new_val) {
+void SwmJob::set_gang_id(std::pmr::string &&new_val) {
+  gang_id = std::move(new_val);
+  lazy_fields &= ~FIELD_GANG_ID;
+}
+
+void SwmJob::set_execution_path(const std::pmr::string &new_val) {
   execution_path = new_val;
+  lazy_fields &= ~FIELD_EXECUTION_PATH;
+}
+
+void SwmJob::set_execution_path(std::pmr::string &&new_val) {
+  execution_path = std::move(new_val);
+  lazy_fields &= ~FIELD_EXECUTION_PATH;
 }
 
-void SwmJob::set_script_content(const std::string &new_val) {
+void SwmJob::set_script_content(const std::pmr::string &new_val) {
   script_content = new_val;
+  lazy_fields &= ~FIELD_SCRIPT_CONTENT;
+}
+
+void SwmJob::set_script_content(std::pmr::string &&new_val) {
+  script_content = std::move(new_val);
+  lazy_fields &= ~FIELD_SCRIPT_CONTENT;
 }
 
-void SwmJob::set_request(const std::vector<SwmResource> &new_val) {
+void SwmJob::set_request(const std::pmr::vector<SwmResource> &new_val) {
   request = new_val;
+  lazy_fields &= ~FIELD_REQUEST;
 }
 
-void SwmJob::set_resources(const std::vector<SwmResource> &new_val) {
+void SwmJob::set_request(std::pmr::vector<SwmResource> &&new_val) {
+  request = std::move(new_val);
+  lazy_fields &= ~FIELD_REQUEST;
+}
+
+void SwmJob::set_resources(const std::pmr::vector<SwmResource> &new_val) {
   resources = new_val;
+  lazy_fields &= ~FIELD_RESOURCES;
 }
 
-void SwmJob::set_container(const std::string &new_val) {
+void SwmJob::set_resources(std::pmr::vector<SwmResource> &&new_val) {
+  resources = std::move(new_val);
+  lazy_fields &= ~FIELD_RESOURCES;
+}
+
+void SwmJob::set_container(const std::pmr::string &new_val) {
   container = new_val;
+  lazy_fields &= ~FIELD_CONTAINER;
 }
 
-void SwmJob::set_relocatable(const std::string &new_val) {
+void SwmJob::set_container(std::pmr::string &&new_val) {
+  container = std::move(new_val);
+  lazy_fields &= ~FIELD_CONTAINER;
+}
+
+void SwmJob::set_relocatable(const SwmAtom &new_val) {
   relocatable = new_val;
+  lazy_fields &= ~FIELD_RELOCATABLE;
 }
 
 void SwmJob::set_exitcode(const uint64_t &new_val) {
   exitcode = new_val;
+  lazy_fields &= ~FIELD_EXITCODE;
 }
 
 void SwmJob::set_signal(const uint64_t &new_val) {
   signal = new_val;
+  lazy_fields &= ~FIELD_SIGNAL;
 }
 
 void SwmJob::set_priority(const uint64_t &new_val) {
   priority = new_val;
+  lazy_fields &= ~FIELD_PRIORITY;
 }
 
-void SwmJob::set_comment(const std::string &new_val) {
+void SwmJob::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmJob::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmJob::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-std::string SwmJob::get_id() const {
+const SwmId& SwmJob::get_id() const {
   return id;
 }
 
-std::string SwmJob::get_name() const {
+const std::pmr::string& SwmJob::get_name() const {
   return name;
 }
 
-std::string SwmJob::get_cluster_id() const {
+const std::pmr::string& SwmJob::get_cluster_id() const {
   return cluster_id;
 }
 
-std::vector<std::string> SwmJob::get_nodes() const {
+const std::pmr::vector<std::pmr::string>& SwmJob::get_nodes() const {
   return nodes;
 }
 
-std::string SwmJob::get_state() const {
+const std::pmr::string& SwmJob::get_state() const {
   return state;
 }
 
-std::string SwmJob::get_state_details() const {
+const std::pmr::string& SwmJob::get_state_details() const {
   return state_details;
 }
 
-std::string SwmJob::get_start_time() const {
+const std::pmr::string& SwmJob::get_start_time() const {
   return start_time;
 }
 
-std::string SwmJob::get_submit_time() const {
+const std::pmr::string& SwmJob::get_submit_time() const {
   return submit_time;
 }
 
-std::string SwmJob::get_end_time() const {
+const std::pmr::string& SwmJob::get_end_time() const {
   return end_time;
 }
 
-uint64_t SwmJob::get_duration() const {
+const uint64_t& SwmJob::get_duration() const {
   return duration;
 }
 
-std::string SwmJob::get_job_stdin() const {
+const std::pmr::string& SwmJob::get_job_stdin() const {
   return job_stdin;
 }
 
-std::string SwmJob::get_job_stdout() const {
+const std::pmr::string& SwmJob::get_job_stdout() const {
   return job_stdout;
 }
 
-std::string SwmJob::get_job_stderr() const {
+const std::pmr::string& SwmJob::get_job_stderr() const {
   return job_stderr;
 }
 
-std::vector<std::string> SwmJob::get_input_files() const {
+const std::pmr::vector<std::pmr::string>& SwmJob::get_input_files() const {
   return input_files;
 }
 
-std::vector<std::string> SwmJob::get_output_files() const {
+const std::pmr::vector<std::pmr::string>& SwmJob::get_output_files() const {
   return output_files;
 }
 
-std::string SwmJob::get_workdir() const {
+const std::pmr::string& SwmJob::get_workdir() const {
   return workdir;
 }
 
-std::string SwmJob::get_user_id() const {
+const std::pmr::string& SwmJob::get_user_id() const {
   return user_id;
 }
 
-std::vector<std::string> SwmJob::get_hooks() const {
+const std::pmr::vector<std::pmr::string>& SwmJob::get_hooks() const {
   return hooks;
 }
 
-std::vector<SwmTupleStrStr> SwmJob::get_env() const {
+const std::pmr::vector<SwmTupleStrStr>& SwmJob::get_env() const {
   return env;
 }
 
-std::vector<SwmTupleAtomStr> SwmJob::get_deps() const {
+const std::pmr::vector<SwmTupleAtomStr>& SwmJob::get_deps() const {
   return deps;
 }
 
-std::string SwmJob::get_account_id() const {
+const std::pmr::string& SwmJob::get_account_id() const {
   return account_id;
 }
 
-std::string SwmJob::get_gang_id() const {
+const std::pmr::string& SwmJob::get_gang_id() const {
   return gang_id;
 }
 
-std::string SwmJob::get_execution_path() const {
+const std::pmr::string& SwmJob::get_execution_path() const {
   return execution_path;
 }
 
-std::string SwmJob::get_script_content() const {
+const std::pmr::string& SwmJob::get_script_content() const {
   return script_content;
 }
 
-std::vector<SwmResource> SwmJob::get_request() const {
+const std::pmr::vector<SwmResource>& SwmJob::get_request() const {
   return request;
 }
 
-std::vector<SwmResource> SwmJob::get_resources() const {
+const std::pmr::vector<SwmResource>& SwmJob::get_resources() const {
   return resources;
 }
 
-std::string SwmJob::get_container() const {
+const std::pmr::string& SwmJob::get_container() const {
   return container;
 }
 
-std::string SwmJob::get_relocatable() const {
+const SwmAtom& SwmJob::get_relocatable() const {
   return relocatable;
 }
 
-uint64_t SwmJob::get_exitcode() const {
+const uint64_t& SwmJob::get_exitcode() const {
   return exitcode;
 }
 
-uint64_t SwmJob::get_signal() const {
+const uint64_t& SwmJob::get_signal() const {
   return signal;
 }
 
-uint64_t SwmJob::get_priority() const {
+const uint64_t& SwmJob::get_priority() const {
   return priority;
 }
 
-std::string SwmJob::get_comment() const {
+const std::pmr::string& SwmJob::get_comment() const {
   return comment;
 }
 
-uint64_t SwmJob::get_revision() const {
+const uint64_t& SwmJob::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_job(const char *buf, int &index, std::vector<SwmJob> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a job list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for job at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a job list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of job list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
-int swm::ei_buffer_to_job(const char* buf, int &index, SwmJob &obj) {
-  obj = SwmJob(buf, index);
-  return 0;
+} // namespace
+
+int swm::ei_buffer_to_job(const char *buf, int &index, std::vector<SwmJob> &array) {
+  return buffer_to_array(buf, index, array);
 }
 
-void SwmJob::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << cluster_id << separator;
-  if (nodes.empty()) {
-    std::cerr << prefix << "nodes: []" << separator;
-  } else {
-    std::cerr << prefix << "nodes" << ": [";
-    for (const auto &q: nodes) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+int swm::ei_buffer_to_job(const char *buf, int &index, std::pmr::vector<SwmJob> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_job(const char *buf, int &index, std::vector<SwmJob> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a job list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
   }
-  std::cerr << prefix << state << separator;
-  std::cerr << prefix << state_details << separator;
-  std::cerr << prefix << start_time << separator;
-  std::cerr << prefix << submit_time << separator;
-  std::cerr << prefix << end_time << separator;
-  std::cerr << prefix << duration << separator;
-  std::cerr << prefix << job_stdin << separator;
-  std::cerr << prefix << job_stdout << separator;
-  std::cerr << prefix << job_stderr << separator;
-  if (input_files.empty()) {
-    std::cerr << prefix << "input_files: []" << separator;
-  } else {
-    std::cerr << prefix << "input_files" << ": [";
-    for (const auto &q: input_files) {
-      std::cerr << q << ",";
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmJob(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
     }
-    std::cerr << "]" << separator;
+  });
+  return failed ? -1 : 0;
+}
+
+int swm::ei_buffer_to_job(const char* buf, int &index, SwmJob &obj) {
+  obj = SwmJob(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmJob::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmJob::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode job" << std::endl;
+    return -1;
   }
-  if (output_files.empty()) {
-    std::cerr << prefix << "output_files: []" << separator;
-  } else {
-    std::cerr << prefix << "output_files" << ": [";
-    for (const auto &q: output_files) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_job(char* buf, int &index, const SwmJob &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_job(char* buf, int &index, const std::vector<SwmJob> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmJob &x) { x.encode(b, i); });
+}
+
+void swm::encode_job(char* buf, int &index, const std::pmr::vector<SwmJob> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmJob &x) { x.encode(b, i); });
+}
+
+int swm::encode_job(ei_x_buff &x, const std::vector<SwmJob> &array) {
+  int size = 0;
+  encode_job(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode job list" << std::endl;
+    return -1;
   }
-  std::cerr << prefix << workdir << separator;
-  std::cerr << prefix << user_id << separator;
-  if (hooks.empty()) {
-    std::cerr << prefix << "hooks: []" << separator;
-  } else {
-    std::cerr << prefix << "hooks" << ": [";
-    for (const auto &q: hooks) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  encode_job(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_job(ei_x_buff &x, const std::pmr::vector<SwmJob> &array) {
+  int size = 0;
+  encode_job(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode job list" << std::endl;
+    return -1;
   }
-  if (env.empty()) {
-    std::cerr << prefix << "env: []" << separator;
-  } else {
-    std::cerr << prefix << "env" << ": [";
-    for (const auto &q: env) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  encode_job(x.buff, x.index, array);
+  return 0;
+}
+
+void SwmJob::print(const std::string &prefix, const char separator) const {
+  entity_print(*this, prefix, separator);
+}
+
+SwmJobView::SwmJobView() {
+}
+
+SwmJobView::SwmJobView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmJobView: null" << std::endl;
+    return;
   }
-  if (deps.empty()) {
-    std::cerr << prefix << "deps: []" << separator;
-  } else {
-    std::cerr << prefix << "deps" << ": [";
-    for (const auto &q: deps) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  if (skip_entity_fields(buf, index, offsets.data(), 33)) {
+    std::cerr << "Could not create SwmJobView at " << index << std::endl;
+    this->buf = nullptr;
   }
-  std::cerr << prefix << account_id << separator;
-  std::cerr << prefix << gang_id << separator;
-  std::cerr << prefix << execution_path << separator;
-  std::cerr << prefix << script_content << separator;
-  if (request.empty()) {
-    std::cerr << prefix << "request: []" << separator;
-  } else {
-    std::cerr << prefix << "request" << ": [";
-    for (const auto &q: request) {
-      q.print(prefix, separator);
+}
+
+bool SwmJobView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmJobView::get_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+std::string_view SwmJobView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmJobView::get_cluster_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmJobView::get_nodes() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[3]);
+}
+
+std::string_view SwmJobView::get_state() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[4]);
+}
+
+std::string_view SwmJobView::get_state_details() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[5]);
+}
+
+std::string_view SwmJobView::get_start_time() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[6]);
+}
+
+std::string_view SwmJobView::get_submit_time() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[7]);
+}
+
+std::string_view SwmJobView::get_end_time() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[8]);
+}
+
+uint64_t SwmJobView::get_duration() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[9]);
+}
+
+std::string_view SwmJobView::get_job_stdin() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[10]);
+}
+
+std::string_view SwmJobView::get_job_stdout() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[11]);
+}
+
+std::string_view SwmJobView::get_job_stderr() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[12]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmJobView::get_input_files() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[13]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmJobView::get_output_files() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[14]);
+}
+
+std::string_view SwmJobView::get_workdir() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[15]);
+}
+
+std::string_view SwmJobView::get_user_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[16]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmJobView::get_hooks() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[17]);
+}
+
+SwmListView<SwmTupleStrStrView, ei_buffer_to_tuple_str_str> SwmJobView::get_env() const {
+  return SwmListView<SwmTupleStrStrView, ei_buffer_to_tuple_str_str>(buf, offsets[18]);
+}
+
+SwmListView<SwmTupleAtomStrView, ei_buffer_to_tuple_atom_str> SwmJobView::get_deps() const {
+  return SwmListView<SwmTupleAtomStrView, ei_buffer_to_tuple_atom_str>(buf, offsets[19]);
+}
+
+std::string_view SwmJobView::get_account_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[20]);
+}
+
+std::string_view SwmJobView::get_gang_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[21]);
+}
+
+std::string_view SwmJobView::get_execution_path() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[22]);
+}
+
+std::string_view SwmJobView::get_script_content() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[23]);
+}
+
+SwmListView<SwmResourceView, ei_buffer_to_resource> SwmJobView::get_request() const {
+  return SwmListView<SwmResourceView, ei_buffer_to_resource>(buf, offsets[24]);
+}
+
+SwmListView<SwmResourceView, ei_buffer_to_resource> SwmJobView::get_resources() const {
+  return SwmListView<SwmResourceView, ei_buffer_to_resource>(buf, offsets[25]);
+}
+
+std::string_view SwmJobView::get_container() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[26]);
+}
+
+std::string_view SwmJobView::get_relocatable() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[27]);
+}
+
+uint64_t SwmJobView::get_exitcode() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[28]);
+}
+
+uint64_t SwmJobView::get_signal() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[29]);
+}
+
+uint64_t SwmJobView::get_priority() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[30]);
+}
+
+std::string_view SwmJobView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[31]);
+}
+
+uint64_t SwmJobView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[32]);
+}
+
+int swm::ei_buffer_to_job(const char* buf, int &index, SwmJobView &obj) {
+  obj = SwmJobView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_job(const char* buf, int &index, std::vector<SwmJobView> &array) {
+  const SwmListView<SwmJobView, ei_buffer_to_job> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmJobView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
+    array.push_back(view);
   }
-  if (resources.empty()) {
-    std::cerr << prefix << "resources: []" << separator;
-  } else {
-    std::cerr << prefix << "resources" << ": [";
-    for (const auto &q: resources) {
-      q.print(prefix, separator);
-    }
-    std::cerr << "]" << separator;
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of job at " << index << std::endl;
+    return -1;
   }
-  std::cerr << prefix << container << separator;
-  std::cerr << prefix << relocatable << separator;
-  std::cerr << prefix << exitcode << separator;
-  std::cerr << prefix << signal << separator;
-  std::cerr << prefix << priority << separator;
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  return 0;
 }
 
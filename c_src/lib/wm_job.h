@@ -2,6 +2,7 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #define SWM_JOB_STATE_QUEUED       "Q"
 #define SWM_JOB_STATE_WAITING      "W"
@@ -13,7 +14,11 @@
 
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 #include "wm_resource.h"
 #include "wm_resource.h"
 
@@ -22,117 +27,316 @@ namespace swm {
 class SwmJob:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 33;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_NAME = 1ull << 1;
+  static constexpr uint64_t FIELD_CLUSTER_ID = 1ull << 2;
+  static constexpr uint64_t FIELD_NODES = 1ull << 3;
+  static constexpr uint64_t FIELD_STATE = 1ull << 4;
+  static constexpr uint64_t FIELD_STATE_DETAILS = 1ull << 5;
+  static constexpr uint64_t FIELD_START_TIME = 1ull << 6;
+  static constexpr uint64_t FIELD_SUBMIT_TIME = 1ull << 7;
+  static constexpr uint64_t FIELD_END_TIME = 1ull << 8;
+  static constexpr uint64_t FIELD_DURATION = 1ull << 9;
+  static constexpr uint64_t FIELD_JOB_STDIN = 1ull << 10;
+  static constexpr uint64_t FIELD_JOB_STDOUT = 1ull << 11;
+  static constexpr uint64_t FIELD_JOB_STDERR = 1ull << 12;
+  static constexpr uint64_t FIELD_INPUT_FILES = 1ull << 13;
+  static constexpr uint64_t FIELD_OUTPUT_FILES = 1ull << 14;
+  static constexpr uint64_t FIELD_WORKDIR = 1ull << 15;
+  static constexpr uint64_t FIELD_USER_ID = 1ull << 16;
+  static constexpr uint64_t FIELD_HOOKS = 1ull << 17;
+  static constexpr uint64_t FIELD_ENV = 1ull << 18;
+  static constexpr uint64_t FIELD_DEPS = 1ull << 19;
+  static constexpr uint64_t FIELD_ACCOUNT_ID = 1ull << 20;
+  static constexpr uint64_t FIELD_GANG_ID = 1ull << 21;
+  static constexpr uint64_t FIELD_EXECUTION_PATH = 1ull << 22;
+  static constexpr uint64_t FIELD_SCRIPT_CONTENT = 1ull << 23;
+  static constexpr uint64_t FIELD_REQUEST = 1ull << 24;
+  static constexpr uint64_t FIELD_RESOURCES = 1ull << 25;
+  static constexpr uint64_t FIELD_CONTAINER = 1ull << 26;
+  static constexpr uint64_t FIELD_RELOCATABLE = 1ull << 27;
+  static constexpr uint64_t FIELD_EXITCODE = 1ull << 28;
+  static constexpr uint64_t FIELD_SIGNAL = 1ull << 29;
+  static constexpr uint64_t FIELD_PRIORITY = 1ull << 30;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 31;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 32;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "job";
+  static const SwmFieldInfo<SwmJob> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmJob();
-  SwmJob(const char*, int&);
+  explicit SwmJob(const allocator_type&);
+  SwmJob(const char*, int&, const allocator_type& = {});
+  SwmJob(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmJob(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmJob(const SwmJob&, const allocator_type&);
+  SwmJob(SwmJob&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmJob &old_obj, const SwmJob &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_id(const std::string&);
-  void set_name(const std::string&);
-  void set_cluster_id(const std::string&);
-  void set_nodes(const std::vector<std::string>&);
-  void set_state(const std::string&);
-  void set_state_details(const std::string&);
-  void set_start_time(const std::string&);
-  void set_submit_time(const std::string&);
-  void set_end_time(const std::string&);
+  void set_id(const SwmId&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_cluster_id(const std::pmr::string&);
+  void set_cluster_id(std::pmr::string&&);
+  void set_nodes(const std::pmr::vector<std::pmr::string>&);
+  void set_nodes(std::pmr::vector<std::pmr::string>&&);
+  void set_state(const std::pmr::string&);
+  void set_state(std::pmr::string&&);
+  void set_state_details(const std::pmr::string&);
+  void set_state_details(std::pmr::string&&);
+  void set_start_time(const std::pmr::string&);
+  void set_start_time(std::pmr::string&&);
+  void set_submit_time(const std::pmr::string&);
+  void set_submit_time(std::pmr::string&&);
+  void set_end_time(const std::pmr::string&);
+  void set_end_time(std::pmr::string&&);
   void set_duration(const uint64_t&);
-  void set_job_stdin(const std::string&);
-  void set_job_stdout(const std::string&);
-  void set_job_stderr(const std::string&);
-  void set_input_files(const std::vector<std::string>&);
-  void set_output_files(const std::vector<std::string>&);
-  void set_workdir(const std::string&);
-  void set_user_id(const std::string&);
-  void set_hooks(const std::vector<std::string>&);
-  void set_env(const std::vector<SwmTupleStrStr>&);
-  void set_deps(const std::vector<SwmTupleAtomStr>&);
-  void set_account_id(const std::string&);
-  void set_gang_id(const std::string&);
-  void set_execution_path(const std::string&);
-  void set_script_content(const std::string&);
-  void set_request(const std::vector<SwmResource>&);
-  void set_resources(const std::vector<SwmResource>&);
-  void set_container(const std::string&);
-  void set_relocatable(const std::string&);
+  void set_job_stdin(const std::pmr::string&);
+  void set_job_stdin(std::pmr::string&&);
+  void set_job_stdout(const std::pmr::string&);
+  void set_job_stdout(std::pmr::string&&);
+  void set_job_stderr(const std::pmr::string&);
+  void set_job_stderr(std::pmr::string&&);
+  void set_input_files(const std::pmr::vector<std::pmr::string>&);
+  void set_input_files(std::pmr::vector<std::pmr::string>&&);
+  void set_output_files(const std::pmr::vector<std::pmr::string>&);
+  void set_output_files(std::pmr::vector<std::pmr::string>&&);
+  void set_workdir(const std::pmr::string&);
+  void set_workdir(std::pmr::string&&);
+  void set_user_id(const std::pmr::string&);
+  void set_user_id(std::pmr::string&&);
+  void set_hooks(const std::pmr::vector<std::pmr::string>&);
+  void set_hooks(std::pmr::vector<std::pmr::string>&&);
+  void set_env(const std::pmr::vector<SwmTupleStrStr>&);
+  void set_env(std::pmr::vector<SwmTupleStrStr>&&);
+  void set_deps(const std::pmr::vector<SwmTupleAtomStr>&);
+  void set_deps(std::pmr::vector<SwmTupleAtomStr>&&);
+  void set_account_id(const std::pmr::string&);
+  void set_account_id(std::pmr::string&&);
+  void set_gang_id(const std::pmr::string&);
+  void set_gang_id(std::pmr::string&&);
+  void set_execution_path(const std::pmr::string&);
+  void set_execution_path(std::pmr::string&&);
+  void set_script_content(const std::pmr::string&);
+  void set_script_content(std::pmr::string&&);
+  void set_request(const std::pmr::vector<SwmResource>&);
+  void set_request(std::pmr::vector<SwmResource>&&);
+  void set_resources(const std::pmr::vector<SwmResource>&);
+  void set_resources(std::pmr::vector<SwmResource>&&);
+  void set_container(const std::pmr::string&);
+  void set_container(std::pmr::string&&);
+  void set_relocatable(const SwmAtom&);
   void set_exitcode(const uint64_t&);
   void set_signal(const uint64_t&);
   void set_priority(const uint64_t&);
-  void set_comment(const std::string&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  std::string get_id() const;
-  std::string get_name() const;
-  std::string get_cluster_id() const;
-  std::vector<std::string> get_nodes() const;
-  std::string get_state() const;
-  std::string get_state_details() const;
-  std::string get_start_time() const;
-  std::string get_submit_time() const;
-  std::string get_end_time() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const SwmId& get_id() const;
+  const std::pmr::string& get_name() const;
+  const std::pmr::string& get_cluster_id() const;
+  const std::pmr::vector<std::pmr::string>& get_nodes() const;
+  const std::pmr::string& get_state() const;
+  const std::pmr::string& get_state_details() const;
+  const std::pmr::string& get_start_time() const;
+  const std::pmr::string& get_submit_time() const;
+  const std::pmr::string& get_end_time() const;
+  const uint64_t& get_duration() const;
+  const std::pmr::string& get_job_stdin() const;
+  const std::pmr::string& get_job_stdout() const;
+  const std::pmr::string& get_job_stderr() const;
+  const std::pmr::vector<std::pmr::string>& get_input_files() const;
+  const std::pmr::vector<std::pmr::string>& get_output_files() const;
+  const std::pmr::string& get_workdir() const;
+  const std::pmr::string& get_user_id() const;
+  const std::pmr::vector<std::pmr::string>& get_hooks() const;
+  const std::pmr::vector<SwmTupleStrStr>& get_env() const;
+  const std::pmr::vector<SwmTupleAtomStr>& get_deps() const;
+  const std::pmr::string& get_account_id() const;
+  const std::pmr::string& get_gang_id() const;
+  const std::pmr::string& get_execution_path() const;
+  const std::pmr::string& get_script_content() const;
+  const std::pmr::vector<SwmResource>& get_request() const;
+  const std::pmr::vector<SwmResource>& get_resources() const;
+  const std::pmr::string& get_container() const;
+  const SwmAtom& get_relocatable() const;
+  const uint64_t& get_exitcode() const;
+  const uint64_t& get_signal() const;
+  const uint64_t& get_priority() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_nodes(Args&&... args) {
+    return nodes.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_input_files(Args&&... args) {
+    return input_files.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_output_files(Args&&... args) {
+    return output_files.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_hooks(Args&&... args) {
+    return hooks.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_env(Args&&... args) {
+    return env.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_deps(Args&&... args) {
+    return deps.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_request(Args&&... args) {
+    return request.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_resources(Args&&... args) {
+    return resources.emplace_back(std::forward<Args>(args)...);
+  }
+
+ private:
+  SwmId id;
+  std::pmr::string name;
+  std::pmr::string cluster_id;
+  std::pmr::vector<std::pmr::string> nodes;
+  std::pmr::string state;
+  std::pmr::string state_details;
+  std::pmr::string start_time;
+  std::pmr::string submit_time;
+  std::pmr::string end_time;
+  uint64_t duration = 0;
+  std::pmr::string job_stdin;
+  std::pmr::string job_stdout;
+  std::pmr::string job_stderr;
+  std::pmr::vector<std::pmr::string> input_files;
+  std::pmr::vector<std::pmr::string> output_files;
+  std::pmr::string workdir;
+  std::pmr::string user_id;
+  std::pmr::vector<std::pmr::string> hooks;
+  std::pmr::vector<SwmTupleStrStr> env;
+  std::pmr::vector<SwmTupleAtomStr> deps;
+  std::pmr::string account_id;
+  std::pmr::string gang_id;
+  std::pmr::string execution_path;
+  std::pmr::string script_content;
+  std::pmr::vector<SwmResource> request;
+  std::pmr::vector<SwmResource> resources;
+  std::pmr::string container;
+  SwmAtom relocatable;
+  uint64_t exitcode = 0;
+  uint64_t signal = 0;
+  uint64_t priority = 0;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
+
+};
+
+class SwmJobView;
+
+int ei_buffer_to_job(const char*, int&, std::vector<SwmJob>&);
+int ei_buffer_to_job(const char*, int&, std::pmr::vector<SwmJob>&);
+int ei_buffer_to_job(const char*, int&, std::vector<SwmJob>&, SwmThreadPool&);
+int ei_buffer_to_job(const char*, int&, SwmJob&);
+int ei_buffer_to_job(const char*, int&, std::vector<SwmJobView>&);
+int ei_buffer_to_job(const char*, int&, SwmJobView&);
+
+void encode_job(char*, int&, const SwmJob&);
+void encode_job(char*, int&, const std::vector<SwmJob>&);
+void encode_job(char*, int&, const std::pmr::vector<SwmJob>&);
+int encode_job(ei_x_buff&, const std::vector<SwmJob>&);
+int encode_job(ei_x_buff&, const std::pmr::vector<SwmJob>&);
+
+class SwmJobView {
+
+ public:
+  SwmJobView();
+  SwmJobView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_id() const;
+  std::string_view get_name() const;
+  std::string_view get_cluster_id() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_nodes() const;
+  std::string_view get_state() const;
+  std::string_view get_state_details() const;
+  std::string_view get_start_time() const;
+  std::string_view get_submit_time() const;
+  std::string_view get_end_time() const;
   uint64_t get_duration() const;
-  std::string get_job_stdin() const;
-  std::string get_job_stdout() const;
-  std::string get_job_stderr() const;
-  std::vector<std::string> get_input_files() const;
-  std::vector<std::string> get_output_files() const;
-  std::string get_workdir() const;
-  std::string get_user_id() const;
-  std::vector<std::string> get_hooks() const;
-  std::vector<SwmTupleStrStr> get_env() const;
-  std::vector<SwmTupleAtomStr> get_deps() const;
-  std::string get_account_id() const;
-  std::string get_gang_id() const;
-  std::string get_execution_path() const;
-  std::string get_script_content() const;
-  std::vector<SwmResource> get_request() const;
-  std::vector<SwmResource> get_resources() const;
-  std::string get_container() const;
-  std::string get_relocatable() const;
+  std::string_view get_job_stdin() const;
+  std::string_view get_job_stdout() const;
+  std::string_view get_job_stderr() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_input_files() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_output_files() const;
+  std::string_view get_workdir() const;
+  std::string_view get_user_id() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_hooks() const;
+  SwmListView<SwmTupleStrStrView, ei_buffer_to_tuple_str_str> get_env() const;
+  SwmListView<SwmTupleAtomStrView, ei_buffer_to_tuple_atom_str> get_deps() const;
+  std::string_view get_account_id() const;
+  std::string_view get_gang_id() const;
+  std::string_view get_execution_path() const;
+  std::string_view get_script_content() const;
+  SwmListView<SwmResourceView, ei_buffer_to_resource> get_request() const;
+  SwmListView<SwmResourceView, ei_buffer_to_resource> get_resources() const;
+  std::string_view get_container() const;
+  std::string_view get_relocatable() const;
   uint64_t get_exitcode() const;
   uint64_t get_signal() const;
   uint64_t get_priority() const;
-  std::string get_comment() const;
+  std::string_view get_comment() const;
   uint64_t get_revision() const;
 
  private:
-  std::string id;
-  std::string name;
-  std::string cluster_id;
-  std::vector<std::string> nodes;
-  std::string state;
-  std::string state_details;
-  std::string start_time;
-  std::string submit_time;
-  std::string end_time;
-  uint64_t duration;
-  std::string job_stdin;
-  std::string job_stdout;
-  std::string job_stderr;
-  std::vector<std::string> input_files;
-  std::vector<std::string> output_files;
-  std::string workdir;
-  std::string user_id;
-  std::vector<std::string> hooks;
-  std::vector<SwmTupleStrStr> env;
-  std::vector<SwmTupleAtomStr> deps;
-  std::string account_id;
-  std::string gang_id;
-  std::string execution_path;
-  std::string script_content;
-  std::vector<SwmResource> request;
-  std::vector<SwmResource> resources;
-  std::string container;
-  std::string relocatable;
-  uint64_t exitcode;
-  uint64_t signal;
-  uint64_t priority;
-  std::string comment;
-  uint64_t revision;
+  const char* buf = nullptr;
+  std::array<int, 33> offsets = {};
 
 };
 
-int ei_buffer_to_job(const char*, int&, std::vector<SwmJob>&);
-int ei_buffer_to_job(const char*, int&, SwmJob&);
-
 } // namespace swm
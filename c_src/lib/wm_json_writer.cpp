@@ -0,0 +1,228 @@
+#include "wm_json_writer.h"
+#include "wm_etf_reader.h"
+
+#include <charconv>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+
+using namespace swm;
+
+// Bytes are checked 32 (AVX2) or 16 (SSE2) at once: equal to a quote or a
+// backslash, or not greater than 0x1f as unsigned (max(v, 0x1f) == 0x1f).
+size_t swm::json_scan_plain(const char* p, const size_t size) {
+  size_t n = 0;
+#if defined(__AVX2__)
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1f);
+  for (; size - n >= 32; n += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + n));
+    const __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+                                            _mm256_cmpeq_epi8(_mm256_max_epu8(v, control), control));
+    const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+    if (mask) {
+      return n + static_cast<size_t>(__builtin_ctz(mask));
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i quote_128 = _mm_set1_epi8('"');
+  const __m128i backslash_128 = _mm_set1_epi8('\\');
+  const __m128i control_128 = _mm_set1_epi8(0x1f);
+  for (; size - n >= 16; n += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+    const __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote_128), _mm_cmpeq_epi8(v, backslash_128)),
+                                         _mm_cmpeq_epi8(_mm_max_epu8(v, control_128), control_128));
+    const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+    if (mask) {
+      return n + static_cast<size_t>(__builtin_ctz(mask));
+    }
+  }
+#endif
+  while (n < size) {
+    const auto c = static_cast<unsigned char>(p[n]);
+    if (c == '"' || c == '\\' || c <= 0x1f) {
+      break;
+    }
+    ++n;
+  }
+  return n;
+}
+
+void SwmJsonWriter::write_string(const std::string_view s) {
+  static const char hex[] = "0123456789abcdef";
+  out.push_back('"');
+  size_t pos = 0;
+  while (pos < s.size()) {
+    const size_t plain = json_scan_plain(s.data() + pos, s.size() - pos);
+    out.append(s.data() + pos, plain);
+    pos += plain;
+    if (pos == s.size()) {
+      break;
+    }
+    const auto c = static_cast<unsigned char>(s[pos++]);
+    switch (c) {
+      case '"': out.append("\\\""); break;
+      case '\\': out.append("\\\\"); break;
+      case '\n': out.append("\\n"); break;
+      case '\r': out.append("\\r"); break;
+      case '\t': out.append("\\t"); break;
+      case '\b': out.append("\\b"); break;
+      case '\f': out.append("\\f"); break;
+      default: {
+        const char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+        out.append(escaped, sizeof(escaped));
+      }
+    }
+  }
+  out.push_back('"');
+}
+
+void SwmJsonWriter::value_atom(const std::string_view a) {
+  if (a == "true" || a == "false") {
+    separate();
+    out.append(a);
+  } else if (a == "undefined") {
+    value_null();
+  } else {
+    value_str(a);
+  }
+}
+
+void SwmJsonWriter::value_uint64(const uint64_t n) {
+  separate();
+  char buf[24];
+  const auto result = std::to_chars(buf, buf + sizeof(buf), n);
+  out.append(buf, static_cast<size_t>(result.ptr - buf));
+}
+
+void SwmJsonWriter::value_int64(const int64_t n) {
+  separate();
+  char buf[24];
+  const auto result = std::to_chars(buf, buf + sizeof(buf), n);
+  out.append(buf, static_cast<size_t>(result.ptr - buf));
+}
+
+void SwmJsonWriter::value_double(const double d) {
+  if (!std::isfinite(d)) {
+    value_null();
+    return;
+  }
+  separate();
+  char buf[32];
+  const auto result = std::to_chars(buf, buf + sizeof(buf), d);
+  out.append(buf, static_cast<size_t>(result.ptr - buf));
+}
+
+namespace {
+
+int map_key_to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  const char* data = nullptr;
+  int size = 0;
+  if (etf_decode_atom_bytes(buf, index, data, size) && etf_decode_bytes(buf, index, data, size)) {
+    std::string key;
+    if (etf_decode_str(buf, index, key)) {
+      std::cerr << "Could not write map key at " << index << " to JSON, type " << etf_term_tag(buf, index) << std::endl;
+      return -1;
+    }
+    writer.key(key);
+    return 0;
+  }
+  writer.key(std::string_view(data, static_cast<size_t>(size)));
+  return 0;
+}
+
+} // namespace
+
+int swm::etf_to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  const int tag = etf_term_tag(buf, index);
+  switch (tag) {
+    case ERL_SMALL_INTEGER_EXT:
+    case ERL_INTEGER_EXT:
+    case ERL_SMALL_BIG_EXT: {
+      uint64_t magnitude = 0;
+      bool negative = false;
+      if (etf_decode_big(buf, index, magnitude, negative)) {
+        break;
+      }
+      if (negative) {
+        writer.value_int64(static_cast<int64_t>(0 - magnitude));
+      } else {
+        writer.value_uint64(magnitude);
+      }
+      return 0;
+    }
+    case NEW_FLOAT_EXT:
+    case ERL_FLOAT_EXT: {
+      double d = 0.0;
+      if (etf_decode_double(buf, index, d)) {
+        break;
+      }
+      writer.value_double(d);
+      return 0;
+    }
+    case ERL_SMALL_ATOM_UTF8_EXT:
+    case ERL_SMALL_ATOM_EXT:
+    case ERL_ATOM_UTF8_EXT:
+    case ERL_ATOM_EXT: {
+      const char* data = nullptr;
+      int size = 0;
+      etf_decode_atom_bytes(buf, index, data, size);
+      writer.value_atom(std::string_view(data, static_cast<size_t>(size)));
+      return 0;
+    }
+    case ERL_STRING_EXT:
+    case ERL_BINARY_EXT: {
+      const char* data = nullptr;
+      int size = 0;
+      etf_decode_bytes(buf, index, data, size);
+      writer.value_str(std::string_view(data, static_cast<size_t>(size)));
+      return 0;
+    }
+    case ERL_NIL_EXT:
+    case ERL_LIST_EXT:
+    case ERL_SMALL_TUPLE_EXT:
+    case ERL_LARGE_TUPLE_EXT: {
+      int i = index;
+      int arity = 0;
+      const bool list = tag == ERL_NIL_EXT || tag == ERL_LIST_EXT;
+      if (list ? etf_decode_list_header(buf, i, arity) : etf_decode_tuple_header(buf, i, arity)) {
+        break;
+      }
+      writer.begin_array();
+      for (int n = 0; n < arity; ++n) {
+        if (etf_to_json(buf, i, writer)) {
+          return -1;
+        }
+      }
+      writer.end_array();
+      if (list && arity && etf_decode_list_tail(buf, i)) {
+        break;
+      }
+      index = i;
+      return 0;
+    }
+    case ERL_MAP_EXT: {
+      int i = index;
+      int arity = 0;
+      etf_decode_map_header(buf, i, arity);
+      writer.begin_object();
+      for (int n = 0; n < arity; ++n) {
+        if (map_key_to_json(buf, i, writer) || etf_to_json(buf, i, writer)) {
+          return -1;
+        }
+      }
+      writer.end_object();
+      index = i;
+      return 0;
+    }
+  }
+  std::cerr << "Could not write term at " << index << " to JSON, type " << tag << std::endl;
+  return -1;
+}
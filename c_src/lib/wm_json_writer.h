@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace swm {
+
+// Appends JSON text to a string buffer. Commas are put automatically, so a
+// document is written as a sequence of begin/end, key and value calls.
+// The buffer is reserved once (e.g. for a whole listing) and is reused
+// after clear().
+//
+// Atoms true and false are written as booleans and undefined as null, the
+// same as in the mochijson2 encoding of the erlang side.
+class SwmJsonWriter {
+ public:
+  explicit SwmJsonWriter(size_t capacity = 0) {
+    out.reserve(capacity);
+  }
+
+  void begin_object() { separate(); out.push_back('{'); first = true; }
+  void end_object() { out.push_back('}'); first = false; }
+  void begin_array() { separate(); out.push_back('['); first = true; }
+  void end_array() { out.push_back(']'); first = false; }
+
+  void key(std::string_view name) {
+    separate();
+    write_string(name);
+    out.push_back(':');
+    first = true;
+  }
+
+  void value_str(std::string_view s) { separate(); write_string(s); }
+  void value_atom(std::string_view a);
+  void value_uint64(uint64_t n);
+  void value_int64(int64_t n);
+  void value_double(double d);  // NaN and infinities are written as null
+  void value_null() { separate(); out.append("null"); }
+
+  const std::string& str() const { return out; }
+  size_t size() const { return out.size(); }
+  void clear() { out.clear(); first = true; }
+
+ private:
+  void separate() {
+    if (!first) {
+      out.push_back(',');
+    }
+    first = false;
+  }
+
+  void write_string(std::string_view s);
+
+  std::string out;
+  bool first = true;
+};
+
+// Returns number of leading bytes that are written to JSON strings as they
+// are (no quote, backslash or control character), at most size.
+size_t json_scan_plain(const char* p, size_t size);
+
+// Writes the erlang term at index as JSON: tuples and lists are arrays,
+// maps with atom or string keys are objects, strings and binaries are
+// strings. The index is moved past the term, -1 is returned for terms
+// that can not be written (pids, references, funs, maps with other keys).
+int etf_to_json(const char* buf, int &index, SwmJsonWriter &writer);
+
+} // namespace swm
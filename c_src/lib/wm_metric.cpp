@@ -1,139 +1,338 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_metric.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmMetric> SwmMetric::FIELDS_INFO[] = {
+  field_info<SwmMetric, SwmAtom, &SwmMetric::name,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("name"),
+  field_info<SwmMetric, uint64_t, &SwmMetric::value_integer,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("value_integer"),
+  field_info<SwmMetric, double, &SwmMetric::value_float64,
+             ei_buffer_to_double, encode_double,
+             SwmDoubleTerm>("value_float64"),
+};
+
 SwmMetric::SwmMetric() {
 }
 
-SwmMetric::SwmMetric(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmMetric: null" << std::endl;
-    return;
-  }
+SwmMetric::SwmMetric(const allocator_type&) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmMetric header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmMetric::SwmMetric(const SwmMetric &other, const allocator_type &)
+  : name(other.name),
+    value_integer(other.value_integer),
+    value_float64(other.value_float64),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmMetric term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmMetric::SwmMetric(SwmMetric &&other, const allocator_type &)
+  : name(other.name),
+    value_integer(other.value_integer),
+    value_float64(other.value_float64),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_atom(buf, index, this->name)) {
-    std::cerr << "Could not init metric::name at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmMetric::allocator_type SwmMetric::get_allocator() const {
+  return allocator_type();  // no fields with dynamic memory
+}
+
+SwmMetric::SwmMetric(const char* buf, int &index, const allocator_type &allocator)
+  : SwmMetric(buf, index, FIELD_ALL, allocator) {
+}
+
+SwmMetric::SwmMetric(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmMetric(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
+  }
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->value_integer)) {
-    std::cerr << "Could not init metric::value_integer at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmMetric::SwmMetric(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmMetric(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_double(buf, index, this->value_float64)) {
-    std::cerr << "Could not init metric::value_float64 at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmMetric::validate(const char* buf, int &index) {
+  return entity_validate<SwmMetric>(buf, index);
+}
+
+void SwmMetric::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmMetric::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmMetric>(buf, index, writer);
+}
+
+SwmPatch SwmMetric::diff(const SwmMetric &old_obj, const SwmMetric &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmMetric::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmMetric::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip metric::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmMetric::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmMetric::set_name(const std::string &new_val) {
+void SwmMetric::set_name(const SwmAtom &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
 }
 
 void SwmMetric::set_value_integer(const uint64_t &new_val) {
   value_integer = new_val;
+  lazy_fields &= ~FIELD_VALUE_INTEGER;
 }
 
 void SwmMetric::set_value_float64(const double &new_val) {
   value_float64 = new_val;
+  lazy_fields &= ~FIELD_VALUE_FLOAT64;
 }
 
-std::string SwmMetric::get_name() const {
+const SwmAtom& SwmMetric::get_name() const {
   return name;
 }
 
-uint64_t SwmMetric::get_value_integer() const {
+const uint64_t& SwmMetric::get_value_integer() const {
   return value_integer;
 }
 
-double SwmMetric::get_value_float64() const {
+const double& SwmMetric::get_value_float64() const {
   return value_float64;
 }
 
-int swm::ei_buffer_to_metric(const char *buf, int &index, std::vector<SwmMetric> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a metric list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for metric at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a metric list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of metric list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_metric(const char *buf, int &index, std::vector<SwmMetric> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_metric(const char *buf, int &index, std::pmr::vector<SwmMetric> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_metric(const char *buf, int &index, std::vector<SwmMetric> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a metric list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmMetric(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_metric(const char* buf, int &index, SwmMetric &obj) {
-  obj = SwmMetric(buf, index);
+  obj = SwmMetric(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmMetric::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmMetric::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode metric" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_metric(char* buf, int &index, const SwmMetric &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_metric(char* buf, int &index, const std::vector<SwmMetric> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmMetric &x) { x.encode(b, i); });
+}
+
+void swm::encode_metric(char* buf, int &index, const std::pmr::vector<SwmMetric> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmMetric &x) { x.encode(b, i); });
+}
+
+int swm::encode_metric(ei_x_buff &x, const std::vector<SwmMetric> &array) {
+  int size = 0;
+  encode_metric(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode metric list" << std::endl;
+    return -1;
+  }
+  encode_metric(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_metric(ei_x_buff &x, const std::pmr::vector<SwmMetric> &array) {
+  int size = 0;
+  encode_metric(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode metric list" << std::endl;
+    return -1;
+  }
+  encode_metric(x.buff, x.index, array);
   return 0;
 }
 
 void SwmMetric::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << value_integer << separator;
-  std::cerr << prefix << value_float64 << separator;
-  std::cerr << std::endl;
+  entity_print(*this, prefix, separator);
+}
+
+SwmMetricView::SwmMetricView() {
+}
+
+SwmMetricView::SwmMetricView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmMetricView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 3)) {
+    std::cerr << "Could not create SwmMetricView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmMetricView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmMetricView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[0]);
+}
+
+uint64_t SwmMetricView::get_value_integer() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[1]);
+}
+
+double SwmMetricView::get_value_float64() const {
+  return get_view_value<double, ei_buffer_to_double>(buf, offsets[2]);
+}
+
+int swm::ei_buffer_to_metric(const char* buf, int &index, SwmMetricView &obj) {
+  obj = SwmMetricView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_metric(const char* buf, int &index, std::vector<SwmMetricView> &array) {
+  const SwmListView<SwmMetricView, ei_buffer_to_metric> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmMetricView at " << index << std::endl;
+      return -1;
+    }
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of metric at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
@@ -2,36 +2,120 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmMetric:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 3;
+  static constexpr uint64_t FIELD_NAME = 1ull << 0;
+  static constexpr uint64_t FIELD_VALUE_INTEGER = 1ull << 1;
+  static constexpr uint64_t FIELD_VALUE_FLOAT64 = 1ull << 2;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "metric";
+  static const SwmFieldInfo<SwmMetric> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmMetric();
-  SwmMetric(const char*, int&);
+  explicit SwmMetric(const allocator_type&);
+  SwmMetric(const char*, int&, const allocator_type& = {});
+  SwmMetric(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmMetric(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmMetric(const SwmMetric&, const allocator_type&);
+  SwmMetric(SwmMetric&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmMetric &old_obj, const SwmMetric &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_name(const std::string&);
+  void set_name(const SwmAtom&);
   void set_value_integer(const uint64_t&);
   void set_value_float64(const double&);
 
-  std::string get_name() const;
-  uint64_t get_value_integer() const;
-  double get_value_float64() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const SwmAtom& get_name() const;
+  const uint64_t& get_value_integer() const;
+  const double& get_value_float64() const;
 
  private:
-  std::string name;
-  uint64_t value_integer;
-  double value_float64;
+  SwmAtom name;
+  uint64_t value_integer = 0;
+  double value_float64 = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmMetricView;
+
 int ei_buffer_to_metric(const char*, int&, std::vector<SwmMetric>&);
+int ei_buffer_to_metric(const char*, int&, std::pmr::vector<SwmMetric>&);
+int ei_buffer_to_metric(const char*, int&, std::vector<SwmMetric>&, SwmThreadPool&);
 int ei_buffer_to_metric(const char*, int&, SwmMetric&);
+int ei_buffer_to_metric(const char*, int&, std::vector<SwmMetricView>&);
+int ei_buffer_to_metric(const char*, int&, SwmMetricView&);
+
+void encode_metric(char*, int&, const SwmMetric&);
+void encode_metric(char*, int&, const std::vector<SwmMetric>&);
+void encode_metric(char*, int&, const std::pmr::vector<SwmMetric>&);
+int encode_metric(ei_x_buff&, const std::vector<SwmMetric>&);
+int encode_metric(ei_x_buff&, const std::pmr::vector<SwmMetric>&);
+
+class SwmMetricView {
+
+ public:
+  SwmMetricView();
+  SwmMetricView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_name() const;
+  uint64_t get_value_integer() const;
+  double get_value_float64() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 3> offsets = {};
+
+};
 
 } // namespace swm
@@ -1,428 +1,699 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_node.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 #include "wm_resource.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmNode> SwmNode::FIELDS_INFO[] = {
+  field_info<SwmNode, SwmId, &SwmNode::id,
+             ei_buffer_to_id, encode_id,
+             SwmIdTerm>("id"),
+  field_info<SwmNode, std::pmr::string, &SwmNode::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmNode, std::pmr::string, &SwmNode::host,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("host"),
+  field_info<SwmNode, uint64_t, &SwmNode::api_port,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("api_port"),
+  field_info<SwmNode, std::pmr::string, &SwmNode::parent,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("parent"),
+  field_info<SwmNode, SwmAtom, &SwmNode::state_power,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("state_power"),
+  field_info<SwmNode, SwmAtom, &SwmNode::state_alloc,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("state_alloc"),
+  field_info<SwmNode, std::pmr::vector<uint64_t>, &SwmNode::roles,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmListTerm<SwmUint64Term>>("roles"),
+  field_info<SwmNode, std::pmr::vector<SwmResource>, &SwmNode::resources,
+             ei_buffer_to_resource, encode_resource,
+             SwmListTerm<SwmEntityTerm<SwmResource>>>("resources"),
+  field_info<SwmNode, std::pmr::vector<SwmTupleAtomBuff>, &SwmNode::properties,
+             ei_buffer_to_tuple_atom_buff, encode_tuple_atom_buff,
+             SwmListTerm<SwmTupleTerm<SwmAtomTerm, SwmAnyTerm>>>("properties"),
+  field_info<SwmNode, SwmAtom, &SwmNode::subdivision,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("subdivision"),
+  field_info<SwmNode, std::pmr::string, &SwmNode::subdivision_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("subdivision_id"),
+  field_info<SwmNode, std::pmr::vector<uint64_t>, &SwmNode::malfunctions,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmListTerm<SwmUint64Term>>("malfunctions"),
+  field_info<SwmNode, std::pmr::string, &SwmNode::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmNode, std::pmr::string, &SwmNode::remote_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("remote_id"),
+  field_info<SwmNode, SwmAtom, &SwmNode::is_template,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("is_template"),
+  field_info<SwmNode, std::pmr::string, &SwmNode::gateway,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("gateway"),
+  field_info<SwmNode, SwmPriceMap, &SwmNode::prices,
+             ei_buffer_to_price_map, encode_price_map,
+             SwmPriceMapTerm>("prices"),
+  field_info<SwmNode, uint64_t, &SwmNode::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmNode::SwmNode() {
 }
 
-SwmNode::SwmNode(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmNode: null" << std::endl;
-    return;
-  }
-
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmNode header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmNode term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->id)) {
-    std::cerr << "Could not init node::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init node::name at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->host)) {
-    std::cerr << "Could not init node::host at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->api_port)) {
-    std::cerr << "Could not init node::api_port at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->parent)) {
-    std::cerr << "Could not init node::parent at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_atom(buf, index, this->state_power)) {
-    std::cerr << "Could not init node::state_power at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_atom(buf, index, this->state_alloc)) {
-    std::cerr << "Could not init node::state_alloc at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->roles)) {
-    std::cerr << "Could not init node::roles at pos 9: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_resource(buf, index, this->resources)) {
-    std::cerr << "Could not init node::resources at pos 10: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_tuple_atom_buff(buf, index, this->properties)) {
-    std::cerr << "Could not init node::properties at pos 11: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmNode::SwmNode(const allocator_type &allocator)
+  : name(allocator),
+    host(allocator),
+    parent(allocator),
+    roles(allocator),
+    resources(allocator),
+    properties(allocator),
+    subdivision_id(allocator),
+    malfunctions(allocator),
+    comment(allocator),
+    remote_id(allocator),
+    gateway(allocator),
+    prices(allocator) {
+}
+
+SwmNode::SwmNode(const SwmNode &other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name, allocator),
+    host(other.host, allocator),
+    api_port(other.api_port),
+    parent(other.parent, allocator),
+    state_power(other.state_power),
+    state_alloc(other.state_alloc),
+    roles(other.roles, allocator),
+    resources(other.resources, allocator),
+    properties(other.properties, allocator),
+    subdivision(other.subdivision),
+    subdivision_id(other.subdivision_id, allocator),
+    malfunctions(other.malfunctions, allocator),
+    comment(other.comment, allocator),
+    remote_id(other.remote_id, allocator),
+    is_template(other.is_template),
+    gateway(other.gateway, allocator),
+    prices(other.prices, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
+
+SwmNode::SwmNode(SwmNode &&other, const allocator_type &allocator)
+  : id(other.id),
+    name(std::move(other.name), allocator),
+    host(std::move(other.host), allocator),
+    api_port(other.api_port),
+    parent(std::move(other.parent), allocator),
+    state_power(other.state_power),
+    state_alloc(other.state_alloc),
+    roles(std::move(other.roles), allocator),
+    resources(std::move(other.resources), allocator),
+    properties(std::move(other.properties), allocator),
+    subdivision(other.subdivision),
+    subdivision_id(std::move(other.subdivision_id), allocator),
+    malfunctions(std::move(other.malfunctions), allocator),
+    comment(std::move(other.comment), allocator),
+    remote_id(std::move(other.remote_id), allocator),
+    is_template(other.is_template),
+    gateway(std::move(other.gateway), allocator),
+    prices(std::move(other.prices), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
+
+SwmNode::allocator_type SwmNode::get_allocator() const {
+  return name.get_allocator();
+}
+
+SwmNode::SwmNode(const char* buf, int &index, const allocator_type &allocator)
+  : SwmNode(buf, index, FIELD_ALL, allocator) {
+}
+
+SwmNode::SwmNode(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmNode(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_atom(buf, index, this->subdivision)) {
-    std::cerr << "Could not init node::subdivision at pos 12: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->subdivision_id)) {
-    std::cerr << "Could not init node::subdivision_id at pos 13: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmNode::SwmNode(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmNode(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->malfunctions)) {
-    std::cerr << "Could not init node::malfunctions at pos 14: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmNode::validate(const char* buf, int &index) {
+  return entity_validate<SwmNode>(buf, index);
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init node::comment at pos 15: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+void SwmNode::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
 
-  if (ei_buffer_to_str(buf, index, this->remote_id)) {
-    std::cerr << "Could not init node::remote_id at pos 16: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmNode::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmNode>(buf, index, writer);
+}
 
-  if (ei_buffer_to_atom(buf, index, this->is_template)) {
-    std::cerr << "Could not init node::is_template at pos 17: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmPatch SwmNode::diff(const SwmNode &old_obj, const SwmNode &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
 
-  if (ei_buffer_to_str(buf, index, this->gateway)) {
-    std::cerr << "Could not init node::gateway at pos 18: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmNode::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
 
-  if (ei_buffer_to_map(buf, index, this->prices)) {
-    std::cerr << "Could not init node::prices at pos 19: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmNode::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip node::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
   }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init node::revision at pos 20: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmNode::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmNode::set_id(const std::string &new_val) {
+void SwmNode::set_id(const SwmId &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmNode::set_name(const std::string &new_val) {
+void SwmNode::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmNode::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmNode::set_host(const std::string &new_val) {
+void SwmNode::set_host(const std::pmr::string &new_val) {
   host = new_val;
+  lazy_fields &= ~FIELD_HOST;
+}
+
+void SwmNode::set_host(std::pmr::string &&new_val) {
+  host = std::move(new_val);
+  lazy_fields &= ~FIELD_HOST;
 }
 
 void SwmNode::set_api_port(const uint64_t &new_val) {
   api_port = new_val;
+  lazy_fields &= ~FIELD_API_PORT;
 }
 
-void SwmNode::set_parent(const std::string &new_val) {
+void SwmNode::set_parent(const std::pmr::string &new_val) {
   parent = new_val;
+  lazy_fields &= ~FIELD_PARENT;
 }
 
-void SwmNode::set_state_power(const std::string &new_val) {
+void SwmNode::set_parent(std::pmr::string &&new_val) {
+  parent = std::move(new_val);
+  lazy_fields &= ~FIELD_PARENT;
+}
+
+void SwmNode::set_state_power(const SwmAtom &new_val) {
   state_power = new_val;
+  lazy_fields &= ~FIELD_STATE_POWER;
 }
 
-void SwmNode::set_state_alloc(const std::string &new_val) {
+void SwmNode::set_state_alloc(const SwmAtom &new_val) {
   state_alloc = new_val;
+  lazy_fields &= ~FIELD_STATE_ALLOC;
 }
 
-void SwmNode::set_roles(const std::vector<uint64_t> &new_val) {
+void SwmNode::set_roles(const std::pmr::vector<uint64_t> &new_val) {
   roles = new_val;
+  lazy_fields &= ~FIELD_ROLES;
 }
 
-void SwmNode::set_resources(const std::vector<SwmResource> &new_val) {
+void SwmNode::set_roles(std::pmr::vector<uint64_t> &&new_val) {
+  roles = std::move(new_val);
+  lazy_fields &= ~FIELD_ROLES;
+}
+
+void SwmNode::set_resources(const std::pmr::vector<SwmResource> &new_val) {
   resources = new_val;
+  lazy_fields &= ~FIELD_RESOURCES;
+}
+
+void SwmNode::set_resources(std::pmr::vector<SwmResource> &&new_val) {
+  resources = std::move(new_val);
+  lazy_fields &= ~FIELD_RESOURCES;
 }
 
-void SwmNode::set_properties(const std::vector<SwmTupleAtomBuff> &new_val) {
+void SwmNode::set_properties(const std::pmr::vector<SwmTupleAtomBuff> &new_val) {
   properties = new_val;
+  lazy_fields &= ~FIELD_PROPERTIES;
 }
 
-void SwmNode::set_subdivision(const std::string &new_val) {
+void SwmNode::set_properties(std::pmr::vector<SwmTupleAtomBuff> &&new_val) {
+  properties = std::move(new_val);
+  lazy_fields &= ~FIELD_PROPERTIES;
+}
+
+void SwmNode::set_subdivision(const SwmAtom &new_val) {
   subdivision = new_val;
+  lazy_fields &= ~FIELD_SUBDIVISION;
 }
 
-void SwmNode::set_subdivision_id(const std::string &new_val) {
+void SwmNode::set_subdivision_id(const std::pmr::string &new_val) {
   subdivision_id = new_val;
+  lazy_fields &= ~FIELD_SUBDIVISION_ID;
+}
+
+void SwmNode::set_subdivision_id(std::pmr::string &&new_val) {
+  subdivision_id = std::move(new_val);
+  lazy_fields &= ~FIELD_SUBDIVISION_ID;
 }
 
-void SwmNode::set_malfunctions(const std::vector<uint64_t> &new_val) {
+void SwmNode::set_malfunctions(const std::pmr::vector<uint64_t> &new_val) {
   malfunctions = new_val;
+  lazy_fields &= ~FIELD_MALFUNCTIONS;
+}
+
+void SwmNode::set_malfunctions(std::pmr::vector<uint64_t> &&new_val) {
+  malfunctions = std::move(new_val);
+  lazy_fields &= ~FIELD_MALFUNCTIONS;
 }
 
-void SwmNode::set_comment(const std::string &new_val) {
+void SwmNode::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
-void SwmNode::set_remote_id(const std::string &new_val) {
+void SwmNode::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmNode::set_remote_id(const std::pmr::string &new_val) {
   remote_id = new_val;
+  lazy_fields &= ~FIELD_REMOTE_ID;
 }
 
-void SwmNode::set_is_template(const std::string &new_val) {
+void SwmNode::set_remote_id(std::pmr::string &&new_val) {
+  remote_id = std::move(new_val);
+  lazy_fields &= ~FIELD_REMOTE_ID;
+}
+
+void SwmNode::set_is_template(const SwmAtom &new_val) {
   is_template = new_val;
+  lazy_fields &= ~FIELD_IS_TEMPLATE;
 }
 
-void SwmNode::set_gateway(const std::string &new_val) {
+void SwmNode::set_gateway(const std::pmr::string &new_val) {
   gateway = new_val;
+  lazy_fields &= ~FIELD_GATEWAY;
+}
+
+void SwmNode::set_gateway(std::pmr::string &&new_val) {
+  gateway = std::move(new_val);
+  lazy_fields &= ~FIELD_GATEWAY;
 }
 
-void SwmNode::set_prices(const std::map<std::string, std::string> &new_val) {
+void SwmNode::set_prices(const SwmPriceMap &new_val) {
   prices = new_val;
+  lazy_fields &= ~FIELD_PRICES;
+}
+
+void SwmNode::set_prices(SwmPriceMap &&new_val) {
+  prices = std::move(new_val);
+  lazy_fields &= ~FIELD_PRICES;
 }
 
 void SwmNode::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-std::string SwmNode::get_id() const {
+const SwmId& SwmNode::get_id() const {
   return id;
 }
 
-std::string SwmNode::get_name() const {
+const std::pmr::string& SwmNode::get_name() const {
   return name;
 }
 
-std::string SwmNode::get_host() const {
+const std::pmr::string& SwmNode::get_host() const {
   return host;
 }
 
-uint64_t SwmNode::get_api_port() const {
+const uint64_t& SwmNode::get_api_port() const {
   return api_port;
 }
 
-std::string SwmNode::get_parent() const {
+const std::pmr::string& SwmNode::get_parent() const {
   return parent;
 }
 
-std::string SwmNode::get_state_power() const {
+const SwmAtom& SwmNode::get_state_power() const {
   return state_power;
 }
 
-std::string SwmNode::get_state_alloc() const {
+const SwmAtom& SwmNode::get_state_alloc() const {
   return state_alloc;
 }
 
-std::vector<uint64_t> SwmNode::get_roles() const {
+const std::pmr::vector<uint64_t>& SwmNode::get_roles() const {
   return roles;
 }
 
-std::vector<SwmResource> SwmNode::get_resources() const {
+const std::pmr::vector<SwmResource>& SwmNode::get_resources() const {
   return resources;
 }
 
-std::vector<SwmTupleAtomBuff> SwmNode::get_properties() const {
+const std::pmr::vector<SwmTupleAtomBuff>& SwmNode::get_properties() const {
   return properties;
 }
 
-std::string SwmNode::get_subdivision() const {
+const SwmAtom& SwmNode::get_subdivision() const {
   return subdivision;
 }
 
-std::string SwmNode::get_subdivision_id() const {
+const std::pmr::string& SwmNode::get_subdivision_id() const {
   return subdivision_id;
 }
 
-std::vector<uint64_t> SwmNode::get_malfunctions() const {
+const std::pmr::vector<uint64_t>& SwmNode::get_malfunctions() const {
   return malfunctions;
 }
 
-std::string SwmNode::get_comment() const {
+const std::pmr::string& SwmNode::get_comment() const {
   return comment;
 }
 
-std::string SwmNode::get_remote_id() const {
+const std::pmr::string& SwmNode::get_remote_id() const {
   return remote_id;
 }
 
-std::string SwmNode::get_is_template() const {
+const SwmAtom& SwmNode::get_is_template() const {
   return is_template;
 }
 
-std::string SwmNode::get_gateway() const {
+const std::pmr::string& SwmNode::get_gateway() const {
   return gateway;
 }
 
-std::map<std::string, std::string> SwmNode::get_prices() const {
+const SwmPriceMap& SwmNode::get_prices() const {
   return prices;
 }
 
-uint64_t SwmNode::get_revision() const {
+const uint64_t& SwmNode::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_node(const char *buf, int &index, std::vector<SwmNode> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a node list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for node at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a node list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of node list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_node(const char *buf, int &index, std::vector<SwmNode> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_node(const char *buf, int &index, std::pmr::vector<SwmNode> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_node(const char *buf, int &index, std::vector<SwmNode> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a node list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmNode(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_node(const char* buf, int &index, SwmNode &obj) {
-  obj = SwmNode(buf, index);
+  obj = SwmNode(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmNode::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmNode::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode node" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_node(char* buf, int &index, const SwmNode &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_node(char* buf, int &index, const std::vector<SwmNode> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmNode &x) { x.encode(b, i); });
+}
+
+void swm::encode_node(char* buf, int &index, const std::pmr::vector<SwmNode> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmNode &x) { x.encode(b, i); });
+}
+
+int swm::encode_node(ei_x_buff &x, const std::vector<SwmNode> &array) {
+  int size = 0;
+  encode_node(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode node list" << std::endl;
+    return -1;
+  }
+  encode_node(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_node(ei_x_buff &x, const std::pmr::vector<SwmNode> &array) {
+  int size = 0;
+  encode_node(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode node list" << std::endl;
+    return -1;
+  }
+  encode_node(x.buff, x.index, array);
   return 0;
 }
 
 void SwmNode::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << host << separator;
-  std::cerr << prefix << api_port << separator;
-  std::cerr << prefix << parent << separator;
-  std::cerr << prefix << state_power << separator;
-  std::cerr << prefix << state_alloc << separator;
-  if (roles.empty()) {
-    std::cerr << prefix << "roles: []" << separator;
-  } else {
-    std::cerr << prefix << "roles" << ": [";
-    for (const auto &q: roles) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  entity_print(*this, prefix, separator);
+}
+
+SwmNodeView::SwmNodeView() {
+}
+
+SwmNodeView::SwmNodeView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmNodeView: null" << std::endl;
+    return;
   }
-  if (resources.empty()) {
-    std::cerr << prefix << "resources: []" << separator;
-  } else {
-    std::cerr << prefix << "resources" << ": [";
-    for (const auto &q: resources) {
-      q.print(prefix, separator);
-    }
-    std::cerr << "]" << separator;
+  if (skip_entity_fields(buf, index, offsets.data(), 19)) {
+    std::cerr << "Could not create SwmNodeView at " << index << std::endl;
+    this->buf = nullptr;
   }
-  if (properties.empty()) {
-    std::cerr << prefix << "properties: []" << separator;
-  } else {
-    std::cerr << prefix << "properties" << ": [";
-    for (const auto &q: properties) {
-      std::cerr << q << ",";
+}
+
+bool SwmNodeView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmNodeView::get_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+std::string_view SwmNodeView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmNodeView::get_host() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+uint64_t SwmNodeView::get_api_port() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[3]);
+}
+
+std::string_view SwmNodeView::get_parent() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[4]);
+}
+
+std::string_view SwmNodeView::get_state_power() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[5]);
+}
+
+std::string_view SwmNodeView::get_state_alloc() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[6]);
+}
+
+SwmListView<uint64_t, ei_buffer_to_uint64_t> SwmNodeView::get_roles() const {
+  return SwmListView<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[7]);
+}
+
+SwmListView<SwmResourceView, ei_buffer_to_resource> SwmNodeView::get_resources() const {
+  return SwmListView<SwmResourceView, ei_buffer_to_resource>(buf, offsets[8]);
+}
+
+SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff> SwmNodeView::get_properties() const {
+  return SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff>(buf, offsets[9]);
+}
+
+std::string_view SwmNodeView::get_subdivision() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[10]);
+}
+
+std::string_view SwmNodeView::get_subdivision_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[11]);
+}
+
+SwmListView<uint64_t, ei_buffer_to_uint64_t> SwmNodeView::get_malfunctions() const {
+  return SwmListView<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[12]);
+}
+
+std::string_view SwmNodeView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[13]);
+}
+
+std::string_view SwmNodeView::get_remote_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[14]);
+}
+
+std::string_view SwmNodeView::get_is_template() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[15]);
+}
+
+std::string_view SwmNodeView::get_gateway() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[16]);
+}
+
+SwmTermView SwmNodeView::get_prices() const {
+  return get_view_value<SwmTermView, ei_buffer_to_map>(buf, offsets[17]);
+}
+
+uint64_t SwmNodeView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[18]);
+}
+
+int swm::ei_buffer_to_node(const char* buf, int &index, SwmNodeView &obj) {
+  obj = SwmNodeView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_node(const char* buf, int &index, std::vector<SwmNodeView> &array) {
+  const SwmListView<SwmNodeView, ei_buffer_to_node> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmNodeView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
+    array.push_back(view);
   }
-  std::cerr << prefix << subdivision << separator;
-  std::cerr << prefix << subdivision_id << separator;
-  if (malfunctions.empty()) {
-    std::cerr << prefix << "malfunctions: []" << separator;
-  } else {
-    std::cerr << prefix << "malfunctions" << ": [";
-    for (const auto &q: malfunctions) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of node at " << index << std::endl;
+    return -1;
   }
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << remote_id << separator;
-  std::cerr << prefix << is_template << separator;
-  std::cerr << prefix << gateway << separator;
-  std::cerr << prefix << prices << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  return 0;
 }
 
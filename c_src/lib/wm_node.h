@@ -2,9 +2,14 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 #include "wm_resource.h"
 
 namespace swm {
@@ -12,75 +17,216 @@ namespace swm {
 class SwmNode:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 19;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_NAME = 1ull << 1;
+  static constexpr uint64_t FIELD_HOST = 1ull << 2;
+  static constexpr uint64_t FIELD_API_PORT = 1ull << 3;
+  static constexpr uint64_t FIELD_PARENT = 1ull << 4;
+  static constexpr uint64_t FIELD_STATE_POWER = 1ull << 5;
+  static constexpr uint64_t FIELD_STATE_ALLOC = 1ull << 6;
+  static constexpr uint64_t FIELD_ROLES = 1ull << 7;
+  static constexpr uint64_t FIELD_RESOURCES = 1ull << 8;
+  static constexpr uint64_t FIELD_PROPERTIES = 1ull << 9;
+  static constexpr uint64_t FIELD_SUBDIVISION = 1ull << 10;
+  static constexpr uint64_t FIELD_SUBDIVISION_ID = 1ull << 11;
+  static constexpr uint64_t FIELD_MALFUNCTIONS = 1ull << 12;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 13;
+  static constexpr uint64_t FIELD_REMOTE_ID = 1ull << 14;
+  static constexpr uint64_t FIELD_IS_TEMPLATE = 1ull << 15;
+  static constexpr uint64_t FIELD_GATEWAY = 1ull << 16;
+  static constexpr uint64_t FIELD_PRICES = 1ull << 17;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 18;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "node";
+  static const SwmFieldInfo<SwmNode> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmNode();
-  SwmNode(const char*, int&);
+  explicit SwmNode(const allocator_type&);
+  SwmNode(const char*, int&, const allocator_type& = {});
+  SwmNode(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmNode(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmNode(const SwmNode&, const allocator_type&);
+  SwmNode(SwmNode&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmNode &old_obj, const SwmNode &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_id(const std::string&);
-  void set_name(const std::string&);
-  void set_host(const std::string&);
+  void set_id(const SwmId&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_host(const std::pmr::string&);
+  void set_host(std::pmr::string&&);
   void set_api_port(const uint64_t&);
-  void set_parent(const std::string&);
-  void set_state_power(const std::string&);
-  void set_state_alloc(const std::string&);
-  void set_roles(const std::vector<uint64_t>&);
-  void set_resources(const std::vector<SwmResource>&);
-  void set_properties(const std::vector<SwmTupleAtomBuff>&);
-  void set_subdivision(const std::string&);
-  void set_subdivision_id(const std::string&);
-  void set_malfunctions(const std::vector<uint64_t>&);
-  void set_comment(const std::string&);
-  void set_remote_id(const std::string&);
-  void set_is_template(const std::string&);
-  void set_gateway(const std::string&);
-  void set_prices(const std::map<std::string, std::string>&);
+  void set_parent(const std::pmr::string&);
+  void set_parent(std::pmr::string&&);
+  void set_state_power(const SwmAtom&);
+  void set_state_alloc(const SwmAtom&);
+  void set_roles(const std::pmr::vector<uint64_t>&);
+  void set_roles(std::pmr::vector<uint64_t>&&);
+  void set_resources(const std::pmr::vector<SwmResource>&);
+  void set_resources(std::pmr::vector<SwmResource>&&);
+  void set_properties(const std::pmr::vector<SwmTupleAtomBuff>&);
+  void set_properties(std::pmr::vector<SwmTupleAtomBuff>&&);
+  void set_subdivision(const SwmAtom&);
+  void set_subdivision_id(const std::pmr::string&);
+  void set_subdivision_id(std::pmr::string&&);
+  void set_malfunctions(const std::pmr::vector<uint64_t>&);
+  void set_malfunctions(std::pmr::vector<uint64_t>&&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
+  void set_remote_id(const std::pmr::string&);
+  void set_remote_id(std::pmr::string&&);
+  void set_is_template(const SwmAtom&);
+  void set_gateway(const std::pmr::string&);
+  void set_gateway(std::pmr::string&&);
+  void set_prices(const SwmPriceMap&);
+  void set_prices(SwmPriceMap&&);
   void set_revision(const uint64_t&);
 
-  std::string get_id() const;
-  std::string get_name() const;
-  std::string get_host() const;
-  uint64_t get_api_port() const;
-  std::string get_parent() const;
-  std::string get_state_power() const;
-  std::string get_state_alloc() const;
-  std::vector<uint64_t> get_roles() const;
-  std::vector<SwmResource> get_resources() const;
-  std::vector<SwmTupleAtomBuff> get_properties() const;
-  std::string get_subdivision() const;
-  std::string get_subdivision_id() const;
-  std::vector<uint64_t> get_malfunctions() const;
-  std::string get_comment() const;
-  std::string get_remote_id() const;
-  std::string get_is_template() const;
-  std::string get_gateway() const;
-  std::map<std::string, std::string> get_prices() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const SwmId& get_id() const;
+  const std::pmr::string& get_name() const;
+  const std::pmr::string& get_host() const;
+  const uint64_t& get_api_port() const;
+  const std::pmr::string& get_parent() const;
+  const SwmAtom& get_state_power() const;
+  const SwmAtom& get_state_alloc() const;
+  const std::pmr::vector<uint64_t>& get_roles() const;
+  const std::pmr::vector<SwmResource>& get_resources() const;
+  const std::pmr::vector<SwmTupleAtomBuff>& get_properties() const;
+  const SwmAtom& get_subdivision() const;
+  const std::pmr::string& get_subdivision_id() const;
+  const std::pmr::vector<uint64_t>& get_malfunctions() const;
+  const std::pmr::string& get_comment() const;
+  const std::pmr::string& get_remote_id() const;
+  const SwmAtom& get_is_template() const;
+  const std::pmr::string& get_gateway() const;
+  const SwmPriceMap& get_prices() const;
+  const uint64_t& get_revision() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_roles(Args&&... args) {
+    return roles.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_resources(Args&&... args) {
+    return resources.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_properties(Args&&... args) {
+    return properties.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_malfunctions(Args&&... args) {
+    return malfunctions.emplace_back(std::forward<Args>(args)...);
+  }
 
  private:
-  std::string id;
-  std::string name;
-  std::string host;
-  uint64_t api_port;
-  std::string parent;
-  std::string state_power;
-  std::string state_alloc;
-  std::vector<uint64_t> roles;
-  std::vector<SwmResource> resources;
-  std::vector<SwmTupleAtomBuff> properties;
-  std::string subdivision;
-  std::string subdivision_id;
-  std::vector<uint64_t> malfunctions;
-  std::string comment;
-  std::string remote_id;
-  std::string is_template;
-  std::string gateway;
-  std::map<std::string, std::string> prices;
-  uint64_t revision;
+  SwmId id;
+  std::pmr::string name;
+  std::pmr::string host;
+  uint64_t api_port = 0;
+  std::pmr::string parent;
+  SwmAtom state_power;
+  SwmAtom state_alloc;
+  std::pmr::vector<uint64_t> roles;
+  std::pmr::vector<SwmResource> resources;
+  std::pmr::vector<SwmTupleAtomBuff> properties;
+  SwmAtom subdivision;
+  std::pmr::string subdivision_id;
+  std::pmr::vector<uint64_t> malfunctions;
+  std::pmr::string comment;
+  std::pmr::string remote_id;
+  SwmAtom is_template;
+  std::pmr::string gateway;
+  SwmPriceMap prices;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmNodeView;
+
 int ei_buffer_to_node(const char*, int&, std::vector<SwmNode>&);
+int ei_buffer_to_node(const char*, int&, std::pmr::vector<SwmNode>&);
+int ei_buffer_to_node(const char*, int&, std::vector<SwmNode>&, SwmThreadPool&);
 int ei_buffer_to_node(const char*, int&, SwmNode&);
+int ei_buffer_to_node(const char*, int&, std::vector<SwmNodeView>&);
+int ei_buffer_to_node(const char*, int&, SwmNodeView&);
+
+void encode_node(char*, int&, const SwmNode&);
+void encode_node(char*, int&, const std::vector<SwmNode>&);
+void encode_node(char*, int&, const std::pmr::vector<SwmNode>&);
+int encode_node(ei_x_buff&, const std::vector<SwmNode>&);
+int encode_node(ei_x_buff&, const std::pmr::vector<SwmNode>&);
+
+class SwmNodeView {
+
+ public:
+  SwmNodeView();
+  SwmNodeView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_id() const;
+  std::string_view get_name() const;
+  std::string_view get_host() const;
+  uint64_t get_api_port() const;
+  std::string_view get_parent() const;
+  std::string_view get_state_power() const;
+  std::string_view get_state_alloc() const;
+  SwmListView<uint64_t, ei_buffer_to_uint64_t> get_roles() const;
+  SwmListView<SwmResourceView, ei_buffer_to_resource> get_resources() const;
+  SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff> get_properties() const;
+  std::string_view get_subdivision() const;
+  std::string_view get_subdivision_id() const;
+  SwmListView<uint64_t, ei_buffer_to_uint64_t> get_malfunctions() const;
+  std::string_view get_comment() const;
+  std::string_view get_remote_id() const;
+  std::string_view get_is_template() const;
+  std::string_view get_gateway() const;
+  SwmTermView get_prices() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 19> offsets = {};
+
+};
 
 } // namespace swm
@@ -1,436 +1,705 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_partition.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 #include "wm_resource.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmPartition> SwmPartition::FIELDS_INFO[] = {
+  field_info<SwmPartition, SwmId, &SwmPartition::id,
+             ei_buffer_to_id, encode_id,
+             SwmIdTerm>("id"),
+  field_info<SwmPartition, std::pmr::string, &SwmPartition::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmPartition, SwmAtom, &SwmPartition::state,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("state"),
+  field_info<SwmPartition, std::pmr::string, &SwmPartition::manager,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("manager"),
+  field_info<SwmPartition, std::pmr::vector<std::pmr::string>, &SwmPartition::nodes,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("nodes"),
+  field_info<SwmPartition, std::pmr::vector<std::pmr::string>, &SwmPartition::partitions,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("partitions"),
+  field_info<SwmPartition, std::pmr::vector<std::pmr::string>, &SwmPartition::hooks,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("hooks"),
+  field_info<SwmPartition, uint64_t, &SwmPartition::scheduler,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("scheduler"),
+  field_info<SwmPartition, uint64_t, &SwmPartition::jobs_per_node,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("jobs_per_node"),
+  field_info<SwmPartition, std::pmr::vector<SwmResource>, &SwmPartition::resources,
+             ei_buffer_to_resource, encode_resource,
+             SwmListTerm<SwmEntityTerm<SwmResource>>>("resources"),
+  field_info<SwmPartition, std::pmr::vector<SwmTupleAtomBuff>, &SwmPartition::properties,
+             ei_buffer_to_tuple_atom_buff, encode_tuple_atom_buff,
+             SwmListTerm<SwmTupleTerm<SwmAtomTerm, SwmAnyTerm>>>("properties"),
+  field_info<SwmPartition, SwmAtom, &SwmPartition::subdivision,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("subdivision"),
+  field_info<SwmPartition, std::pmr::string, &SwmPartition::subdivision_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("subdivision_id"),
+  field_info<SwmPartition, std::pmr::string, &SwmPartition::created,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("created"),
+  field_info<SwmPartition, std::pmr::string, &SwmPartition::updated,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("updated"),
+  field_info<SwmPartition, std::pmr::string, &SwmPartition::external_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("external_id"),
+  field_info<SwmPartition, SwmMapStrStr, &SwmPartition::addresses,
+             ei_buffer_to_map, encode_map,
+             SwmMapTerm>("addresses"),
+  field_info<SwmPartition, std::pmr::string, &SwmPartition::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmPartition, uint64_t, &SwmPartition::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmPartition::SwmPartition() {
 }
 
-SwmPartition::SwmPartition(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmPartition: null" << std::endl;
+SwmPartition::SwmPartition(const allocator_type &allocator)
+  : name(allocator),
+    manager(allocator),
+    nodes(allocator),
+    partitions(allocator),
+    hooks(allocator),
+    resources(allocator),
+    properties(allocator),
+    subdivision_id(allocator),
+    created(allocator),
+    updated(allocator),
+    external_id(allocator),
+    addresses(allocator),
+    comment(allocator) {
+}
+
+SwmPartition::SwmPartition(const SwmPartition &other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name, allocator),
+    state(other.state),
+    manager(other.manager, allocator),
+    nodes(other.nodes, allocator),
+    partitions(other.partitions, allocator),
+    hooks(other.hooks, allocator),
+    scheduler(other.scheduler),
+    jobs_per_node(other.jobs_per_node),
+    resources(other.resources, allocator),
+    properties(other.properties, allocator),
+    subdivision(other.subdivision),
+    subdivision_id(other.subdivision_id, allocator),
+    created(other.created, allocator),
+    updated(other.updated, allocator),
+    external_id(other.external_id, allocator),
+    addresses(other.addresses, allocator),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
+
+SwmPartition::SwmPartition(SwmPartition &&other, const allocator_type &allocator)
+  : id(other.id),
+    name(std::move(other.name), allocator),
+    state(other.state),
+    manager(std::move(other.manager), allocator),
+    nodes(std::move(other.nodes), allocator),
+    partitions(std::move(other.partitions), allocator),
+    hooks(std::move(other.hooks), allocator),
+    scheduler(other.scheduler),
+    jobs_per_node(other.jobs_per_node),
+    resources(std::move(other.resources), allocator),
+    properties(std::move(other.properties), allocator),
+    subdivision(other.subdivision),
+    subdivision_id(std::move(other.subdivision_id), allocator),
+    created(std::move(other.created), allocator),
+    updated(std::move(other.updated), allocator),
+    external_id(std::move(other.external_id), allocator),
+    addresses(std::move(other.addresses), allocator),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
+
+SwmPartition::allocator_type SwmPartition::get_allocator() const {
+  return name.get_allocator();
+}
+
+SwmPartition::SwmPartition(const char* buf, int &index, const allocator_type &allocator)
+  : SwmPartition(buf, index, FIELD_ALL, allocator) {
+}
+
+SwmPartition::SwmPartition(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmPartition(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmPartition header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmPartition term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->id)) {
-    std::cerr << "Could not init partition::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init partition::name at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_atom(buf, index, this->state)) {
-    std::cerr << "Could not init partition::state at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->manager)) {
-    std::cerr << "Could not init partition::manager at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->nodes)) {
-    std::cerr << "Could not init partition::nodes at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->partitions)) {
-    std::cerr << "Could not init partition::partitions at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_str(buf, index, this->hooks)) {
-    std::cerr << "Could not init partition::hooks at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->scheduler)) {
-    std::cerr << "Could not init partition::scheduler at pos 9: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->jobs_per_node)) {
-    std::cerr << "Could not init partition::jobs_per_node at pos 10: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_resource(buf, index, this->resources)) {
-    std::cerr << "Could not init partition::resources at pos 11: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
-
-  if (ei_buffer_to_tuple_atom_buff(buf, index, this->properties)) {
-    std::cerr << "Could not init partition::properties at pos 12: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_atom(buf, index, this->subdivision)) {
-    std::cerr << "Could not init partition::subdivision at pos 13: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmPartition::SwmPartition(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmPartition(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->subdivision_id)) {
-    std::cerr << "Could not init partition::subdivision_id at pos 14: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmPartition::validate(const char* buf, int &index) {
+  return entity_validate<SwmPartition>(buf, index);
+}
 
-  if (ei_buffer_to_str(buf, index, this->created)) {
-    std::cerr << "Could not init partition::created at pos 15: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+void SwmPartition::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
 
-  if (ei_buffer_to_str(buf, index, this->updated)) {
-    std::cerr << "Could not init partition::updated at pos 16: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmPartition::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmPartition>(buf, index, writer);
+}
 
-  if (ei_buffer_to_str(buf, index, this->external_id)) {
-    std::cerr << "Could not init partition::external_id at pos 17: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmPatch SwmPartition::diff(const SwmPartition &old_obj, const SwmPartition &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
 
-  if (ei_buffer_to_map(buf, index, this->addresses)) {
-    std::cerr << "Could not init partition::addresses at pos 18: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmPartition::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init partition::comment at pos 19: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmPartition::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip partition::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
   }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init partition::revision at pos 20: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmPartition::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmPartition::set_id(const std::string &new_val) {
+void SwmPartition::set_id(const SwmId &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmPartition::set_name(const std::string &new_val) {
+void SwmPartition::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmPartition::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmPartition::set_state(const std::string &new_val) {
+void SwmPartition::set_state(const SwmAtom &new_val) {
   state = new_val;
+  lazy_fields &= ~FIELD_STATE;
 }
 
-void SwmPartition::set_manager(const std::string &new_val) {
+void SwmPartition::set_manager(const std::pmr::string &new_val) {
   manager = new_val;
+  lazy_fields &= ~FIELD_MANAGER;
 }
 
-void SwmPartition::set_nodes(const std::vector<std::string> &new_val) {
+void SwmPartition::set_manager(std::pmr::string &&new_val) {
+  manager = std::move(new_val);
+  lazy_fields &= ~FIELD_MANAGER;
+}
+
+void SwmPartition::set_nodes(const std::pmr::vector<std::pmr::string> &new_val) {
   nodes = new_val;
+  lazy_fields &= ~FIELD_NODES;
+}
+
+void SwmPartition::set_nodes(std::pmr::vector<std::pmr::string> &&new_val) {
+  nodes = std::move(new_val);
+  lazy_fields &= ~FIELD_NODES;
 }
 
-void SwmPartition::set_partitions(const std::vector<std::string> &new_val) {
+void SwmPartition::set_partitions(const std::pmr::vector<std::pmr::string> &new_val) {
   partitions = new_val;
+  lazy_fields &= ~FIELD_PARTITIONS;
+}
+
+void SwmPartition::set_partitions(std::pmr::vector<std::pmr::string> &&new_val) {
+  partitions = std::move(new_val);
+  lazy_fields &= ~FIELD_PARTITIONS;
 }
 
-void SwmPartition::set_hooks(const std::vector<std::string> &new_val) {
+void SwmPartition::set_hooks(const std::pmr::vector<std::pmr::string> &new_val) {
   hooks = new_val;
+  lazy_fields &= ~FIELD_HOOKS;
+}
+
+void SwmPartition::set_hooks(std::pmr::vector<std::pmr::string> &&new_val) {
+  hooks = std::move(new_val);
+  lazy_fields &= ~FIELD_HOOKS;
 }
 
 void SwmPartition::set_scheduler(const uint64_t &new_val) {
   scheduler = new_val;
+  lazy_fields &= ~FIELD_SCHEDULER;
 }
 
 void SwmPartition::set_jobs_per_node(const uint64_t &new_val) {
   jobs_per_node = new_val;
+  lazy_fields &= ~FIELD_JOBS_PER_NODE;
 }
 
-void SwmPartition::set_resources(const std::vector<SwmResource> &new_val) {
+void SwmPartition::set_resources(const std::pmr::vector<SwmResource> &new_val) {
   resources = new_val;
+  lazy_fields &= ~FIELD_RESOURCES;
+}
+
+void SwmPartition::set_resources(std::pmr::vector<SwmResource> &&new_val) {
+  resources = std::move(new_val);
+  lazy_fields &= ~FIELD_RESOURCES;
 }
 
-void SwmPartition::set_properties(const std::vector<SwmTupleAtomBuff> &new_val) {
+void SwmPartition::set_properties(const std::pmr::vector<SwmTupleAtomBuff> &new_val) {
   properties = new_val;
+  lazy_fields &= ~FIELD_PROPERTIES;
+}
+
+void SwmPartition::set_properties(std::pmr::vector<SwmTupleAtomBuff> &&new_val) {
+  properties = std::move(new_val);
+  lazy_fields &= ~FIELD_PROPERTIES;
 }
 
-void SwmPartition::set_subdivision(const std::string &new_val) {
+void SwmPartition::set_subdivision(const SwmAtom &new_val) {
   subdivision = new_val;
+  lazy_fields &= ~FIELD_SUBDIVISION;
 }
 
-void SwmPartition::set_subdivision_id(const std::string &new_val) {
+void SwmPartition::set_subdivision_id(const std::pmr::string &new_val) {
   subdivision_id = new_val;
+  lazy_fields &= ~FIELD_SUBDIVISION_ID;
 }
 
-void SwmPartition::set_created(const std::string &new_val) {
+void SwmPartition::set_subdivision_id(std::pmr::string &&new_val) {
+  subdivision_id = std::move(new_val);
+  lazy_fields &= ~FIELD_SUBDIVISION_ID;
+}
+
+void SwmPartition::set_created(const std::pmr::string &new_val) {
   created = new_val;
+  lazy_fields &= ~FIELD_CREATED;
+}
+
+void SwmPartition::set_created(std::pmr::string &&new_val) {
+  created = std::move(new_val);
+  lazy_fields &= ~FIELD_CREATED;
 }
 
-void SwmPartition::set_updated(const std::string &new_val) {
+void SwmPartition::set_updated(const std::pmr::string &new_val) {
   updated = new_val;
+  lazy_fields &= ~FIELD_UPDATED;
+}
+
+void SwmPartition::set_updated(std::pmr::string &&new_val) {
+  updated = std::move(new_val);
+  lazy_fields &= ~FIELD_UPDATED;
 }
 
-void SwmPartition::set_external_id(const std::string &new_val) {
+void SwmPartition::set_external_id(const std::pmr::string &new_val) {
   external_id = new_val;
+  lazy_fields &= ~FIELD_EXTERNAL_ID;
 }
 
-void SwmPartition::set_addresses(const std::map<std::string, std::string> &new_val) {
+void SwmPartition::set_external_id(std::pmr::string &&new_val) {
+  external_id = std::move(new_val);
+  lazy_fields &= ~FIELD_EXTERNAL_ID;
+}
+
+void SwmPartition::set_addresses(const SwmMapStrStr &new_val) {
   addresses = new_val;
+  lazy_fields &= ~FIELD_ADDRESSES;
+}
+
+void SwmPartition::set_addresses(SwmMapStrStr &&new_val) {
+  addresses = std::move(new_val);
+  lazy_fields &= ~FIELD_ADDRESSES;
 }
 
-void SwmPartition::set_comment(const std::string &new_val) {
+void SwmPartition::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmPartition::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmPartition::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-std::string SwmPartition::get_id() const {
+const SwmId& SwmPartition::get_id() const {
   return id;
 }
 
-std::string SwmPartition::get_name() const {
+const std::pmr::string& SwmPartition::get_name() const {
   return name;
 }
 
-std::string SwmPartition::get_state() const {
+const SwmAtom& SwmPartition::get_state() const {
   return state;
 }
 
-std::string SwmPartition::get_manager() const {
+const std::pmr::string& SwmPartition::get_manager() const {
   return manager;
 }
 
-std::vector<std::string> SwmPartition::get_nodes() const {
+const std::pmr::vector<std::pmr::string>& SwmPartition::get_nodes() const {
   return nodes;
 }
 
-std::vector<std::string> SwmPartition::get_partitions() const {
+const std::pmr::vector<std::pmr::string>& SwmPartition::get_partitions() const {
   return partitions;
 }
 
-std::vector<std::string> SwmPartition::get_hooks() const {
+const std::pmr::vector<std::pmr::string>& SwmPartition::get_hooks() const {
   return hooks;
 }
 
-uint64_t SwmPartition::get_scheduler() const {
+const uint64_t& SwmPartition::get_scheduler() const {
   return scheduler;
 }
 
-uint64_t SwmPartition::get_jobs_per_node() const {
+const uint64_t& SwmPartition::get_jobs_per_node() const {
   return jobs_per_node;
 }
 
-std::vector<SwmResource> SwmPartition::get_resources() const {
+const std::pmr::vector<SwmResource>& SwmPartition::get_resources() const {
   return resources;
 }
 
-std::vector<SwmTupleAtomBuff> SwmPartition::get_properties() const {
+const std::pmr::vector<SwmTupleAtomBuff>& SwmPartition::get_properties() const {
   return properties;
 }
 
-std::string SwmPartition::get_subdivision() const {
+const SwmAtom& SwmPartition::get_subdivision() const {
   return subdivision;
 }
 
-std::string SwmPartition::get_subdivision_id() const {
+const std::pmr::string& SwmPartition::get_subdivision_id() const {
   return subdivision_id;
 }
 
-std::string SwmPartition::get_created() const {
+const std::pmr::string& SwmPartition::get_created() const {
   return created;
 }
 
-std::string SwmPartition::get_updated() const {
+const std::pmr::string& SwmPartition::get_updated() const {
   return updated;
 }
 
-std::string SwmPartition::get_external_id() const {
+const std::pmr::string& SwmPartition::get_external_id() const {
   return external_id;
 }
 
-std::map<std::string, std::string> SwmPartition::get_addresses() const {
+const SwmMapStrStr& SwmPartition::get_addresses() const {
   return addresses;
 }
 
-std::string SwmPartition::get_comment() const {
+const std::pmr::string& SwmPartition::get_comment() const {
   return comment;
 }
 
-uint64_t SwmPartition::get_revision() const {
+const uint64_t& SwmPartition::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_partition(const char *buf, int &index, std::vector<SwmPartition> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a partition list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for partition at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a partition list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of partition list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_partition(const char *buf, int &index, std::vector<SwmPartition> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_partition(const char *buf, int &index, std::pmr::vector<SwmPartition> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_partition(const char *buf, int &index, std::vector<SwmPartition> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a partition list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmPartition(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_partition(const char* buf, int &index, SwmPartition &obj) {
-  obj = SwmPartition(buf, index);
+  obj = SwmPartition(buf, index, obj.get_allocator());
   return 0;
 }
 
-void SwmPartition::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << state << separator;
-  std::cerr << prefix << manager << separator;
-  if (nodes.empty()) {
-    std::cerr << prefix << "nodes: []" << separator;
-  } else {
-    std::cerr << prefix << "nodes" << ": [";
-    for (const auto &q: nodes) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+void SwmPartition::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmPartition::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode partition" << std::endl;
+    return -1;
   }
-  if (partitions.empty()) {
-    std::cerr << prefix << "partitions: []" << separator;
-  } else {
-    std::cerr << prefix << "partitions" << ": [";
-    for (const auto &q: partitions) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_partition(char* buf, int &index, const SwmPartition &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_partition(char* buf, int &index, const std::vector<SwmPartition> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmPartition &x) { x.encode(b, i); });
+}
+
+void swm::encode_partition(char* buf, int &index, const std::pmr::vector<SwmPartition> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmPartition &x) { x.encode(b, i); });
+}
+
+int swm::encode_partition(ei_x_buff &x, const std::vector<SwmPartition> &array) {
+  int size = 0;
+  encode_partition(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode partition list" << std::endl;
+    return -1;
   }
-  if (hooks.empty()) {
-    std::cerr << prefix << "hooks: []" << separator;
-  } else {
-    std::cerr << prefix << "hooks" << ": [";
-    for (const auto &q: hooks) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  encode_partition(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_partition(ei_x_buff &x, const std::pmr::vector<SwmPartition> &array) {
+  int size = 0;
+  encode_partition(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode partition list" << std::endl;
+    return -1;
   }
-  std::cerr << prefix << scheduler << separator;
-  std::cerr << prefix << jobs_per_node << separator;
-  if (resources.empty()) {
-    std::cerr << prefix << "resources: []" << separator;
-  } else {
-    std::cerr << prefix << "resources" << ": [";
-    for (const auto &q: resources) {
-      q.print(prefix, separator);
-    }
-    std::cerr << "]" << separator;
+  encode_partition(x.buff, x.index, array);
+  return 0;
+}
+
+void SwmPartition::print(const std::string &prefix, const char separator) const {
+  entity_print(*this, prefix, separator);
+}
+
+SwmPartitionView::SwmPartitionView() {
+}
+
+SwmPartitionView::SwmPartitionView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmPartitionView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 19)) {
+    std::cerr << "Could not create SwmPartitionView at " << index << std::endl;
+    this->buf = nullptr;
   }
-  if (properties.empty()) {
-    std::cerr << prefix << "properties: []" << separator;
-  } else {
-    std::cerr << prefix << "properties" << ": [";
-    for (const auto &q: properties) {
-      std::cerr << q << ",";
+}
+
+bool SwmPartitionView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmPartitionView::get_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+std::string_view SwmPartitionView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmPartitionView::get_state() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[2]);
+}
+
+std::string_view SwmPartitionView::get_manager() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[3]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmPartitionView::get_nodes() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[4]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmPartitionView::get_partitions() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[5]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmPartitionView::get_hooks() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[6]);
+}
+
+uint64_t SwmPartitionView::get_scheduler() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[7]);
+}
+
+uint64_t SwmPartitionView::get_jobs_per_node() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[8]);
+}
+
+SwmListView<SwmResourceView, ei_buffer_to_resource> SwmPartitionView::get_resources() const {
+  return SwmListView<SwmResourceView, ei_buffer_to_resource>(buf, offsets[9]);
+}
+
+SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff> SwmPartitionView::get_properties() const {
+  return SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff>(buf, offsets[10]);
+}
+
+std::string_view SwmPartitionView::get_subdivision() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[11]);
+}
+
+std::string_view SwmPartitionView::get_subdivision_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[12]);
+}
+
+std::string_view SwmPartitionView::get_created() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[13]);
+}
+
+std::string_view SwmPartitionView::get_updated() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[14]);
+}
+
+std::string_view SwmPartitionView::get_external_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[15]);
+}
+
+SwmTermView SwmPartitionView::get_addresses() const {
+  return get_view_value<SwmTermView, ei_buffer_to_map>(buf, offsets[16]);
+}
+
+std::string_view SwmPartitionView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[17]);
+}
+
+uint64_t SwmPartitionView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[18]);
+}
+
+int swm::ei_buffer_to_partition(const char* buf, int &index, SwmPartitionView &obj) {
+  obj = SwmPartitionView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_partition(const char* buf, int &index, std::vector<SwmPartitionView> &array) {
+  const SwmListView<SwmPartitionView, ei_buffer_to_partition> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmPartitionView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
+    array.push_back(view);
   }
-  std::cerr << prefix << subdivision << separator;
-  std::cerr << prefix << subdivision_id << separator;
-  std::cerr << prefix << created << separator;
-  std::cerr << prefix << updated << separator;
-  std::cerr << prefix << external_id << separator;
-  std::cerr << prefix << addresses << separator;
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of partition at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
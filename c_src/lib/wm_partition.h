@@ -2,9 +2,14 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 #include "wm_resource.h"
 
 namespace swm {
@@ -12,75 +17,221 @@ namespace swm {
 class SwmPartition:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 19;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_NAME = 1ull << 1;
+  static constexpr uint64_t FIELD_STATE = 1ull << 2;
+  static constexpr uint64_t FIELD_MANAGER = 1ull << 3;
+  static constexpr uint64_t FIELD_NODES = 1ull << 4;
+  static constexpr uint64_t FIELD_PARTITIONS = 1ull << 5;
+  static constexpr uint64_t FIELD_HOOKS = 1ull << 6;
+  static constexpr uint64_t FIELD_SCHEDULER = 1ull << 7;
+  static constexpr uint64_t FIELD_JOBS_PER_NODE = 1ull << 8;
+  static constexpr uint64_t FIELD_RESOURCES = 1ull << 9;
+  static constexpr uint64_t FIELD_PROPERTIES = 1ull << 10;
+  static constexpr uint64_t FIELD_SUBDIVISION = 1ull << 11;
+  static constexpr uint64_t FIELD_SUBDIVISION_ID = 1ull << 12;
+  static constexpr uint64_t FIELD_CREATED = 1ull << 13;
+  static constexpr uint64_t FIELD_UPDATED = 1ull << 14;
+  static constexpr uint64_t FIELD_EXTERNAL_ID = 1ull << 15;
+  static constexpr uint64_t FIELD_ADDRESSES = 1ull << 16;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 17;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 18;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "partition";
+  static const SwmFieldInfo<SwmPartition> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmPartition();
-  SwmPartition(const char*, int&);
+  explicit SwmPartition(const allocator_type&);
+  SwmPartition(const char*, int&, const allocator_type& = {});
+  SwmPartition(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmPartition(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmPartition(const SwmPartition&, const allocator_type&);
+  SwmPartition(SwmPartition&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmPartition &old_obj, const SwmPartition &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_id(const std::string&);
-  void set_name(const std::string&);
-  void set_state(const std::string&);
-  void set_manager(const std::string&);
-  void set_nodes(const std::vector<std::string>&);
-  void set_partitions(const std::vector<std::string>&);
-  void set_hooks(const std::vector<std::string>&);
+  void set_id(const SwmId&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_state(const SwmAtom&);
+  void set_manager(const std::pmr::string&);
+  void set_manager(std::pmr::string&&);
+  void set_nodes(const std::pmr::vector<std::pmr::string>&);
+  void set_nodes(std::pmr::vector<std::pmr::string>&&);
+  void set_partitions(const std::pmr::vector<std::pmr::string>&);
+  void set_partitions(std::pmr::vector<std::pmr::string>&&);
+  void set_hooks(const std::pmr::vector<std::pmr::string>&);
+  void set_hooks(std::pmr::vector<std::pmr::string>&&);
   void set_scheduler(const uint64_t&);
   void set_jobs_per_node(const uint64_t&);
-  void set_resources(const std::vector<SwmResource>&);
-  void set_properties(const std::vector<SwmTupleAtomBuff>&);
-  void set_subdivision(const std::string&);
-  void set_subdivision_id(const std::string&);
-  void set_created(const std::string&);
-  void set_updated(const std::string&);
-  void set_external_id(const std::string&);
-  void set_addresses(const std::map<std::string, std::string>&);
-  void set_comment(const std::string&);
+  void set_resources(const std::pmr::vector<SwmResource>&);
+  void set_resources(std::pmr::vector<SwmResource>&&);
+  void set_properties(const std::pmr::vector<SwmTupleAtomBuff>&);
+  void set_properties(std::pmr::vector<SwmTupleAtomBuff>&&);
+  void set_subdivision(const SwmAtom&);
+  void set_subdivision_id(const std::pmr::string&);
+  void set_subdivision_id(std::pmr::string&&);
+  void set_created(const std::pmr::string&);
+  void set_created(std::pmr::string&&);
+  void set_updated(const std::pmr::string&);
+  void set_updated(std::pmr::string&&);
+  void set_external_id(const std::pmr::string&);
+  void set_external_id(std::pmr::string&&);
+  void set_addresses(const SwmMapStrStr&);
+  void set_addresses(SwmMapStrStr&&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  std::string get_id() const;
-  std::string get_name() const;
-  std::string get_state() const;
-  std::string get_manager() const;
-  std::vector<std::string> get_nodes() const;
-  std::vector<std::string> get_partitions() const;
-  std::vector<std::string> get_hooks() const;
-  uint64_t get_scheduler() const;
-  uint64_t get_jobs_per_node() const;
-  std::vector<SwmResource> get_resources() const;
-  std::vector<SwmTupleAtomBuff> get_properties() const;
-  std::string get_subdivision() const;
-  std::string get_subdivision_id() const;
-  std::string get_created() const;
-  std::string get_updated() const;
-  std::string get_external_id() const;
-  std::map<std::string, std::string> get_addresses() const;
-  std::string get_comment() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const SwmId& get_id() const;
+  const std::pmr::string& get_name() const;
+  const SwmAtom& get_state() const;
+  const std::pmr::string& get_manager() const;
+  const std::pmr::vector<std::pmr::string>& get_nodes() const;
+  const std::pmr::vector<std::pmr::string>& get_partitions() const;
+  const std::pmr::vector<std::pmr::string>& get_hooks() const;
+  const uint64_t& get_scheduler() const;
+  const uint64_t& get_jobs_per_node() const;
+  const std::pmr::vector<SwmResource>& get_resources() const;
+  const std::pmr::vector<SwmTupleAtomBuff>& get_properties() const;
+  const SwmAtom& get_subdivision() const;
+  const std::pmr::string& get_subdivision_id() const;
+  const std::pmr::string& get_created() const;
+  const std::pmr::string& get_updated() const;
+  const std::pmr::string& get_external_id() const;
+  const SwmMapStrStr& get_addresses() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_nodes(Args&&... args) {
+    return nodes.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_partitions(Args&&... args) {
+    return partitions.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_hooks(Args&&... args) {
+    return hooks.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_resources(Args&&... args) {
+    return resources.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_properties(Args&&... args) {
+    return properties.emplace_back(std::forward<Args>(args)...);
+  }
 
  private:
-  std::string id;
-  std::string name;
-  std::string state;
-  std::string manager;
-  std::vector<std::string> nodes;
-  std::vector<std::string> partitions;
-  std::vector<std::string> hooks;
-  uint64_t scheduler;
-  uint64_t jobs_per_node;
-  std::vector<SwmResource> resources;
-  std::vector<SwmTupleAtomBuff> properties;
-  std::string subdivision;
-  std::string subdivision_id;
-  std::string created;
-  std::string updated;
-  std::string external_id;
-  std::map<std::string, std::string> addresses;
-  std::string comment;
-  uint64_t revision;
+  SwmId id;
+  std::pmr::string name;
+  SwmAtom state;
+  std::pmr::string manager;
+  std::pmr::vector<std::pmr::string> nodes;
+  std::pmr::vector<std::pmr::string> partitions;
+  std::pmr::vector<std::pmr::string> hooks;
+  uint64_t scheduler = 0;
+  uint64_t jobs_per_node = 0;
+  std::pmr::vector<SwmResource> resources;
+  std::pmr::vector<SwmTupleAtomBuff> properties;
+  SwmAtom subdivision;
+  std::pmr::string subdivision_id;
+  std::pmr::string created;
+  std::pmr::string updated;
+  std::pmr::string external_id;
+  SwmMapStrStr addresses;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmPartitionView;
+
 int ei_buffer_to_partition(const char*, int&, std::vector<SwmPartition>&);
+int ei_buffer_to_partition(const char*, int&, std::pmr::vector<SwmPartition>&);
+int ei_buffer_to_partition(const char*, int&, std::vector<SwmPartition>&, SwmThreadPool&);
 int ei_buffer_to_partition(const char*, int&, SwmPartition&);
+int ei_buffer_to_partition(const char*, int&, std::vector<SwmPartitionView>&);
+int ei_buffer_to_partition(const char*, int&, SwmPartitionView&);
+
+void encode_partition(char*, int&, const SwmPartition&);
+void encode_partition(char*, int&, const std::vector<SwmPartition>&);
+void encode_partition(char*, int&, const std::pmr::vector<SwmPartition>&);
+int encode_partition(ei_x_buff&, const std::vector<SwmPartition>&);
+int encode_partition(ei_x_buff&, const std::pmr::vector<SwmPartition>&);
+
+class SwmPartitionView {
+
+ public:
+  SwmPartitionView();
+  SwmPartitionView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_id() const;
+  std::string_view get_name() const;
+  std::string_view get_state() const;
+  std::string_view get_manager() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_nodes() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_partitions() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_hooks() const;
+  uint64_t get_scheduler() const;
+  uint64_t get_jobs_per_node() const;
+  SwmListView<SwmResourceView, ei_buffer_to_resource> get_resources() const;
+  SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff> get_properties() const;
+  std::string_view get_subdivision() const;
+  std::string_view get_subdivision_id() const;
+  std::string_view get_created() const;
+  std::string_view get_updated() const;
+  std::string_view get_external_id() const;
+  SwmTermView get_addresses() const;
+  std::string_view get_comment() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 19> offsets = {};
+
+};
 
 } // namespace swm
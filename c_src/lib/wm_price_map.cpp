@@ -0,0 +1,97 @@
+#include "wm_price_map.h"
+
+#include <algorithm>
+
+
+using namespace swm;
+
+namespace {
+
+bool less_key(const SwmPriceMap::value_type &x, const SwmId &key) {
+  return x.first < key;
+}
+
+bool less_item(const SwmPriceMap::value_type &x, const SwmPriceMap::value_type &y) {
+  return x.first < y.first;
+}
+
+} // namespace
+
+SwmPriceMap::SwmPriceMap(const allocator_type &allocator): items(allocator) {
+}
+
+SwmPriceMap::SwmPriceMap(const SwmPriceMap &other, const allocator_type &allocator)
+  : items(other.items, allocator) {
+}
+
+SwmPriceMap::SwmPriceMap(SwmPriceMap &&other, const allocator_type &allocator)
+  : items(std::move(other.items), allocator) {
+}
+
+SwmPriceMap::const_iterator SwmPriceMap::find(const SwmId &key) const {
+  const auto it = std::lower_bound(items.begin(), items.end(), key, less_key);
+  return it != items.end() && it->first == key ? it : items.end();
+}
+
+SwmPriceMap::const_iterator SwmPriceMap::find(const std::string_view key) const {
+  SwmId id;
+  return SwmId::find(key, id) ? find(id) : items.end();
+}
+
+double SwmPriceMap::get(const SwmId &key, const double default_price) const {
+  const auto it = find(key);
+  return it != items.end() ? it->second.get() : default_price;
+}
+
+double SwmPriceMap::get(const std::string_view key, const double default_price) const {
+  const auto it = find(key);
+  return it != items.end() ? it->second.get() : default_price;
+}
+
+void SwmPriceMap::set(const SwmId &key, const SwmPrice &price) {
+  const auto it = std::lower_bound(items.begin(), items.end(), key, less_key);
+  if (it != items.end() && it->first == key) {
+    it->second = price;
+  } else {
+    items.emplace(it, key, price);
+  }
+}
+
+void SwmPriceMap::set(const std::string_view key, const double price) {
+  set(SwmId(key), SwmPrice::from_double(price));
+}
+
+void SwmPriceMap::append(const SwmId &key, const SwmPrice &price) {
+  items.emplace_back(key, price);
+}
+
+void SwmPriceMap::sort() {
+  std::stable_sort(items.begin(), items.end(), less_item);
+  // the last value wins for duplicated keys like in erlang maps:from_list/1
+  auto out = items.begin();
+  for (auto it = items.begin(); it != items.end(); ++it) {
+    if (out != items.begin() && (out - 1)->first == it->first) {
+      (out - 1)->second = it->second;
+    } else {
+      *out++ = *it;
+    }
+  }
+  items.erase(out, items.end());
+}
+
+SwmPriceMap::allocator_type SwmPriceMap::get_allocator() const {
+  return items.get_allocator();
+}
+
+std::ostream& swm::operator<<(std::ostream& out, const SwmPrice &price) {
+  return price.is_integer() ? out << price.get_int() : out << price.get();
+}
+
+std::ostream& swm::operator<<(std::ostream& out, const SwmPriceMap &prices) {
+  out << "{";
+  for (const auto &[account, price] : prices) {
+    out << account << ": " << price << ", ";
+  }
+  out << "}" << std::endl;
+  return out;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "wm_id.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace swm {
+
+// Price as it comes in the term: erlang integers are kept exactly and are
+// encoded back as integers, floats as floats
+class SwmPrice {
+ public:
+  constexpr SwmPrice() {
+  }
+  static constexpr SwmPrice from_int(const int64_t n) { return SwmPrice(static_cast<double>(n), n, true); }
+  static constexpr SwmPrice from_double(const double x) { return SwmPrice(x, 0, false); }
+
+  bool is_integer() const { return integer; }
+  int64_t get_int() const { return int_value; }  // exact value of an integer price
+  double get() const { return value; }
+
+  bool operator==(const SwmPrice &other) const {
+    return integer == other.integer && (integer ? int_value == other.int_value : value == other.value);
+  }
+  bool operator!=(const SwmPrice &other) const { return !(*this == other); }
+
+ private:
+  constexpr SwmPrice(const double value, const int64_t int_value, const bool integer)
+    : value(value), int_value(int_value), integer(integer) {
+  }
+
+  double value = 0.0;
+  int64_t int_value = 0;
+  bool integer = false;
+};
+
+// Prices per account: flat vector of (account id, price) pairs sorted by
+// the id. Account ids are UUIDs, so they are kept as SwmId and do not grow
+// any table. Maps of prices are small, so lookups are binary searches over
+// contiguous memory and values are numbers, not strings like in generic
+// maps.
+class SwmPriceMap {
+ public:
+  typedef std::pair<SwmId, SwmPrice> value_type;
+  typedef std::pmr::vector<value_type> container_type;
+  typedef container_type::const_iterator const_iterator;
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
+  SwmPriceMap() {
+  }
+  explicit SwmPriceMap(const allocator_type &allocator);
+  SwmPriceMap(const SwmPriceMap &other) = default;
+  SwmPriceMap(SwmPriceMap &&other) = default;
+  SwmPriceMap(const SwmPriceMap &other, const allocator_type &allocator);
+  SwmPriceMap(SwmPriceMap &&other, const allocator_type &allocator);
+  SwmPriceMap& operator=(const SwmPriceMap &other) = default;
+  SwmPriceMap& operator=(SwmPriceMap &&other) = default;
+
+  size_t size() const { return items.size(); }
+  bool empty() const { return items.empty(); }
+  const_iterator begin() const { return items.begin(); }
+  const_iterator end() const { return items.end(); }
+  void clear() { items.clear(); }
+  void reserve(size_t n) { items.reserve(n); }
+
+  const_iterator find(const SwmId &key) const;
+  const_iterator find(std::string_view key) const;  // does not intern the key
+  double get(const SwmId &key, double default_price = 0.0) const;
+  double get(std::string_view key, double default_price = 0.0) const;
+  void set(const SwmId &key, const SwmPrice &price);
+  void set(std::string_view key, double price);
+
+  // Adds a price without keeping the order, sort() must be called afterwards
+  void append(const SwmId &key, const SwmPrice &price);
+  void sort();
+
+  allocator_type get_allocator() const;
+
+  bool operator==(const SwmPriceMap &other) const { return items == other.items; }
+  bool operator!=(const SwmPriceMap &other) const { return items != other.items; }
+
+ private:
+  container_type items;
+};
+
+std::ostream& operator<<(std::ostream& out, const SwmPrice &price);
+std::ostream& operator<<(std::ostream& out, const SwmPriceMap &prices);
+
+} // namespace swm
@@ -1,171 +1,386 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_process.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmProcess> SwmProcess::FIELDS_INFO[] = {
+  field_info<SwmProcess, int64_t, &SwmProcess::pid,
+             ei_buffer_to_int64_t, encode_int64_t,
+             SwmInt64Term>("pid"),
+  field_info<SwmProcess, std::pmr::string, &SwmProcess::state,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("state"),
+  field_info<SwmProcess, int64_t, &SwmProcess::exitcode,
+             ei_buffer_to_int64_t, encode_int64_t,
+             SwmInt64Term>("exitcode"),
+  field_info<SwmProcess, int64_t, &SwmProcess::signal,
+             ei_buffer_to_int64_t, encode_int64_t,
+             SwmInt64Term>("signal"),
+  field_info<SwmProcess, std::pmr::string, &SwmProcess::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+};
+
 SwmProcess::SwmProcess() {
 }
 
-SwmProcess::SwmProcess(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmProcess: null" << std::endl;
-    return;
-  }
+SwmProcess::SwmProcess(const allocator_type &allocator)
+  : state(allocator),
+    comment(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmProcess header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmProcess::SwmProcess(const SwmProcess &other, const allocator_type &allocator)
+  : pid(other.pid),
+    state(other.state, allocator),
+    exitcode(other.exitcode),
+    signal(other.signal),
+    comment(other.comment, allocator),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmProcess term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmProcess::SwmProcess(SwmProcess &&other, const allocator_type &allocator)
+  : pid(other.pid),
+    state(std::move(other.state), allocator),
+    exitcode(other.exitcode),
+    signal(other.signal),
+    comment(std::move(other.comment), allocator),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_int64_t(buf, index, this->pid)) {
-    std::cerr << "Could not init process::pid at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmProcess::allocator_type SwmProcess::get_allocator() const {
+  return state.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->state)) {
-    std::cerr << "Could not init process::state at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmProcess::SwmProcess(const char* buf, int &index, const allocator_type &allocator)
+  : SwmProcess(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_int64_t(buf, index, this->exitcode)) {
-    std::cerr << "Could not init process::exitcode at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmProcess::SwmProcess(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmProcess(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
+  }
+}
 
-  if (ei_buffer_to_int64_t(buf, index, this->signal)) {
-    std::cerr << "Could not init process::signal at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmProcess::SwmProcess(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmProcess(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init process::comment at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmProcess::validate(const char* buf, int &index) {
+  return entity_validate<SwmProcess>(buf, index);
+}
+
+void SwmProcess::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmProcess::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmProcess>(buf, index, writer);
+}
+
+SwmPatch SwmProcess::diff(const SwmProcess &old_obj, const SwmProcess &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmProcess::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmProcess::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip process::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmProcess::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
 void SwmProcess::set_pid(const int64_t &new_val) {
   pid = new_val;
+  lazy_fields &= ~FIELD_PID;
 }
 
-void SwmProcess::set_state(const std::string &new_val) {
+void SwmProcess::set_state(const std::pmr::string &new_val) {
   state = new_val;
+  lazy_fields &= ~FIELD_STATE;
+}
+
+void SwmProcess::set_state(std::pmr::string &&new_val) {
+  state = std::move(new_val);
+  lazy_fields &= ~FIELD_STATE;
 }
 
 void SwmProcess::set_exitcode(const int64_t &new_val) {
   exitcode = new_val;
+  lazy_fields &= ~FIELD_EXITCODE;
 }
 
 void SwmProcess::set_signal(const int64_t &new_val) {
   signal = new_val;
+  lazy_fields &= ~FIELD_SIGNAL;
 }
 
-void SwmProcess::set_comment(const std::string &new_val) {
+void SwmProcess::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmProcess::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
-int64_t SwmProcess::get_pid() const {
+const int64_t& SwmProcess::get_pid() const {
   return pid;
 }
 
-std::string SwmProcess::get_state() const {
+const std::pmr::string& SwmProcess::get_state() const {
   return state;
 }
 
-int64_t SwmProcess::get_exitcode() const {
+const int64_t& SwmProcess::get_exitcode() const {
   return exitcode;
 }
 
-int64_t SwmProcess::get_signal() const {
+const int64_t& SwmProcess::get_signal() const {
   return signal;
 }
 
-std::string SwmProcess::get_comment() const {
+const std::pmr::string& SwmProcess::get_comment() const {
   return comment;
 }
 
-int swm::ei_buffer_to_process(const char *buf, int &index, std::vector<SwmProcess> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a process list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for process at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a process list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of process list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_process(const char *buf, int &index, std::vector<SwmProcess> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_process(const char *buf, int &index, std::pmr::vector<SwmProcess> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_process(const char *buf, int &index, std::vector<SwmProcess> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a process list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmProcess(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_process(const char* buf, int &index, SwmProcess &obj) {
-  obj = SwmProcess(buf, index);
+  obj = SwmProcess(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmProcess::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmProcess::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode process" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_process(char* buf, int &index, const SwmProcess &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_process(char* buf, int &index, const std::vector<SwmProcess> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmProcess &x) { x.encode(b, i); });
+}
+
+void swm::encode_process(char* buf, int &index, const std::pmr::vector<SwmProcess> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmProcess &x) { x.encode(b, i); });
+}
+
+int swm::encode_process(ei_x_buff &x, const std::vector<SwmProcess> &array) {
+  int size = 0;
+  encode_process(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode process list" << std::endl;
+    return -1;
+  }
+  encode_process(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_process(ei_x_buff &x, const std::pmr::vector<SwmProcess> &array) {
+  int size = 0;
+  encode_process(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode process list" << std::endl;
+    return -1;
+  }
+  encode_process(x.buff, x.index, array);
   return 0;
 }
 
 void SwmProcess::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << pid << separator;
-  std::cerr << prefix << state << separator;
-  std::cerr << prefix << exitcode << separator;
-  std::cerr << prefix << signal << separator;
-  std::cerr << prefix << comment << separator;
-  std::cerr << std::endl;
+  entity_print(*this, prefix, separator);
+}
+
+SwmProcessView::SwmProcessView() {
+}
+
+SwmProcessView::SwmProcessView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmProcessView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 5)) {
+    std::cerr << "Could not create SwmProcessView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmProcessView::is_valid() const {
+  return buf != nullptr;
+}
+
+int64_t SwmProcessView::get_pid() const {
+  return get_view_value<int64_t, ei_buffer_to_int64_t>(buf, offsets[0]);
+}
+
+std::string_view SwmProcessView::get_state() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+int64_t SwmProcessView::get_exitcode() const {
+  return get_view_value<int64_t, ei_buffer_to_int64_t>(buf, offsets[2]);
+}
+
+int64_t SwmProcessView::get_signal() const {
+  return get_view_value<int64_t, ei_buffer_to_int64_t>(buf, offsets[3]);
+}
+
+std::string_view SwmProcessView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[4]);
+}
+
+int swm::ei_buffer_to_process(const char* buf, int &index, SwmProcessView &obj) {
+  obj = SwmProcessView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_process(const char* buf, int &index, std::vector<SwmProcessView> &array) {
+  const SwmListView<SwmProcessView, ei_buffer_to_process> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmProcessView at " << index << std::endl;
+      return -1;
+    }
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of process at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
@@ -2,42 +2,132 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmProcess:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 5;
+  static constexpr uint64_t FIELD_PID = 1ull << 0;
+  static constexpr uint64_t FIELD_STATE = 1ull << 1;
+  static constexpr uint64_t FIELD_EXITCODE = 1ull << 2;
+  static constexpr uint64_t FIELD_SIGNAL = 1ull << 3;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 4;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "process";
+  static const SwmFieldInfo<SwmProcess> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmProcess();
-  SwmProcess(const char*, int&);
+  explicit SwmProcess(const allocator_type&);
+  SwmProcess(const char*, int&, const allocator_type& = {});
+  SwmProcess(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmProcess(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmProcess(const SwmProcess&, const allocator_type&);
+  SwmProcess(SwmProcess&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmProcess &old_obj, const SwmProcess &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
   void set_pid(const int64_t&);
-  void set_state(const std::string&);
+  void set_state(const std::pmr::string&);
+  void set_state(std::pmr::string&&);
   void set_exitcode(const int64_t&);
   void set_signal(const int64_t&);
-  void set_comment(const std::string&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
 
-  int64_t get_pid() const;
-  std::string get_state() const;
-  int64_t get_exitcode() const;
-  int64_t get_signal() const;
-  std::string get_comment() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const int64_t& get_pid() const;
+  const std::pmr::string& get_state() const;
+  const int64_t& get_exitcode() const;
+  const int64_t& get_signal() const;
+  const std::pmr::string& get_comment() const;
 
  private:
-  int64_t pid;
-  std::string state;
-  int64_t exitcode;
-  int64_t signal;
-  std::string comment;
+  int64_t pid = 0;
+  std::pmr::string state;
+  int64_t exitcode = 0;
+  int64_t signal = 0;
+  std::pmr::string comment;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmProcessView;
+
 int ei_buffer_to_process(const char*, int&, std::vector<SwmProcess>&);
+int ei_buffer_to_process(const char*, int&, std::pmr::vector<SwmProcess>&);
+int ei_buffer_to_process(const char*, int&, std::vector<SwmProcess>&, SwmThreadPool&);
 int ei_buffer_to_process(const char*, int&, SwmProcess&);
+int ei_buffer_to_process(const char*, int&, std::vector<SwmProcessView>&);
+int ei_buffer_to_process(const char*, int&, SwmProcessView&);
+
+void encode_process(char*, int&, const SwmProcess&);
+void encode_process(char*, int&, const std::vector<SwmProcess>&);
+void encode_process(char*, int&, const std::pmr::vector<SwmProcess>&);
+int encode_process(ei_x_buff&, const std::vector<SwmProcess>&);
+int encode_process(ei_x_buff&, const std::pmr::vector<SwmProcess>&);
+
+class SwmProcessView {
+
+ public:
+  SwmProcessView();
+  SwmProcessView(const char*, int&);
+
+  bool is_valid() const;
+
+  int64_t get_pid() const;
+  std::string_view get_state() const;
+  int64_t get_exitcode() const;
+  int64_t get_signal() const;
+  std::string_view get_comment() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 5> offsets = {};
+
+};
 
 } // namespace swm
@@ -1,307 +1,524 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_queue.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmQueue> SwmQueue::FIELDS_INFO[] = {
+  field_info<SwmQueue, uint64_t, &SwmQueue::id,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("id"),
+  field_info<SwmQueue, std::pmr::string, &SwmQueue::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmQueue, SwmAtom, &SwmQueue::state,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("state"),
+  field_info<SwmQueue, std::pmr::vector<std::pmr::string>, &SwmQueue::jobs,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("jobs"),
+  field_info<SwmQueue, std::pmr::vector<std::pmr::string>, &SwmQueue::nodes,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("nodes"),
+  field_info<SwmQueue, std::pmr::vector<std::pmr::string>, &SwmQueue::users,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("users"),
+  field_info<SwmQueue, std::pmr::vector<std::pmr::string>, &SwmQueue::admins,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("admins"),
+  field_info<SwmQueue, std::pmr::vector<std::pmr::string>, &SwmQueue::hooks,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("hooks"),
+  field_info<SwmQueue, int64_t, &SwmQueue::priority,
+             ei_buffer_to_int64_t, encode_int64_t,
+             SwmInt64Term>("priority"),
+  field_info<SwmQueue, std::pmr::string, &SwmQueue::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmQueue, uint64_t, &SwmQueue::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmQueue::SwmQueue() {
 }
 
-SwmQueue::SwmQueue(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmQueue: null" << std::endl;
-    return;
-  }
+SwmQueue::SwmQueue(const allocator_type &allocator)
+  : name(allocator),
+    jobs(allocator),
+    nodes(allocator),
+    users(allocator),
+    admins(allocator),
+    hooks(allocator),
+    comment(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmQueue header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmQueue::SwmQueue(const SwmQueue &other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name, allocator),
+    state(other.state),
+    jobs(other.jobs, allocator),
+    nodes(other.nodes, allocator),
+    users(other.users, allocator),
+    admins(other.admins, allocator),
+    hooks(other.hooks, allocator),
+    priority(other.priority),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmQueue term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmQueue::SwmQueue(SwmQueue &&other, const allocator_type &allocator)
+  : id(other.id),
+    name(std::move(other.name), allocator),
+    state(other.state),
+    jobs(std::move(other.jobs), allocator),
+    nodes(std::move(other.nodes), allocator),
+    users(std::move(other.users), allocator),
+    admins(std::move(other.admins), allocator),
+    hooks(std::move(other.hooks), allocator),
+    priority(other.priority),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->id)) {
-    std::cerr << "Could not init queue::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmQueue::allocator_type SwmQueue::get_allocator() const {
+  return name.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init queue::name at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmQueue::SwmQueue(const char* buf, int &index, const allocator_type &allocator)
+  : SwmQueue(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_atom(buf, index, this->state)) {
-    std::cerr << "Could not init queue::state at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmQueue::SwmQueue(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmQueue(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_str(buf, index, this->jobs)) {
-    std::cerr << "Could not init queue::jobs at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->nodes)) {
-    std::cerr << "Could not init queue::nodes at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmQueue::SwmQueue(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmQueue(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->users)) {
-    std::cerr << "Could not init queue::users at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmQueue::validate(const char* buf, int &index) {
+  return entity_validate<SwmQueue>(buf, index);
+}
 
-  if (ei_buffer_to_str(buf, index, this->admins)) {
-    std::cerr << "Could not init queue::admins at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+void SwmQueue::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
 
-  if (ei_buffer_to_str(buf, index, this->hooks)) {
-    std::cerr << "Could not init queue::hooks at pos 9: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmQueue::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmQueue>(buf, index, writer);
+}
 
-  if (ei_buffer_to_int64_t(buf, index, this->priority)) {
-    std::cerr << "Could not init queue::priority at pos 10: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmPatch SwmQueue::diff(const SwmQueue &old_obj, const SwmQueue &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init queue::comment at pos 11: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmQueue::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init queue::revision at pos 12: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmQueue::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip queue::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmQueue::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
 void SwmQueue::set_id(const uint64_t &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmQueue::set_name(const std::string &new_val) {
+void SwmQueue::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmQueue::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmQueue::set_state(const std::string &new_val) {
+void SwmQueue::set_state(const SwmAtom &new_val) {
   state = new_val;
+  lazy_fields &= ~FIELD_STATE;
 }
 
-void SwmQueue::set_jobs(const std::vector<std::string> &new_val) {
+void SwmQueue::set_jobs(const std::pmr::vector<std::pmr::string> &new_val) {
   jobs = new_val;
+  lazy_fields &= ~FIELD_JOBS;
 }
 
-void SwmQueue::set_nodes(const std::vector<std::string> &new_val) {
+void SwmQueue::set_jobs(std::pmr::vector<std::pmr::string> &&new_val) {
+  jobs = std::move(new_val);
+  lazy_fields &= ~FIELD_JOBS;
+}
+
+void SwmQueue::set_nodes(const std::pmr::vector<std::pmr::string> &new_val) {
   nodes = new_val;
+  lazy_fields &= ~FIELD_NODES;
 }
 
-void SwmQueue::set_users(const std::vector<std::string> &new_val) {
+void SwmQueue::set_nodes(std::pmr::vector<std::pmr::string> &&new_val) {
+  nodes = std::move(new_val);
+  lazy_fields &= ~FIELD_NODES;
+}
+
+void SwmQueue::set_users(const std::pmr::vector<std::pmr::string> &new_val) {
   users = new_val;
+  lazy_fields &= ~FIELD_USERS;
 }
 
-void SwmQueue::set_admins(const std::vector<std::string> &new_val) {
+void SwmQueue::set_users(std::pmr::vector<std::pmr::string> &&new_val) {
+  users = std::move(new_val);
+  lazy_fields &= ~FIELD_USERS;
+}
+
+void SwmQueue::set_admins(const std::pmr::vector<std::pmr::string> &new_val) {
   admins = new_val;
+  lazy_fields &= ~FIELD_ADMINS;
+}
+
+void SwmQueue::set_admins(std::pmr::vector<std::pmr::string> &&new_val) {
+  admins = std::move(new_val);
+  lazy_fields &= ~FIELD_ADMINS;
 }
 
-void SwmQueue::set_hooks(const std::vector<std::string> &new_val) {
+void SwmQueue::set_hooks(const std::pmr::vector<std::pmr::string> &new_val) {
   hooks = new_val;
+  lazy_fields &= ~FIELD_HOOKS;
+}
+
+void SwmQueue::set_hooks(std::pmr::vector<std::pmr::string> &&new_val) {
+  hooks = std::move(new_val);
+  lazy_fields &= ~FIELD_HOOKS;
 }
 
 void SwmQueue::set_priority(const int64_t &new_val) {
   priority = new_val;
+  lazy_fields &= ~FIELD_PRIORITY;
 }
 
-void SwmQueue::set_comment(const std::string &new_val) {
+void SwmQueue::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmQueue::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmQueue::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-uint64_t SwmQueue::get_id() const {
+const uint64_t& SwmQueue::get_id() const {
   return id;
 }
 
-std::string SwmQueue::get_name() const {
+const std::pmr::string& SwmQueue::get_name() const {
   return name;
 }
 
-std::string SwmQueue::get_state() const {
+const SwmAtom& SwmQueue::get_state() const {
   return state;
 }
 
-std::vector<std::string> SwmQueue::get_jobs() const {
+const std::pmr::vector<std::pmr::string>& SwmQueue::get_jobs() const {
   return jobs;
 }
 
-std::vector<std::string> SwmQueue::get_nodes() const {
+const std::pmr::vector<std::pmr::string>& SwmQueue::get_nodes() const {
   return nodes;
 }
 
-std::vector<std::string> SwmQueue::get_users() const {
+const std::pmr::vector<std::pmr::string>& SwmQueue::get_users() const {
   return users;
 }
 
-std::vector<std::string> SwmQueue::get_admins() const {
+const std::pmr::vector<std::pmr::string>& SwmQueue::get_admins() const {
   return admins;
 }
 
-std::vector<std::string> SwmQueue::get_hooks() const {
+const std::pmr::vector<std::pmr::string>& SwmQueue::get_hooks() const {
   return hooks;
 }
 
-int64_t SwmQueue::get_priority() const {
+const int64_t& SwmQueue::get_priority() const {
   return priority;
 }
 
-std::string SwmQueue::get_comment() const {
+const std::pmr::string& SwmQueue::get_comment() const {
   return comment;
 }
 
-uint64_t SwmQueue::get_revision() const {
+const uint64_t& SwmQueue::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_queue(const char *buf, int &index, std::vector<SwmQueue> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a queue list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for queue at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a queue list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of queue list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_queue(const char *buf, int &index, std::vector<SwmQueue> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_queue(const char *buf, int &index, std::pmr::vector<SwmQueue> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_queue(const char *buf, int &index, std::vector<SwmQueue> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a queue list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmQueue(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_queue(const char* buf, int &index, SwmQueue &obj) {
-  obj = SwmQueue(buf, index);
+  obj = SwmQueue(buf, index, obj.get_allocator());
   return 0;
 }
 
-void SwmQueue::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << state << separator;
-  if (jobs.empty()) {
-    std::cerr << prefix << "jobs: []" << separator;
-  } else {
-    std::cerr << prefix << "jobs" << ": [";
-    for (const auto &q: jobs) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+void SwmQueue::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmQueue::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode queue" << std::endl;
+    return -1;
   }
-  if (nodes.empty()) {
-    std::cerr << prefix << "nodes: []" << separator;
-  } else {
-    std::cerr << prefix << "nodes" << ": [";
-    for (const auto &q: nodes) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_queue(char* buf, int &index, const SwmQueue &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_queue(char* buf, int &index, const std::vector<SwmQueue> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmQueue &x) { x.encode(b, i); });
+}
+
+void swm::encode_queue(char* buf, int &index, const std::pmr::vector<SwmQueue> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmQueue &x) { x.encode(b, i); });
+}
+
+int swm::encode_queue(ei_x_buff &x, const std::vector<SwmQueue> &array) {
+  int size = 0;
+  encode_queue(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode queue list" << std::endl;
+    return -1;
   }
-  if (users.empty()) {
-    std::cerr << prefix << "users: []" << separator;
-  } else {
-    std::cerr << prefix << "users" << ": [";
-    for (const auto &q: users) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  encode_queue(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_queue(ei_x_buff &x, const std::pmr::vector<SwmQueue> &array) {
+  int size = 0;
+  encode_queue(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode queue list" << std::endl;
+    return -1;
   }
-  if (admins.empty()) {
-    std::cerr << prefix << "admins: []" << separator;
-  } else {
-    std::cerr << prefix << "admins" << ": [";
-    for (const auto &q: admins) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
+  encode_queue(x.buff, x.index, array);
+  return 0;
+}
+
+void SwmQueue::print(const std::string &prefix, const char separator) const {
+  entity_print(*this, prefix, separator);
+}
+
+SwmQueueView::SwmQueueView() {
+}
+
+SwmQueueView::SwmQueueView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmQueueView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 11)) {
+    std::cerr << "Could not create SwmQueueView at " << index << std::endl;
+    this->buf = nullptr;
   }
-  if (hooks.empty()) {
-    std::cerr << prefix << "hooks: []" << separator;
-  } else {
-    std::cerr << prefix << "hooks" << ": [";
-    for (const auto &q: hooks) {
-      std::cerr << q << ",";
+}
+
+bool SwmQueueView::is_valid() const {
+  return buf != nullptr;
+}
+
+uint64_t SwmQueueView::get_id() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[0]);
+}
+
+std::string_view SwmQueueView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmQueueView::get_state() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[2]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmQueueView::get_jobs() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[3]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmQueueView::get_nodes() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[4]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmQueueView::get_users() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[5]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmQueueView::get_admins() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[6]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmQueueView::get_hooks() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[7]);
+}
+
+int64_t SwmQueueView::get_priority() const {
+  return get_view_value<int64_t, ei_buffer_to_int64_t>(buf, offsets[8]);
+}
+
+std::string_view SwmQueueView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[9]);
+}
+
+uint64_t SwmQueueView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[10]);
+}
+
+int swm::ei_buffer_to_queue(const char* buf, int &index, SwmQueueView &obj) {
+  obj = SwmQueueView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_queue(const char* buf, int &index, std::vector<SwmQueueView> &array) {
+  const SwmListView<SwmQueueView, ei_buffer_to_queue> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmQueueView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of queue at " << index << std::endl;
+    return -1;
   }
-  std::cerr << prefix << priority << separator;
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  return 0;
 }
 
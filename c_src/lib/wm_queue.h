@@ -2,60 +2,189 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmQueue:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 11;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_NAME = 1ull << 1;
+  static constexpr uint64_t FIELD_STATE = 1ull << 2;
+  static constexpr uint64_t FIELD_JOBS = 1ull << 3;
+  static constexpr uint64_t FIELD_NODES = 1ull << 4;
+  static constexpr uint64_t FIELD_USERS = 1ull << 5;
+  static constexpr uint64_t FIELD_ADMINS = 1ull << 6;
+  static constexpr uint64_t FIELD_HOOKS = 1ull << 7;
+  static constexpr uint64_t FIELD_PRIORITY = 1ull << 8;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 9;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 10;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "queue";
+  static const SwmFieldInfo<SwmQueue> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmQueue();
-  SwmQueue(const char*, int&);
+  explicit SwmQueue(const allocator_type&);
+  SwmQueue(const char*, int&, const allocator_type& = {});
+  SwmQueue(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmQueue(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmQueue(const SwmQueue&, const allocator_type&);
+  SwmQueue(SwmQueue&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmQueue &old_obj, const SwmQueue &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
   void set_id(const uint64_t&);
-  void set_name(const std::string&);
-  void set_state(const std::string&);
-  void set_jobs(const std::vector<std::string>&);
-  void set_nodes(const std::vector<std::string>&);
-  void set_users(const std::vector<std::string>&);
-  void set_admins(const std::vector<std::string>&);
-  void set_hooks(const std::vector<std::string>&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_state(const SwmAtom&);
+  void set_jobs(const std::pmr::vector<std::pmr::string>&);
+  void set_jobs(std::pmr::vector<std::pmr::string>&&);
+  void set_nodes(const std::pmr::vector<std::pmr::string>&);
+  void set_nodes(std::pmr::vector<std::pmr::string>&&);
+  void set_users(const std::pmr::vector<std::pmr::string>&);
+  void set_users(std::pmr::vector<std::pmr::string>&&);
+  void set_admins(const std::pmr::vector<std::pmr::string>&);
+  void set_admins(std::pmr::vector<std::pmr::string>&&);
+  void set_hooks(const std::pmr::vector<std::pmr::string>&);
+  void set_hooks(std::pmr::vector<std::pmr::string>&&);
   void set_priority(const int64_t&);
-  void set_comment(const std::string&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  uint64_t get_id() const;
-  std::string get_name() const;
-  std::string get_state() const;
-  std::vector<std::string> get_jobs() const;
-  std::vector<std::string> get_nodes() const;
-  std::vector<std::string> get_users() const;
-  std::vector<std::string> get_admins() const;
-  std::vector<std::string> get_hooks() const;
-  int64_t get_priority() const;
-  std::string get_comment() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const uint64_t& get_id() const;
+  const std::pmr::string& get_name() const;
+  const SwmAtom& get_state() const;
+  const std::pmr::vector<std::pmr::string>& get_jobs() const;
+  const std::pmr::vector<std::pmr::string>& get_nodes() const;
+  const std::pmr::vector<std::pmr::string>& get_users() const;
+  const std::pmr::vector<std::pmr::string>& get_admins() const;
+  const std::pmr::vector<std::pmr::string>& get_hooks() const;
+  const int64_t& get_priority() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_jobs(Args&&... args) {
+    return jobs.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_nodes(Args&&... args) {
+    return nodes.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_users(Args&&... args) {
+    return users.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_admins(Args&&... args) {
+    return admins.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_hooks(Args&&... args) {
+    return hooks.emplace_back(std::forward<Args>(args)...);
+  }
 
  private:
-  uint64_t id;
-  std::string name;
-  std::string state;
-  std::vector<std::string> jobs;
-  std::vector<std::string> nodes;
-  std::vector<std::string> users;
-  std::vector<std::string> admins;
-  std::vector<std::string> hooks;
-  int64_t priority;
-  std::string comment;
-  uint64_t revision;
+  uint64_t id = 0;
+  std::pmr::string name;
+  SwmAtom state;
+  std::pmr::vector<std::pmr::string> jobs;
+  std::pmr::vector<std::pmr::string> nodes;
+  std::pmr::vector<std::pmr::string> users;
+  std::pmr::vector<std::pmr::string> admins;
+  std::pmr::vector<std::pmr::string> hooks;
+  int64_t priority = 0;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmQueueView;
+
 int ei_buffer_to_queue(const char*, int&, std::vector<SwmQueue>&);
+int ei_buffer_to_queue(const char*, int&, std::pmr::vector<SwmQueue>&);
+int ei_buffer_to_queue(const char*, int&, std::vector<SwmQueue>&, SwmThreadPool&);
 int ei_buffer_to_queue(const char*, int&, SwmQueue&);
+int ei_buffer_to_queue(const char*, int&, std::vector<SwmQueueView>&);
+int ei_buffer_to_queue(const char*, int&, SwmQueueView&);
+
+void encode_queue(char*, int&, const SwmQueue&);
+void encode_queue(char*, int&, const std::vector<SwmQueue>&);
+void encode_queue(char*, int&, const std::pmr::vector<SwmQueue>&);
+int encode_queue(ei_x_buff&, const std::vector<SwmQueue>&);
+int encode_queue(ei_x_buff&, const std::pmr::vector<SwmQueue>&);
+
+class SwmQueueView {
+
+ public:
+  SwmQueueView();
+  SwmQueueView(const char*, int&);
+
+  bool is_valid() const;
+
+  uint64_t get_id() const;
+  std::string_view get_name() const;
+  std::string_view get_state() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_jobs() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_nodes() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_users() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_admins() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_hooks() const;
+  int64_t get_priority() const;
+  std::string_view get_comment() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 11> offsets = {};
+
+};
 
 } // namespace swm
@@ -1,155 +1,368 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_relocation.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmRelocation> SwmRelocation::FIELDS_INFO[] = {
+  field_info<SwmRelocation, std::uint64_t, &SwmRelocation::id,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("id"),
+  field_info<SwmRelocation, std::pmr::string, &SwmRelocation::job_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("job_id"),
+  field_info<SwmRelocation, std::pmr::string, &SwmRelocation::template_node_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("template_node_id"),
+  field_info<SwmRelocation, SwmAtom, &SwmRelocation::canceled,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("canceled"),
+};
+
 SwmRelocation::SwmRelocation() {
 }
 
-SwmRelocation::SwmRelocation(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmRelocation: null" << std::endl;
-    return;
-  }
+SwmRelocation::SwmRelocation(const allocator_type &allocator)
+  : job_id(allocator),
+    template_node_id(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmRelocation header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRelocation::SwmRelocation(const SwmRelocation &other, const allocator_type &allocator)
+  : id(other.id),
+    job_id(other.job_id, allocator),
+    template_node_id(other.template_node_id, allocator),
+    canceled(other.canceled),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmRelocation term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRelocation::SwmRelocation(SwmRelocation &&other, const allocator_type &allocator)
+  : id(other.id),
+    job_id(std::move(other.job_id), allocator),
+    template_node_id(std::move(other.template_node_id), allocator),
+    canceled(other.canceled),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->id)) {
-    std::cerr << "Could not init relocation::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRelocation::allocator_type SwmRelocation::get_allocator() const {
+  return job_id.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->job_id)) {
-    std::cerr << "Could not init relocation::job_id at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmRelocation::SwmRelocation(const char* buf, int &index, const allocator_type &allocator)
+  : SwmRelocation(buf, index, FIELD_ALL, allocator) {
+}
+
+SwmRelocation::SwmRelocation(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmRelocation(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
+  }
+}
 
-  if (ei_buffer_to_str(buf, index, this->template_node_id)) {
-    std::cerr << "Could not init relocation::template_node_id at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmRelocation::SwmRelocation(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmRelocation(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_atom(buf, index, this->canceled)) {
-    std::cerr << "Could not init relocation::canceled at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmRelocation::validate(const char* buf, int &index) {
+  return entity_validate<SwmRelocation>(buf, index);
+}
+
+void SwmRelocation::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmRelocation::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmRelocation>(buf, index, writer);
+}
+
+SwmPatch SwmRelocation::diff(const SwmRelocation &old_obj, const SwmRelocation &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmRelocation::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmRelocation::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip relocation::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmRelocation::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
 void SwmRelocation::set_id(const std::uint64_t &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmRelocation::set_job_id(const std::string &new_val) {
+void SwmRelocation::set_job_id(const std::pmr::string &new_val) {
   job_id = new_val;
+  lazy_fields &= ~FIELD_JOB_ID;
+}
+
+void SwmRelocation::set_job_id(std::pmr::string &&new_val) {
+  job_id = std::move(new_val);
+  lazy_fields &= ~FIELD_JOB_ID;
 }
 
-void SwmRelocation::set_template_node_id(const std::string &new_val) {
+void SwmRelocation::set_template_node_id(const std::pmr::string &new_val) {
   template_node_id = new_val;
+  lazy_fields &= ~FIELD_TEMPLATE_NODE_ID;
 }
 
-void SwmRelocation::set_canceled(const std::string &new_val) {
+void SwmRelocation::set_template_node_id(std::pmr::string &&new_val) {
+  template_node_id = std::move(new_val);
+  lazy_fields &= ~FIELD_TEMPLATE_NODE_ID;
+}
+
+void SwmRelocation::set_canceled(const SwmAtom &new_val) {
   canceled = new_val;
+  lazy_fields &= ~FIELD_CANCELED;
 }
 
-std::uint64_t SwmRelocation::get_id() const {
+const std::uint64_t& SwmRelocation::get_id() const {
   return id;
 }
 
-std::string SwmRelocation::get_job_id() const {
+const std::pmr::string& SwmRelocation::get_job_id() const {
   return job_id;
 }
 
-std::string SwmRelocation::get_template_node_id() const {
+const std::pmr::string& SwmRelocation::get_template_node_id() const {
   return template_node_id;
 }
 
-std::string SwmRelocation::get_canceled() const {
+const SwmAtom& SwmRelocation::get_canceled() const {
   return canceled;
 }
 
-int swm::ei_buffer_to_relocation(const char *buf, int &index, std::vector<SwmRelocation> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a relocation list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for relocation at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a relocation list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of relocation list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_relocation(const char *buf, int &index, std::vector<SwmRelocation> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_relocation(const char *buf, int &index, std::pmr::vector<SwmRelocation> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_relocation(const char *buf, int &index, std::vector<SwmRelocation> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a relocation list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmRelocation(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_relocation(const char* buf, int &index, SwmRelocation &obj) {
-  obj = SwmRelocation(buf, index);
+  obj = SwmRelocation(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmRelocation::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmRelocation::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode relocation" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_relocation(char* buf, int &index, const SwmRelocation &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_relocation(char* buf, int &index, const std::vector<SwmRelocation> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmRelocation &x) { x.encode(b, i); });
+}
+
+void swm::encode_relocation(char* buf, int &index, const std::pmr::vector<SwmRelocation> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmRelocation &x) { x.encode(b, i); });
+}
+
+int swm::encode_relocation(ei_x_buff &x, const std::vector<SwmRelocation> &array) {
+  int size = 0;
+  encode_relocation(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode relocation list" << std::endl;
+    return -1;
+  }
+  encode_relocation(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_relocation(ei_x_buff &x, const std::pmr::vector<SwmRelocation> &array) {
+  int size = 0;
+  encode_relocation(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode relocation list" << std::endl;
+    return -1;
+  }
+  encode_relocation(x.buff, x.index, array);
   return 0;
 }
 
 void SwmRelocation::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << job_id << separator;
-  std::cerr << prefix << template_node_id << separator;
-  std::cerr << prefix << canceled << separator;
-  std::cerr << std::endl;
+  entity_print(*this, prefix, separator);
+}
+
+SwmRelocationView::SwmRelocationView() {
+}
+
+SwmRelocationView::SwmRelocationView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmRelocationView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 4)) {
+    std::cerr << "Could not create SwmRelocationView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmRelocationView::is_valid() const {
+  return buf != nullptr;
+}
+
+uint64_t SwmRelocationView::get_id() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[0]);
+}
+
+std::string_view SwmRelocationView::get_job_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmRelocationView::get_template_node_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+std::string_view SwmRelocationView::get_canceled() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[3]);
+}
+
+int swm::ei_buffer_to_relocation(const char* buf, int &index, SwmRelocationView &obj) {
+  obj = SwmRelocationView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_relocation(const char* buf, int &index, std::vector<SwmRelocationView> &array) {
+  const SwmListView<SwmRelocationView, ei_buffer_to_relocation> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmRelocationView at " << index << std::endl;
+      return -1;
+    }
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of relocation at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
@@ -2,39 +2,127 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmRelocation:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 4;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_JOB_ID = 1ull << 1;
+  static constexpr uint64_t FIELD_TEMPLATE_NODE_ID = 1ull << 2;
+  static constexpr uint64_t FIELD_CANCELED = 1ull << 3;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "relocation";
+  static const SwmFieldInfo<SwmRelocation> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmRelocation();
-  SwmRelocation(const char*, int&);
+  explicit SwmRelocation(const allocator_type&);
+  SwmRelocation(const char*, int&, const allocator_type& = {});
+  SwmRelocation(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmRelocation(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmRelocation(const SwmRelocation&, const allocator_type&);
+  SwmRelocation(SwmRelocation&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmRelocation &old_obj, const SwmRelocation &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
   void set_id(const std::uint64_t&);
-  void set_job_id(const std::string&);
-  void set_template_node_id(const std::string&);
-  void set_canceled(const std::string&);
+  void set_job_id(const std::pmr::string&);
+  void set_job_id(std::pmr::string&&);
+  void set_template_node_id(const std::pmr::string&);
+  void set_template_node_id(std::pmr::string&&);
+  void set_canceled(const SwmAtom&);
 
-  std::uint64_t get_id() const;
-  std::string get_job_id() const;
-  std::string get_template_node_id() const;
-  std::string get_canceled() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const std::uint64_t& get_id() const;
+  const std::pmr::string& get_job_id() const;
+  const std::pmr::string& get_template_node_id() const;
+  const SwmAtom& get_canceled() const;
 
  private:
   std::uint64_t id;
-  std::string job_id;
-  std::string template_node_id;
-  std::string canceled;
+  std::pmr::string job_id;
+  std::pmr::string template_node_id;
+  SwmAtom canceled;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmRelocationView;
+
 int ei_buffer_to_relocation(const char*, int&, std::vector<SwmRelocation>&);
+int ei_buffer_to_relocation(const char*, int&, std::pmr::vector<SwmRelocation>&);
+int ei_buffer_to_relocation(const char*, int&, std::vector<SwmRelocation>&, SwmThreadPool&);
 int ei_buffer_to_relocation(const char*, int&, SwmRelocation&);
+int ei_buffer_to_relocation(const char*, int&, std::vector<SwmRelocationView>&);
+int ei_buffer_to_relocation(const char*, int&, SwmRelocationView&);
+
+void encode_relocation(char*, int&, const SwmRelocation&);
+void encode_relocation(char*, int&, const std::vector<SwmRelocation>&);
+void encode_relocation(char*, int&, const std::pmr::vector<SwmRelocation>&);
+int encode_relocation(ei_x_buff&, const std::vector<SwmRelocation>&);
+int encode_relocation(ei_x_buff&, const std::pmr::vector<SwmRelocation>&);
+
+class SwmRelocationView {
+
+ public:
+  SwmRelocationView();
+  SwmRelocationView(const char*, int&);
+
+  bool is_valid() const;
+
+  uint64_t get_id() const;
+  std::string_view get_job_id() const;
+  std::string_view get_template_node_id() const;
+  std::string_view get_canceled() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 4> offsets = {};
+
+};
 
 } // namespace swm
@@ -1,267 +1,518 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_remote.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmRemote> SwmRemote::FIELDS_INFO[] = {
+  field_info<SwmRemote, SwmId, &SwmRemote::id,
+             ei_buffer_to_id, encode_id,
+             SwmIdTerm>("id"),
+  field_info<SwmRemote, std::pmr::string, &SwmRemote::account_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("account_id"),
+  field_info<SwmRemote, std::pmr::string, &SwmRemote::default_image_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("default_image_id"),
+  field_info<SwmRemote, std::pmr::string, &SwmRemote::default_flavor_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("default_flavor_id"),
+  field_info<SwmRemote, SwmAtom, &SwmRemote::name,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("name"),
+  field_info<SwmRemote, SwmAtom, &SwmRemote::kind,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("kind"),
+  field_info<SwmRemote, std::pmr::string, &SwmRemote::location,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("location"),
+  field_info<SwmRemote, std::pmr::string, &SwmRemote::server,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("server"),
+  field_info<SwmRemote, uint64_t, &SwmRemote::port,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("port"),
+  field_info<SwmRemote, SwmMapStrStr, &SwmRemote::runtime,
+             ei_buffer_to_map, encode_map,
+             SwmMapTerm>("runtime"),
+  field_info<SwmRemote, uint64_t, &SwmRemote::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmRemote::SwmRemote() {
 }
 
-SwmRemote::SwmRemote(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmRemote: null" << std::endl;
-    return;
-  }
+SwmRemote::SwmRemote(const allocator_type &allocator)
+  : account_id(allocator),
+    default_image_id(allocator),
+    default_flavor_id(allocator),
+    location(allocator),
+    server(allocator),
+    runtime(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmRemote header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRemote::SwmRemote(const SwmRemote &other, const allocator_type &allocator)
+  : id(other.id),
+    account_id(other.account_id, allocator),
+    default_image_id(other.default_image_id, allocator),
+    default_flavor_id(other.default_flavor_id, allocator),
+    name(other.name),
+    kind(other.kind),
+    location(other.location, allocator),
+    server(other.server, allocator),
+    port(other.port),
+    runtime(other.runtime, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmRemote term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRemote::SwmRemote(SwmRemote &&other, const allocator_type &allocator)
+  : id(other.id),
+    account_id(std::move(other.account_id), allocator),
+    default_image_id(std::move(other.default_image_id), allocator),
+    default_flavor_id(std::move(other.default_flavor_id), allocator),
+    name(other.name),
+    kind(other.kind),
+    location(std::move(other.location), allocator),
+    server(std::move(other.server), allocator),
+    port(other.port),
+    runtime(std::move(other.runtime), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->id)) {
-    std::cerr << "Could not init remote::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRemote::allocator_type SwmRemote::get_allocator() const {
+  return account_id.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->account_id)) {
-    std::cerr << "Could not init remote::account_id at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRemote::SwmRemote(const char* buf, int &index, const allocator_type &allocator)
+  : SwmRemote(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->default_image_id)) {
-    std::cerr << "Could not init remote::default_image_id at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmRemote::SwmRemote(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmRemote(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_str(buf, index, this->default_flavor_id)) {
-    std::cerr << "Could not init remote::default_flavor_id at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_atom(buf, index, this->name)) {
-    std::cerr << "Could not init remote::name at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmRemote::SwmRemote(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmRemote(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_atom(buf, index, this->kind)) {
-    std::cerr << "Could not init remote::kind at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmRemote::validate(const char* buf, int &index) {
+  return entity_validate<SwmRemote>(buf, index);
+}
 
-  if (ei_buffer_to_str(buf, index, this->location)) {
-    std::cerr << "Could not init remote::location at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+void SwmRemote::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
 
-  if (ei_buffer_to_str(buf, index, this->server)) {
-    std::cerr << "Could not init remote::server at pos 9: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmRemote::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmRemote>(buf, index, writer);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->port)) {
-    std::cerr << "Could not init remote::port at pos 10: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmPatch SwmRemote::diff(const SwmRemote &old_obj, const SwmRemote &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
 
-  if (ei_buffer_to_map(buf, index, this->runtime)) {
-    std::cerr << "Could not init remote::runtime at pos 11: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmRemote::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init remote::revision at pos 12: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmRemote::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip remote::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmRemote::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmRemote::set_id(const std::string &new_val) {
+void SwmRemote::set_id(const SwmId &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmRemote::set_account_id(const std::string &new_val) {
+void SwmRemote::set_account_id(const std::pmr::string &new_val) {
   account_id = new_val;
+  lazy_fields &= ~FIELD_ACCOUNT_ID;
+}
+
+void SwmRemote::set_account_id(std::pmr::string &&new_val) {
+  account_id = std::move(new_val);
+  lazy_fields &= ~FIELD_ACCOUNT_ID;
 }
 
-void SwmRemote::set_default_image_id(const std::string &new_val) {
+void SwmRemote::set_default_image_id(const std::pmr::string &new_val) {
   default_image_id = new_val;
+  lazy_fields &= ~FIELD_DEFAULT_IMAGE_ID;
 }
 
-void SwmRemote::set_default_flavor_id(const std::string &new_val) {
+void SwmRemote::set_default_image_id(std::pmr::string &&new_val) {
+  default_image_id = std::move(new_val);
+  lazy_fields &= ~FIELD_DEFAULT_IMAGE_ID;
+}
+
+void SwmRemote::set_default_flavor_id(const std::pmr::string &new_val) {
   default_flavor_id = new_val;
+  lazy_fields &= ~FIELD_DEFAULT_FLAVOR_ID;
 }
 
-void SwmRemote::set_name(const std::string &new_val) {
+void SwmRemote::set_default_flavor_id(std::pmr::string &&new_val) {
+  default_flavor_id = std::move(new_val);
+  lazy_fields &= ~FIELD_DEFAULT_FLAVOR_ID;
+}
+
+void SwmRemote::set_name(const SwmAtom &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmRemote::set_kind(const std::string &new_val) {
+void SwmRemote::set_kind(const SwmAtom &new_val) {
   kind = new_val;
+  lazy_fields &= ~FIELD_KIND;
 }
 
-void SwmRemote::set_location(const std::string &new_val) {
+void SwmRemote::set_location(const std::pmr::string &new_val) {
   location = new_val;
+  lazy_fields &= ~FIELD_LOCATION;
 }
 
-void SwmRemote::set_server(const std::string &new_val) {
+void SwmRemote::set_location(std::pmr::string &&new_val) {
+  location = std::move(new_val);
+  lazy_fields &= ~FIELD_LOCATION;
+}
+
+void SwmRemote::set_server(const std::pmr::string &new_val) {
   server = new_val;
+  lazy_fields &= ~FIELD_SERVER;
+}
+
+void SwmRemote::set_server(std::pmr::string &&new_val) {
+  server = std::move(new_val);
+  lazy_fields &= ~FIELD_SERVER;
 }
 
 void SwmRemote::set_port(const uint64_t &new_val) {
   port = new_val;
+  lazy_fields &= ~FIELD_PORT;
 }
 
-void SwmRemote::set_runtime(const std::map<std::string, std::string> &new_val) {
+void SwmRemote::set_runtime(const SwmMapStrStr &new_val) {
   runtime = new_val;
+  lazy_fields &= ~FIELD_RUNTIME;
+}
+
+void SwmRemote::set_runtime(SwmMapStrStr &&new_val) {
+  runtime = std::move(new_val);
+  lazy_fields &= ~FIELD_RUNTIME;
 }
 
 void SwmRemote::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-std::string SwmRemote::get_id() const {
+const SwmId& SwmRemote::get_id() const {
   return id;
 }
 
-std::string SwmRemote::get_account_id() const {
+const std::pmr::string& SwmRemote::get_account_id() const {
   return account_id;
 }
 
-std::string SwmRemote::get_default_image_id() const {
+const std::pmr::string& SwmRemote::get_default_image_id() const {
   return default_image_id;
 }
 
-std::string SwmRemote::get_default_flavor_id() const {
+const std::pmr::string& SwmRemote::get_default_flavor_id() const {
   return default_flavor_id;
 }
 
-std::string SwmRemote::get_name() const {
+const SwmAtom& SwmRemote::get_name() const {
   return name;
 }
 
-std::string SwmRemote::get_kind() const {
+const SwmAtom& SwmRemote::get_kind() const {
   return kind;
 }
 
-std::string SwmRemote::get_location() const {
+const std::pmr::string& SwmRemote::get_location() const {
   return location;
 }
 
-std::string SwmRemote::get_server() const {
+const std::pmr::string& SwmRemote::get_server() const {
   return server;
 }
 
-uint64_t SwmRemote::get_port() const {
+const uint64_t& SwmRemote::get_port() const {
   return port;
 }
 
-std::map<std::string, std::string> SwmRemote::get_runtime() const {
+const SwmMapStrStr& SwmRemote::get_runtime() const {
   return runtime;
 }
 
-uint64_t SwmRemote::get_revision() const {
+const uint64_t& SwmRemote::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_remote(const char *buf, int &index, std::vector<SwmRemote> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a remote list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for remote at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a remote list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of remote list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_remote(const char *buf, int &index, std::vector<SwmRemote> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_remote(const char *buf, int &index, std::pmr::vector<SwmRemote> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_remote(const char *buf, int &index, std::vector<SwmRemote> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a remote list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmRemote(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_remote(const char* buf, int &index, SwmRemote &obj) {
-  obj = SwmRemote(buf, index);
+  obj = SwmRemote(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmRemote::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmRemote::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode remote" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_remote(char* buf, int &index, const SwmRemote &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_remote(char* buf, int &index, const std::vector<SwmRemote> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmRemote &x) { x.encode(b, i); });
+}
+
+void swm::encode_remote(char* buf, int &index, const std::pmr::vector<SwmRemote> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmRemote &x) { x.encode(b, i); });
+}
+
+int swm::encode_remote(ei_x_buff &x, const std::vector<SwmRemote> &array) {
+  int size = 0;
+  encode_remote(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode remote list" << std::endl;
+    return -1;
+  }
+  encode_remote(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_remote(ei_x_buff &x, const std::pmr::vector<SwmRemote> &array) {
+  int size = 0;
+  encode_remote(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode remote list" << std::endl;
+    return -1;
+  }
+  encode_remote(x.buff, x.index, array);
   return 0;
 }
 
 void SwmRemote::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << account_id << separator;
-  std::cerr << prefix << default_image_id << separator;
-  std::cerr << prefix << default_flavor_id << separator;
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << kind << separator;
-  std::cerr << prefix << location << separator;
-  std::cerr << prefix << server << separator;
-  std::cerr << prefix << port << separator;
-  std::cerr << prefix << runtime << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  entity_print(*this, prefix, separator);
+}
+
+SwmRemoteView::SwmRemoteView() {
+}
+
+SwmRemoteView::SwmRemoteView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmRemoteView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 11)) {
+    std::cerr << "Could not create SwmRemoteView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmRemoteView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmRemoteView::get_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+std::string_view SwmRemoteView::get_account_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmRemoteView::get_default_image_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+std::string_view SwmRemoteView::get_default_flavor_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[3]);
+}
+
+std::string_view SwmRemoteView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[4]);
+}
+
+std::string_view SwmRemoteView::get_kind() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[5]);
+}
+
+std::string_view SwmRemoteView::get_location() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[6]);
+}
+
+std::string_view SwmRemoteView::get_server() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[7]);
+}
+
+uint64_t SwmRemoteView::get_port() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[8]);
+}
+
+SwmTermView SwmRemoteView::get_runtime() const {
+  return get_view_value<SwmTermView, ei_buffer_to_map>(buf, offsets[9]);
+}
+
+uint64_t SwmRemoteView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[10]);
+}
+
+int swm::ei_buffer_to_remote(const char* buf, int &index, SwmRemoteView &obj) {
+  obj = SwmRemoteView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_remote(const char* buf, int &index, std::vector<SwmRemoteView> &array) {
+  const SwmListView<SwmRemoteView, ei_buffer_to_remote> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmRemoteView at " << index << std::endl;
+      return -1;
+    }
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of remote at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
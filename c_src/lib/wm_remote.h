@@ -2,60 +2,166 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmRemote:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 11;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_ACCOUNT_ID = 1ull << 1;
+  static constexpr uint64_t FIELD_DEFAULT_IMAGE_ID = 1ull << 2;
+  static constexpr uint64_t FIELD_DEFAULT_FLAVOR_ID = 1ull << 3;
+  static constexpr uint64_t FIELD_NAME = 1ull << 4;
+  static constexpr uint64_t FIELD_KIND = 1ull << 5;
+  static constexpr uint64_t FIELD_LOCATION = 1ull << 6;
+  static constexpr uint64_t FIELD_SERVER = 1ull << 7;
+  static constexpr uint64_t FIELD_PORT = 1ull << 8;
+  static constexpr uint64_t FIELD_RUNTIME = 1ull << 9;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 10;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "remote";
+  static const SwmFieldInfo<SwmRemote> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmRemote();
-  SwmRemote(const char*, int&);
+  explicit SwmRemote(const allocator_type&);
+  SwmRemote(const char*, int&, const allocator_type& = {});
+  SwmRemote(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmRemote(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmRemote(const SwmRemote&, const allocator_type&);
+  SwmRemote(SwmRemote&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmRemote &old_obj, const SwmRemote &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_id(const std::string&);
-  void set_account_id(const std::string&);
-  void set_default_image_id(const std::string&);
-  void set_default_flavor_id(const std::string&);
-  void set_name(const std::string&);
-  void set_kind(const std::string&);
-  void set_location(const std::string&);
-  void set_server(const std::string&);
+  void set_id(const SwmId&);
+  void set_account_id(const std::pmr::string&);
+  void set_account_id(std::pmr::string&&);
+  void set_default_image_id(const std::pmr::string&);
+  void set_default_image_id(std::pmr::string&&);
+  void set_default_flavor_id(const std::pmr::string&);
+  void set_default_flavor_id(std::pmr::string&&);
+  void set_name(const SwmAtom&);
+  void set_kind(const SwmAtom&);
+  void set_location(const std::pmr::string&);
+  void set_location(std::pmr::string&&);
+  void set_server(const std::pmr::string&);
+  void set_server(std::pmr::string&&);
   void set_port(const uint64_t&);
-  void set_runtime(const std::map<std::string, std::string>&);
+  void set_runtime(const SwmMapStrStr&);
+  void set_runtime(SwmMapStrStr&&);
   void set_revision(const uint64_t&);
 
-  std::string get_id() const;
-  std::string get_account_id() const;
-  std::string get_default_image_id() const;
-  std::string get_default_flavor_id() const;
-  std::string get_name() const;
-  std::string get_kind() const;
-  std::string get_location() const;
-  std::string get_server() const;
-  uint64_t get_port() const;
-  std::map<std::string, std::string> get_runtime() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const SwmId& get_id() const;
+  const std::pmr::string& get_account_id() const;
+  const std::pmr::string& get_default_image_id() const;
+  const std::pmr::string& get_default_flavor_id() const;
+  const SwmAtom& get_name() const;
+  const SwmAtom& get_kind() const;
+  const std::pmr::string& get_location() const;
+  const std::pmr::string& get_server() const;
+  const uint64_t& get_port() const;
+  const SwmMapStrStr& get_runtime() const;
+  const uint64_t& get_revision() const;
 
  private:
-  std::string id;
-  std::string account_id;
-  std::string default_image_id;
-  std::string default_flavor_id;
-  std::string name;
-  std::string kind;
-  std::string location;
-  std::string server;
-  uint64_t port;
-  std::map<std::string, std::string> runtime;
-  uint64_t revision;
+  SwmId id;
+  std::pmr::string account_id;
+  std::pmr::string default_image_id;
+  std::pmr::string default_flavor_id;
+  SwmAtom name;
+  SwmAtom kind;
+  std::pmr::string location;
+  std::pmr::string server;
+  uint64_t port = 0;
+  SwmMapStrStr runtime;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmRemoteView;
+
 int ei_buffer_to_remote(const char*, int&, std::vector<SwmRemote>&);
+int ei_buffer_to_remote(const char*, int&, std::pmr::vector<SwmRemote>&);
+int ei_buffer_to_remote(const char*, int&, std::vector<SwmRemote>&, SwmThreadPool&);
 int ei_buffer_to_remote(const char*, int&, SwmRemote&);
+int ei_buffer_to_remote(const char*, int&, std::vector<SwmRemoteView>&);
+int ei_buffer_to_remote(const char*, int&, SwmRemoteView&);
+
+void encode_remote(char*, int&, const SwmRemote&);
+void encode_remote(char*, int&, const std::vector<SwmRemote>&);
+void encode_remote(char*, int&, const std::pmr::vector<SwmRemote>&);
+int encode_remote(ei_x_buff&, const std::vector<SwmRemote>&);
+int encode_remote(ei_x_buff&, const std::pmr::vector<SwmRemote>&);
+
+class SwmRemoteView {
+
+ public:
+  SwmRemoteView();
+  SwmRemoteView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_id() const;
+  std::string_view get_account_id() const;
+  std::string_view get_default_image_id() const;
+  std::string_view get_default_flavor_id() const;
+  std::string_view get_name() const;
+  std::string_view get_kind() const;
+  std::string_view get_location() const;
+  std::string_view get_server() const;
+  uint64_t get_port() const;
+  SwmTermView get_runtime() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 11> offsets = {};
+
+};
 
 } // namespace swm
@@ -1,228 +1,441 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_resource.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 #include "wm_resource.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmResource> SwmResource::FIELDS_INFO[] = {
+  field_info<SwmResource, std::pmr::string, &SwmResource::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmResource, uint64_t, &SwmResource::count,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("count"),
+  field_info<SwmResource, std::pmr::vector<std::pmr::string>, &SwmResource::hooks,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("hooks"),
+  field_info<SwmResource, std::pmr::vector<SwmTupleAtomBuff>, &SwmResource::properties,
+             ei_buffer_to_tuple_atom_buff, encode_tuple_atom_buff,
+             SwmListTerm<SwmTupleTerm<SwmAtomTerm, SwmAnyTerm>>>("properties"),
+  field_info<SwmResource, SwmPriceMap, &SwmResource::prices,
+             ei_buffer_to_price_map, encode_price_map,
+             SwmPriceMapTerm>("prices"),
+  field_info<SwmResource, uint64_t, &SwmResource::usage_time,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("usage_time"),
+  field_info<SwmResource, std::pmr::vector<SwmResource>, &SwmResource::resources,
+             ei_buffer_to_resource, encode_resource,
+             SwmListTerm<SwmEntityTerm<SwmResource>>>("resources"),
+};
+
 SwmResource::SwmResource() {
 }
 
-SwmResource::SwmResource(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmResource: null" << std::endl;
-    return;
-  }
+SwmResource::SwmResource(const allocator_type &allocator)
+  : name(allocator),
+    hooks(allocator),
+    properties(allocator),
+    prices(allocator),
+    resources(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmResource header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmResource::SwmResource(const SwmResource &other, const allocator_type &allocator)
+  : name(other.name, allocator),
+    count(other.count),
+    hooks(other.hooks, allocator),
+    properties(other.properties, allocator),
+    prices(other.prices, allocator),
+    usage_time(other.usage_time),
+    resources(other.resources, allocator),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmResource term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmResource::SwmResource(SwmResource &&other, const allocator_type &allocator)
+  : name(std::move(other.name), allocator),
+    count(other.count),
+    hooks(std::move(other.hooks), allocator),
+    properties(std::move(other.properties), allocator),
+    prices(std::move(other.prices), allocator),
+    usage_time(other.usage_time),
+    resources(std::move(other.resources), allocator),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init resource::name at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmResource::allocator_type SwmResource::get_allocator() const {
+  return name.get_allocator();
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->count)) {
-    std::cerr << "Could not init resource::count at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmResource::SwmResource(const char* buf, int &index, const allocator_type &allocator)
+  : SwmResource(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->hooks)) {
-    std::cerr << "Could not init resource::hooks at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmResource::SwmResource(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmResource(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_tuple_atom_buff(buf, index, this->properties)) {
-    std::cerr << "Could not init resource::properties at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_map(buf, index, this->prices)) {
-    std::cerr << "Could not init resource::prices at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmResource::SwmResource(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmResource(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->usage_time)) {
-    std::cerr << "Could not init resource::usage_time at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmResource::validate(const char* buf, int &index) {
+  return entity_validate<SwmResource>(buf, index);
+}
 
-  if (ei_buffer_to_resource(buf, index, this->resources)) {
-    std::cerr << "Could not init resource::resources at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+void SwmResource::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmResource::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmResource>(buf, index, writer);
+}
+
+SwmPatch SwmResource::diff(const SwmResource &old_obj, const SwmResource &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmResource::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmResource::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip resource::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
   }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
+  }
+  return 0;
+}
 
+uint64_t SwmResource::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmResource::set_name(const std::string &new_val) {
+void SwmResource::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmResource::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
 }
 
 void SwmResource::set_count(const uint64_t &new_val) {
   count = new_val;
+  lazy_fields &= ~FIELD_COUNT;
 }
 
-void SwmResource::set_hooks(const std::vector<std::string> &new_val) {
+void SwmResource::set_hooks(const std::pmr::vector<std::pmr::string> &new_val) {
   hooks = new_val;
+  lazy_fields &= ~FIELD_HOOKS;
+}
+
+void SwmResource::set_hooks(std::pmr::vector<std::pmr::string> &&new_val) {
+  hooks = std::move(new_val);
+  lazy_fields &= ~FIELD_HOOKS;
 }
 
-void SwmResource::set_properties(const std::vector<SwmTupleAtomBuff> &new_val) {
+void SwmResource::set_properties(const std::pmr::vector<SwmTupleAtomBuff> &new_val) {
   properties = new_val;
+  lazy_fields &= ~FIELD_PROPERTIES;
+}
+
+void SwmResource::set_properties(std::pmr::vector<SwmTupleAtomBuff> &&new_val) {
+  properties = std::move(new_val);
+  lazy_fields &= ~FIELD_PROPERTIES;
 }
 
-void SwmResource::set_prices(const std::map<std::string, std::string> &new_val) {
+void SwmResource::set_prices(const SwmPriceMap &new_val) {
   prices = new_val;
+  lazy_fields &= ~FIELD_PRICES;
+}
+
+void SwmResource::set_prices(SwmPriceMap &&new_val) {
+  prices = std::move(new_val);
+  lazy_fields &= ~FIELD_PRICES;
 }
 
 void SwmResource::set_usage_time(const uint64_t &new_val) {
   usage_time = new_val;
+  lazy_fields &= ~FIELD_USAGE_TIME;
 }
 
-void SwmResource::set_resources(const std::vector<SwmResource> &new_val) {
+void SwmResource::set_resources(const std::pmr::vector<SwmResource> &new_val) {
   resources = new_val;
+  lazy_fields &= ~FIELD_RESOURCES;
+}
+
+void SwmResource::set_resources(std::pmr::vector<SwmResource> &&new_val) {
+  resources = std::move(new_val);
+  lazy_fields &= ~FIELD_RESOURCES;
 }
 
-std::string SwmResource::get_name() const {
+const std::pmr::string& SwmResource::get_name() const {
   return name;
 }
 
-uint64_t SwmResource::get_count() const {
+const uint64_t& SwmResource::get_count() const {
   return count;
 }
 
-std::vector<std::string> SwmResource::get_hooks() const {
+const std::pmr::vector<std::pmr::string>& SwmResource::get_hooks() const {
   return hooks;
 }
 
-std::vector<SwmTupleAtomBuff> SwmResource::get_properties() const {
+const std::pmr::vector<SwmTupleAtomBuff>& SwmResource::get_properties() const {
   return properties;
 }
 
-std::map<std::string, std::string> SwmResource::get_prices() const {
+const SwmPriceMap& SwmResource::get_prices() const {
   return prices;
 }
 
-uint64_t SwmResource::get_usage_time() const {
+const uint64_t& SwmResource::get_usage_time() const {
   return usage_time;
 }
 
-std::vector<SwmResource> SwmResource::get_resources() const {
+const std::pmr::vector<SwmResource>& SwmResource::get_resources() const {
   return resources;
 }
 
-int swm::ei_buffer_to_resource(const char *buf, int &index, std::vector<SwmResource> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a resource list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for resource at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a resource list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of resource list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_resource(const char *buf, int &index, std::vector<SwmResource> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_resource(const char *buf, int &index, std::pmr::vector<SwmResource> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_resource(const char *buf, int &index, std::vector<SwmResource> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a resource list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmResource(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_resource(const char* buf, int &index, SwmResource &obj) {
-  obj = SwmResource(buf, index);
+  obj = SwmResource(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmResource::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmResource::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode resource" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_resource(char* buf, int &index, const SwmResource &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_resource(char* buf, int &index, const std::vector<SwmResource> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmResource &x) { x.encode(b, i); });
+}
+
+void swm::encode_resource(char* buf, int &index, const std::pmr::vector<SwmResource> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmResource &x) { x.encode(b, i); });
+}
+
+int swm::encode_resource(ei_x_buff &x, const std::vector<SwmResource> &array) {
+  int size = 0;
+  encode_resource(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode resource list" << std::endl;
+    return -1;
+  }
+  encode_resource(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_resource(ei_x_buff &x, const std::pmr::vector<SwmResource> &array) {
+  int size = 0;
+  encode_resource(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode resource list" << std::endl;
+    return -1;
+  }
+  encode_resource(x.buff, x.index, array);
   return 0;
 }
 
 void SwmResource::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << count << separator;
-  if (hooks.empty()) {
-    std::cerr << prefix << "hooks: []" << separator;
-  } else {
-    std::cerr << prefix << "hooks" << ": [";
-    for (const auto &q: hooks) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
-  }
-  if (properties.empty()) {
-    std::cerr << prefix << "properties: []" << separator;
-  } else {
-    std::cerr << prefix << "properties" << ": [";
-    for (const auto &q: properties) {
-      std::cerr << q << ",";
-    }
-    std::cerr << "]" << separator;
-  }
-  std::cerr << prefix << prices << separator;
-  std::cerr << prefix << usage_time << separator;
-  if (resources.empty()) {
-    std::cerr << prefix << "resources: []" << separator;
-  } else {
-    std::cerr << prefix << "resources" << ": [";
-    for (const auto &q: resources) {
-      q.print(prefix, separator);
+  entity_print(*this, prefix, separator);
+}
+
+SwmResourceView::SwmResourceView() {
+}
+
+SwmResourceView::SwmResourceView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmResourceView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 7)) {
+    std::cerr << "Could not create SwmResourceView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmResourceView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmResourceView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+uint64_t SwmResourceView::get_count() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[1]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmResourceView::get_hooks() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff> SwmResourceView::get_properties() const {
+  return SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff>(buf, offsets[3]);
+}
+
+SwmTermView SwmResourceView::get_prices() const {
+  return get_view_value<SwmTermView, ei_buffer_to_map>(buf, offsets[4]);
+}
+
+uint64_t SwmResourceView::get_usage_time() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[5]);
+}
+
+SwmListView<SwmResourceView, ei_buffer_to_resource> SwmResourceView::get_resources() const {
+  return SwmListView<SwmResourceView, ei_buffer_to_resource>(buf, offsets[6]);
+}
+
+int swm::ei_buffer_to_resource(const char* buf, int &index, SwmResourceView &obj) {
+  obj = SwmResourceView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_resource(const char* buf, int &index, std::vector<SwmResourceView> &array) {
+  const SwmListView<SwmResourceView, ei_buffer_to_resource> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmResourceView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
+    array.push_back(view);
   }
-  std::cerr << std::endl;
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of resource at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
@@ -2,9 +2,14 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 #include "wm_resource.h"
 
 namespace swm {
@@ -12,39 +17,145 @@ namespace swm {
 class SwmResource:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 7;
+  static constexpr uint64_t FIELD_NAME = 1ull << 0;
+  static constexpr uint64_t FIELD_COUNT = 1ull << 1;
+  static constexpr uint64_t FIELD_HOOKS = 1ull << 2;
+  static constexpr uint64_t FIELD_PROPERTIES = 1ull << 3;
+  static constexpr uint64_t FIELD_PRICES = 1ull << 4;
+  static constexpr uint64_t FIELD_USAGE_TIME = 1ull << 5;
+  static constexpr uint64_t FIELD_RESOURCES = 1ull << 6;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "resource";
+  static const SwmFieldInfo<SwmResource> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmResource();
-  SwmResource(const char*, int&);
+  explicit SwmResource(const allocator_type&);
+  SwmResource(const char*, int&, const allocator_type& = {});
+  SwmResource(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmResource(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmResource(const SwmResource&, const allocator_type&);
+  SwmResource(SwmResource&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmResource &old_obj, const SwmResource &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_name(const std::string&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
   void set_count(const uint64_t&);
-  void set_hooks(const std::vector<std::string>&);
-  void set_properties(const std::vector<SwmTupleAtomBuff>&);
-  void set_prices(const std::map<std::string, std::string>&);
+  void set_hooks(const std::pmr::vector<std::pmr::string>&);
+  void set_hooks(std::pmr::vector<std::pmr::string>&&);
+  void set_properties(const std::pmr::vector<SwmTupleAtomBuff>&);
+  void set_properties(std::pmr::vector<SwmTupleAtomBuff>&&);
+  void set_prices(const SwmPriceMap&);
+  void set_prices(SwmPriceMap&&);
   void set_usage_time(const uint64_t&);
-  void set_resources(const std::vector<SwmResource>&);
+  void set_resources(const std::pmr::vector<SwmResource>&);
+  void set_resources(std::pmr::vector<SwmResource>&&);
 
-  std::string get_name() const;
-  uint64_t get_count() const;
-  std::vector<std::string> get_hooks() const;
-  std::vector<SwmTupleAtomBuff> get_properties() const;
-  std::map<std::string, std::string> get_prices() const;
-  uint64_t get_usage_time() const;
-  std::vector<SwmResource> get_resources() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const std::pmr::string& get_name() const;
+  const uint64_t& get_count() const;
+  const std::pmr::vector<std::pmr::string>& get_hooks() const;
+  const std::pmr::vector<SwmTupleAtomBuff>& get_properties() const;
+  const SwmPriceMap& get_prices() const;
+  const uint64_t& get_usage_time() const;
+  const std::pmr::vector<SwmResource>& get_resources() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_hooks(Args&&... args) {
+    return hooks.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_properties(Args&&... args) {
+    return properties.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_resources(Args&&... args) {
+    return resources.emplace_back(std::forward<Args>(args)...);
+  }
 
  private:
-  std::string name;
-  uint64_t count;
-  std::vector<std::string> hooks;
-  std::vector<SwmTupleAtomBuff> properties;
-  std::map<std::string, std::string> prices;
-  uint64_t usage_time;
-  std::vector<SwmResource> resources;
+  std::pmr::string name;
+  uint64_t count = 0;
+  std::pmr::vector<std::pmr::string> hooks;
+  std::pmr::vector<SwmTupleAtomBuff> properties;
+  SwmPriceMap prices;
+  uint64_t usage_time = 0;
+  std::pmr::vector<SwmResource> resources;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmResourceView;
+
 int ei_buffer_to_resource(const char*, int&, std::vector<SwmResource>&);
+int ei_buffer_to_resource(const char*, int&, std::pmr::vector<SwmResource>&);
+int ei_buffer_to_resource(const char*, int&, std::vector<SwmResource>&, SwmThreadPool&);
 int ei_buffer_to_resource(const char*, int&, SwmResource&);
+int ei_buffer_to_resource(const char*, int&, std::vector<SwmResourceView>&);
+int ei_buffer_to_resource(const char*, int&, SwmResourceView&);
+
+void encode_resource(char*, int&, const SwmResource&);
+void encode_resource(char*, int&, const std::vector<SwmResource>&);
+void encode_resource(char*, int&, const std::pmr::vector<SwmResource>&);
+int encode_resource(ei_x_buff&, const std::vector<SwmResource>&);
+int encode_resource(ei_x_buff&, const std::pmr::vector<SwmResource>&);
+
+class SwmResourceView {
+
+ public:
+  SwmResourceView();
+  SwmResourceView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_name() const;
+  uint64_t get_count() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_hooks() const;
+  SwmListView<SwmTupleAtomBuffView, ei_buffer_to_tuple_atom_buff> get_properties() const;
+  SwmTermView get_prices() const;
+  uint64_t get_usage_time() const;
+  SwmListView<SwmResourceView, ei_buffer_to_resource> get_resources() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 7> offsets = {};
+
+};
 
 } // namespace swm
@@ -1,179 +1,392 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_role.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmRole> SwmRole::FIELDS_INFO[] = {
+  field_info<SwmRole, uint64_t, &SwmRole::id,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("id"),
+  field_info<SwmRole, std::pmr::string, &SwmRole::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmRole, std::pmr::vector<uint64_t>, &SwmRole::services,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmListTerm<SwmUint64Term>>("services"),
+  field_info<SwmRole, std::pmr::string, &SwmRole::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmRole, uint64_t, &SwmRole::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmRole::SwmRole() {
 }
 
-SwmRole::SwmRole(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmRole: null" << std::endl;
-    return;
-  }
+SwmRole::SwmRole(const allocator_type &allocator)
+  : name(allocator),
+    services(allocator),
+    comment(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmRole header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRole::SwmRole(const SwmRole &other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name, allocator),
+    services(other.services, allocator),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmRole term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRole::SwmRole(SwmRole &&other, const allocator_type &allocator)
+  : id(other.id),
+    name(std::move(other.name), allocator),
+    services(std::move(other.services), allocator),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->id)) {
-    std::cerr << "Could not init role::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRole::allocator_type SwmRole::get_allocator() const {
+  return name.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init role::name at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmRole::SwmRole(const char* buf, int &index, const allocator_type &allocator)
+  : SwmRole(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->services)) {
-    std::cerr << "Could not init role::services at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmRole::SwmRole(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmRole(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
+  }
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init role::comment at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmRole::SwmRole(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmRole(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init role::revision at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmRole::validate(const char* buf, int &index) {
+  return entity_validate<SwmRole>(buf, index);
+}
+
+void SwmRole::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmRole::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmRole>(buf, index, writer);
+}
+
+SwmPatch SwmRole::diff(const SwmRole &old_obj, const SwmRole &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmRole::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmRole::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip role::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmRole::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
 void SwmRole::set_id(const uint64_t &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmRole::set_name(const std::string &new_val) {
+void SwmRole::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmRole::set_services(const std::vector<uint64_t> &new_val) {
+void SwmRole::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmRole::set_services(const std::pmr::vector<uint64_t> &new_val) {
   services = new_val;
+  lazy_fields &= ~FIELD_SERVICES;
+}
+
+void SwmRole::set_services(std::pmr::vector<uint64_t> &&new_val) {
+  services = std::move(new_val);
+  lazy_fields &= ~FIELD_SERVICES;
 }
 
-void SwmRole::set_comment(const std::string &new_val) {
+void SwmRole::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmRole::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmRole::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-uint64_t SwmRole::get_id() const {
+const uint64_t& SwmRole::get_id() const {
   return id;
 }
 
-std::string SwmRole::get_name() const {
+const std::pmr::string& SwmRole::get_name() const {
   return name;
 }
 
-std::vector<uint64_t> SwmRole::get_services() const {
+const std::pmr::vector<uint64_t>& SwmRole::get_services() const {
   return services;
 }
 
-std::string SwmRole::get_comment() const {
+const std::pmr::string& SwmRole::get_comment() const {
   return comment;
 }
 
-uint64_t SwmRole::get_revision() const {
+const uint64_t& SwmRole::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_role(const char *buf, int &index, std::vector<SwmRole> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a role list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for role at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a role list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of role list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_role(const char *buf, int &index, std::vector<SwmRole> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_role(const char *buf, int &index, std::pmr::vector<SwmRole> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_role(const char *buf, int &index, std::vector<SwmRole> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a role list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmRole(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_role(const char* buf, int &index, SwmRole &obj) {
-  obj = SwmRole(buf, index);
+  obj = SwmRole(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmRole::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmRole::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode role" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_role(char* buf, int &index, const SwmRole &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_role(char* buf, int &index, const std::vector<SwmRole> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmRole &x) { x.encode(b, i); });
+}
+
+void swm::encode_role(char* buf, int &index, const std::pmr::vector<SwmRole> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmRole &x) { x.encode(b, i); });
+}
+
+int swm::encode_role(ei_x_buff &x, const std::vector<SwmRole> &array) {
+  int size = 0;
+  encode_role(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode role list" << std::endl;
+    return -1;
+  }
+  encode_role(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_role(ei_x_buff &x, const std::pmr::vector<SwmRole> &array) {
+  int size = 0;
+  encode_role(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode role list" << std::endl;
+    return -1;
+  }
+  encode_role(x.buff, x.index, array);
   return 0;
 }
 
 void SwmRole::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << name << separator;
-  if (services.empty()) {
-    std::cerr << prefix << "services: []" << separator;
-  } else {
-    std::cerr << prefix << "services" << ": [";
-    for (const auto &q: services) {
-      std::cerr << q << ",";
+  entity_print(*this, prefix, separator);
+}
+
+SwmRoleView::SwmRoleView() {
+}
+
+SwmRoleView::SwmRoleView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmRoleView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 5)) {
+    std::cerr << "Could not create SwmRoleView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmRoleView::is_valid() const {
+  return buf != nullptr;
+}
+
+uint64_t SwmRoleView::get_id() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[0]);
+}
+
+std::string_view SwmRoleView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+SwmListView<uint64_t, ei_buffer_to_uint64_t> SwmRoleView::get_services() const {
+  return SwmListView<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[2]);
+}
+
+std::string_view SwmRoleView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[3]);
+}
+
+uint64_t SwmRoleView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[4]);
+}
+
+int swm::ei_buffer_to_role(const char* buf, int &index, SwmRoleView &obj) {
+  obj = SwmRoleView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_role(const char* buf, int &index, std::vector<SwmRoleView> &array) {
+  const SwmListView<SwmRoleView, ei_buffer_to_role> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmRoleView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
+    array.push_back(view);
   }
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of role at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
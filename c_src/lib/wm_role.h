@@ -2,42 +2,139 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmRole:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 5;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_NAME = 1ull << 1;
+  static constexpr uint64_t FIELD_SERVICES = 1ull << 2;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 3;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 4;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "role";
+  static const SwmFieldInfo<SwmRole> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmRole();
-  SwmRole(const char*, int&);
+  explicit SwmRole(const allocator_type&);
+  SwmRole(const char*, int&, const allocator_type& = {});
+  SwmRole(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmRole(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmRole(const SwmRole&, const allocator_type&);
+  SwmRole(SwmRole&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmRole &old_obj, const SwmRole &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
   void set_id(const uint64_t&);
-  void set_name(const std::string&);
-  void set_services(const std::vector<uint64_t>&);
-  void set_comment(const std::string&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_services(const std::pmr::vector<uint64_t>&);
+  void set_services(std::pmr::vector<uint64_t>&&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  uint64_t get_id() const;
-  std::string get_name() const;
-  std::vector<uint64_t> get_services() const;
-  std::string get_comment() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const uint64_t& get_id() const;
+  const std::pmr::string& get_name() const;
+  const std::pmr::vector<uint64_t>& get_services() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_services(Args&&... args) {
+    return services.emplace_back(std::forward<Args>(args)...);
+  }
 
  private:
-  uint64_t id;
-  std::string name;
-  std::vector<uint64_t> services;
-  std::string comment;
-  uint64_t revision;
+  uint64_t id = 0;
+  std::pmr::string name;
+  std::pmr::vector<uint64_t> services;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmRoleView;
+
 int ei_buffer_to_role(const char*, int&, std::vector<SwmRole>&);
+int ei_buffer_to_role(const char*, int&, std::pmr::vector<SwmRole>&);
+int ei_buffer_to_role(const char*, int&, std::vector<SwmRole>&, SwmThreadPool&);
 int ei_buffer_to_role(const char*, int&, SwmRole&);
+int ei_buffer_to_role(const char*, int&, std::vector<SwmRoleView>&);
+int ei_buffer_to_role(const char*, int&, SwmRoleView&);
+
+void encode_role(char*, int&, const SwmRole&);
+void encode_role(char*, int&, const std::vector<SwmRole>&);
+void encode_role(char*, int&, const std::pmr::vector<SwmRole>&);
+int encode_role(ei_x_buff&, const std::vector<SwmRole>&);
+int encode_role(ei_x_buff&, const std::pmr::vector<SwmRole>&);
+
+class SwmRoleView {
+
+ public:
+  SwmRoleView();
+  SwmRoleView(const char*, int&);
+
+  bool is_valid() const;
+
+  uint64_t get_id() const;
+  std::string_view get_name() const;
+  SwmListView<uint64_t, ei_buffer_to_uint64_t> get_services() const;
+  std::string_view get_comment() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 5> offsets = {};
+
+};
 
 } // namespace swm
@@ -1,284 +1,543 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_scheduler.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 #include "wm_executable.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmScheduler> SwmScheduler::FIELDS_INFO[] = {
+  field_info<SwmScheduler, uint64_t, &SwmScheduler::id,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("id"),
+  field_info<SwmScheduler, std::pmr::string, &SwmScheduler::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmScheduler, SwmAtom, &SwmScheduler::state,
+             ei_buffer_to_atom, encode_atom,
+             SwmAtomTerm>("state"),
+  field_info<SwmScheduler, std::pmr::string, &SwmScheduler::start_time,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("start_time"),
+  field_info<SwmScheduler, std::pmr::string, &SwmScheduler::stop_time,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("stop_time"),
+  field_info<SwmScheduler, uint64_t, &SwmScheduler::run_interval,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("run_interval"),
+  field_info<SwmScheduler, SwmExecutable, &SwmScheduler::path,
+             ei_buffer_to_executable, encode_executable,
+             SwmEntityTerm<SwmExecutable>>("path"),
+  field_info<SwmScheduler, std::pmr::string, &SwmScheduler::family,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("family"),
+  field_info<SwmScheduler, std::pmr::string, &SwmScheduler::version,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("version"),
+  field_info<SwmScheduler, uint64_t, &SwmScheduler::cu,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("cu"),
+  field_info<SwmScheduler, std::pmr::string, &SwmScheduler::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmScheduler, uint64_t, &SwmScheduler::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmScheduler::SwmScheduler() {
 }
 
-SwmScheduler::SwmScheduler(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmScheduler: null" << std::endl;
-    return;
-  }
+SwmScheduler::SwmScheduler(const allocator_type &allocator)
+  : name(allocator),
+    start_time(allocator),
+    stop_time(allocator),
+    path(allocator),
+    family(allocator),
+    version(allocator),
+    comment(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmScheduler header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmScheduler::SwmScheduler(const SwmScheduler &other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name, allocator),
+    state(other.state),
+    start_time(other.start_time, allocator),
+    stop_time(other.stop_time, allocator),
+    run_interval(other.run_interval),
+    path(other.path, allocator),
+    family(other.family, allocator),
+    version(other.version, allocator),
+    cu(other.cu),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmScheduler term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmScheduler::SwmScheduler(SwmScheduler &&other, const allocator_type &allocator)
+  : id(other.id),
+    name(std::move(other.name), allocator),
+    state(other.state),
+    start_time(std::move(other.start_time), allocator),
+    stop_time(std::move(other.stop_time), allocator),
+    run_interval(other.run_interval),
+    path(std::move(other.path), allocator),
+    family(std::move(other.family), allocator),
+    version(std::move(other.version), allocator),
+    cu(other.cu),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->id)) {
-    std::cerr << "Could not init scheduler::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmScheduler::allocator_type SwmScheduler::get_allocator() const {
+  return name.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init scheduler::name at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmScheduler::SwmScheduler(const char* buf, int &index, const allocator_type &allocator)
+  : SwmScheduler(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_atom(buf, index, this->state)) {
-    std::cerr << "Could not init scheduler::state at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmScheduler::SwmScheduler(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmScheduler(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_str(buf, index, this->start_time)) {
-    std::cerr << "Could not init scheduler::start_time at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->stop_time)) {
-    std::cerr << "Could not init scheduler::stop_time at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmScheduler::SwmScheduler(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmScheduler(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->run_interval)) {
-    std::cerr << "Could not init scheduler::run_interval at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmScheduler::validate(const char* buf, int &index) {
+  return entity_validate<SwmScheduler>(buf, index);
+}
 
-  if (ei_buffer_to_executable(buf, index, this->path)) {
-    std::cerr << "Could not init scheduler::path at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+void SwmScheduler::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
 
-  if (ei_buffer_to_str(buf, index, this->family)) {
-    std::cerr << "Could not init scheduler::family at pos 9: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmScheduler::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmScheduler>(buf, index, writer);
+}
 
-  if (ei_buffer_to_str(buf, index, this->version)) {
-    std::cerr << "Could not init scheduler::version at pos 10: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmPatch SwmScheduler::diff(const SwmScheduler &old_obj, const SwmScheduler &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->cu)) {
-    std::cerr << "Could not init scheduler::cu at pos 11: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmScheduler::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init scheduler::comment at pos 12: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmScheduler::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip scheduler::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
   }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init scheduler::revision at pos 13: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmScheduler::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
 void SwmScheduler::set_id(const uint64_t &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmScheduler::set_name(const std::string &new_val) {
+void SwmScheduler::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmScheduler::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmScheduler::set_state(const std::string &new_val) {
+void SwmScheduler::set_state(const SwmAtom &new_val) {
   state = new_val;
+  lazy_fields &= ~FIELD_STATE;
 }
 
-void SwmScheduler::set_start_time(const std::string &new_val) {
+void SwmScheduler::set_start_time(const std::pmr::string &new_val) {
   start_time = new_val;
+  lazy_fields &= ~FIELD_START_TIME;
 }
 
-void SwmScheduler::set_stop_time(const std::string &new_val) {
+void SwmScheduler::set_start_time(std::pmr::string &&new_val) {
+  start_time = std::move(new_val);
+  lazy_fields &= ~FIELD_START_TIME;
+}
+
+void SwmScheduler::set_stop_time(const std::pmr::string &new_val) {
   stop_time = new_val;
+  lazy_fields &= ~FIELD_STOP_TIME;
+}
+
+void SwmScheduler::set_stop_time(std::pmr::string &&new_val) {
+  stop_time = std::move(new_val);
+  lazy_fields &= ~FIELD_STOP_TIME;
 }
 
 void SwmScheduler::set_run_interval(const uint64_t &new_val) {
   run_interval = new_val;
+  lazy_fields &= ~FIELD_RUN_INTERVAL;
 }
 
 void SwmScheduler::set_path(const SwmExecutable &new_val) {
   path = new_val;
+  lazy_fields &= ~FIELD_PATH;
 }
 
-void SwmScheduler::set_family(const std::string &new_val) {
+void SwmScheduler::set_path(SwmExecutable &&new_val) {
+  path = std::move(new_val);
+  lazy_fields &= ~FIELD_PATH;
+}
+
+void SwmScheduler::set_family(const std::pmr::string &new_val) {
   family = new_val;
+  lazy_fields &= ~FIELD_FAMILY;
+}
+
+void SwmScheduler::set_family(std::pmr::string &&new_val) {
+  family = std::move(new_val);
+  lazy_fields &= ~FIELD_FAMILY;
 }
 
-void SwmScheduler::set_version(const std::string &new_val) {
+void SwmScheduler::set_version(const std::pmr::string &new_val) {
   version = new_val;
+  lazy_fields &= ~FIELD_VERSION;
+}
+
+void SwmScheduler::set_version(std::pmr::string &&new_val) {
+  version = std::move(new_val);
+  lazy_fields &= ~FIELD_VERSION;
 }
 
 void SwmScheduler::set_cu(const uint64_t &new_val) {
   cu = new_val;
+  lazy_fields &= ~FIELD_CU;
 }
 
-void SwmScheduler::set_comment(const std::string &new_val) {
+void SwmScheduler::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmScheduler::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmScheduler::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-uint64_t SwmScheduler::get_id() const {
+const uint64_t& SwmScheduler::get_id() const {
   return id;
 }
 
-std::string SwmScheduler::get_name() const {
+const std::pmr::string& SwmScheduler::get_name() const {
   return name;
 }
 
-std::string SwmScheduler::get_state() const {
+const SwmAtom& SwmScheduler::get_state() const {
   return state;
 }
 
-std::string SwmScheduler::get_start_time() const {
+const std::pmr::string& SwmScheduler::get_start_time() const {
   return start_time;
 }
 
-std::string SwmScheduler::get_stop_time() const {
+const std::pmr::string& SwmScheduler::get_stop_time() const {
   return stop_time;
 }
 
-uint64_t SwmScheduler::get_run_interval() const {
+const uint64_t& SwmScheduler::get_run_interval() const {
   return run_interval;
 }
 
-SwmExecutable SwmScheduler::get_path() const {
+const SwmExecutable& SwmScheduler::get_path() const {
   return path;
 }
 
-std::string SwmScheduler::get_family() const {
+const std::pmr::string& SwmScheduler::get_family() const {
   return family;
 }
 
-std::string SwmScheduler::get_version() const {
+const std::pmr::string& SwmScheduler::get_version() const {
   return version;
 }
 
-uint64_t SwmScheduler::get_cu() const {
+const uint64_t& SwmScheduler::get_cu() const {
   return cu;
 }
 
-std::string SwmScheduler::get_comment() const {
+const std::pmr::string& SwmScheduler::get_comment() const {
   return comment;
 }
 
-uint64_t SwmScheduler::get_revision() const {
+const uint64_t& SwmScheduler::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_scheduler(const char *buf, int &index, std::vector<SwmScheduler> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a scheduler list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for scheduler at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a scheduler list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of scheduler list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_scheduler(const char *buf, int &index, std::vector<SwmScheduler> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_scheduler(const char *buf, int &index, std::pmr::vector<SwmScheduler> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_scheduler(const char *buf, int &index, std::vector<SwmScheduler> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a scheduler list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmScheduler(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_scheduler(const char* buf, int &index, SwmScheduler &obj) {
-  obj = SwmScheduler(buf, index);
+  obj = SwmScheduler(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmScheduler::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmScheduler::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode scheduler" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_scheduler(char* buf, int &index, const SwmScheduler &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_scheduler(char* buf, int &index, const std::vector<SwmScheduler> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmScheduler &x) { x.encode(b, i); });
+}
+
+void swm::encode_scheduler(char* buf, int &index, const std::pmr::vector<SwmScheduler> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmScheduler &x) { x.encode(b, i); });
+}
+
+int swm::encode_scheduler(ei_x_buff &x, const std::vector<SwmScheduler> &array) {
+  int size = 0;
+  encode_scheduler(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode scheduler list" << std::endl;
+    return -1;
+  }
+  encode_scheduler(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_scheduler(ei_x_buff &x, const std::pmr::vector<SwmScheduler> &array) {
+  int size = 0;
+  encode_scheduler(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode scheduler list" << std::endl;
+    return -1;
+  }
+  encode_scheduler(x.buff, x.index, array);
   return 0;
 }
 
 void SwmScheduler::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << state << separator;
-  std::cerr << prefix << start_time << separator;
-  std::cerr << prefix << stop_time << separator;
-  std::cerr << prefix << run_interval << separator;
-  path.print(prefix, separator);
-  std::cerr << prefix << family << separator;
-  std::cerr << prefix << version << separator;
-  std::cerr << prefix << cu << separator;
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  entity_print(*this, prefix, separator);
+}
+
+SwmSchedulerView::SwmSchedulerView() {
+}
+
+SwmSchedulerView::SwmSchedulerView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmSchedulerView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 12)) {
+    std::cerr << "Could not create SwmSchedulerView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmSchedulerView::is_valid() const {
+  return buf != nullptr;
+}
+
+uint64_t SwmSchedulerView::get_id() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[0]);
+}
+
+std::string_view SwmSchedulerView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmSchedulerView::get_state() const {
+  return get_view_value<std::string_view, ei_buffer_to_atom>(buf, offsets[2]);
+}
+
+std::string_view SwmSchedulerView::get_start_time() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[3]);
+}
+
+std::string_view SwmSchedulerView::get_stop_time() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[4]);
+}
+
+uint64_t SwmSchedulerView::get_run_interval() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[5]);
+}
+
+SwmExecutableView SwmSchedulerView::get_path() const {
+  return get_view_value<SwmExecutableView, ei_buffer_to_executable>(buf, offsets[6]);
+}
+
+std::string_view SwmSchedulerView::get_family() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[7]);
+}
+
+std::string_view SwmSchedulerView::get_version() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[8]);
+}
+
+uint64_t SwmSchedulerView::get_cu() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[9]);
+}
+
+std::string_view SwmSchedulerView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[10]);
+}
+
+uint64_t SwmSchedulerView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[11]);
+}
+
+int swm::ei_buffer_to_scheduler(const char* buf, int &index, SwmSchedulerView &obj) {
+  obj = SwmSchedulerView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_scheduler(const char* buf, int &index, std::vector<SwmSchedulerView> &array) {
+  const SwmListView<SwmSchedulerView, ei_buffer_to_scheduler> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmSchedulerView at " << index << std::endl;
+      return -1;
+    }
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of scheduler at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
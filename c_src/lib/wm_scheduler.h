@@ -2,9 +2,14 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 #include "wm_executable.h"
 
 namespace swm {
@@ -12,54 +17,158 @@ namespace swm {
 class SwmScheduler:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 12;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_NAME = 1ull << 1;
+  static constexpr uint64_t FIELD_STATE = 1ull << 2;
+  static constexpr uint64_t FIELD_START_TIME = 1ull << 3;
+  static constexpr uint64_t FIELD_STOP_TIME = 1ull << 4;
+  static constexpr uint64_t FIELD_RUN_INTERVAL = 1ull << 5;
+  static constexpr uint64_t FIELD_PATH = 1ull << 6;
+  static constexpr uint64_t FIELD_FAMILY = 1ull << 7;
+  static constexpr uint64_t FIELD_VERSION = 1ull << 8;
+  static constexpr uint64_t FIELD_CU = 1ull << 9;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 10;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 11;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "scheduler";
+  static const SwmFieldInfo<SwmScheduler> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmScheduler();
-  SwmScheduler(const char*, int&);
+  explicit SwmScheduler(const allocator_type&);
+  SwmScheduler(const char*, int&, const allocator_type& = {});
+  SwmScheduler(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmScheduler(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmScheduler(const SwmScheduler&, const allocator_type&);
+  SwmScheduler(SwmScheduler&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmScheduler &old_obj, const SwmScheduler &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
   void set_id(const uint64_t&);
-  void set_name(const std::string&);
-  void set_state(const std::string&);
-  void set_start_time(const std::string&);
-  void set_stop_time(const std::string&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_state(const SwmAtom&);
+  void set_start_time(const std::pmr::string&);
+  void set_start_time(std::pmr::string&&);
+  void set_stop_time(const std::pmr::string&);
+  void set_stop_time(std::pmr::string&&);
   void set_run_interval(const uint64_t&);
   void set_path(const SwmExecutable&);
-  void set_family(const std::string&);
-  void set_version(const std::string&);
+  void set_path(SwmExecutable&&);
+  void set_family(const std::pmr::string&);
+  void set_family(std::pmr::string&&);
+  void set_version(const std::pmr::string&);
+  void set_version(std::pmr::string&&);
   void set_cu(const uint64_t&);
-  void set_comment(const std::string&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  uint64_t get_id() const;
-  std::string get_name() const;
-  std::string get_state() const;
-  std::string get_start_time() const;
-  std::string get_stop_time() const;
-  uint64_t get_run_interval() const;
-  SwmExecutable get_path() const;
-  std::string get_family() const;
-  std::string get_version() const;
-  uint64_t get_cu() const;
-  std::string get_comment() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const uint64_t& get_id() const;
+  const std::pmr::string& get_name() const;
+  const SwmAtom& get_state() const;
+  const std::pmr::string& get_start_time() const;
+  const std::pmr::string& get_stop_time() const;
+  const uint64_t& get_run_interval() const;
+  const SwmExecutable& get_path() const;
+  const std::pmr::string& get_family() const;
+  const std::pmr::string& get_version() const;
+  const uint64_t& get_cu() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
 
  private:
-  uint64_t id;
-  std::string name;
-  std::string state;
-  std::string start_time;
-  std::string stop_time;
-  uint64_t run_interval;
+  uint64_t id = 0;
+  std::pmr::string name;
+  SwmAtom state;
+  std::pmr::string start_time;
+  std::pmr::string stop_time;
+  uint64_t run_interval = 0;
   SwmExecutable path;
-  std::string family;
-  std::string version;
-  uint64_t cu;
-  std::string comment;
-  uint64_t revision;
+  std::pmr::string family;
+  std::pmr::string version;
+  uint64_t cu = 0;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmSchedulerView;
+
 int ei_buffer_to_scheduler(const char*, int&, std::vector<SwmScheduler>&);
+int ei_buffer_to_scheduler(const char*, int&, std::pmr::vector<SwmScheduler>&);
+int ei_buffer_to_scheduler(const char*, int&, std::vector<SwmScheduler>&, SwmThreadPool&);
 int ei_buffer_to_scheduler(const char*, int&, SwmScheduler&);
+int ei_buffer_to_scheduler(const char*, int&, std::vector<SwmSchedulerView>&);
+int ei_buffer_to_scheduler(const char*, int&, SwmSchedulerView&);
+
+void encode_scheduler(char*, int&, const SwmScheduler&);
+void encode_scheduler(char*, int&, const std::vector<SwmScheduler>&);
+void encode_scheduler(char*, int&, const std::pmr::vector<SwmScheduler>&);
+int encode_scheduler(ei_x_buff&, const std::vector<SwmScheduler>&);
+int encode_scheduler(ei_x_buff&, const std::pmr::vector<SwmScheduler>&);
+
+class SwmSchedulerView {
+
+ public:
+  SwmSchedulerView();
+  SwmSchedulerView(const char*, int&);
+
+  bool is_valid() const;
+
+  uint64_t get_id() const;
+  std::string_view get_name() const;
+  std::string_view get_state() const;
+  std::string_view get_start_time() const;
+  std::string_view get_stop_time() const;
+  uint64_t get_run_interval() const;
+  SwmExecutableView get_path() const;
+  std::string_view get_family() const;
+  std::string_view get_version() const;
+  uint64_t get_cu() const;
+  std::string_view get_comment() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 12> offsets = {};
+
+};
 
 } // namespace swm
@@ -1,221 +1,430 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_scheduler_result.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 #include "wm_metric.h"
 #include "wm_timetable.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmSchedulerResult> SwmSchedulerResult::FIELDS_INFO[] = {
+  field_info<SwmSchedulerResult, std::pmr::vector<SwmTimetable>, &SwmSchedulerResult::timetable,
+             ei_buffer_to_timetable, encode_timetable,
+             SwmListTerm<SwmEntityTerm<SwmTimetable>>>("timetable"),
+  field_info<SwmSchedulerResult, std::pmr::vector<SwmMetric>, &SwmSchedulerResult::metrics,
+             ei_buffer_to_metric, encode_metric,
+             SwmListTerm<SwmEntityTerm<SwmMetric>>>("metrics"),
+  field_info<SwmSchedulerResult, std::pmr::string, &SwmSchedulerResult::request_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("request_id"),
+  field_info<SwmSchedulerResult, uint64_t, &SwmSchedulerResult::status,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("status"),
+  field_info<SwmSchedulerResult, double, &SwmSchedulerResult::astro_time,
+             ei_buffer_to_double, encode_double,
+             SwmDoubleTerm>("astro_time"),
+  field_info<SwmSchedulerResult, double, &SwmSchedulerResult::idle_time,
+             ei_buffer_to_double, encode_double,
+             SwmDoubleTerm>("idle_time"),
+  field_info<SwmSchedulerResult, double, &SwmSchedulerResult::work_time,
+             ei_buffer_to_double, encode_double,
+             SwmDoubleTerm>("work_time"),
+};
+
 SwmSchedulerResult::SwmSchedulerResult() {
 }
 
-SwmSchedulerResult::SwmSchedulerResult(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmSchedulerResult: null" << std::endl;
-    return;
-  }
+SwmSchedulerResult::SwmSchedulerResult(const allocator_type &allocator)
+  : timetable(allocator),
+    metrics(allocator),
+    request_id(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmSchedulerResult header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmSchedulerResult::SwmSchedulerResult(const SwmSchedulerResult &other, const allocator_type &allocator)
+  : timetable(other.timetable, allocator),
+    metrics(other.metrics, allocator),
+    request_id(other.request_id, allocator),
+    status(other.status),
+    astro_time(other.astro_time),
+    idle_time(other.idle_time),
+    work_time(other.work_time),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmSchedulerResult term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmSchedulerResult::SwmSchedulerResult(SwmSchedulerResult &&other, const allocator_type &allocator)
+  : timetable(std::move(other.timetable), allocator),
+    metrics(std::move(other.metrics), allocator),
+    request_id(std::move(other.request_id), allocator),
+    status(other.status),
+    astro_time(other.astro_time),
+    idle_time(other.idle_time),
+    work_time(other.work_time),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_timetable(buf, index, this->timetable)) {
-    std::cerr << "Could not init scheduler_result::timetable at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmSchedulerResult::allocator_type SwmSchedulerResult::get_allocator() const {
+  return timetable.get_allocator();
+}
 
-  if (ei_buffer_to_metric(buf, index, this->metrics)) {
-    std::cerr << "Could not init scheduler_result::metrics at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmSchedulerResult::SwmSchedulerResult(const char* buf, int &index, const allocator_type &allocator)
+  : SwmSchedulerResult(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->request_id)) {
-    std::cerr << "Could not init scheduler_result::request_id at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmSchedulerResult::SwmSchedulerResult(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmSchedulerResult(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_uint64_t(buf, index, this->status)) {
-    std::cerr << "Could not init scheduler_result::status at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_double(buf, index, this->astro_time)) {
-    std::cerr << "Could not init scheduler_result::astro_time at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmSchedulerResult::SwmSchedulerResult(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmSchedulerResult(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_double(buf, index, this->idle_time)) {
-    std::cerr << "Could not init scheduler_result::idle_time at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+int SwmSchedulerResult::validate(const char* buf, int &index) {
+  return entity_validate<SwmSchedulerResult>(buf, index);
+}
 
-  if (ei_buffer_to_double(buf, index, this->work_time)) {
-    std::cerr << "Could not init scheduler_result::work_time at pos 8: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+void SwmSchedulerResult::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmSchedulerResult::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmSchedulerResult>(buf, index, writer);
+}
+
+SwmPatch SwmSchedulerResult::diff(const SwmSchedulerResult &old_obj, const SwmSchedulerResult &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmSchedulerResult::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmSchedulerResult::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip scheduler_result::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmSchedulerResult::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmSchedulerResult::set_timetable(const std::vector<SwmTimetable> &new_val) {
+void SwmSchedulerResult::set_timetable(const std::pmr::vector<SwmTimetable> &new_val) {
   timetable = new_val;
+  lazy_fields &= ~FIELD_TIMETABLE;
 }
 
-void SwmSchedulerResult::set_metrics(const std::vector<SwmMetric> &new_val) {
+void SwmSchedulerResult::set_timetable(std::pmr::vector<SwmTimetable> &&new_val) {
+  timetable = std::move(new_val);
+  lazy_fields &= ~FIELD_TIMETABLE;
+}
+
+void SwmSchedulerResult::set_metrics(const std::pmr::vector<SwmMetric> &new_val) {
   metrics = new_val;
+  lazy_fields &= ~FIELD_METRICS;
+}
+
+void SwmSchedulerResult::set_metrics(std::pmr::vector<SwmMetric> &&new_val) {
+  metrics = std::move(new_val);
+  lazy_fields &= ~FIELD_METRICS;
 }
 
-void SwmSchedulerResult::set_request_id(const std::string &new_val) {
+void SwmSchedulerResult::set_request_id(const std::pmr::string &new_val) {
   request_id = new_val;
+  lazy_fields &= ~FIELD_REQUEST_ID;
+}
+
+void SwmSchedulerResult::set_request_id(std::pmr::string &&new_val) {
+  request_id = std::move(new_val);
+  lazy_fields &= ~FIELD_REQUEST_ID;
 }
 
 void SwmSchedulerResult::set_status(const uint64_t &new_val) {
   status = new_val;
+  lazy_fields &= ~FIELD_STATUS;
 }
 
 void SwmSchedulerResult::set_astro_time(const double &new_val) {
   astro_time = new_val;
+  lazy_fields &= ~FIELD_ASTRO_TIME;
 }
 
 void SwmSchedulerResult::set_idle_time(const double &new_val) {
   idle_time = new_val;
+  lazy_fields &= ~FIELD_IDLE_TIME;
 }
 
 void SwmSchedulerResult::set_work_time(const double &new_val) {
   work_time = new_val;
+  lazy_fields &= ~FIELD_WORK_TIME;
 }
 
-std::vector<SwmTimetable> SwmSchedulerResult::get_timetable() const {
+const std::pmr::vector<SwmTimetable>& SwmSchedulerResult::get_timetable() const {
   return timetable;
 }
 
-std::vector<SwmMetric> SwmSchedulerResult::get_metrics() const {
+const std::pmr::vector<SwmMetric>& SwmSchedulerResult::get_metrics() const {
   return metrics;
 }
 
-std::string SwmSchedulerResult::get_request_id() const {
+const std::pmr::string& SwmSchedulerResult::get_request_id() const {
   return request_id;
 }
 
-uint64_t SwmSchedulerResult::get_status() const {
+const uint64_t& SwmSchedulerResult::get_status() const {
   return status;
 }
 
-double SwmSchedulerResult::get_astro_time() const {
+const double& SwmSchedulerResult::get_astro_time() const {
   return astro_time;
 }
 
-double SwmSchedulerResult::get_idle_time() const {
+const double& SwmSchedulerResult::get_idle_time() const {
   return idle_time;
 }
 
-double SwmSchedulerResult::get_work_time() const {
+const double& SwmSchedulerResult::get_work_time() const {
   return work_time;
 }
 
-int swm::ei_buffer_to_scheduler_result(const char *buf, int &index, std::vector<SwmSchedulerResult> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a scheduler_result list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for scheduler_result at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a scheduler_result list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of scheduler_result list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_scheduler_result(const char *buf, int &index, std::vector<SwmSchedulerResult> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_scheduler_result(const char *buf, int &index, std::pmr::vector<SwmSchedulerResult> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_scheduler_result(const char *buf, int &index, std::vector<SwmSchedulerResult> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a scheduler_result list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmSchedulerResult(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_scheduler_result(const char* buf, int &index, SwmSchedulerResult &obj) {
-  obj = SwmSchedulerResult(buf, index);
+  obj = SwmSchedulerResult(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmSchedulerResult::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmSchedulerResult::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode scheduler_result" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_scheduler_result(char* buf, int &index, const SwmSchedulerResult &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_scheduler_result(char* buf, int &index, const std::vector<SwmSchedulerResult> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmSchedulerResult &x) { x.encode(b, i); });
+}
+
+void swm::encode_scheduler_result(char* buf, int &index, const std::pmr::vector<SwmSchedulerResult> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmSchedulerResult &x) { x.encode(b, i); });
+}
+
+int swm::encode_scheduler_result(ei_x_buff &x, const std::vector<SwmSchedulerResult> &array) {
+  int size = 0;
+  encode_scheduler_result(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode scheduler_result list" << std::endl;
+    return -1;
+  }
+  encode_scheduler_result(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_scheduler_result(ei_x_buff &x, const std::pmr::vector<SwmSchedulerResult> &array) {
+  int size = 0;
+  encode_scheduler_result(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode scheduler_result list" << std::endl;
+    return -1;
+  }
+  encode_scheduler_result(x.buff, x.index, array);
   return 0;
 }
 
 void SwmSchedulerResult::print(const std::string &prefix, const char separator) const {
-  if (timetable.empty()) {
-    std::cerr << prefix << "timetable: []" << separator;
-  } else {
-    std::cerr << prefix << "timetable" << ": [";
-    for (const auto &q: timetable) {
-      q.print(prefix, separator);
-    }
-    std::cerr << "]" << separator;
-  }
-  if (metrics.empty()) {
-    std::cerr << prefix << "metrics: []" << separator;
-  } else {
-    std::cerr << prefix << "metrics" << ": [";
-    for (const auto &q: metrics) {
-      q.print(prefix, separator);
+  entity_print(*this, prefix, separator);
+}
+
+SwmSchedulerResultView::SwmSchedulerResultView() {
+}
+
+SwmSchedulerResultView::SwmSchedulerResultView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmSchedulerResultView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 7)) {
+    std::cerr << "Could not create SwmSchedulerResultView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmSchedulerResultView::is_valid() const {
+  return buf != nullptr;
+}
+
+SwmListView<SwmTimetableView, ei_buffer_to_timetable> SwmSchedulerResultView::get_timetable() const {
+  return SwmListView<SwmTimetableView, ei_buffer_to_timetable>(buf, offsets[0]);
+}
+
+SwmListView<SwmMetricView, ei_buffer_to_metric> SwmSchedulerResultView::get_metrics() const {
+  return SwmListView<SwmMetricView, ei_buffer_to_metric>(buf, offsets[1]);
+}
+
+std::string_view SwmSchedulerResultView::get_request_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+uint64_t SwmSchedulerResultView::get_status() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[3]);
+}
+
+double SwmSchedulerResultView::get_astro_time() const {
+  return get_view_value<double, ei_buffer_to_double>(buf, offsets[4]);
+}
+
+double SwmSchedulerResultView::get_idle_time() const {
+  return get_view_value<double, ei_buffer_to_double>(buf, offsets[5]);
+}
+
+double SwmSchedulerResultView::get_work_time() const {
+  return get_view_value<double, ei_buffer_to_double>(buf, offsets[6]);
+}
+
+int swm::ei_buffer_to_scheduler_result(const char* buf, int &index, SwmSchedulerResultView &obj) {
+  obj = SwmSchedulerResultView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_scheduler_result(const char* buf, int &index, std::vector<SwmSchedulerResultView> &array) {
+  const SwmListView<SwmSchedulerResultView, ei_buffer_to_scheduler_result> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmSchedulerResultView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
-  }
-  std::cerr << prefix << request_id << separator;
-  std::cerr << prefix << status << separator;
-  std::cerr << prefix << astro_time << separator;
-  std::cerr << prefix << idle_time << separator;
-  std::cerr << prefix << work_time << separator;
-  std::cerr << std::endl;
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of scheduler_result at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
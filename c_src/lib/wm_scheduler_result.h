@@ -2,9 +2,14 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 #include "wm_timetable.h"
 #include "wm_metric.h"
 
@@ -13,39 +18,139 @@ namespace swm {
 class SwmSchedulerResult:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 7;
+  static constexpr uint64_t FIELD_TIMETABLE = 1ull << 0;
+  static constexpr uint64_t FIELD_METRICS = 1ull << 1;
+  static constexpr uint64_t FIELD_REQUEST_ID = 1ull << 2;
+  static constexpr uint64_t FIELD_STATUS = 1ull << 3;
+  static constexpr uint64_t FIELD_ASTRO_TIME = 1ull << 4;
+  static constexpr uint64_t FIELD_IDLE_TIME = 1ull << 5;
+  static constexpr uint64_t FIELD_WORK_TIME = 1ull << 6;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "scheduler_result";
+  static const SwmFieldInfo<SwmSchedulerResult> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmSchedulerResult();
-  SwmSchedulerResult(const char*, int&);
+  explicit SwmSchedulerResult(const allocator_type&);
+  SwmSchedulerResult(const char*, int&, const allocator_type& = {});
+  SwmSchedulerResult(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmSchedulerResult(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmSchedulerResult(const SwmSchedulerResult&, const allocator_type&);
+  SwmSchedulerResult(SwmSchedulerResult&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmSchedulerResult &old_obj, const SwmSchedulerResult &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_timetable(const std::vector<SwmTimetable>&);
-  void set_metrics(const std::vector<SwmMetric>&);
-  void set_request_id(const std::string&);
+  void set_timetable(const std::pmr::vector<SwmTimetable>&);
+  void set_timetable(std::pmr::vector<SwmTimetable>&&);
+  void set_metrics(const std::pmr::vector<SwmMetric>&);
+  void set_metrics(std::pmr::vector<SwmMetric>&&);
+  void set_request_id(const std::pmr::string&);
+  void set_request_id(std::pmr::string&&);
   void set_status(const uint64_t&);
   void set_astro_time(const double&);
   void set_idle_time(const double&);
   void set_work_time(const double&);
 
-  std::vector<SwmTimetable> get_timetable() const;
-  std::vector<SwmMetric> get_metrics() const;
-  std::string get_request_id() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const std::pmr::vector<SwmTimetable>& get_timetable() const;
+  const std::pmr::vector<SwmMetric>& get_metrics() const;
+  const std::pmr::string& get_request_id() const;
+  const uint64_t& get_status() const;
+  const double& get_astro_time() const;
+  const double& get_idle_time() const;
+  const double& get_work_time() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_timetable(Args&&... args) {
+    return timetable.emplace_back(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  auto& emplace_metrics(Args&&... args) {
+    return metrics.emplace_back(std::forward<Args>(args)...);
+  }
+
+ private:
+  std::pmr::vector<SwmTimetable> timetable;
+  std::pmr::vector<SwmMetric> metrics;
+  std::pmr::string request_id;
+  uint64_t status = 0;
+  double astro_time = 0;
+  double idle_time = 0;
+  double work_time = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
+
+};
+
+class SwmSchedulerResultView;
+
+int ei_buffer_to_scheduler_result(const char*, int&, std::vector<SwmSchedulerResult>&);
+int ei_buffer_to_scheduler_result(const char*, int&, std::pmr::vector<SwmSchedulerResult>&);
+int ei_buffer_to_scheduler_result(const char*, int&, std::vector<SwmSchedulerResult>&, SwmThreadPool&);
+int ei_buffer_to_scheduler_result(const char*, int&, SwmSchedulerResult&);
+int ei_buffer_to_scheduler_result(const char*, int&, std::vector<SwmSchedulerResultView>&);
+int ei_buffer_to_scheduler_result(const char*, int&, SwmSchedulerResultView&);
+
+void encode_scheduler_result(char*, int&, const SwmSchedulerResult&);
+void encode_scheduler_result(char*, int&, const std::vector<SwmSchedulerResult>&);
+void encode_scheduler_result(char*, int&, const std::pmr::vector<SwmSchedulerResult>&);
+int encode_scheduler_result(ei_x_buff&, const std::vector<SwmSchedulerResult>&);
+int encode_scheduler_result(ei_x_buff&, const std::pmr::vector<SwmSchedulerResult>&);
+
+class SwmSchedulerResultView {
+
+ public:
+  SwmSchedulerResultView();
+  SwmSchedulerResultView(const char*, int&);
+
+  bool is_valid() const;
+
+  SwmListView<SwmTimetableView, ei_buffer_to_timetable> get_timetable() const;
+  SwmListView<SwmMetricView, ei_buffer_to_metric> get_metrics() const;
+  std::string_view get_request_id() const;
   uint64_t get_status() const;
   double get_astro_time() const;
   double get_idle_time() const;
   double get_work_time() const;
 
  private:
-  std::vector<SwmTimetable> timetable;
-  std::vector<SwmMetric> metrics;
-  std::string request_id;
-  uint64_t status;
-  double astro_time;
-  double idle_time;
-  double work_time;
+  const char* buf = nullptr;
+  std::array<int, 7> offsets = {};
 
 };
 
-int ei_buffer_to_scheduler_result(const char*, int&, std::vector<SwmSchedulerResult>&);
-int ei_buffer_to_scheduler_result(const char*, int&, SwmSchedulerResult&);
-
 } // namespace swm
@@ -0,0 +1,117 @@
+#include "wm_shared_buffer.h"
+
+#include "wm_etf_reader.h"
+
+#include <ei.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+
+using namespace swm;
+
+namespace {
+
+thread_local const SwmSharedBufferScope* innermost_scope = nullptr;
+
+} // namespace
+
+SwmSharedBufferScope::SwmSharedBufferScope(const SwmSharedBuffer &buffer, const size_t size)
+  : buffer(buffer), size(size), parent(innermost_scope) {
+  innermost_scope = this;
+}
+
+SwmSharedBufferScope::SwmSharedBufferScope(const SwmSharedBufferScope* other)
+  : parent(innermost_scope) {
+  if (other) {
+    buffer = other->buffer;
+    size = other->size;
+  }
+  innermost_scope = this;
+}
+
+SwmSharedBufferScope::~SwmSharedBufferScope() {
+  innermost_scope = parent;
+}
+
+const SwmSharedBufferScope* SwmSharedBufferScope::current() {
+  return innermost_scope;
+}
+
+const SwmSharedBuffer* SwmSharedBufferScope::find(const char* data) {
+  for (auto scope = innermost_scope; scope; scope = scope->parent) {
+    const char* begin = scope->buffer.get();
+    if (begin && data >= begin && data < begin + scope->size) {
+      return &scope->buffer;
+    }
+  }
+  return nullptr;
+}
+
+int SwmTermRef::assign(const char* buf, int &index) {
+  const int begin = index;
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip term at " << begin << std::endl;
+    return -1;
+  }
+  term_size = index - begin;
+  if (const auto shared = SwmSharedBufferScope::find(buf + begin)) {
+    buffer = *shared;
+    term = buf + begin;
+    return 0;
+  }
+  std::shared_ptr<char[]> copy(new char[static_cast<size_t>(term_size)]);
+  std::memcpy(copy.get(), buf + begin, static_cast<size_t>(term_size));
+  term = copy.get();
+  buffer = std::move(copy);
+  return 0;
+}
+
+int SwmTermRef::get_atom(SwmAtom &a) const {
+  const char* data = nullptr;
+  int size = 0;
+  int index = 0;
+  if (!term || etf_decode_atom_bytes(term, index, data, size)) {
+    return -1;
+  }
+  a = SwmAtom(std::string_view(data, static_cast<size_t>(size)));
+  return 0;
+}
+
+int SwmTermRef::get_str(std::string &s) const {
+  int index = 0;
+  return term ? etf_decode_str(term, index, s) : -1;
+}
+
+int SwmTermRef::get_uint64(uint64_t &n) const {
+  int index = 0;
+  return term ? etf_decode_uint64(term, index, n) : -1;
+}
+
+int SwmTermRef::get_int64(int64_t &n) const {
+  int index = 0;
+  return term ? etf_decode_int64(term, index, n) : -1;
+}
+
+int SwmTermRef::get_double(double &d) const {
+  int index = 0;
+  return term ? etf_decode_double(term, index, d) : -1;
+}
+
+bool SwmTermRef::operator==(const SwmTermRef &other) const {
+  return term_size == other.term_size && (term_size == 0 || std::memcmp(term, other.term, static_cast<size_t>(term_size)) == 0);
+}
+
+std::ostream& swm::operator<<(std::ostream &out, const SwmTermRef &term) {
+  if (term.empty()) {
+    return out << "undefined";
+  }
+  char* term_str = nullptr;
+  int index = 0;
+  ei_s_print_term(&term_str, term.data(), &index);
+  out << term_str;
+  free(term_str);  // allocated by ei with malloc
+  return out;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "wm_atom.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace swm {
+
+// Reference counted ETF input buffer
+typedef std::shared_ptr<const char[]> SwmSharedBuffer;
+
+// While a scope is alive, terms that are decoded on its thread from the
+// buffer keep references into the buffer instead of copies. Scopes nest.
+class SwmSharedBufferScope {
+ public:
+  SwmSharedBufferScope(const SwmSharedBuffer &buffer, size_t size);
+  explicit SwmSharedBufferScope(const SwmSharedBufferScope* other);  // the same buffer on another thread
+  ~SwmSharedBufferScope();
+
+  SwmSharedBufferScope(const SwmSharedBufferScope&) = delete;
+  SwmSharedBufferScope& operator=(const SwmSharedBufferScope&) = delete;
+
+  static const SwmSharedBufferScope* current();  // innermost scope of the thread or nullptr
+
+  // Buffer of the innermost scope of the thread that contains data
+  static const SwmSharedBuffer* find(const char* data);
+
+ private:
+  SwmSharedBuffer buffer;
+  size_t size = 0;
+  const SwmSharedBufferScope* parent = nullptr;
+};
+
+// Term that is referenced in a shared buffer. Terms decoded outside of a
+// SwmSharedBufferScope are copied, each into its own buffer.
+class SwmTermRef {
+ public:
+  SwmTermRef() = default;
+
+  // Refers to the term at index, the index is moved past it
+  int assign(const char* buf, int &index);
+
+  bool empty() const { return term == nullptr; }
+  const char* data() const { return term; }
+  int size() const { return term_size; }
+
+  // Typed accessors decode the term on every call, they return -1 if
+  // the term has another type
+  int get_atom(SwmAtom &a) const;
+  int get_str(std::string &s) const;
+  int get_uint64(uint64_t &n) const;
+  int get_int64(int64_t &n) const;
+  int get_double(double &d) const;
+
+  bool operator==(const SwmTermRef &other) const;  // the same encoded terms
+
+ private:
+  SwmSharedBuffer buffer;
+  const char* term = nullptr;
+  int term_size = 0;
+};
+
+std::ostream& operator<<(std::ostream &out, const SwmTermRef &term);
+
+} // namespace swm
@@ -0,0 +1,251 @@
+#include "wm_snapshot_file.h"
+#include "wm_etf_reader.h"
+#include "wm_etf_stream.h"
+#include "wm_io.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SWM_COMMAND_SCHEDULE 0
+
+
+using namespace swm;
+
+namespace {
+
+bool is_little_endian() {
+  const uint16_t value = 1;
+  unsigned char first = 0;
+  std::memcpy(&first, &value, 1);
+  return first == 1;
+}
+
+} // namespace
+
+SwmSnapshotWriter::SwmSnapshotWriter(const std::string &path)
+  : out(path, std::ios::binary | std::ios::trunc), path(path) {
+  const SwmSnapshotHeader header{};  // written again by finish()
+  write(&header, sizeof(header));
+}
+
+int SwmSnapshotWriter::write(const void* data, const size_t size) {
+  out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+  if (!out) {
+    std::cerr << "Could not write " << size << " bytes to snapshot " << path << std::endl;
+    return -1;
+  }
+  offset += size;
+  return 0;
+}
+
+int SwmSnapshotWriter::pad() {
+  const char zeros[8] = {};
+  return write(zeros, (8 - offset % 8) % 8);
+}
+
+int SwmSnapshotWriter::add(const SwmSnapshotSection section, const char* buf, const int index) {
+  if (section >= SWM_SNAPSHOT_SECTIONS) {
+    std::cerr << "Unknown snapshot section: " << section << std::endl;
+    return -1;
+  }
+  if (current != static_cast<int>(section)) {
+    if (written[section]) {
+      std::cerr << "Snapshot section " << section << " is already written" << std::endl;
+      return -1;
+    }
+    if (end_section()) {
+      return -1;
+    }
+    current = static_cast<int>(section);
+    table[section].type = section;
+    table[section].terms_offset = offset;
+    offsets.clear();
+  }
+  int end = index;
+  if (etf_skip_term(buf, end)) {
+    std::cerr << "Could not find the end of snapshot term at " << index << std::endl;
+    return -1;
+  }
+  const uint64_t term_offset = offset - table[section].terms_offset;
+  if (term_offset + static_cast<uint64_t>(end - index) > INT_MAX) {
+    std::cerr << "Snapshot section " << section << " is larger than " << INT_MAX << " bytes" << std::endl;
+    return -1;
+  }
+  offsets.push_back(term_offset);
+  return write(buf + index, static_cast<size_t>(end - index));
+}
+
+int SwmSnapshotWriter::end_section() {
+  if (current < 0) {
+    return 0;
+  }
+  auto &info = table[static_cast<size_t>(current)];
+  info.terms_size = offset - info.terms_offset;
+  info.count = offsets.size();
+  offsets.push_back(info.terms_size);
+  if (pad()) {
+    return -1;
+  }
+  info.offsets_offset = offset;
+  if (write(offsets.data(), offsets.size() * sizeof(uint64_t))) {
+    return -1;
+  }
+  written[static_cast<size_t>(current)] = true;
+  current = -1;
+  return 0;
+}
+
+int SwmSnapshotWriter::finish() {
+  if (!is_little_endian()) {
+    std::cerr << "Snapshots can be written only on little endian hosts" << std::endl;
+    return -1;
+  }
+  if (end_section()) {
+    return -1;
+  }
+  for (uint32_t section = 0; section < SWM_SNAPSHOT_SECTIONS; ++section) {
+    if (!written[section]) {  // empty sections have only the end offset
+      current = static_cast<int>(section);
+      table[section].type = section;
+      table[section].terms_offset = offset;
+      offsets.clear();
+      if (end_section()) {
+        return -1;
+      }
+    }
+  }
+  if (pad()) {
+    return -1;
+  }
+  SwmSnapshotHeader header{};
+  std::memcpy(header.magic, SWM_SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SWM_SNAPSHOT_VERSION;
+  header.sections = SWM_SNAPSHOT_SECTIONS;
+  header.table_offset = offset;
+  if (write(table.data(), sizeof(table))) {
+    return -1;
+  }
+  header.file_size = offset;
+  out.seekp(0);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.close();
+  if (!out) {
+    std::cerr << "Could not finish snapshot " << path << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+int swm::swm_write_snapshot(std::istream *input, SwmSnapshotWriter &writer) {
+  char command = 0;
+  char total = 0;
+  if (!swm_read_exact(input, &command, 1) || !swm_read_exact(input, &total, 1)) {
+    std::cerr << "Could not read scheduler input command" << std::endl;
+    return -1;
+  }
+  if (command != SWM_COMMAND_SCHEDULE) {
+    std::cerr << "Unknown scheduler input command: " << static_cast<int>(command) << std::endl;
+    return -1;
+  }
+  for (int i = 0; i < static_cast<unsigned char>(total); ++i) {
+    char type = 0;
+    uint32_t len = 0;
+    if (!swm_read_exact(input, &type, 1) || !swm_read_length(input, &len)) {
+      std::cerr << "Could not read data type and length (i=" << i << ")" << std::endl;
+      return -1;
+    }
+    const auto section = static_cast<SwmSnapshotSection>(type);
+    SwmEtfStream decoder;
+    const auto add = [&writer, section](const char* buf, const int index) {
+      return writer.add(section, buf, index);
+    };
+    if (swm_read_etf_stream(input, len, decoder, add)) {
+      std::cerr << "Could not read data type " << static_cast<int>(type) << " of scheduler input" << std::endl;
+      return -1;
+    }
+  }
+  return writer.finish();
+}
+
+SwmSnapshotFile::~SwmSnapshotFile() {
+  close();
+}
+
+void SwmSnapshotFile::close() {
+  mapping.reset();
+  base = nullptr;
+  length = 0;
+  sections = {};
+}
+
+int SwmSnapshotFile::open(const std::string &path) {
+  close();
+  if (!is_little_endian()) {
+    std::cerr << "Snapshots can be read only on little endian hosts" << std::endl;
+    return -1;
+  }
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Could not open snapshot " << path << ": " << std::strerror(errno) << std::endl;
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(SwmSnapshotHeader)) {
+    std::cerr << "Snapshot " << path << " is too short" << std::endl;
+    ::close(fd);
+    return -1;
+  }
+  length = static_cast<size_t>(st.st_size);
+  void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    std::cerr << "Could not map snapshot " << path << ": " << std::strerror(errno) << std::endl;
+    length = 0;
+    return -1;
+  }
+  const size_t size = length;
+  mapping.reset(static_cast<const char*>(addr), [size](const char* p) { munmap(const_cast<char*>(p), size); });
+  base = mapping.get();
+
+  const auto header = reinterpret_cast<const SwmSnapshotHeader*>(base);
+  if (std::memcmp(header->magic, SWM_SNAPSHOT_MAGIC, sizeof(header->magic)) ||
+      header->version != SWM_SNAPSHOT_VERSION || header->sections != SWM_SNAPSHOT_SECTIONS) {
+    std::cerr << "Snapshot " << path << " has wrong header (version " << header->version
+              << ", expected " << SWM_SNAPSHOT_VERSION << ")" << std::endl;
+    close();
+    return -1;
+  }
+  if (header->file_size != length || header->table_offset % 8 ||
+      header->table_offset + sizeof(SwmSnapshotSectionInfo) * SWM_SNAPSHOT_SECTIONS > length) {
+    std::cerr << "Snapshot " << path << " is truncated: " << length << " bytes of " << header->file_size << std::endl;
+    close();
+    return -1;
+  }
+  const auto table = reinterpret_cast<const SwmSnapshotSectionInfo*>(base + header->table_offset);
+  for (uint32_t i = 0; i < SWM_SNAPSHOT_SECTIONS; ++i) {
+    const auto &info = table[i];
+    const uint64_t offsets_size = (info.count + 1) * sizeof(uint64_t);
+    if (info.type != i || info.terms_size > INT_MAX || info.terms_offset + info.terms_size > length ||
+        info.offsets_offset % 8 || info.count > length || info.offsets_offset + offsets_size > length) {
+      std::cerr << "Snapshot " << path << " has wrong section " << i << std::endl;
+      close();
+      return -1;
+    }
+    auto &section = sections[i];
+    section.terms = base + info.terms_offset;
+    section.offsets = reinterpret_cast<const uint64_t*>(base + info.offsets_offset);
+    section.count = info.count;
+    if (section.offsets[info.count] != info.terms_size) {
+      std::cerr << "Snapshot " << path << " has wrong offsets of section " << i << std::endl;
+      close();
+      return -1;
+    }
+  }
+  return 0;
+}
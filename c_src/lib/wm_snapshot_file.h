@@ -0,0 +1,140 @@
+#pragma once
+
+#include "wm_shared_buffer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace swm {
+
+// Sections have the same numbers as the data types of the scheduler input,
+// see include/wm_scheduler.hrl
+enum SwmSnapshotSection: uint32_t {
+  SWM_SNAPSHOT_SCHEDULERS = 0,
+  SWM_SNAPSHOT_RH = 1,
+  SWM_SNAPSHOT_JOBS = 2,
+  SWM_SNAPSHOT_GRID = 3,
+  SWM_SNAPSHOT_CLUSTERS = 4,
+  SWM_SNAPSHOT_PARTITIONS = 5,
+  SWM_SNAPSHOT_NODES = 6,
+  SWM_SNAPSHOT_SECTIONS = 7
+};
+
+// Snapshot file layout, all numbers are little endian and 8 byte aligned:
+//
+//   header | section 0 terms | pad | section 0 offsets | ... | section table
+//
+// Terms of a section are the ETF elements of its top level list (or the
+// term itself if it is not a list) without the version byte, stored one
+// after another. The offsets table has count + 1 offsets of the elements
+// relative to the first term, so the file has no pointers and is used as
+// it is mapped.
+#define SWM_SNAPSHOT_MAGIC "SWMSTATE"
+#define SWM_SNAPSHOT_VERSION 1
+
+struct SwmSnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t sections;
+  uint64_t table_offset;
+  uint64_t file_size;
+};
+
+struct SwmSnapshotSectionInfo {
+  uint32_t type;
+  uint32_t reserved;
+  uint64_t count;
+  uint64_t terms_offset;
+  uint64_t terms_size;
+  uint64_t offsets_offset;
+};
+
+// Writes sections one after another, terms of a section are added in a row
+class SwmSnapshotWriter {
+ public:
+  explicit SwmSnapshotWriter(const std::string &path);
+
+  // Appends the term at index of buf to the section
+  int add(SwmSnapshotSection section, const char* buf, int index);
+  int finish();
+
+ private:
+  int write(const void* data, size_t size);
+  int pad();
+  int end_section();
+
+  std::ofstream out;
+  std::string path;
+  uint64_t offset = 0;
+  std::array<SwmSnapshotSectionInfo, SWM_SNAPSHOT_SECTIONS> table{};
+  std::array<bool, SWM_SNAPSHOT_SECTIONS> written{};
+  int current = -1;
+  std::vector<uint64_t> offsets;
+};
+
+// Reads the scheduler input (as wm_scheduler:get_binary_for_scheduler/1
+// makes it) from the stream and writes its terms to the snapshot file
+int swm_write_snapshot(std::istream *input, SwmSnapshotWriter &writer);
+
+// Read-only memory mapped snapshot. Opening checks only the header and the
+// section table, so it takes the same time for any file size. Terms are read
+// in place by the entity views or decoded into entities:
+//
+//   const auto job = file.view<SwmJobView>(SWM_SNAPSHOT_JOBS, 0);
+//   const auto node = file.decode<SwmNode>(SWM_SNAPSHOT_NODES, 0);
+class SwmSnapshotFile {
+ public:
+  SwmSnapshotFile() = default;
+  ~SwmSnapshotFile();
+
+  SwmSnapshotFile(const SwmSnapshotFile&) = delete;
+  SwmSnapshotFile& operator=(const SwmSnapshotFile&) = delete;
+
+  int open(const std::string &path);
+  void close();
+
+  bool is_open() const { return base != nullptr; }
+  size_t size() const { return length; }  // mapped bytes
+
+  size_t count(SwmSnapshotSection section) const { return sections[section].count; }
+
+  // Term buffer of the section and the index of its n-th term
+  const char* terms(SwmSnapshotSection section) const { return sections[section].terms; }
+  int index(SwmSnapshotSection section, size_t n) const {
+    return static_cast<int>(sections[section].offsets[n]);
+  }
+
+  template <typename View>
+  View view(const SwmSnapshotSection section, const size_t n) const {
+    int i = index(section, n);
+    return View(terms(section), i);
+  }
+
+  // Decodes the n-th term of the section. Terms of any type in the entity
+  // refer to the mapping, which stays mapped while they live.
+  template <typename Entity>
+  Entity decode(const SwmSnapshotSection section, const size_t n) const {
+    const SwmSharedBufferScope scope(mapping, length);
+    int i = index(section, n);
+    return Entity(terms(section), i);
+  }
+
+ private:
+  struct Section {
+    const char* terms = nullptr;
+    const uint64_t* offsets = nullptr;
+    size_t count = 0;
+  };
+
+  SwmSharedBuffer mapping;  // unmapped when the last reference is gone
+  const char* base = nullptr;
+  size_t length = 0;
+  std::array<Section, SWM_SNAPSHOT_SECTIONS> sections{};
+};
+
+} // namespace swm
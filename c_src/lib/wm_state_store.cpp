@@ -0,0 +1,22 @@
+#include "wm_state_store.h"
+
+
+using namespace swm;
+
+namespace {
+
+std::string_view job_state(const SwmJob &job) { return job.get_state(); }
+std::string_view job_user_id(const SwmJob &job) { return job.get_user_id(); }
+std::string_view job_account_id(const SwmJob &job) { return job.get_account_id(); }
+std::string_view job_gang_id(const SwmJob &job) { return job.get_gang_id(); }
+std::string_view partition_subdivision_id(const SwmPartition &partition) { return partition.get_subdivision_id(); }
+std::string_view node_subdivision_id(const SwmNode &node) { return node.get_subdivision_id(); }
+
+} // namespace
+
+// Keys are in the order of the index enums
+SwmStateStore::SwmStateStore()
+  : partition_store({partition_subdivision_id}),
+    node_store({node_subdivision_id}),
+    job_store({job_state, job_user_id, job_account_id, job_gang_id}) {
+}
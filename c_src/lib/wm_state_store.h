@@ -0,0 +1,195 @@
+#pragma once
+
+#include "wm_cluster.h"
+#include "wm_entity_patch.h"
+#include "wm_hash_index.h"
+#include "wm_job.h"
+#include "wm_node.h"
+#include "wm_partition.h"
+
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace swm {
+
+// Entities of one type with the index by id and secondary indexes by the
+// given keys (e.g. job state). Entities never move in memory and every
+// secondary key keeps the list of the slots with that key together with
+// the position of each slot in it: an update or removal changes only the
+// lists of the keys that differ.
+template <typename Entity>
+class SwmEntityStore {
+ public:
+  typedef std::string_view (*KeyFun)(const Entity&);
+
+  explicit SwmEntityStore(const std::initializer_list<KeyFun> keys = {})
+    : key_funs(keys), indexes(keys.size()), positions(keys.size()) {
+  }
+
+  SwmEntityStore(const SwmEntityStore&) = delete;
+  SwmEntityStore& operator=(const SwmEntityStore&) = delete;
+
+  size_t size() const { return ids.size(); }
+
+  const Entity* find(const SwmId &id) const {
+    const auto slot = ids.find(id);
+    return slot ? &slots[*slot] : nullptr;
+  }
+
+  const Entity* find(const std::string_view id) const {
+    SwmId key;
+    return SwmId::find(id, key) ? find(key) : nullptr;
+  }
+
+  // Stores the entity unless the store has the same or a newer revision of
+  // it, returns true if the entity is stored
+  bool update(Entity entity) {
+    const SwmId id = entity.get_id();
+    if (const auto found = ids.find(id)) {
+      const uint32_t slot = *found;
+      Entity &old = slots[slot];
+      if (has_revision_field<Entity>::value && entity_revision(entity) <= entity_revision(old)) {
+        return false;
+      }
+      std::vector<std::string> old_keys(key_funs.size());
+      for (size_t n = 0; n < key_funs.size(); ++n) {
+        old_keys[n] = key_funs[n](old);
+      }
+      old = std::move(entity);
+      for (size_t n = 0; n < key_funs.size(); ++n) {
+        if (key_funs[n](old) != old_keys[n]) {
+          unlink(n, old_keys[n], slot);
+          link(n, slot);
+        }
+      }
+      return true;
+    }
+    uint32_t slot = 0;
+    if (free_slots.empty()) {
+      slot = static_cast<uint32_t>(slots.size());
+      slots.push_back(std::move(entity));
+      for (auto &index_positions : positions) {
+        index_positions.push_back(0);
+      }
+    } else {
+      slot = free_slots.back();
+      free_slots.pop_back();
+      slots[slot] = std::move(entity);
+    }
+    ids.insert(id) = slot;
+    for (size_t n = 0; n < key_funs.size(); ++n) {
+      link(n, slot);
+    }
+    return true;
+  }
+
+  bool erase(const SwmId &id) {
+    const auto found = ids.find(id);
+    if (!found) {
+      return false;
+    }
+    const uint32_t slot = *found;
+    for (size_t n = 0; n < key_funs.size(); ++n) {
+      unlink(n, key_funs[n](slots[slot]), slot);
+    }
+    ids.erase(id);
+    slots[slot] = Entity();
+    free_slots.push_back(slot);
+    return true;
+  }
+
+  bool erase(const std::string_view id) {
+    SwmId key;
+    return SwmId::find(id, key) && erase(key);
+  }
+
+  // Number of the entities with the key in the secondary index
+  size_t count(const size_t index, const std::string_view key) const {
+    const auto list = indexes[index].find(key);
+    return list ? list->size() : 0;
+  }
+
+  // Calls fun(entity) for the entities with the key in the secondary index
+  template <typename F>
+  void for_each(const size_t index, const std::string_view key, F &&fun) const {
+    if (const auto list = indexes[index].find(key)) {
+      for (const uint32_t slot : *list) {
+        fun(slots[slot]);
+      }
+    }
+  }
+
+  void clear() {
+    ids.clear();
+    for (auto &index : indexes) {
+      index.clear();
+    }
+    for (auto &index_positions : positions) {
+      index_positions.clear();
+    }
+    slots.clear();
+    free_slots.clear();
+  }
+
+ private:
+  void link(const size_t index, const uint32_t slot) {
+    auto &list = indexes[index].insert(std::string(key_funs[index](slots[slot])));
+    positions[index][slot] = static_cast<uint32_t>(list.size());
+    list.push_back(slot);
+  }
+
+  // The last slot of the list takes the position of the removed one
+  void unlink(const size_t index, const std::string_view key, const uint32_t slot) {
+    auto list = indexes[index].find(key);
+    const uint32_t pos = positions[index][slot];
+    const uint32_t last = list->back();
+    (*list)[pos] = last;
+    positions[index][last] = pos;
+    list->pop_back();
+    if (list->empty()) {
+      indexes[index].erase(key);
+    }
+  }
+
+  std::vector<KeyFun> key_funs;
+  SwmHashIndex<SwmId, uint32_t> ids;
+  std::vector<SwmHashIndex<std::string, std::vector<uint32_t>>> indexes;
+  std::vector<std::vector<uint32_t>> positions;  // of every slot in the lists of its keys
+  std::deque<Entity> slots;
+  std::vector<uint32_t> free_slots;
+};
+
+// Cluster state with the lookups the scheduler and what-if queries need:
+// entities by id, jobs by state, user, account and gang, partitions and
+// nodes by their subdivision (cluster or partition). The store is updated
+// incrementally by the entities of newer revisions.
+class SwmStateStore {
+ public:
+  enum JobIndex { JOB_STATE, JOB_USER_ID, JOB_ACCOUNT_ID, JOB_GANG_ID };
+  enum PartitionIndex { PARTITION_SUBDIVISION_ID };
+  enum NodeIndex { NODE_SUBDIVISION_ID };
+
+  SwmStateStore();
+
+  SwmEntityStore<SwmCluster>& clusters() { return cluster_store; }
+  SwmEntityStore<SwmPartition>& partitions() { return partition_store; }
+  SwmEntityStore<SwmNode>& nodes() { return node_store; }
+  SwmEntityStore<SwmJob>& jobs() { return job_store; }
+  const SwmEntityStore<SwmCluster>& clusters() const { return cluster_store; }
+  const SwmEntityStore<SwmPartition>& partitions() const { return partition_store; }
+  const SwmEntityStore<SwmNode>& nodes() const { return node_store; }
+  const SwmEntityStore<SwmJob>& jobs() const { return job_store; }
+
+ private:
+  SwmEntityStore<SwmCluster> cluster_store;
+  SwmEntityStore<SwmPartition> partition_store;
+  SwmEntityStore<SwmNode> node_store;
+  SwmEntityStore<SwmJob> job_store;
+};
+
+} // namespace swm
@@ -0,0 +1,81 @@
+#include "wm_thread_pool.h"
+
+#include <algorithm>
+
+
+using namespace swm;
+
+SwmThreadPool::SwmThreadPool(size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  workers.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back(&SwmThreadPool::run, this);
+  }
+}
+
+SwmThreadPool::~SwmThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  task_ready.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+size_t SwmThreadPool::size() const {
+  return workers.size();
+}
+
+void SwmThreadPool::parallel_for(const size_t count, const std::function<void(size_t, size_t)> &fun, const size_t min_chunk) {
+  if (count == 0) {
+    return;
+  }
+  // A few chunks per worker even out elements of different size
+  const size_t chunks = std::min(workers.size() * 4, (count + min_chunk - 1) / std::max<size_t>(min_chunk, 1));
+  if (workers.size() < 2 || chunks < 2) {
+    fun(0, count);
+    return;
+  }
+
+  std::mutex done_mutex;
+  std::condition_variable done;
+  const size_t chunk_size = (count + chunks - 1) / chunks;
+  size_t left = (count + chunk_size - 1) / chunk_size;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t begin = 0; begin < count; begin += chunk_size) {
+      const size_t end = std::min(count, begin + chunk_size);
+      tasks.emplace_back([&fun, &done_mutex, &done, &left, begin, end]() {
+        fun(begin, end);
+        std::lock_guard<std::mutex> done_lock(done_mutex);
+        if (--left == 0) {
+          done.notify_one();
+        }
+      });
+    }
+  }
+  task_ready.notify_all();
+
+  std::unique_lock<std::mutex> done_lock(done_mutex);
+  done.wait(done_lock, [&left]() { return left == 0; });
+}
+
+void SwmThreadPool::run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      task_ready.wait(lock, [this]() { return stopping || !tasks.empty(); });
+      if (tasks.empty()) {
+        return;  // stopping
+      }
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace swm {
+
+// Fixed set of worker threads used to decode big entity lists in parallel.
+class SwmThreadPool {
+ public:
+  explicit SwmThreadPool(size_t threads = 0);  // 0 means one per core
+  ~SwmThreadPool();
+
+  SwmThreadPool(const SwmThreadPool&) = delete;
+  SwmThreadPool& operator=(const SwmThreadPool&) = delete;
+
+  size_t size() const;
+
+  // Splits [0, count) into chunks of at least min_chunk items, calls fun(begin, end)
+  // for each chunk on the workers and waits until all chunks are processed.
+  void parallel_for(size_t count, const std::function<void(size_t, size_t)> &fun, size_t min_chunk = 64);
+
+ private:
+  void run();
+
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable task_ready;
+  bool stopping = false;
+};
+
+} // namespace swm
@@ -1,147 +1,350 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_timetable.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmTimetable> SwmTimetable::FIELDS_INFO[] = {
+  field_info<SwmTimetable, uint64_t, &SwmTimetable::start_time,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("start_time"),
+  field_info<SwmTimetable, std::pmr::string, &SwmTimetable::job_id,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("job_id"),
+  field_info<SwmTimetable, std::pmr::vector<std::pmr::string>, &SwmTimetable::job_nodes,
+             ei_buffer_to_str, encode_str,
+             SwmListTerm<SwmStrTerm>>("job_nodes"),
+};
+
 SwmTimetable::SwmTimetable() {
 }
 
-SwmTimetable::SwmTimetable(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmTimetable: null" << std::endl;
-    return;
-  }
+SwmTimetable::SwmTimetable(const allocator_type &allocator)
+  : job_id(allocator),
+    job_nodes(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmTimetable header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmTimetable::SwmTimetable(const SwmTimetable &other, const allocator_type &allocator)
+  : start_time(other.start_time),
+    job_id(other.job_id, allocator),
+    job_nodes(other.job_nodes, allocator),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmTimetable term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmTimetable::SwmTimetable(SwmTimetable &&other, const allocator_type &allocator)
+  : start_time(other.start_time),
+    job_id(std::move(other.job_id), allocator),
+    job_nodes(std::move(other.job_nodes), allocator),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->start_time)) {
-    std::cerr << "Could not init timetable::start_time at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmTimetable::allocator_type SwmTimetable::get_allocator() const {
+  return job_id.get_allocator();
+}
+
+SwmTimetable::SwmTimetable(const char* buf, int &index, const allocator_type &allocator)
+  : SwmTimetable(buf, index, FIELD_ALL, allocator) {
+}
+
+SwmTimetable::SwmTimetable(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmTimetable(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
+  }
+}
 
-  if (ei_buffer_to_str(buf, index, this->job_id)) {
-    std::cerr << "Could not init timetable::job_id at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmTimetable::SwmTimetable(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmTimetable(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->job_nodes)) {
-    std::cerr << "Could not init timetable::job_nodes at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmTimetable::validate(const char* buf, int &index) {
+  return entity_validate<SwmTimetable>(buf, index);
+}
+
+void SwmTimetable::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmTimetable::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmTimetable>(buf, index, writer);
+}
+
+SwmPatch SwmTimetable::diff(const SwmTimetable &old_obj, const SwmTimetable &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmTimetable::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmTimetable::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip timetable::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmTimetable::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
 void SwmTimetable::set_start_time(const uint64_t &new_val) {
   start_time = new_val;
+  lazy_fields &= ~FIELD_START_TIME;
 }
 
-void SwmTimetable::set_job_id(const std::string &new_val) {
+void SwmTimetable::set_job_id(const std::pmr::string &new_val) {
   job_id = new_val;
+  lazy_fields &= ~FIELD_JOB_ID;
+}
+
+void SwmTimetable::set_job_id(std::pmr::string &&new_val) {
+  job_id = std::move(new_val);
+  lazy_fields &= ~FIELD_JOB_ID;
 }
 
-void SwmTimetable::set_job_nodes(const std::vector<std::string> &new_val) {
+void SwmTimetable::set_job_nodes(const std::pmr::vector<std::pmr::string> &new_val) {
   job_nodes = new_val;
+  lazy_fields &= ~FIELD_JOB_NODES;
 }
 
-uint64_t SwmTimetable::get_start_time() const {
+void SwmTimetable::set_job_nodes(std::pmr::vector<std::pmr::string> &&new_val) {
+  job_nodes = std::move(new_val);
+  lazy_fields &= ~FIELD_JOB_NODES;
+}
+
+const uint64_t& SwmTimetable::get_start_time() const {
   return start_time;
 }
 
-std::string SwmTimetable::get_job_id() const {
+const std::pmr::string& SwmTimetable::get_job_id() const {
   return job_id;
 }
 
-std::vector<std::string> SwmTimetable::get_job_nodes() const {
+const std::pmr::vector<std::pmr::string>& SwmTimetable::get_job_nodes() const {
   return job_nodes;
 }
 
-int swm::ei_buffer_to_timetable(const char *buf, int &index, std::vector<SwmTimetable> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a timetable list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for timetable at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a timetable list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of timetable list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_timetable(const char *buf, int &index, std::vector<SwmTimetable> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_timetable(const char *buf, int &index, std::pmr::vector<SwmTimetable> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_timetable(const char *buf, int &index, std::vector<SwmTimetable> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a timetable list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmTimetable(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_timetable(const char* buf, int &index, SwmTimetable &obj) {
-  obj = SwmTimetable(buf, index);
+  obj = SwmTimetable(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmTimetable::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmTimetable::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode timetable" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_timetable(char* buf, int &index, const SwmTimetable &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_timetable(char* buf, int &index, const std::vector<SwmTimetable> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmTimetable &x) { x.encode(b, i); });
+}
+
+void swm::encode_timetable(char* buf, int &index, const std::pmr::vector<SwmTimetable> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmTimetable &x) { x.encode(b, i); });
+}
+
+int swm::encode_timetable(ei_x_buff &x, const std::vector<SwmTimetable> &array) {
+  int size = 0;
+  encode_timetable(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode timetable list" << std::endl;
+    return -1;
+  }
+  encode_timetable(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_timetable(ei_x_buff &x, const std::pmr::vector<SwmTimetable> &array) {
+  int size = 0;
+  encode_timetable(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode timetable list" << std::endl;
+    return -1;
+  }
+  encode_timetable(x.buff, x.index, array);
   return 0;
 }
 
 void SwmTimetable::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << start_time << separator;
-  std::cerr << prefix << job_id << separator;
-  if (job_nodes.empty()) {
-    std::cerr << prefix << "job_nodes: []" << separator;
-  } else {
-    std::cerr << prefix << "job_nodes" << ": [";
-    for (const auto &q: job_nodes) {
-      std::cerr << q << ",";
+  entity_print(*this, prefix, separator);
+}
+
+SwmTimetableView::SwmTimetableView() {
+}
+
+SwmTimetableView::SwmTimetableView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmTimetableView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 3)) {
+    std::cerr << "Could not create SwmTimetableView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmTimetableView::is_valid() const {
+  return buf != nullptr;
+}
+
+uint64_t SwmTimetableView::get_start_time() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[0]);
+}
+
+std::string_view SwmTimetableView::get_job_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+SwmListView<std::string_view, ei_buffer_to_str> SwmTimetableView::get_job_nodes() const {
+  return SwmListView<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+int swm::ei_buffer_to_timetable(const char* buf, int &index, SwmTimetableView &obj) {
+  obj = SwmTimetableView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_timetable(const char* buf, int &index, std::vector<SwmTimetableView> &array) {
+  const SwmListView<SwmTimetableView, ei_buffer_to_timetable> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmTimetableView at " << index << std::endl;
+      return -1;
     }
-    std::cerr << "]" << separator;
+    array.push_back(view);
   }
-  std::cerr << std::endl;
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of timetable at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
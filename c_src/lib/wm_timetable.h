@@ -2,36 +2,128 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmTimetable:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 3;
+  static constexpr uint64_t FIELD_START_TIME = 1ull << 0;
+  static constexpr uint64_t FIELD_JOB_ID = 1ull << 1;
+  static constexpr uint64_t FIELD_JOB_NODES = 1ull << 2;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "timetable";
+  static const SwmFieldInfo<SwmTimetable> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmTimetable();
-  SwmTimetable(const char*, int&);
+  explicit SwmTimetable(const allocator_type&);
+  SwmTimetable(const char*, int&, const allocator_type& = {});
+  SwmTimetable(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmTimetable(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmTimetable(const SwmTimetable&, const allocator_type&);
+  SwmTimetable(SwmTimetable&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmTimetable &old_obj, const SwmTimetable &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
   void set_start_time(const uint64_t&);
-  void set_job_id(const std::string&);
-  void set_job_nodes(const std::vector<std::string>&);
+  void set_job_id(const std::pmr::string&);
+  void set_job_id(std::pmr::string&&);
+  void set_job_nodes(const std::pmr::vector<std::pmr::string>&);
+  void set_job_nodes(std::pmr::vector<std::pmr::string>&&);
 
-  uint64_t get_start_time() const;
-  std::string get_job_id() const;
-  std::vector<std::string> get_job_nodes() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const uint64_t& get_start_time() const;
+  const std::pmr::string& get_job_id() const;
+  const std::pmr::vector<std::pmr::string>& get_job_nodes() const;
+
+  // Constructs a list element in place with the entity allocator
+  template <typename... Args>
+  auto& emplace_job_nodes(Args&&... args) {
+    return job_nodes.emplace_back(std::forward<Args>(args)...);
+  }
 
  private:
-  uint64_t start_time;
-  std::string job_id;
-  std::vector<std::string> job_nodes;
+  uint64_t start_time = 0;
+  std::pmr::string job_id;
+  std::pmr::vector<std::pmr::string> job_nodes;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmTimetableView;
+
 int ei_buffer_to_timetable(const char*, int&, std::vector<SwmTimetable>&);
+int ei_buffer_to_timetable(const char*, int&, std::pmr::vector<SwmTimetable>&);
+int ei_buffer_to_timetable(const char*, int&, std::vector<SwmTimetable>&, SwmThreadPool&);
 int ei_buffer_to_timetable(const char*, int&, SwmTimetable&);
+int ei_buffer_to_timetable(const char*, int&, std::vector<SwmTimetableView>&);
+int ei_buffer_to_timetable(const char*, int&, SwmTimetableView&);
+
+void encode_timetable(char*, int&, const SwmTimetable&);
+void encode_timetable(char*, int&, const std::vector<SwmTimetable>&);
+void encode_timetable(char*, int&, const std::pmr::vector<SwmTimetable>&);
+int encode_timetable(ei_x_buff&, const std::vector<SwmTimetable>&);
+int encode_timetable(ei_x_buff&, const std::pmr::vector<SwmTimetable>&);
+
+class SwmTimetableView {
+
+ public:
+  SwmTimetableView();
+  SwmTimetableView(const char*, int&);
+
+  bool is_valid() const;
+
+  uint64_t get_start_time() const;
+  std::string_view get_job_id() const;
+  SwmListView<std::string_view, ei_buffer_to_str> get_job_nodes() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 3> offsets = {};
+
+};
 
 } // namespace swm
@@ -1,187 +1,410 @@
+#include <atomic>
 #include <iostream>
 
 #include "wm_user.h"
 
 #include <ei.h>
 
+#include "wm_etf_reader.h"
+#include "wm_etf_writer.h"
 
 using namespace swm;
 
 
+constexpr SwmFieldInfo<SwmUser> SwmUser::FIELDS_INFO[] = {
+  field_info<SwmUser, SwmId, &SwmUser::id,
+             ei_buffer_to_id, encode_id,
+             SwmIdTerm>("id"),
+  field_info<SwmUser, std::pmr::string, &SwmUser::name,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("name"),
+  field_info<SwmUser, std::pmr::string, &SwmUser::acl,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("acl"),
+  field_info<SwmUser, int64_t, &SwmUser::priority,
+             ei_buffer_to_int64_t, encode_int64_t,
+             SwmInt64Term>("priority"),
+  field_info<SwmUser, std::pmr::string, &SwmUser::comment,
+             ei_buffer_to_str, encode_str,
+             SwmStrTerm>("comment"),
+  field_info<SwmUser, uint64_t, &SwmUser::revision,
+             ei_buffer_to_uint64_t, encode_uint64_t,
+             SwmUint64Term>("revision"),
+};
+
 SwmUser::SwmUser() {
 }
 
-SwmUser::SwmUser(const char* buf, int &index) {
-  if (!buf) {
-    std::cerr << "Could not convert ei buffer into SwmUser: null" << std::endl;
-    return;
-  }
+SwmUser::SwmUser(const allocator_type &allocator)
+  : name(allocator),
+    acl(allocator),
+    comment(allocator) {
+}
 
-  int term_size = 0;
-  if (ei_decode_tuple_header(buf, &index, &term_size)) {
-    std::cerr << "Could not decode SwmUser header from ei buffer: ";
-    ei_print_term(stdout, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmUser::SwmUser(const SwmUser &other, const allocator_type &allocator)
+  : id(other.id),
+    name(other.name, allocator),
+    acl(other.acl, allocator),
+    priority(other.priority),
+    comment(other.comment, allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_skip_term(buf, &index) < 0) {  // first atom is the term name
-    std::cerr << "Could not skip SwmUser term first atom: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmUser::SwmUser(SwmUser &&other, const allocator_type &allocator)
+  : id(other.id),
+    name(std::move(other.name), allocator),
+    acl(std::move(other.acl), allocator),
+    priority(other.priority),
+    comment(std::move(other.comment), allocator),
+    revision(other.revision),
+    lazy_buf(other.lazy_buf),
+    lazy_index(other.lazy_index),
+    lazy_fields(other.lazy_fields) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->id)) {
-    std::cerr << "Could not init user::id at pos 2: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmUser::allocator_type SwmUser::get_allocator() const {
+  return name.get_allocator();
+}
 
-  if (ei_buffer_to_str(buf, index, this->name)) {
-    std::cerr << "Could not init user::name at pos 3: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
-  }
+SwmUser::SwmUser(const char* buf, int &index, const allocator_type &allocator)
+  : SwmUser(buf, index, FIELD_ALL, allocator) {
+}
 
-  if (ei_buffer_to_str(buf, index, this->acl)) {
-    std::cerr << "Could not init user::acl at pos 4: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
+SwmUser::SwmUser(const char* buf, int &index, const uint64_t fields, const allocator_type &allocator)
+  : SwmUser(allocator) {
+  int first_field = 0;
+  if (entity_decode(buf, index, fields, *this, first_field)) {
     return;
   }
-
-  if (ei_buffer_to_int64_t(buf, index, this->priority)) {
-    std::cerr << "Could not init user::priority at pos 5: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_str(buf, index, this->comment)) {
-    std::cerr << "Could not init user::comment at pos 6: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+SwmUser::SwmUser(const char* buf, int &index, SwmUnchecked, const uint64_t fields, const allocator_type &allocator)
+  : SwmUser(allocator) {
+  const int first_field = entity_decode_unchecked(buf, index, fields, *this);
+  lazy_fields = ~fields & FIELD_ALL;
+  if (lazy_fields) {
+    lazy_buf = buf;
+    lazy_index = first_field;
   }
+}
 
-  if (ei_buffer_to_uint64_t(buf, index, this->revision)) {
-    std::cerr << "Could not init user::revision at pos 7: ";
-    ei_print_term(stderr, buf, &index);
-    std::cerr << std::endl;
-    return;
+int SwmUser::validate(const char* buf, int &index) {
+  return entity_validate<SwmUser>(buf, index);
+}
+
+void SwmUser::to_json(SwmJsonWriter &writer) const {
+  entity_json(*this, writer);
+}
+
+int SwmUser::to_json(const char* buf, int &index, SwmJsonWriter &writer) {
+  return entity_etf_to_json<SwmUser>(buf, index, writer);
+}
+
+SwmPatch SwmUser::diff(const SwmUser &old_obj, const SwmUser &new_obj) {
+  return entity_diff(old_obj, new_obj);
+}
+
+int SwmUser::apply(const SwmPatch &patch) {
+  return entity_apply(*this, patch);
+}
+
+int SwmUser::decode_fields(const uint64_t fields) {
+  int index = lazy_index;
+  for (int pos = 0; pos < FIELDS_COUNT && (fields & lazy_fields); ++pos) {
+    const uint64_t field = 1ull << pos;
+    if (fields & lazy_fields & field) {
+      if (entity_decode_field(lazy_buf, index, pos, *this)) {
+        return -1;
+      }
+      lazy_fields &= ~field;
+    } else if (etf_skip_term(lazy_buf, index)) {
+      std::cerr << "Could not skip user::" << FIELDS_INFO[pos].name << " at pos " << pos + 2 << std::endl;
+      return -1;
+    }
+  }
+  if (!lazy_fields) {
+    lazy_buf = nullptr;
   }
+  return 0;
+}
 
+uint64_t SwmUser::get_lazy_fields() const {
+  return lazy_fields;
 }
 
 
-void SwmUser::set_id(const std::string &new_val) {
+void SwmUser::set_id(const SwmId &new_val) {
   id = new_val;
+  lazy_fields &= ~FIELD_ID;
 }
 
-void SwmUser::set_name(const std::string &new_val) {
+void SwmUser::set_name(const std::pmr::string &new_val) {
   name = new_val;
+  lazy_fields &= ~FIELD_NAME;
 }
 
-void SwmUser::set_acl(const std::string &new_val) {
+void SwmUser::set_name(std::pmr::string &&new_val) {
+  name = std::move(new_val);
+  lazy_fields &= ~FIELD_NAME;
+}
+
+void SwmUser::set_acl(const std::pmr::string &new_val) {
   acl = new_val;
+  lazy_fields &= ~FIELD_ACL;
+}
+
+void SwmUser::set_acl(std::pmr::string &&new_val) {
+  acl = std::move(new_val);
+  lazy_fields &= ~FIELD_ACL;
 }
 
 void SwmUser::set_priority(const int64_t &new_val) {
   priority = new_val;
+  lazy_fields &= ~FIELD_PRIORITY;
 }
 
-void SwmUser::set_comment(const std::string &new_val) {
+void SwmUser::set_comment(const std::pmr::string &new_val) {
   comment = new_val;
+  lazy_fields &= ~FIELD_COMMENT;
+}
+
+void SwmUser::set_comment(std::pmr::string &&new_val) {
+  comment = std::move(new_val);
+  lazy_fields &= ~FIELD_COMMENT;
 }
 
 void SwmUser::set_revision(const uint64_t &new_val) {
   revision = new_val;
+  lazy_fields &= ~FIELD_REVISION;
 }
 
-std::string SwmUser::get_id() const {
+const SwmId& SwmUser::get_id() const {
   return id;
 }
 
-std::string SwmUser::get_name() const {
+const std::pmr::string& SwmUser::get_name() const {
   return name;
 }
 
-std::string SwmUser::get_acl() const {
+const std::pmr::string& SwmUser::get_acl() const {
   return acl;
 }
 
-int64_t SwmUser::get_priority() const {
+const int64_t& SwmUser::get_priority() const {
   return priority;
 }
 
-std::string SwmUser::get_comment() const {
+const std::pmr::string& SwmUser::get_comment() const {
   return comment;
 }
 
-uint64_t SwmUser::get_revision() const {
+const uint64_t& SwmUser::get_revision() const {
   return revision;
 }
 
-int swm::ei_buffer_to_user(const char *buf, int &index, std::vector<SwmUser> &array) {
-  int term_size = 0;
-  int term_type = 0;
-  const int parsed = ei_get_type(buf, &index, &term_type, &term_size);
-  if (parsed < 0) {
-    std::cerr << "Could not get term type at position " << index << std::endl;
-    return -1;
-  }
+namespace {
 
-  if (term_type != ERL_LIST_EXT && term_type != ERL_NIL_EXT) {
-      std::cerr << "Could not parse term: not a user list at " << index << ": " << term_type << std::endl;
-      return -1;
-  }
+// Elements are constructed by the vector allocator, so a pmr vector
+// puts all nested strings and lists into its memory resource.
+template <typename Array>
+int buffer_to_array(const char *buf, int &index, Array &array) {
   int list_size = 0;
-  if (ei_decode_list_header(buf, &index, &list_size) < 0) {
-    std::cerr << "Could not parse list for user at position " << index << std::endl;
+  if (etf_decode_list_header(buf, index, list_size)) {
+    std::cerr << "Could not parse term: not a user list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
     return -1;
   }
   if (list_size == 0) {
     return 0;
   }
 
-  array.reserve(list_size);
+  array.reserve(array.size() + list_size);
   for (int i=0; i<list_size; ++i) {
-    int entry_size = 0;
-    int sub_term_type = 0;
-    const int parsed = ei_get_type(buf, &index, &sub_term_type, &entry_size);
-    if (parsed < 0) {
-      std::cerr << "Could not get term type at position " << index << std::endl;
-      return -1;
-    }
-    switch (sub_term_type) {
+    switch (etf_term_tag(buf, index)) {
       case ERL_SMALL_TUPLE_EXT:
       case ERL_LARGE_TUPLE_EXT:
         array.emplace_back(buf, index);
         break;
       default:
         std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+        return -1;
     }
   }
-  ei_skip_term(buf, &index);  // last element of a list is empty list
+  if (etf_decode_list_tail(buf, index)) {  // last element of a list is empty list
+    std::cerr << "Could not parse tail of user list at " << index << std::endl;
+    return -1;
+  }
 
   return 0;
 }
 
+} // namespace
+
+int swm::ei_buffer_to_user(const char *buf, int &index, std::vector<SwmUser> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+int swm::ei_buffer_to_user(const char *buf, int &index, std::pmr::vector<SwmUser> &array) {
+  return buffer_to_array(buf, index, array);
+}
+
+// Offsets of all list elements are found by one sequential scan, then the
+// elements are decoded by the pool threads directly into their slots.
+int swm::ei_buffer_to_user(const char *buf, int &index, std::vector<SwmUser> &array, SwmThreadPool &pool) {
+  std::vector<int> offsets;
+  if (etf_list_offsets(buf, index, offsets)) {
+    std::cerr << "Could not parse term: not a user list at " << index << ": " << etf_term_tag(buf, index) << std::endl;
+    return -1;
+  }
+
+  const size_t first = array.size();
+  array.resize(first + offsets.size());
+  std::atomic<bool> failed(false);
+  const auto scope = SwmSharedBufferScope::current();  // terms are shared on the pool threads too
+  pool.parallel_for(offsets.size(), [&](const size_t begin, const size_t end) {
+    const SwmSharedBufferScope thread_scope(scope);
+    for (size_t i = begin; i < end && !failed; ++i) {
+      int element_index = offsets[i];
+      switch (etf_term_tag(buf, element_index)) {
+        case ERL_SMALL_TUPLE_EXT:
+        case ERL_LARGE_TUPLE_EXT:
+          array[first + i] = SwmUser(buf, element_index);
+          break;
+        default:
+          std::cerr << "List element (at position " << i << ") is not a tuple" << std::endl;
+          failed = true;
+      }
+    }
+  });
+  return failed ? -1 : 0;
+}
+
 int swm::ei_buffer_to_user(const char* buf, int &index, SwmUser &obj) {
-  obj = SwmUser(buf, index);
+  obj = SwmUser(buf, index, obj.get_allocator());
+  return 0;
+}
+
+void SwmUser::encode(char* buf, int &index) const {
+  entity_encode(buf, index, *this);
+}
+
+int SwmUser::encode(ei_x_buff &x) const {
+  int size = 0;
+  encode(nullptr, size);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode user" << std::endl;
+    return -1;
+  }
+  encode(x.buff, x.index);
+  return 0;
+}
+
+void swm::encode_user(char* buf, int &index, const SwmUser &obj) {
+  obj.encode(buf, index);
+}
+
+void swm::encode_user(char* buf, int &index, const std::vector<SwmUser> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmUser &x) { x.encode(b, i); });
+}
+
+void swm::encode_user(char* buf, int &index, const std::pmr::vector<SwmUser> &array) {
+  etf_encode_list(buf, index, array, [](char* b, int &i, const SwmUser &x) { x.encode(b, i); });
+}
+
+int swm::encode_user(ei_x_buff &x, const std::vector<SwmUser> &array) {
+  int size = 0;
+  encode_user(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode user list" << std::endl;
+    return -1;
+  }
+  encode_user(x.buff, x.index, array);
+  return 0;
+}
+
+int swm::encode_user(ei_x_buff &x, const std::pmr::vector<SwmUser> &array) {
+  int size = 0;
+  encode_user(nullptr, size, array);
+  if (etf_x_reserve(x, size)) {
+    std::cerr << "Could not allocate " << size << " bytes to encode user list" << std::endl;
+    return -1;
+  }
+  encode_user(x.buff, x.index, array);
   return 0;
 }
 
 void SwmUser::print(const std::string &prefix, const char separator) const {
-  std::cerr << prefix << id << separator;
-  std::cerr << prefix << name << separator;
-  std::cerr << prefix << acl << separator;
-  std::cerr << prefix << priority << separator;
-  std::cerr << prefix << comment << separator;
-  std::cerr << prefix << revision << separator;
-  std::cerr << std::endl;
+  entity_print(*this, prefix, separator);
+}
+
+SwmUserView::SwmUserView() {
+}
+
+SwmUserView::SwmUserView(const char* buf, int &index): buf(buf) {
+  if (!buf) {
+    std::cerr << "Could not create SwmUserView: null" << std::endl;
+    return;
+  }
+  if (skip_entity_fields(buf, index, offsets.data(), 6)) {
+    std::cerr << "Could not create SwmUserView at " << index << std::endl;
+    this->buf = nullptr;
+  }
+}
+
+bool SwmUserView::is_valid() const {
+  return buf != nullptr;
+}
+
+std::string_view SwmUserView::get_id() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[0]);
+}
+
+std::string_view SwmUserView::get_name() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[1]);
+}
+
+std::string_view SwmUserView::get_acl() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[2]);
+}
+
+int64_t SwmUserView::get_priority() const {
+  return get_view_value<int64_t, ei_buffer_to_int64_t>(buf, offsets[3]);
+}
+
+std::string_view SwmUserView::get_comment() const {
+  return get_view_value<std::string_view, ei_buffer_to_str>(buf, offsets[4]);
+}
+
+uint64_t SwmUserView::get_revision() const {
+  return get_view_value<uint64_t, ei_buffer_to_uint64_t>(buf, offsets[5]);
+}
+
+int swm::ei_buffer_to_user(const char* buf, int &index, SwmUserView &obj) {
+  obj = SwmUserView(buf, index);
+  return obj.is_valid() ? 0 : -1;
+}
+
+int swm::ei_buffer_to_user(const char* buf, int &index, std::vector<SwmUserView> &array) {
+  const SwmListView<SwmUserView, ei_buffer_to_user> list(buf, index);
+  array.reserve(array.size() + list.size());
+  for (const auto &view : list) {
+    if (!view.is_valid()) {
+      std::cerr << "Could not init array of SwmUserView at " << index << std::endl;
+      return -1;
+    }
+    array.push_back(view);
+  }
+  if (etf_skip_term(buf, index)) {
+    std::cerr << "Could not skip list of user at " << index << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
@@ -2,45 +2,138 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "wm_entity.h"
+#include "wm_entity_fields.h"
+#include "wm_entity_patch.h"
 #include "wm_entity_utils.h"
+#include "wm_entity_view.h"
+#include "wm_thread_pool.h"
 
 namespace swm {
 
 class SwmUser:SwmEntity {
 
  public:
+  static constexpr int FIELDS_COUNT = 6;
+  static constexpr uint64_t FIELD_ID = 1ull << 0;
+  static constexpr uint64_t FIELD_NAME = 1ull << 1;
+  static constexpr uint64_t FIELD_ACL = 1ull << 2;
+  static constexpr uint64_t FIELD_PRIORITY = 1ull << 3;
+  static constexpr uint64_t FIELD_COMMENT = 1ull << 4;
+  static constexpr uint64_t FIELD_REVISION = 1ull << 5;
+  static constexpr uint64_t FIELD_ALL = (1ull << FIELDS_COUNT) - 1;
+
+  // Name of the erlang record and descriptors of its fields in the tuple order
+  static constexpr const char* ENTITY_NAME = "user";
+  static const SwmFieldInfo<SwmUser> FIELDS_INFO[FIELDS_COUNT];
+
+  typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
   SwmUser();
-  SwmUser(const char*, int&);
+  explicit SwmUser(const allocator_type&);
+  SwmUser(const char*, int&, const allocator_type& = {});
+  SwmUser(const char*, int&, uint64_t fields, const allocator_type& = {});
+  SwmUser(const char*, int&, SwmUnchecked, uint64_t fields = FIELD_ALL, const allocator_type& = {});
+  SwmUser(const SwmUser&, const allocator_type&);
+  SwmUser(SwmUser&&, const allocator_type&);
+
+  allocator_type get_allocator() const;
+
+  // The term size is computed first, so the buffer is grown only once.
+  // With a null buffer only the index is advanced by the term size.
+  void encode(char*, int&) const;
+  int encode(ei_x_buff&) const;
+
+  // Checks the term against the schema, so it can be decoded unchecked.
+  // On failure the index points to the first unexpected term.
+  static int validate(const char*, int&);
+
+  // JSON object with the field names as keys, it is written from the entity
+  // or directly from the entity term (see wm_entity_fields.h)
+  void to_json(SwmJsonWriter&) const;
+  static int to_json(const char*, int&, SwmJsonWriter&);
+
+  // Changed fields and their application, see wm_entity_patch.h
+  static SwmPatch diff(const SwmUser &old_obj, const SwmUser &new_obj);
+  int apply(const SwmPatch&);
+
+  // Fields missing in the constructor mask are skipped and can be decoded
+  // later while the original buffer is still alive. A setter marks its
+  // field as decoded, so the value set is not replaced by the buffer one.
+  int decode_fields(uint64_t fields);
+  uint64_t get_lazy_fields() const;
 
   virtual void print(const std::string &prefix, const char separator) const;
 
-  void set_id(const std::string&);
-  void set_name(const std::string&);
-  void set_acl(const std::string&);
+  void set_id(const SwmId&);
+  void set_name(const std::pmr::string&);
+  void set_name(std::pmr::string&&);
+  void set_acl(const std::pmr::string&);
+  void set_acl(std::pmr::string&&);
   void set_priority(const int64_t&);
-  void set_comment(const std::string&);
+  void set_comment(const std::pmr::string&);
+  void set_comment(std::pmr::string&&);
   void set_revision(const uint64_t&);
 
-  std::string get_id() const;
-  std::string get_name() const;
-  std::string get_acl() const;
-  int64_t get_priority() const;
-  std::string get_comment() const;
-  uint64_t get_revision() const;
+  // Getters return references to the fields, so reading decoded state
+  // does not allocate. The references are valid while the entity lives.
+  const SwmId& get_id() const;
+  const std::pmr::string& get_name() const;
+  const std::pmr::string& get_acl() const;
+  const int64_t& get_priority() const;
+  const std::pmr::string& get_comment() const;
+  const uint64_t& get_revision() const;
 
  private:
-  std::string id;
-  std::string name;
-  std::string acl;
-  int64_t priority;
-  std::string comment;
-  uint64_t revision;
+  SwmId id;
+  std::pmr::string name;
+  std::pmr::string acl;
+  int64_t priority = 0;
+  std::pmr::string comment;
+  uint64_t revision = 0;
+
+  const char* lazy_buf = nullptr;
+  int lazy_index = 0;
+  uint64_t lazy_fields = 0;
 
 };
 
+class SwmUserView;
+
 int ei_buffer_to_user(const char*, int&, std::vector<SwmUser>&);
+int ei_buffer_to_user(const char*, int&, std::pmr::vector<SwmUser>&);
+int ei_buffer_to_user(const char*, int&, std::vector<SwmUser>&, SwmThreadPool&);
 int ei_buffer_to_user(const char*, int&, SwmUser&);
+int ei_buffer_to_user(const char*, int&, std::vector<SwmUserView>&);
+int ei_buffer_to_user(const char*, int&, SwmUserView&);
+
+void encode_user(char*, int&, const SwmUser&);
+void encode_user(char*, int&, const std::vector<SwmUser>&);
+void encode_user(char*, int&, const std::pmr::vector<SwmUser>&);
+int encode_user(ei_x_buff&, const std::vector<SwmUser>&);
+int encode_user(ei_x_buff&, const std::pmr::vector<SwmUser>&);
+
+class SwmUserView {
+
+ public:
+  SwmUserView();
+  SwmUserView(const char*, int&);
+
+  bool is_valid() const;
+
+  std::string_view get_id() const;
+  std::string_view get_name() const;
+  std::string_view get_acl() const;
+  int64_t get_priority() const;
+  std::string_view get_comment() const;
+  uint64_t get_revision() const;
+
+ private:
+  const char* buf = nullptr;
+  std::array<int, 6> offsets = {};
+
+};
 
 } // namespace swm
@@ -27,7 +27,6 @@
 #include <unistd.h>
 
 #define CHILD_WAITING_TIME 5
-#define PROCESS_TUPLE_SIZE 6
 
 using namespace swm;
 
@@ -93,9 +92,9 @@ void switch_stderr(const std::string &path) {
 
 void set_io(const SwmJob &job) {
   swm_logd("Set IO");
-  auto out_path = job.get_job_stdout();
+  std::string out_path(job.get_job_stdout());
   static std::string token = "%j";
-  const auto id = job.get_id();
+  const auto id = job.get_id().str();
   const size_t len = std::string("%j").size();
   if (out_path.size()) {
     const size_t pos = out_path.find(token);
@@ -106,7 +105,7 @@ void set_io(const SwmJob &job) {
     switch_stdout(out_path);
   }
 
-  auto err_path = job.get_job_stderr();
+  std::string err_path(job.get_job_stderr());
   if (err_path.size()) {
     const size_t pos = err_path.find(token);
     if (pos != std::string::npos) {
@@ -149,12 +148,12 @@ void parse_opts(int argc, char* const argv[]) {
 }
 
 void set_env(passwd *pw, const SwmJob &job) {
-  const std::string cwd = job.get_workdir();
+  const std::string cwd(job.get_workdir());
   setenv("HOME", pw->pw_dir, 1);
   setenv("USER", pw->pw_name, 1);
-  setenv("SWM_JOB_ID", job.get_id().c_str(), 1);
+  setenv("SWM_JOB_ID", job.get_id().str().c_str(), 1);
   if (cwd.size()) {
-    const std::string path = job.get_workdir() + ":" + getenv("PATH");
+    const std::string path = cwd + ":" + getenv("PATH");
     const auto path_str = path.c_str();
     setenv("PATH", path_str, 1);
     setenv("PWD", path_str, 1);
@@ -172,32 +171,8 @@ int send_process_info(const SwmProcess &proc) {
     swm_loge("Can't encode version");
     return -1;
   }
-  if (ei_x_encode_tuple_header(&x, PROCESS_TUPLE_SIZE)) {
-    swm_loge("Can't encode process tuple header");
-    return -1;
-  }
-  if (ei_x_encode_atom(&x, "process")) {
-    swm_loge("Can't encode process first atom");
-    return -1;
-  }
-  if (ei_x_encode_ulong(&x, proc.get_pid())) {
-    swm_loge("Can't encode process pid");
-    return -1;
-  }
-  if (ei_x_encode_string(&x, proc.get_state().c_str())) {
-    swm_loge("Can't encode process state");
-    return -1;
-  }
-  if (ei_x_encode_long(&x, proc.get_exitcode())) {
-    swm_loge("Can't encode process exitcode");
-    return -1;
-  }
-  if (ei_x_encode_long(&x, proc.get_signal())) {
-    swm_loge("Can't encode process signal");
-    return -1;
-  }
-  if (ei_x_encode_string(&x, proc.get_comment().c_str())) {
-    swm_loge("Can't encode process comment");
+  if (proc.encode(x)) {
+    swm_loge("Can't encode process term");
     return -1;
   }
 
@@ -249,7 +224,7 @@ std::string save_script(const std::string &job_id, const uid_t uid, const gid_t
 void set_job_dir_ownership(const SwmJob &job, const uid_t uid, const gid_t gid) {
   const auto workdir = job.get_workdir();
   if (chown(workdir.c_str(), uid, gid) == -1) {
-    const std::string msg = "Could not chown directory " + workdir;
+    const auto msg = "Could not chown directory " + workdir;
     std::perror(msg.c_str());
     exit(EXIT_FAILURE);
   }
@@ -303,8 +278,8 @@ int main(int argc, char* const argv[]) {
     };
     swm_logd("User \"%s\" found: uid=%d gid=%d", username, pw->pw_uid, pw->pw_gid);
 
-    const auto content = info.job.get_script_content();
-    const auto job_id = info.job.get_id();
+    const std::string content(info.job.get_script_content());
+    const std::string job_id(info.job.get_id().str());
     const auto path = save_script(job_id, pw->pw_uid, pw->pw_gid, content);
     swm_logi("Temporary execution path: \"%s\"", path.c_str());
 
@@ -3,7 +3,6 @@
 #include "wm_porter_data.h"
 #include "wm_io.h"
 
-#define BUF_SIZE 32
 #define SWM_COMMAND_PORTER_RUN 1
 
 using namespace swm;
@@ -46,23 +45,15 @@ int swm::get_porter_data(std::istream* input, byte* data[]) {
     }
     swm_logd("Data length is %zu (type=%d)", len, type);
 
-    data[i] = new (std::nothrow) byte[len];
+    // Compressed binaries are inflated while they are read
+    uint32_t size = 0;
+    data[i] = swm_read_etf(input, len, &size);
     if (!data[i]) {
-      std::cerr << "Could not allocate " << len << " bytes for data type " << type << std::endl;
+      std::cerr << "Couldn't read " << len << " bytes of data type " << type << std::endl;
       return -1;
     }
-
-    unsigned int read_bytes = 0;
-    for (unsigned int marker=0; marker<len; marker+=BUF_SIZE) {
-      if (marker+BUF_SIZE<len) {
-        read_bytes = BUF_SIZE;
-      } else {
-        read_bytes = len-marker;
-      }
-      if (!swm_read_exact(input, data[i]+marker, read_bytes)) {
-        std::cerr << "Couldn't get " << read_bytes << " bytes of data type " << type << std::endl;
-        return -1;
-      }
+    if (size != len) {
+      swm_logd("Data is inflated to %u bytes (type=%d)", size, type);
     }
 
     int index = 0;
@@ -92,6 +83,20 @@ int swm::get_porter_data(std::istream* input, byte* data[]) {
   return 0;
 }
 
+namespace {
+
+template <typename Entity>
+int validate_term(const char* buf, const int index) {
+  int end = index;
+  if (Entity::validate(buf, end)) {
+    std::cerr << "Invalid " << Entity::ENTITY_NAME << " term at position " << end << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+} // namespace
+
 int swm::parse_data(byte *buf[], SwmProcInfo &info) {
   for (size_t i=0; i<SWM_DATA_TYPES_COUNT; ++i) {
     if (!buf[i]) {
@@ -118,13 +123,25 @@ int swm::parse_data(byte *buf[], SwmProcInfo &info) {
     }
     swm_logd("Parsed buf: term size: %d, term type: %d, index=%d", term_size, term_type, index);
 
+    // Terms come from wm_port: after one validation pass they are decoded unchecked
     switch (i) {
       case SWM_DATA_TYPE_JOBS: {
-        info.job = SwmJob(buf[i], index);
+        if (validate_term<SwmJob>(buf[i], index)) {
+          return -1;
+        }
+        info.job = SwmJob(buf[i], index, swm_unchecked, SwmJob::FIELD_ID |
+                                         SwmJob::FIELD_JOB_STDOUT |
+                                         SwmJob::FIELD_JOB_STDERR |
+                                         SwmJob::FIELD_WORKDIR |
+                                         SwmJob::FIELD_ENV |
+                                         SwmJob::FIELD_SCRIPT_CONTENT);
         break;
       };
       case SWM_DATA_TYPE_USERS: {
-        info.user = SwmUser(buf[i], index);
+        if (validate_term<SwmUser>(buf[i], index)) {
+          return -1;
+        }
+        info.user = SwmUser(buf[i], index, swm_unchecked);
         break;
       };
       default: {
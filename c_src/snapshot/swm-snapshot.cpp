@@ -0,0 +1,113 @@
+#include "wm_cluster.h"
+#include "wm_grid.h"
+#include "wm_io.h"
+#include "wm_job.h"
+#include "wm_node.h"
+#include "wm_partition.h"
+#include "wm_scheduler.h"
+#include "wm_snapshot_file.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include <getopt.h>
+
+using namespace swm;
+
+void print_usage(const std::string &prog) {
+  std::cout << "Usage: " << prog << " [-d] -w FILE < scheduler_input" << std::endl
+            << "       " << prog << " [-d] -r FILE" << std::endl
+            << std::endl
+            << "  -w, --write FILE  write snapshot of the scheduler input read from stdin" << std::endl
+            << "  -r, --read FILE   map the snapshot and print its sections" << std::endl;
+}
+
+int write_snapshot(const std::string &path) {
+  SwmSnapshotWriter writer(path);
+  if (swm_write_snapshot(&std::cin, writer)) {
+    swm_loge("Could not write snapshot %s", path.c_str());
+    return 1;
+  }
+  swm_logi("Snapshot %s has been written", path.c_str());
+  return 0;
+}
+
+template <typename View>
+void print_section(const SwmSnapshotFile &file, const SwmSnapshotSection section, const char* name) {
+  std::cout << name << ": " << file.count(section);
+  if (file.count(section)) {
+    std::cout << " (first id: " << file.view<View>(section, 0).get_id() << ")";
+  }
+  std::cout << std::endl;
+}
+
+int read_snapshot(const std::string &path) {
+  SwmSnapshotFile file;
+  const auto start = std::chrono::steady_clock::now();
+  if (file.open(path)) {
+    return 1;
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  std::cout << path << ": " << file.size() << " bytes, opened in "
+            << std::chrono::duration<double, std::micro>(stop - start).count() << " us" << std::endl;
+  print_section<SwmSchedulerView>(file, SWM_SNAPSHOT_SCHEDULERS, "schedulers");
+  std::cout << "rh: " << file.count(SWM_SNAPSHOT_RH) << std::endl;
+  print_section<SwmJobView>(file, SWM_SNAPSHOT_JOBS, "jobs");
+  print_section<SwmGridView>(file, SWM_SNAPSHOT_GRID, "grid");
+  print_section<SwmClusterView>(file, SWM_SNAPSHOT_CLUSTERS, "clusters");
+  print_section<SwmPartitionView>(file, SWM_SNAPSHOT_PARTITIONS, "partitions");
+  print_section<SwmNodeView>(file, SWM_SNAPSHOT_NODES, "nodes");
+  return 0;
+}
+
+int main(int argc, char* const argv[]) {
+  const char* short_opts = "hdw:r:";
+  const option long_opts[] = {
+    {"help", no_argument, nullptr, 'h'},
+    {"debug", no_argument, nullptr, 'd'},
+    {"write", required_argument, nullptr, 'w'},
+    {"read", required_argument, nullptr, 'r'},
+    {nullptr, 0, nullptr, 0}
+  };
+
+  int res;
+  int opt_idx;
+  int log_level = SWM_LOG_LEVEL_INFO;
+  std::string write_path;
+  std::string read_path;
+  while((res=getopt_long(argc, argv, short_opts, long_opts, &opt_idx)) != -1) {
+    switch(res) {
+      case 'h': {
+        print_usage(argv[0]);
+        return 0;
+      }
+      case 'd': {
+        log_level = SWM_LOG_LEVEL_DEBUG1;
+        break;
+      }
+      case 'w': {
+        write_path = optarg;
+        break;
+      }
+      case 'r': {
+        read_path = optarg;
+        break;
+      }
+      default: {
+        print_usage(argv[0]);
+        return 1;
+      }
+    }
+  }
+  swm_log_init(log_level, stderr);
+
+  if (!write_path.empty()) {
+    return write_snapshot(write_path);
+  }
+  if (!read_path.empty()) {
+    return read_snapshot(read_path);
+  }
+  print_usage(argv[0]);
+  return 1;
+}
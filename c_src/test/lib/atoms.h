@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "wm_atom.h"
+#include "wm_entity_utils.h"
+
+#include <sstream>
+#include <vector>
+
+TEST(Atom, intern) {
+  EXPECT_TRUE(swm::SwmAtom().empty());
+  EXPECT_EQ(swm::SwmAtom(""), swm::SwmAtom());
+  EXPECT_EQ(swm::SwmAtom("up"), swm::SWM_ATOM_UP);
+  EXPECT_EQ(swm::SwmAtom("up").id(), static_cast<uint32_t>(swm::SWM_ATOM_UP));
+  EXPECT_EQ(swm::SwmAtom(swm::SWM_ATOM_CONTAINER).str(), "container");
+
+  const auto count = swm::swm_atoms_count();
+  const swm::SwmAtom first("a-new-atom");
+  const swm::SwmAtom second("a-new-atom");
+  EXPECT_EQ(first, second);
+  EXPECT_GE(first.id(), static_cast<uint32_t>(swm::SWM_ATOM_KNOWN_COUNT));
+  EXPECT_EQ(swm::swm_atoms_count(), count + 1);
+  EXPECT_EQ(first.str(), "a-new-atom");
+  EXPECT_NE(first, swm::SwmAtom("another-new-atom"));
+
+  std::stringstream out;
+  out << first;
+  EXPECT_EQ(out.str(), "a-new-atom");
+}
+
+TEST(Atom, decode) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 3), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "down"), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "drained"), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "down"), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+
+  int index = 0;
+  std::vector<swm::SwmAtom> atoms;
+  EXPECT_EQ(swm::ei_buffer_to_atom(x.buff, index, atoms), 0);
+  ASSERT_EQ(atoms.size(), 3ul);
+  EXPECT_EQ(atoms[0], swm::SWM_ATOM_DOWN);
+  EXPECT_EQ(atoms[1], "drained");
+  EXPECT_EQ(atoms[0], atoms[2]);
+
+  index = 0;  // a list is not an atom
+  swm::SwmAtom atom;
+  EXPECT_EQ(swm::ei_buffer_to_atom(x.buff, index, atom), -1);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include "wm_cluster_snapshot.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::shared_ptr<const swm::SwmJob> snapshot_job(const std::string &id, const uint64_t priority) {
+  auto job = std::make_shared<swm::SwmJob>();
+  job->set_id(swm::SwmId(id));
+  job->set_priority(priority);
+  return job;
+}
+
+TEST(ClusterSnapshot, copy_on_write) {
+  std::vector<std::shared_ptr<const swm::SwmJob>> jobs;
+  for (uint64_t i = 0; i < 200; ++i) {
+    jobs.push_back(snapshot_job("job-" + std::to_string(i), i));
+  }
+  const swm::SwmSnapshotList<swm::SwmJob> original(jobs);
+  ASSERT_EQ(original.size(), 200ul);
+  EXPECT_EQ(original.find("job-150")->get_priority(), 150ul);
+  EXPECT_EQ(original.find("job-200"), nullptr);
+
+  auto updated = original;
+  updated.set(snapshot_job("job-10", 1000));
+  updated.set(snapshot_job("job-200", 200));
+  EXPECT_EQ(updated.size(), 201ul);
+  EXPECT_EQ(updated.find("job-10")->get_priority(), 1000ul);
+  EXPECT_EQ(original.find("job-10")->get_priority(), 10ul);
+  EXPECT_EQ(original.find("job-200"), nullptr);
+  EXPECT_FALSE(updated.shares_chunk(original, 10));
+  EXPECT_TRUE(updated.shares_chunk(original, 100));
+  EXPECT_EQ(&updated[100], &original[100]);
+
+  // The last job takes the place of the removed one
+  EXPECT_TRUE(updated.erase("job-5"));
+  EXPECT_FALSE(updated.erase("job-5"));
+  EXPECT_EQ(updated.size(), 200ul);
+  EXPECT_EQ(updated.find("job-5"), nullptr);
+  EXPECT_EQ(updated[5].get_id(), "job-200");
+  EXPECT_EQ(updated.find("job-200"), &updated[5]);
+  EXPECT_EQ(original[5].get_id(), "job-5");
+
+  size_t priorities = 0;
+  updated.for_each([&priorities](const swm::SwmJob &job) { priorities += job.get_priority(); });
+  EXPECT_EQ(priorities, 199ul * 200 / 2 - 5 - 10 + 1000 + 200);
+}
+
+TEST(ClusterSnapshot, copied_chunks_are_not_updated) {
+  swm::SwmSnapshotList<swm::SwmJob> list;
+  list.set(snapshot_job("job-0", 0));
+  const auto copy = list;  // the chunk was created by list before the copy
+  list.set(snapshot_job("job-0", 1));
+  EXPECT_FALSE(list.shares_chunk(copy, 0));
+  EXPECT_EQ(copy.find("job-0")->get_priority(), 0ul);
+
+  auto moved = std::move(list);
+  EXPECT_TRUE(list.empty());
+  const auto second = moved;
+  moved.set(snapshot_job("job-1", 1));
+  EXPECT_EQ(second.size(), 1ul);
+  EXPECT_EQ(second.find("job-1"), nullptr);
+  EXPECT_EQ(moved.find("job-1")->get_priority(), 1ul);
+}
+
+TEST(ClusterSnapshot, concurrent_readers) {
+  swm::SwmSnapshotPublisher publisher;
+  {
+    swm::SwmClusterSnapshot first;
+    for (uint64_t i = 0; i < 100; ++i) {
+      first.update_jobs().set(snapshot_job("job-" + std::to_string(i), 0));
+    }
+    EXPECT_EQ(publisher.publish(std::move(first)), 1ul);
+  }
+
+  // Each version sets all job priorities to the version number
+  const uint64_t versions = 200;
+  std::atomic<bool> consistent(true);
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int n = 0; n < 4; ++n) {
+    readers.emplace_back([&] {
+      while (!done) {
+        const auto snapshot = publisher.load();
+        const uint64_t expected = snapshot->get_version() == 1 ? 0 : snapshot->get_version();
+        snapshot->get_jobs().for_each([&](const swm::SwmJob &job) {
+          if (job.get_priority() != expected) {
+            consistent = false;
+          }
+        });
+      }
+    });
+  }
+  for (uint64_t version = 2; version <= versions; ++version) {
+    auto next = *publisher.load();
+    for (uint64_t i = 0; i < 100; ++i) {
+      next.update_jobs().set(snapshot_job("job-" + std::to_string(i), version));
+    }
+    EXPECT_EQ(publisher.publish(std::move(next)), version);
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_TRUE(consistent);
+  EXPECT_EQ(publisher.load()->get_version(), versions);
+  EXPECT_EQ(publisher.load()->get_jobs().size(), 100ul);
+}
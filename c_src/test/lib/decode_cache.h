@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include "wm_decode_cache.h"
+#include "wm_user.h"
+
+#include <string>
+#include <vector>
+
+static void encode_user(ei_x_buff &x, const std::string &id, const std::string &name, const uint64_t revision) {
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 7), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "user"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, id.c_str()), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, name.c_str()), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);  // acl
+  EXPECT_EQ(ei_x_encode_longlong(&x, 0), 0);  // priority
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);  // comment
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, revision), 0);
+}
+
+TEST(DecodeCache, revisions) {
+  swm::SwmDecodeCache<swm::SwmUser> cache;
+
+  ei_x_buff first;
+  EXPECT_EQ(ei_x_new(&first), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&first, 2), 0);
+  encode_user(first, "user-1", "alice", 1);
+  encode_user(first, "user-2", "bob", 1);
+  EXPECT_EQ(ei_x_encode_empty_list(&first), 0);
+
+  int index = 0;
+  std::vector<swm::SwmDecodeCache<swm::SwmUser>::EntityPtr> users;
+  EXPECT_EQ(cache.decode(first.buff, index, users), 0);
+  EXPECT_EQ(index, first.index);
+  ASSERT_EQ(users.size(), 2ul);
+  EXPECT_EQ(users[1]->get_name(), "bob");
+  EXPECT_EQ(cache.misses(), 2ul);
+  EXPECT_EQ(cache.evict_unused(), 0ul);
+
+  // Next cycle: user-1 is unchanged, user-2 is removed, user-3 is new
+  ei_x_buff second;
+  EXPECT_EQ(ei_x_new(&second), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&second, 2), 0);
+  encode_user(second, "user-1", "alice", 1);
+  encode_user(second, "user-3", "carol", 1);
+  EXPECT_EQ(ei_x_encode_empty_list(&second), 0);
+
+  index = 0;
+  std::vector<swm::SwmDecodeCache<swm::SwmUser>::EntityPtr> next_users;
+  EXPECT_EQ(cache.decode(second.buff, index, next_users), 0);
+  ASSERT_EQ(next_users.size(), 2ul);
+  EXPECT_EQ(next_users[0], users[0]);  // reused
+  EXPECT_EQ(next_users[1]->get_name(), "carol");
+  EXPECT_EQ(cache.hits(), 1ul);
+  EXPECT_EQ(cache.misses(), 3ul);
+  EXPECT_EQ(cache.evict_unused(), 1ul);
+  EXPECT_EQ(cache.size(), 2ul);
+
+  ei_x_buff third;
+  EXPECT_EQ(ei_x_new(&third), 0);
+  encode_user(third, "user-1", "alice smith", 2);
+
+  index = 0;
+  swm::SwmDecodeCache<swm::SwmUser>::EntityPtr user;
+  EXPECT_EQ(cache.decode(third.buff, index, user), 0);
+  EXPECT_EQ(user->get_name(), "alice smith");
+  EXPECT_EQ(users[0]->get_name(), "alice");  // decoded entities are not changed
+  EXPECT_EQ(cache.misses(), 4ul);
+
+  index = 1;  // not an entity
+  EXPECT_EQ(cache.decode(third.buff, index, user), -1);
+
+  // A malformed term is not cached, so it fails in every cycle
+  ei_x_buff bad;
+  EXPECT_EQ(ei_x_new(&bad), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&bad, 7), 0);
+  EXPECT_EQ(ei_x_encode_atom(&bad, "user"), 0);
+  EXPECT_EQ(ei_x_encode_string(&bad, "user-4"), 0);
+  EXPECT_EQ(ei_x_encode_string(&bad, "dave"), 0);
+  EXPECT_EQ(ei_x_encode_string(&bad, ""), 0);  // acl
+  EXPECT_EQ(ei_x_encode_string(&bad, "high"), 0);  // priority is not an integer
+  EXPECT_EQ(ei_x_encode_string(&bad, ""), 0);  // comment
+  EXPECT_EQ(ei_x_encode_ulonglong(&bad, 1), 0);
+  for (int cycle = 0; cycle < 2; ++cycle) {
+    index = 0;
+    EXPECT_EQ(cache.decode(bad.buff, index, user), -1);
+    EXPECT_EQ(cache.hits(), 1ul);
+    EXPECT_EQ(cache.size(), 2ul);
+  }
+  EXPECT_EQ(ei_x_free(&bad), 0);
+
+  EXPECT_EQ(ei_x_free(&first), 0);
+  EXPECT_EQ(ei_x_free(&second), 0);
+  EXPECT_EQ(ei_x_free(&third), 0);
+}
+
+TEST(DecodeCache, ids) {
+  swm::SwmDecodeCache<swm::SwmUser> cache;
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 1001), 0);
+  for (int i = 0; i < 1000; ++i) {
+    encode_user(x, "user-" + std::to_string(i), "user", 1);
+  }
+  // The same id as a binary is another encoded id
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 7), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "user"), 0);
+  EXPECT_EQ(ei_x_encode_binary(&x, "user-0", 6), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "binary"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);  // acl
+  EXPECT_EQ(ei_x_encode_longlong(&x, 0), 0);  // priority
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);  // comment
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 1), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+
+  for (uint64_t cycle = 1; cycle <= 2; ++cycle) {
+    int index = 0;
+    std::vector<swm::SwmDecodeCache<swm::SwmUser>::EntityPtr> users;
+    EXPECT_EQ(cache.decode(x.buff, index, users), 0);
+    ASSERT_EQ(users.size(), 1001ul);
+    EXPECT_EQ(users[0]->get_name(), "user");
+    EXPECT_EQ(users[1000]->get_name(), "binary");
+    EXPECT_EQ(cache.size(), 1001ul);
+    EXPECT_EQ(cache.misses(), 1001ul);
+    EXPECT_EQ(cache.hits(), (cycle - 1) * 1001);
+    EXPECT_EQ(cache.evict_unused(), 0ul);
+  }
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
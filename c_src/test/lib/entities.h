@@ -8,6 +8,10 @@
 #include "wm_entity_utils.h"
 #include "wm_process.h"
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 using ::testing::ElementsAre;
 
 TEST(Node, construct) {
@@ -78,6 +82,7 @@ TEST(Node, construct) {
   EXPECT_EQ(entity.get_parent(), "the parent");
   EXPECT_EQ(entity.get_state_power(), "up");
   EXPECT_EQ(entity.get_state_alloc(), "busy");
+  EXPECT_EQ(entity.get_state_power(), swm::SWM_ATOM_UP);
   EXPECT_THAT(entity.get_roles(), ElementsAre(2, 3, 4));
 
   const auto resources = entity.get_resources();
@@ -99,8 +104,72 @@ TEST(Node, construct) {
   const auto found2 = prices.find("account-2");
   EXPECT_TRUE(found1 != prices.end());
   EXPECT_TRUE(found2 != prices.end());
-  EXPECT_DOUBLE_EQ(stod(found1->second), 0.0);
-  EXPECT_DOUBLE_EQ(stod(found2->second), 42.12);
+  EXPECT_DOUBLE_EQ(found1->second.get(), 0.0);
+  EXPECT_DOUBLE_EQ(found2->second.get(), 42.12);
+  EXPECT_DOUBLE_EQ(prices.get(swm::SwmId("account-2")), 42.12);
+  EXPECT_DOUBLE_EQ(prices.get("account-3", -1.0), -1.0);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(PriceMap, decode) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_map_header(&x, 3), 0);
+  EXPECT_EQ(ei_x_encode_binary(&x, "account-b", 9), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, 7), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "account-a"), 0);
+  EXPECT_EQ(ei_x_encode_double(&x, 0.5), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "account-c"), 0);
+  EXPECT_EQ(ei_x_encode_double(&x, 2.25), 0);
+
+  int index = 0;
+  swm::SwmPriceMap prices;
+  EXPECT_EQ(swm::ei_buffer_to_price_map(x.buff, index, prices), 0);
+  EXPECT_EQ(index, x.index);
+  ASSERT_EQ(prices.size(), 3ul);
+  EXPECT_DOUBLE_EQ(prices.get("account-a"), 0.5);
+  EXPECT_DOUBLE_EQ(prices.get("account-b"), 7.0);
+  EXPECT_DOUBLE_EQ(prices.get(swm::SwmId("account-c")), 2.25);
+  EXPECT_TRUE(prices.find("account-b")->second.is_integer());
+  for (auto it = prices.begin(); it + 1 != prices.end(); ++it) {
+    EXPECT_LT(it->first, (it + 1)->first);
+  }
+
+  prices.set("account-a", 1.0);
+  prices.set("account-d", 3.0);
+  EXPECT_EQ(prices.size(), 4ul);
+  EXPECT_DOUBLE_EQ(prices.get("account-a"), 1.0);
+  EXPECT_TRUE(prices.find("account-e") == prices.end());
+
+  index = 1;  // not a map
+  EXPECT_EQ(swm::ei_buffer_to_price_map(x.buff, index, prices), -1);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(PriceMap, encode_keeps_value_types) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_map_header(&x, 2), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "7873a946-d85d-11ec-8529-6fdf37248ceb"), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, INT64_MAX), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "7873a946-d85d-11ec-8529-6fdf37248cec"), 0);
+  EXPECT_EQ(ei_x_encode_double(&x, 2.5), 0);
+
+  const size_t ids_count = swm::swm_ids_count();
+  int index = 0;
+  swm::SwmPriceMap prices;
+  EXPECT_EQ(swm::ei_buffer_to_price_map(x.buff, index, prices), 0);
+  EXPECT_EQ(swm::swm_ids_count(), ids_count);  // UUID keys are not interned
+  EXPECT_EQ(prices.find("7873a946-d85d-11ec-8529-6fdf37248ceb")->second.get_int(), INT64_MAX);
+
+  int size = 0;
+  swm::encode_price_map(nullptr, size, prices);
+  std::vector<char> buf(static_cast<size_t>(size));
+  int encoded = 0;
+  swm::encode_price_map(buf.data(), encoded, prices);
+  EXPECT_EQ(std::string(buf.data(), buf.size()), std::string(x.buff, static_cast<size_t>(x.index)));
 
   EXPECT_EQ(ei_x_free(&x), 0);
 }
@@ -206,6 +275,40 @@ TEST(Process, construct) {
   EXPECT_EQ(entity.get_comment(), "comment");
 }
 
+TEST(Process, field_mask) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 6), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "process"), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, 45521), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "R"), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, -1), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, 9), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "comment"), 0);
+
+  int index = 0;
+  auto entity = swm::SwmProcess(x.buff, index, swm::SwmProcess::FIELD_STATE | swm::SwmProcess::FIELD_SIGNAL);
+  EXPECT_EQ(index, x.index);
+  EXPECT_EQ(entity.get_state(), "R");
+  EXPECT_EQ(entity.get_signal(), 9);
+  EXPECT_TRUE(entity.get_comment().empty());
+  EXPECT_EQ(entity.get_lazy_fields(), swm::SwmProcess::FIELD_PID |
+                                      swm::SwmProcess::FIELD_EXITCODE |
+                                      swm::SwmProcess::FIELD_COMMENT);
+
+  EXPECT_EQ(entity.decode_fields(swm::SwmProcess::FIELD_COMMENT), 0);
+  EXPECT_EQ(entity.get_comment(), "comment");
+  entity.set_exitcode(3);  // the value set is kept
+  EXPECT_EQ(entity.get_lazy_fields(), swm::SwmProcess::FIELD_PID);
+  EXPECT_EQ(entity.decode_fields(swm::SwmProcess::FIELD_ALL), 0);
+  EXPECT_EQ(entity.get_pid(), 45521);
+  EXPECT_EQ(entity.get_exitcode(), 3);
+  EXPECT_EQ(entity.get_lazy_fields(), 0ul);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
 TEST(Job, construct) {
   static const int entity_tuple_arity = 34;
 
@@ -225,6 +328,7 @@ TEST(Job, construct) {
   }
   EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
   EXPECT_EQ(ei_x_encode_string(&x, "Q"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "Waiting for resources"), 0);  // state_details
   EXPECT_EQ(ei_x_encode_string(&x, "2022-05-22T20:01:48"), 0);
   EXPECT_EQ(ei_x_encode_string(&x, "2022-05-22T20:00:34"), 0);
   EXPECT_EQ(ei_x_encode_string(&x, "2022-05-22T20:02:00"), 0);
@@ -269,7 +373,6 @@ TEST(Job, construct) {
     }
   }
   EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
-  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);  // projects
   EXPECT_EQ(ei_x_encode_string(&x, "account-id-2"), 0);
   EXPECT_EQ(ei_x_encode_string(&x, "gang-id-4"), 0);
   EXPECT_EQ(ei_x_encode_string(&x, "/home/dude/exec1"), 0);
@@ -339,6 +442,7 @@ TEST(Job, construct) {
   EXPECT_EQ(entity.get_cluster_id(), "cluster-id");
   EXPECT_THAT(entity.get_nodes(), ElementsAre("node-id-1", "node-id-2", "node-id-3"));
   EXPECT_EQ(entity.get_state(), "Q");
+  EXPECT_EQ(entity.get_state_details(), "Waiting for resources");
   EXPECT_EQ(entity.get_start_time(), "2022-05-22T20:01:48");
   EXPECT_EQ(entity.get_submit_time(), "2022-05-22T20:00:34");
   EXPECT_EQ(entity.get_end_time(), "2022-05-22T20:02:00");
@@ -353,7 +457,6 @@ TEST(Job, construct) {
   EXPECT_THAT(entity.get_hooks(), ElementsAre("hook-id-1"));
   EXPECT_THAT(entity.get_env(), ElementsAre(std::pair("HOME", "/home/dude")));
   EXPECT_THAT(entity.get_deps(), ElementsAre(std::pair("ok", "job-id-42")));
-  EXPECT_TRUE(entity.get_projects().empty());
   EXPECT_EQ(entity.get_account_id(), "account-id-2");
   EXPECT_EQ(entity.get_gang_id(), "gang-id-4");
   EXPECT_EQ(entity.get_execution_path(), "/home/dude/exec1");
@@ -378,8 +481,7 @@ TEST(Job, construct) {
   EXPECT_EQ(std::get<0>(props[0]), "value");
 
   std::string value;
-  auto tmp_buf = std::get<1>(props[0]);
-  ASSERT_EQ(swm::ei_buffer_to_str(tmp_buf, value), 0);
+  ASSERT_EQ(std::get<1>(props[0]).get_str(value), 0);
   EXPECT_EQ(value, "m1.tiny");
 
   EXPECT_TRUE(entity.get_resources().empty());
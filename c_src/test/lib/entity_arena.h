@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "wm_resource.h"
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+
+namespace {
+
+void encode_resource(ei_x_buff &x, const std::string &name, const int children) {
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 8), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "resource"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, name.c_str()), 0);
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 64), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 1), 0);  // hooks
+  EXPECT_EQ(ei_x_encode_string(&x, "a-hook-id-long-enough-to-be-allocated"), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);  // properties
+  EXPECT_EQ(ei_x_encode_map_header(&x, 1), 0);  // prices
+  EXPECT_EQ(ei_x_encode_string(&x, "an-account-id-long-enough-to-be-allocated"), 0);
+  EXPECT_EQ(ei_x_encode_double(&x, 1.5), 0);
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 0), 0);  // usage time
+  if (children) {
+    EXPECT_EQ(ei_x_encode_list_header(&x, children), 0);
+    for (int i = 0; i < children; ++i) {
+      encode_resource(x, name + "-child-" + std::to_string(i), 0);
+    }
+  }
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+}
+
+} // namespace
+
+TEST(EntityArena, decode_into_arena) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 2), 0);
+  encode_resource(x, "the-first-resource-with-a-long-name", 2);
+  encode_resource(x, "the-second-resource-with-a-long-name", 1);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+
+  std::array<std::byte, 32768> storage;
+  std::pmr::monotonic_buffer_resource arena(storage.data(), storage.size(), std::pmr::null_memory_resource());
+
+  // Any allocation outside of the arena throws while the list is decoded
+  const auto previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+  std::pmr::vector<swm::SwmResource> resources(&arena);
+  int index = 0;
+  const int result = swm::ei_buffer_to_resource(x.buff, index, resources);
+  std::pmr::set_default_resource(previous);
+
+  EXPECT_EQ(result, 0);
+  EXPECT_EQ(index, x.index);
+  ASSERT_EQ(resources.size(), 2ul);
+  EXPECT_EQ(resources[0].get_allocator().resource(), &arena);
+  EXPECT_EQ(resources[0].get_name(), "the-first-resource-with-a-long-name");
+  EXPECT_EQ(resources[1].get_name(), "the-second-resource-with-a-long-name");
+
+  const auto children = resources[0].get_resources();
+  ASSERT_EQ(children.size(), 2ul);
+  EXPECT_EQ(children[1].get_name(), "the-first-resource-with-a-long-name-child-1");
+  EXPECT_EQ(children[1].get_hooks().size(), 1ul);
+  EXPECT_EQ(children[1].get_prices().size(), 1ul);
+
+  // Copy out of the arena before it is released
+  const swm::SwmResource copy(resources[1], std::pmr::get_default_resource());
+  EXPECT_EQ(copy.get_allocator().resource(), std::pmr::get_default_resource());
+  EXPECT_EQ(copy.get_name(), "the-second-resource-with-a-long-name");
+  EXPECT_EQ(copy.get_resources().size(), 1ul);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityArena, accessors_and_builders) {
+  std::array<std::byte, 8192> storage;
+  std::pmr::monotonic_buffer_resource arena(storage.data(), storage.size(), std::pmr::null_memory_resource());
+
+  // Entities are built in place, nothing is allocated outside of the arena
+  const auto previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+  swm::SwmResource node(&arena);
+  node.set_name(std::pmr::string("node-with-a-long-enough-name", &arena));
+  for (const auto name : {"cpus", "mem", "gpus"}) {
+    auto &child = node.emplace_resources();
+    child.set_name(std::pmr::string(name, &arena));
+    child.emplace_hooks("hook-with-a-long-enough-name");
+  }
+
+  // Reading through the getters does not copy
+  size_t hooks = 0;
+  for (const auto &child : node.get_resources()) {
+    hooks += child.get_hooks().size();
+  }
+  std::pmr::set_default_resource(previous);
+
+  EXPECT_EQ(hooks, 3ul);
+  EXPECT_EQ(node.get_name(), "node-with-a-long-enough-name");
+  ASSERT_EQ(node.get_resources().size(), 3ul);
+  EXPECT_EQ(node.get_resources()[2].get_allocator().resource(), &arena);
+  EXPECT_EQ(node.get_resources()[2].get_name(), "gpus");
+  EXPECT_EQ(&node.get_resources(), &node.get_resources());
+}
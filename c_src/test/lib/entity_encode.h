@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include "wm_etf_writer.h"
+#include "wm_job.h"
+#include "wm_process.h"
+#include "wm_resource.h"
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+TEST(EtfWriter, scalars) {
+  const std::string long_str(70000, 'z');
+  const int64_t numbers[] = {0, 255, 256, -1, INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN};
+
+  int size = 0;
+  swm::etf_encode_str(nullptr, size, long_str);
+  for (const auto n : numbers) {
+    swm::etf_encode_int64(nullptr, size, n);
+  }
+  swm::etf_encode_uint64(nullptr, size, UINT64_MAX);
+  swm::etf_encode_double(nullptr, size, -2.5);
+  swm::etf_encode_atom(nullptr, size, "an_atom");
+
+  std::vector<char> buf(static_cast<size_t>(size));
+  int index = 0;
+  swm::etf_encode_str(buf.data(), index, long_str);
+  for (const auto n : numbers) {
+    swm::etf_encode_int64(buf.data(), index, n);
+  }
+  swm::etf_encode_uint64(buf.data(), index, UINT64_MAX);
+  swm::etf_encode_double(buf.data(), index, -2.5);
+  swm::etf_encode_atom(buf.data(), index, "an_atom");
+  EXPECT_EQ(index, size);
+
+  index = 0;
+  std::string s;
+  EXPECT_EQ(swm::etf_decode_str(buf.data(), index, s), 0);
+  EXPECT_EQ(s, long_str);
+  for (const auto n : numbers) {
+    int64_t x = 0;
+    EXPECT_EQ(swm::etf_decode_int64(buf.data(), index, x), 0);
+    EXPECT_EQ(x, n);
+  }
+  uint64_t u = 0;
+  EXPECT_EQ(swm::etf_decode_uint64(buf.data(), index, u), 0);
+  EXPECT_EQ(u, UINT64_MAX);
+  double d = 0.0;
+  EXPECT_EQ(swm::etf_decode_double(buf.data(), index, d), 0);
+  EXPECT_DOUBLE_EQ(d, -2.5);
+  std::string a;
+  EXPECT_EQ(swm::etf_decode_atom(buf.data(), index, a), 0);
+  EXPECT_EQ(a, "an_atom");
+  EXPECT_EQ(index, size);
+}
+
+TEST(EntityEncode, round_trip) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 8), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "resource"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "mem"), 0);
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 128000000000), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 1), 0);  // hooks
+  EXPECT_EQ(ei_x_encode_string(&x, "hook-1"), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 1), 0);  // properties
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 2), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "value"), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 2), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "any"), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, -7), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+  EXPECT_EQ(ei_x_encode_map_header(&x, 1), 0);  // prices
+  EXPECT_EQ(ei_x_encode_string(&x, "account-1"), 0);
+  EXPECT_EQ(ei_x_encode_double(&x, 0.25), 0);
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 10), 0);  // usage time
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);  // resources
+
+  int index = 0;
+  swm::SwmResource resource(x.buff, index);
+  std::vector<swm::SwmResource> resources{resource, resource};
+  resources[1].set_resources(std::pmr::vector<swm::SwmResource>(1, resource));
+
+  ei_x_buff encoded;
+  EXPECT_EQ(ei_x_new(&encoded), 0);
+  EXPECT_EQ(swm::encode_resource(encoded, resources), 0);
+  EXPECT_EQ(encoded.index, encoded.buffsz);  // exactly sized
+
+  index = 0;
+  std::vector<swm::SwmResource> decoded;
+  EXPECT_EQ(swm::ei_buffer_to_resource(encoded.buff, index, decoded), 0);
+  EXPECT_EQ(index, encoded.index);
+  ASSERT_EQ(decoded.size(), 2ul);
+  EXPECT_EQ(decoded[0].get_name(), "mem");
+  EXPECT_EQ(decoded[0].get_count(), 128000000000ul);
+  EXPECT_EQ(decoded[0].get_hooks().size(), 1ul);
+  EXPECT_DOUBLE_EQ(decoded[0].get_prices().get("account-1"), 0.25);
+  ASSERT_EQ(decoded[1].get_resources().size(), 1ul);
+  EXPECT_EQ(decoded[1].get_resources()[0].get_usage_time(), 10ul);
+
+  const auto properties = decoded[0].get_properties();
+  ASSERT_EQ(properties.size(), 1ul);
+  EXPECT_EQ(properties[0].first, "value");
+  int property_index = 0;
+  int arity = 0;
+  EXPECT_EQ(swm::etf_decode_tuple_header(properties[0].second.data(), property_index, arity), 0);
+  EXPECT_EQ(arity, 2);
+
+  // Encoding of the decoded entities gives the same term
+  ei_x_buff reencoded;
+  EXPECT_EQ(ei_x_new(&reencoded), 0);
+  EXPECT_EQ(swm::encode_resource(reencoded, decoded), 0);
+  ASSERT_EQ(reencoded.index, encoded.index);
+  EXPECT_EQ(std::string(reencoded.buff, reencoded.index), std::string(encoded.buff, encoded.index));
+
+  EXPECT_EQ(ei_x_free(&reencoded), 0);
+  EXPECT_EQ(ei_x_free(&encoded), 0);
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityEncode, process) {
+  swm::SwmProcess process;
+  process.set_pid(-1);
+  process.set_state("R");
+  process.set_exitcode(0);
+  process.set_signal(9);
+  process.set_comment("");
+
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new_with_version(&x), 0);
+  EXPECT_EQ(process.encode(x), 0);
+
+  int index = 0;
+  int version = 0;
+  EXPECT_EQ(ei_decode_version(x.buff, &index, &version), 0);
+  const swm::SwmProcess decoded(x.buff, index);
+  EXPECT_EQ(index, x.index);
+  EXPECT_EQ(decoded.get_pid(), -1);
+  EXPECT_EQ(decoded.get_state(), "R");
+  EXPECT_EQ(decoded.get_signal(), 9);
+  EXPECT_EQ(decoded.get_comment(), "");
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityFields, table) {
+  EXPECT_STREQ(swm::SwmJob::ENTITY_NAME, "job");
+  EXPECT_EQ(std::size(swm::SwmJob::FIELDS_INFO), static_cast<size_t>(swm::SwmJob::FIELDS_COUNT));
+  EXPECT_STREQ(swm::SwmJob::FIELDS_INFO[0].name, "id");
+  EXPECT_STREQ(swm::SwmJob::FIELDS_INFO[swm::entity_field_pos(swm::SwmJob::FIELD_PRIORITY)].name, "priority");
+
+  swm::SwmJob job;
+  job.set_priority(7);
+  const auto &info = swm::SwmJob::FIELDS_INFO[swm::entity_field_pos(swm::SwmJob::FIELD_PRIORITY)];
+  EXPECT_EQ(*static_cast<const uint64_t*>(info.value(job)), 7u);
+
+  int size = 0;
+  info.encode(nullptr, size, info.value(job));
+  std::vector<char> buf(static_cast<size_t>(size));
+  int index = 0;
+  info.encode(buf.data(), index, info.value(job));
+  EXPECT_EQ(index, size);
+
+  swm::SwmJob other;
+  index = 0;
+  EXPECT_EQ(info.decode(buf.data(), index, const_cast<void*>(info.value(other))), 0);
+  EXPECT_EQ(other.get_priority(), 7u);
+}
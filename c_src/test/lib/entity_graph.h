@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include "wm_entity_graph.h"
+
+#include <string>
+#include <vector>
+
+TEST(EntityGraph, resolve) {
+  swm::SwmGrid grid;
+  grid.set_clusters({"c1", "unknown"});
+  std::vector<swm::SwmCluster> clusters(1);
+  clusters[0].set_id(swm::SwmId("c1"));
+  clusters[0].set_partitions({"p2", "p1"});
+
+  std::vector<swm::SwmPartition> partitions(2);
+  partitions[0].set_id(swm::SwmId("p1"));
+  partitions[0].set_nodes({"n1", "n2"});
+  partitions[1].set_id(swm::SwmId("p2"));
+  partitions[1].set_partitions({"p1"});
+  partitions[1].set_nodes({"n3"});
+
+  std::vector<swm::SwmNode> nodes(3);
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i].set_id(swm::SwmId("n" + std::to_string(i + 1)));
+    nodes[i].set_name(std::pmr::string("node" + std::to_string(i + 1)));
+  }
+  nodes[1].set_parent("node1");
+  nodes[2].set_parent("node1");
+
+  std::vector<swm::SwmJob> jobs(2);
+  jobs[0].set_id(swm::SwmId("j1"));
+  jobs[0].set_nodes({"n3", "n1"});
+  jobs[1].set_id(swm::SwmId("j2"));
+  std::vector<swm::SwmTimetable> timetable(1);
+  timetable[0].set_job_id("j1");
+  timetable[0].set_job_nodes({"n3"});
+
+  swm::SwmEntityGraph graph;
+  ASSERT_EQ(graph.resolve(grid, clusters, partitions, nodes, jobs, timetable), 0);
+  EXPECT_EQ(graph.get_unresolved(), 1ul);  // the unknown cluster
+  ASSERT_EQ(graph.get_grid_clusters().size(), 1ul);
+  EXPECT_EQ(graph.get_grid_clusters()[0], 0u);
+
+  const auto cluster_partitions = graph.get_cluster_partitions(0);
+  EXPECT_EQ(std::vector<uint32_t>(cluster_partitions.begin(), cluster_partitions.end()), (std::vector<uint32_t>{1, 0}));
+  EXPECT_EQ(graph.get_partition_ids().str(graph.get_partition_partitions(1)[0]), "p1");
+  EXPECT_EQ(graph.get_partition_nodes(0).size(), 2ul);
+  EXPECT_TRUE(graph.get_partition_partitions(0).empty());
+
+  EXPECT_EQ(graph.get_node_parent(0), swm::SWM_NO_INDEX);
+  EXPECT_EQ(graph.get_node_parent(2), 0u);
+  const auto job_nodes = graph.get_job_nodes(0);
+  EXPECT_EQ(std::vector<uint32_t>(job_nodes.begin(), job_nodes.end()), (std::vector<uint32_t>{2, 0}));
+  EXPECT_TRUE(graph.get_job_nodes(1).empty());
+  EXPECT_EQ(graph.get_timetable_job(0), 0u);
+  EXPECT_EQ(graph.get_timetable_nodes(0)[0], 2u);
+
+  EXPECT_EQ(graph.get_node_ids().find("n2"), 1u);
+  EXPECT_EQ(graph.get_node_ids().find("n4"), swm::SWM_NO_INDEX);
+  EXPECT_EQ(graph.get_job_ids().str(1), "j2");
+
+  // Ids must be unique
+  nodes[2].set_id(swm::SwmId("n1"));
+  EXPECT_EQ(graph.resolve(grid, clusters, partitions, nodes, jobs), -1);
+  EXPECT_EQ(graph.get_node_ids().size(), 0ul);
+}
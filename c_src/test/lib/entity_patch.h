@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "wm_job.h"
+#include "wm_node.h"
+#include "wm_process.h"
+
+TEST(EntityPatch, diff_and_apply) {
+  swm::SwmJob old_job;
+  old_job.set_id(swm::SwmId("job-1"));
+  old_job.set_state("Q");
+  old_job.set_nodes({"node-1"});
+  old_job.set_revision(7);
+
+  auto new_job = old_job;
+  new_job.set_state("R");
+  new_job.set_nodes({"node-1", "node-2"});
+  new_job.set_revision(8);
+
+  const auto patch = swm::SwmJob::diff(old_job, new_job);
+  EXPECT_EQ(patch.get_entity(), "job");
+  EXPECT_EQ(patch.get_revision(), 7ul);
+  EXPECT_EQ(patch.size(), 3ul);
+  EXPECT_TRUE(swm::SwmJob::diff(new_job, new_job).empty());
+
+  // The patch is sent as a term
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(patch.encode(x), 0);
+  int index = 0;
+  swm::SwmPatch decoded;
+  EXPECT_EQ(decoded.decode(x.buff, index), 0);
+  EXPECT_EQ(index, x.index);
+  EXPECT_EQ(decoded.size(), 3ul);
+  EXPECT_EQ(ei_x_free(&x), 0);
+
+  auto job = old_job;
+  EXPECT_EQ(job.apply(decoded), 0);
+  EXPECT_EQ(job.get_state(), "R");
+  EXPECT_EQ(job.get_nodes().size(), 2ul);
+  EXPECT_EQ(job.get_revision(), 8ul);
+  EXPECT_EQ(job.get_id(), "job-1");
+
+  // The patch is made against revision 7
+  EXPECT_EQ(job.apply(decoded), -1);
+  EXPECT_EQ(job.get_revision(), 8ul);
+  swm::SwmNode node;
+  EXPECT_EQ(node.apply(decoded), -1);
+}
+
+TEST(EntityPatch, lazy_fields) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 6), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "process"), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, 45521), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "R"), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, -1), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, 9), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "comment"), 0);
+
+  int index = 0;
+  const swm::SwmProcess lazy(x.buff, index, swm::SwmProcess::FIELD_STATE);
+  ASSERT_NE(lazy.get_lazy_fields(), 0ul);
+  index = 0;
+  auto changed = swm::SwmProcess(x.buff, index);
+  changed.set_comment("changed");
+
+  // Lazy fields are not compared as their default values
+  const auto patch = swm::SwmProcess::diff(lazy, changed);
+  EXPECT_EQ(patch.get_entity(), "process");
+  EXPECT_EQ(patch.size(), 1ul);
+
+  // The patched field is not replaced by the buffer value later
+  auto process = lazy;
+  EXPECT_EQ(process.apply(patch), 0);
+  EXPECT_EQ(process.get_lazy_fields(), 0ul);
+  EXPECT_EQ(process.get_comment(), "changed");
+  EXPECT_EQ(process.get_pid(), 45521);
+  EXPECT_EQ(process.decode_fields(swm::SwmProcess::FIELD_ALL), 0);
+  EXPECT_EQ(process.get_comment(), "changed");
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include "wm_entity_table.h"
+#include "wm_job.h"
+#include "wm_node.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+static swm::SwmResource make_resource(const char* name, const uint64_t count) {
+  swm::SwmResource resource;
+  resource.set_name(name);
+  resource.set_count(count);
+  return resource;
+}
+
+TEST(EntityTable, jobs) {
+  std::vector<swm::SwmJob> jobs(3);
+  jobs[0].set_id(swm::SwmId("job-1"));
+  jobs[0].set_state("Q");
+  jobs[0].set_submit_time("2022-5-2T8:0:4");  // local time from wm_utils:now_iso8601/1
+  jobs[0].set_priority(10);
+  jobs[0].set_request({make_resource("node", 2), make_resource("cpus", 8)});
+  jobs[1].set_id(swm::SwmId("job-2"));
+  jobs[1].set_state("R");
+  jobs[1].set_priority(20);
+  jobs[2].set_id(swm::SwmId("job-3"));
+  jobs[2].set_state("Q");
+  jobs[2].set_submit_time("2022-05-22T20:00:34.512");
+  jobs[2].set_request({make_resource("mem", 1024), make_resource("cpus", 2), make_resource("cpus", 2)});
+
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(swm::encode_job(x, jobs), 0);
+
+  // Decoded in a fixed time zone 3 hours east of UTC
+  const char* tz = std::getenv("TZ");
+  const std::string old_tz = tz ? tz : "";
+  setenv("TZ", "SWM-3", 1);
+  tzset();
+  int index = 0;
+  swm::SwmJobTable table;
+  EXPECT_EQ(swm::ei_buffer_to_job(x.buff, index, table), 0);
+  if (tz) {
+    setenv("TZ", old_tz.c_str(), 1);
+  } else {
+    unsetenv("TZ");
+  }
+  tzset();
+  EXPECT_EQ(index, x.index);
+  ASSERT_EQ(table.size(), 3ul);
+  EXPECT_EQ(table.get_id(0), "job-1");
+  EXPECT_EQ(table.get_id(2), "job-3");
+  EXPECT_EQ(table.get_states()[1], "R");
+  EXPECT_EQ(table.get_states()[0], table.get_states()[2]);
+  EXPECT_EQ(table.get_priorities()[1], 20ul);
+  EXPECT_EQ(table.get_submit_times()[0], 1651478404 - 3 * 3600);
+  EXPECT_EQ(table.get_submit_times()[1], 0);
+  EXPECT_EQ(table.get_submit_times()[2], 1653249634 - 3 * 3600);
+
+  EXPECT_EQ(table.get_request_names().size(), 3ul);
+  const uint64_t* cpus = table.get_request_counts(swm::SwmAtom("cpus"));
+  ASSERT_NE(cpus, nullptr);
+  EXPECT_EQ(cpus[0], 8ul);
+  EXPECT_EQ(cpus[1], 0ul);
+  EXPECT_EQ(cpus[2], 4ul);
+  const uint64_t* nodes = table.get_request_counts(swm::SwmAtom("node"));
+  ASSERT_NE(nodes, nullptr);
+  EXPECT_EQ(nodes[2], 0ul);
+  EXPECT_EQ(table.get_request_counts(swm::SwmAtom("gpus")), nullptr);
+
+  index = 1;  // not a list
+  EXPECT_EQ(swm::ei_buffer_to_job(x.buff, index, table), -1);
+  EXPECT_EQ(table.size(), 0ul);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityTable, nodes) {
+  std::vector<swm::SwmNode> nodes(2);
+  nodes[0].set_id(swm::SwmId("node-1"));
+  nodes[0].set_name("node001");
+  nodes[0].set_state_power(swm::SWM_ATOM_UP);
+  nodes[0].set_state_alloc(swm::SWM_ATOM_IDLE);
+  nodes[0].set_resources({make_resource("cpus", 32), make_resource("mem", 64000)});
+  nodes[1].set_id(swm::SwmId("node-2"));
+  nodes[1].set_name("node002");
+  nodes[1].set_state_power(swm::SWM_ATOM_DOWN);
+  nodes[1].set_state_alloc(swm::SWM_ATOM_IDLE);
+
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(swm::encode_node(x, nodes), 0);
+
+  int index = 0;
+  swm::SwmNodeTable table;
+  EXPECT_EQ(swm::ei_buffer_to_node(x.buff, index, table), 0);
+  ASSERT_EQ(table.size(), 2ul);
+  EXPECT_EQ(table.get_name(1), "node002");
+  EXPECT_EQ(table.get_states_power()[0], swm::SWM_ATOM_UP);
+  EXPECT_EQ(table.get_states_power()[1], swm::SWM_ATOM_DOWN);
+  EXPECT_EQ(table.get_states_alloc()[1], swm::SWM_ATOM_IDLE);
+  const uint64_t* mem = table.get_resource_counts(swm::SwmAtom("mem"));
+  ASSERT_NE(mem, nullptr);
+  EXPECT_EQ(mem[0], 64000ul);
+  EXPECT_EQ(mem[1], 0ul);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityTable, resource_tree) {
+  auto socket = make_resource("socket", 1);
+  socket.set_resources({make_resource("cores", 8), make_resource("gpus", 1)});
+  auto gpu_socket = make_resource("socket", 1);
+  gpu_socket.set_resources({make_resource("cores", 4), make_resource("gpus", 2)});
+  std::vector<swm::SwmNode> nodes(2);
+  nodes[0].set_id(swm::SwmId("node-1"));
+  nodes[0].set_resources({socket, gpu_socket, make_resource("mem", 64000)});
+  nodes[1].set_id(swm::SwmId("node-2"));
+
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(swm::encode_node(x, nodes), 0);
+
+  int index = 0;
+  swm::SwmNodeTable table;
+  EXPECT_EQ(swm::ei_buffer_to_node(x.buff, index, table), 0);
+  const auto &tree = table.get_resource_tree();
+  ASSERT_EQ(tree.rows(), 2ul);
+  ASSERT_EQ(tree.size(), 7ul);
+  EXPECT_EQ(tree.get_row_begin(1), tree.get_row_end(1));  // no resources
+
+  // socket, cores, gpus, socket, cores, gpus, mem
+  const swm::SwmAtom gpus("gpus");
+  EXPECT_EQ(tree.get_names()[0], "socket");
+  EXPECT_EQ(tree.get_names()[6], "mem");
+  EXPECT_EQ(tree.get_end(0), 3u);
+  EXPECT_EQ(tree.get_end(3), 6u);
+  EXPECT_EQ(tree.get_parent(0), swm::SWM_NO_INDEX);
+  EXPECT_EQ(tree.get_parent(5), 3u);
+  EXPECT_EQ(tree.get_row_sum(0, gpus), 3ul);
+  EXPECT_EQ(tree.get_subtree_sum(3, gpus), 2ul);
+  EXPECT_EQ(tree.get_row_sum(1, gpus), 0ul);
+  std::vector<uint32_t> children;
+  tree.for_each_child(3, [&children](const uint32_t child) { children.push_back(child); });
+  EXPECT_EQ(children, std::vector<uint32_t>({4, 5}));
+
+  // The columns keep the top level counts only
+  const uint64_t* sockets = table.get_resource_counts(swm::SwmAtom("socket"));
+  ASSERT_NE(sockets, nullptr);
+  EXPECT_EQ(sockets[0], 2ul);
+  EXPECT_EQ(table.get_resource_counts(gpus), nullptr);
+  EXPECT_EQ(ei_x_free(&x), 0);
+
+  // A resource list alone
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(swm::encode_resource(x, nodes[0].get_resources()), 0);
+  index = 0;
+  swm::SwmResourceTree list_tree;
+  EXPECT_EQ(swm::ei_buffer_to_resource(x.buff, index, list_tree), 0);
+  EXPECT_EQ(index, x.index);
+  EXPECT_EQ(list_tree.get_names(), tree.get_names());
+  EXPECT_EQ(list_tree.get_counts(), tree.get_counts());
+  index = 1;
+  EXPECT_EQ(swm::ei_buffer_to_resource(x.buff, index, list_tree), -1);
+  EXPECT_EQ(list_tree.size(), 0ul);
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
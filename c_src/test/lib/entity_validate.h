@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+
+#include "wm_job.h"
+#include "wm_resource.h"
+#include "wm_user.h"
+
+#include <string>
+#include <vector>
+
+static void encode_user_term(ei_x_buff &x, const char* id, const long long priority) {
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 7), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "user"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, id), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "name"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);  // acl
+  EXPECT_EQ(ei_x_encode_longlong(&x, priority), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);  // comment
+  EXPECT_EQ(ei_x_encode_ulong(&x, 1), 0);  // revision
+}
+
+TEST(EntityValidate, unchecked_decode) {
+  swm::SwmResource cpus;
+  cpus.set_name("cpus");
+  cpus.set_count(8);
+  swm::SwmResource node;
+  node.set_name("node");
+  node.set_count(2);
+  node.set_resources({cpus});
+
+  swm::SwmJob job;
+  job.set_id(swm::SwmId("job-1"));
+  job.set_nodes({"node-1", "node-2"});
+  job.set_state("Q");
+  job.set_env({{"HOME", "/home/user"}});
+  job.set_deps({{"finished", "job-0"}});
+  job.set_script_content(std::pmr::string(70000, 's'));
+  job.set_request({node});
+  job.set_relocatable(swm::SwmAtom("true"));
+  job.set_priority(300);
+  job.set_revision(UINT64_MAX);
+
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(job.encode(x), 0);
+
+  int index = 0;
+  EXPECT_EQ(swm::SwmJob::validate(x.buff, index), 0);
+  EXPECT_EQ(index, x.index);
+
+  index = 0;
+  const swm::SwmJob decoded(x.buff, index, swm::swm_unchecked);
+  EXPECT_EQ(index, x.index);
+  EXPECT_EQ(decoded.get_id(), "job-1");
+  EXPECT_EQ(decoded.get_nodes(), job.get_nodes());
+  EXPECT_EQ(decoded.get_env(), job.get_env());
+  EXPECT_EQ(decoded.get_deps(), job.get_deps());
+  EXPECT_EQ(decoded.get_script_content(), job.get_script_content());
+  ASSERT_EQ(decoded.get_request().size(), 1ul);
+  EXPECT_EQ(decoded.get_request()[0].get_count(), 2ul);
+  ASSERT_EQ(decoded.get_request()[0].get_resources().size(), 1ul);
+  EXPECT_EQ(decoded.get_request()[0].get_resources()[0].get_name(), "cpus");
+  EXPECT_EQ(decoded.get_relocatable(), swm::SwmAtom("true"));
+  EXPECT_EQ(decoded.get_priority(), 300ul);
+  EXPECT_EQ(decoded.get_revision(), UINT64_MAX);
+
+  index = 0;
+  const swm::SwmJob masked(x.buff, index, swm::swm_unchecked, swm::SwmJob::FIELD_ID);
+  EXPECT_EQ(index, x.index);
+  EXPECT_EQ(masked.get_id(), "job-1");
+  EXPECT_EQ(masked.get_lazy_fields(), swm::SwmJob::FIELD_ALL & ~swm::SwmJob::FIELD_ID);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityValidate, error_offset) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 2), 0);
+  encode_user_term(x, "user-1", -5);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 7), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "user"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "user-2"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "name"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);
+  const int bad_offset = x.index;
+  EXPECT_EQ(ei_x_encode_string(&x, "high"), 0);  // priority is not an integer
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);
+  EXPECT_EQ(ei_x_encode_ulong(&x, 1), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+
+  int index = 0;
+  EXPECT_EQ(swm::entity_list_validate<swm::SwmUser>(x.buff, index), -1);
+  EXPECT_EQ(index, bad_offset);
+
+  // Valid list of users
+  EXPECT_EQ(ei_x_free(&x), 0);
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 2), 0);
+  encode_user_term(x, "user-1", -5);
+  encode_user_term(x, "user-2", 1LL << 40);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+
+  index = 0;
+  EXPECT_EQ(swm::entity_list_validate<swm::SwmUser>(x.buff, index), 0);
+  EXPECT_EQ(index, x.index);
+  index = 0;
+  std::vector<swm::SwmUser> users;
+  swm::entity_list_decode_unchecked(x.buff, index, users);
+  EXPECT_EQ(index, x.index);
+  ASSERT_EQ(users.size(), 2ul);
+  EXPECT_EQ(users[0].get_priority(), -5);
+  EXPECT_EQ(users[1].get_id(), "user-2");
+  EXPECT_EQ(users[1].get_priority(), 1LL << 40);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityValidate, small_int_list) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "\x01\x02\x03"), 0);  // erlang encodes [1,2,3] so
+
+  int index = 0;
+  EXPECT_EQ(swm::SwmListTerm<swm::SwmUint64Term>::validate(x.buff, index), 0);
+  EXPECT_EQ(index, x.index);
+  index = 0;
+  EXPECT_EQ(swm::SwmListTerm<swm::SwmDoubleTerm>::validate(x.buff, index), -1);
+  EXPECT_EQ(index, 0);
+
+  index = 0;
+  std::vector<uint64_t> numbers;
+  swm::SwmListTerm<swm::SwmUint64Term>::decode(x.buff, index, numbers);
+  EXPECT_EQ(index, x.index);
+  EXPECT_EQ(numbers, std::vector<uint64_t>({1, 2, 3}));
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityValidate, undefined_strings) {
+  // Record fields that were never set in erlang
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 7), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "user"), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "undefined"), 0);  // id
+  EXPECT_EQ(ei_x_encode_atom(&x, "undefined"), 0);  // name
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);  // acl
+  EXPECT_EQ(ei_x_encode_longlong(&x, 5), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, 0), 0);  // comment
+  EXPECT_EQ(ei_x_encode_ulong(&x, 1), 0);
+
+  int index = 0;
+  EXPECT_EQ(swm::SwmUser::validate(x.buff, index), 0);
+  EXPECT_EQ(index, x.index);
+
+  index = 0;
+  const swm::SwmUser checked(x.buff, index);
+  EXPECT_EQ(index, x.index);
+  index = 0;
+  const swm::SwmUser unchecked(x.buff, index, swm::swm_unchecked);
+  EXPECT_EQ(index, x.index);
+  for (const auto &user : {checked, unchecked}) {
+    EXPECT_TRUE(user.get_id().empty());
+    EXPECT_TRUE(user.get_name().empty());
+    EXPECT_TRUE(user.get_comment().empty());
+    EXPECT_EQ(user.get_priority(), 5);
+  }
+
+  index = 0;
+  const swm::SwmUserView view(x.buff, index);
+  EXPECT_TRUE(view.get_name().empty());
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityValidate, long_string_error_offset) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 3), 0);  // a long string is a list
+  EXPECT_EQ(ei_x_encode_long(&x, 'a'), 0);
+  EXPECT_EQ(ei_x_encode_long(&x, 'b'), 0);
+  const int bad_offset = x.index;
+  EXPECT_EQ(ei_x_encode_longlong(&x, 1000), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+
+  int index = 0;
+  EXPECT_EQ(swm::SwmStrTerm::validate(x.buff, index), -1);
+  EXPECT_EQ(index, bad_offset);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityValidate, large_tuple) {
+  // {"a", "b"} in the large tuple form, that erlang uses for arities over 255
+  const char term[] = {
+    ERL_LARGE_TUPLE_EXT, 0, 0, 0, 2,
+    ERL_STRING_EXT, 0, 1, 'a',
+    ERL_STRING_EXT, 0, 1, 'b'
+  };
+  int index = 0;
+  EXPECT_EQ((swm::SwmTupleTerm<swm::SwmStrTerm, swm::SwmStrTerm>::validate(term, index)), -1);
+  EXPECT_EQ(index, 0);
+
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 2), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "a"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "b"), 0);
+  index = 0;
+  EXPECT_EQ((swm::SwmTupleTerm<swm::SwmStrTerm, swm::SwmStrTerm>::validate(x.buff, index)), 0);
+  EXPECT_EQ(index, x.index);
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EntityValidate, price_map_keys) {
+  // #{[$a, b] => 1}: the key is neither a string nor an atom
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_map_header(&x, 1), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 2), 0);
+  EXPECT_EQ(ei_x_encode_long(&x, 'a'), 0);
+  const int bad_offset = x.index;
+  EXPECT_EQ(ei_x_encode_atom(&x, "b"), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+  EXPECT_EQ(ei_x_encode_long(&x, 1), 0);
+
+  int index = 0;
+  EXPECT_EQ(swm::SwmPriceMapTerm::validate(x.buff, index), -1);
+  EXPECT_EQ(index, bad_offset);
+  EXPECT_EQ(ei_x_free(&x), 0);
+
+  // #{account => "1"}: the price is not a number
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_map_header(&x, 1), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "account"), 0);
+  const int bad_value = x.index;
+  EXPECT_EQ(ei_x_encode_string(&x, "1"), 0);
+  index = 0;
+  EXPECT_EQ(swm::SwmPriceMapTerm::validate(x.buff, index), -1);
+  EXPECT_EQ(index, bad_value);
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "gmock/gmock-matchers.h"
+
+#include "wm_job.h"
+#include "wm_node.h"
+#include "wm_resource.h"
+#include "wm_entity_view.h"
+
+#include <string>
+#include <vector>
+
+using ::testing::ElementsAre;
+
+TEST(NodeView, construct) {
+  static const int entity_tuple_arity = 20;
+
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, entity_tuple_arity), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "node"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "the id"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "the name"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "the host"), 0);
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 10001), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);  // parent
+  EXPECT_EQ(ei_x_encode_atom(&x, "up"), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "busy"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "\2\3\4"), 0);  // roles as erlang encodes [2,3,4]
+  EXPECT_EQ(ei_x_encode_list_header(&x, 2), 0);  // resources
+  {
+    for (const auto &name : {"mem", "cpus"}) {
+      EXPECT_EQ(ei_x_encode_tuple_header(&x, 8), 0);
+      EXPECT_EQ(ei_x_encode_atom(&x, "resource"), 0);
+      EXPECT_EQ(ei_x_encode_binary(&x, name, static_cast<int>(strlen(name))), 0);
+      EXPECT_EQ(ei_x_encode_ulonglong(&x, 64), 0);
+      EXPECT_EQ(ei_x_encode_empty_list(&x), 0);  // hooks
+      EXPECT_EQ(ei_x_encode_empty_list(&x), 0);  // properties
+      EXPECT_EQ(ei_x_encode_map_header(&x, 0), 0);   // prices
+      EXPECT_EQ(ei_x_encode_ulonglong(&x, 0), 0);     // usage time
+      EXPECT_EQ(ei_x_encode_empty_list(&x), 0);  // resources
+    }
+  }
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0); // properties
+  EXPECT_EQ(ei_x_encode_atom(&x, "partition"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "subdivision-id"), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);  // malfunctions
+  EXPECT_EQ(ei_x_encode_string(&x, "a comment"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "remote-id"), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "false"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "gateway"), 0);
+  EXPECT_EQ(ei_x_encode_map_header(&x, 1), 0);   // prices
+  {
+    EXPECT_EQ(ei_x_encode_string(&x, "account-1"), 0);
+    EXPECT_EQ(ei_x_encode_double(&x, 42.12), 0);
+  }
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 5), 0);
+  const int term_end = x.index;
+
+  int index = 0;
+  const auto view = swm::SwmNodeView(x.buff, index);
+  ASSERT_TRUE(view.is_valid());
+  EXPECT_EQ(index, term_end);
+
+  EXPECT_EQ(view.get_id(), "the id");
+  EXPECT_GE(view.get_id().data(), x.buff);  // points into the original buffer
+  EXPECT_LT(view.get_id().data(), x.buff + x.index);
+  EXPECT_EQ(view.get_name(), "the name");
+  EXPECT_EQ(view.get_api_port(), 10001ul);
+  EXPECT_TRUE(view.get_parent().empty());
+  EXPECT_EQ(view.get_state_power(), "up");
+  EXPECT_EQ(view.get_state_alloc(), "busy");
+
+  const auto roles = view.get_roles();
+  EXPECT_THAT(std::vector<uint64_t>(roles.begin(), roles.end()), ElementsAre(2, 3, 4));
+
+  const auto resources = view.get_resources();
+  EXPECT_EQ(resources.size(), 2);
+  std::vector<std::string_view> names;
+  for (const auto &resource : resources) {
+    names.push_back(resource.get_name());
+    EXPECT_EQ(resource.get_count(), 64ul);
+    EXPECT_TRUE(resource.get_resources().empty());
+  }
+  EXPECT_THAT(names, ElementsAre("mem", "cpus"));
+
+  EXPECT_TRUE(view.get_properties().empty());
+  EXPECT_TRUE(view.get_malfunctions().empty());
+  EXPECT_EQ(view.get_subdivision(), "partition");
+  EXPECT_EQ(view.get_is_template(), "false");
+  EXPECT_EQ(view.get_revision(), 5ul);
+
+  auto prices = view.get_prices();
+  int map_size = 0;
+  EXPECT_EQ(ei_decode_map_header(prices.buf, &prices.index, &map_size), 0);
+  EXPECT_EQ(map_size, 1);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(NodeView, broken_buffer) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 2), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "node"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "the id"), 0);
+
+  int index = 0;
+  const auto view = swm::SwmNodeView(x.buff, index);
+  EXPECT_FALSE(view.is_valid());
+  EXPECT_TRUE(view.get_id().empty());
+  EXPECT_TRUE(view.get_resources().empty());
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
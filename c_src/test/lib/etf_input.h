@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "wm_io.h"
+#include "wm_user.h"
+
+#include <zlib.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+// Returns the same binary as erlang term_to_binary(T, [compressed])
+static std::string compress_etf(const ei_x_buff &x) {
+  uLongf size = compressBound(static_cast<uLong>(x.index - 1));
+  std::string out(6 + size, '\0');
+  out[0] = static_cast<char>(ERLANG_BINARY_FORMAT_VERSION);
+  out[1] = static_cast<char>(ERLANG_COMPRESSED_TAG);
+  const auto term_size = static_cast<uint32_t>(x.index - 1);
+  for (int i = 0; i < 4; ++i) {
+    out[2 + i] = static_cast<char>((term_size >> (24 - 8 * i)) & 0xff);
+  }
+  EXPECT_EQ(compress(reinterpret_cast<Bytef*>(&out[6]), &size,
+                     reinterpret_cast<const Bytef*>(x.buff + 1), static_cast<uLong>(x.index - 1)), Z_OK);
+  out.resize(6 + size);
+  return out;
+}
+
+TEST(EtfInput, compressed) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new_with_version(&x), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 7), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "user"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "user-1"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, std::string(100000, 'n').c_str()), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, 0), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "a comment"), 0);
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 3), 0);
+  const std::string plain(x.buff, static_cast<size_t>(x.index));
+  const std::string compressed = compress_etf(x);
+  EXPECT_LT(compressed.size(), plain.size() / 10);
+
+  for (const auto &payload : {plain, compressed}) {
+    std::istringstream input(payload + "next");
+    uint32_t size = 0;
+    std::unique_ptr<char[]> buf(swm_read_etf(&input, static_cast<uint32_t>(payload.size()), &size));
+    ASSERT_TRUE(buf);
+    EXPECT_EQ(std::string(buf.get(), size), plain);
+
+    int index = 1;
+    const swm::SwmUser user(buf.get(), index);
+    EXPECT_EQ(user.get_name().size(), 100000ul);
+    EXPECT_EQ(user.get_revision(), 3ul);
+
+    std::string rest;
+    input >> rest;
+    EXPECT_EQ(rest, "next");
+  }
+
+  uint32_t size = 0;
+  std::istringstream truncated(compressed.substr(0, compressed.size() - 1));
+  EXPECT_EQ(swm_read_etf(&truncated, static_cast<uint32_t>(compressed.size()), &size), nullptr);
+
+  std::string corrupted = compressed;
+  corrupted[10] = static_cast<char>(~corrupted[10]);
+  std::istringstream corrupted_input(corrupted);
+  EXPECT_EQ(swm_read_etf(&corrupted_input, static_cast<uint32_t>(corrupted.size()), &size), nullptr);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include "wm_etf_reader.h"
+
+#include <string>
+
+TEST(EtfReader, strings) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+
+  const std::string long_str(70000, 'z');  // encoded as list of integers
+  EXPECT_EQ(ei_x_encode_string(&x, "short"), 0);
+  EXPECT_EQ(ei_x_encode_binary(&x, "binary", 6), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, ""), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, long_str.c_str()), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "an_atom"), 0);
+
+  int index = 0;
+  std::string s;
+  EXPECT_EQ(swm::etf_decode_str(x.buff, index, s), 0);
+  EXPECT_EQ(s, "short");
+  EXPECT_EQ(swm::etf_decode_str(x.buff, index, s), 0);
+  EXPECT_EQ(s, "binary");
+  EXPECT_EQ(swm::etf_decode_str(x.buff, index, s), 0);
+  EXPECT_TRUE(s.empty());
+  EXPECT_EQ(swm::etf_decode_str(x.buff, index, s), 0);
+  EXPECT_EQ(s, long_str);
+
+  const int atom_index = index;
+  EXPECT_EQ(swm::etf_decode_str(x.buff, index, s), -1);
+  EXPECT_EQ(index, atom_index);
+  EXPECT_EQ(swm::etf_decode_atom(x.buff, index, s), 0);
+  EXPECT_EQ(s, "an_atom");
+  EXPECT_EQ(index, x.index);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EtfReader, numbers) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 7), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, -70000), 0);
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 18446744073709551615ull), 0);
+  EXPECT_EQ(ei_x_encode_longlong(&x, -9000000000ll), 0);
+  EXPECT_EQ(ei_x_encode_double(&x, 42.125), 0);
+
+  int index = 0;
+  uint64_t u = 0;
+  int64_t i = 0;
+  double d = 0.0;
+  EXPECT_EQ(swm::etf_decode_uint64(x.buff, index, u), 0);
+  EXPECT_EQ(u, 7ul);
+  EXPECT_EQ(swm::etf_decode_uint64(x.buff, index, u), -1);  // negative
+  EXPECT_EQ(swm::etf_decode_int64(x.buff, index, i), 0);
+  EXPECT_EQ(i, -70000);
+  EXPECT_EQ(swm::etf_decode_int64(x.buff, index, i), -1);  // too big for int64_t
+  EXPECT_EQ(swm::etf_decode_uint64(x.buff, index, u), 0);
+  EXPECT_EQ(u, 18446744073709551615ull);
+  EXPECT_EQ(swm::etf_decode_int64(x.buff, index, i), 0);
+  EXPECT_EQ(i, -9000000000ll);
+  EXPECT_EQ(swm::etf_decode_double(x.buff, index, d), 0);
+  EXPECT_DOUBLE_EQ(d, 42.125);
+  EXPECT_EQ(index, x.index);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EtfReader, skip_term) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 3), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "t"), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 2), 0);
+  {
+    EXPECT_EQ(ei_x_encode_map_header(&x, 1), 0);
+    EXPECT_EQ(ei_x_encode_string(&x, "k"), 0);
+    EXPECT_EQ(ei_x_encode_double(&x, 1.5), 0);
+    EXPECT_EQ(ei_x_encode_longlong(&x, -9000000000ll), 0);
+  }
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+  EXPECT_EQ(ei_x_encode_binary(&x, "bin", 3), 0);
+
+  int index = 0;
+  EXPECT_EQ(swm::etf_skip_term(x.buff, index), 0);
+  EXPECT_EQ(index, x.index);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(EtfReader, small_int_lists) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+
+  EXPECT_EQ(ei_x_encode_list_header(&x, 45), 0);  // string "aa...a" of 45 characters as a list
+  for (int i = 0; i < 45; ++i) {
+    EXPECT_EQ(ei_x_encode_ulong(&x, 'a' + i % 26), 0);
+  }
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+  const int mixed_list = x.index;
+  EXPECT_EQ(ei_x_encode_list_header(&x, 100), 0);  // small integers interrupted by other terms
+  for (int i = 0; i < 100; ++i) {
+    if (i == 70) {
+      EXPECT_EQ(ei_x_encode_atom(&x, "x"), 0);
+    } else if (i == 90) {
+      EXPECT_EQ(ei_x_encode_ulong(&x, 100000), 0);
+    } else {
+      EXPECT_EQ(ei_x_encode_ulong(&x, static_cast<unsigned long>(i)), 0);
+    }
+  }
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+
+  int index = 0;
+  std::string s;
+  EXPECT_EQ(swm::etf_decode_str(x.buff, index, s), 0);
+  EXPECT_EQ(s.size(), 45ul);
+  EXPECT_EQ(s.substr(0, 3), "abc");
+  EXPECT_EQ(s[44], 'a' + 44 % 26);
+  EXPECT_EQ(index, mixed_list);
+
+  EXPECT_EQ(swm::etf_decode_str(x.buff, index, s), -1);
+  EXPECT_EQ(index, mixed_list);
+  EXPECT_EQ(swm::etf_scan_small_ints(x.buff + index + 5, 100), 70ul);
+
+  EXPECT_EQ(swm::etf_skip_term(x.buff, index), 0);
+  EXPECT_EQ(index, x.index);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include "wm_etf_reader.h"
+#include "wm_etf_stream.h"
+#include "wm_io.h"
+#include "wm_job.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::string encode_stream_jobs(const size_t count) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new_with_version(&x), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, static_cast<long>(count)), 0);
+  for (size_t i = 0; i < count; ++i) {
+    swm::SwmJob job;
+    job.set_id(swm::SwmId("job-" + std::to_string(i)));
+    job.set_script_content(std::pmr::string(i * 10, 's'));
+    job.set_priority(i);
+    EXPECT_EQ(job.encode(x), 0);
+  }
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+  const std::string data(x.buff, static_cast<size_t>(x.index));
+  EXPECT_EQ(ei_x_free(&x), 0);
+  return data;
+}
+
+// Feeds data by chunks, returns the decoded jobs
+static std::vector<swm::SwmJob> feed_stream_jobs(const std::string &data, const size_t chunk, size_t &max_buffered) {
+  swm::SwmEtfStream stream;
+  std::vector<swm::SwmJob> jobs;
+  max_buffered = 0;
+  for (size_t pos = 0; pos < data.size(); pos += chunk) {
+    const size_t size = std::min(chunk, data.size() - pos);
+    EXPECT_EQ(stream.feed(data.data() + pos, size, [&jobs](const char* buf, int index) {
+      jobs.emplace_back(buf, index);
+      return 0;
+    }), 0);
+    max_buffered = std::max(max_buffered, stream.buffered());
+  }
+  EXPECT_TRUE(stream.done());
+  EXPECT_EQ(stream.elements(), jobs.size());
+  return jobs;
+}
+
+TEST(EtfStream, chunks) {
+  const auto data = encode_stream_jobs(100);
+  for (const size_t chunk : {1ul, 7ul, 4096ul, data.size()}) {
+    size_t max_buffered = 0;
+    const auto jobs = feed_stream_jobs(data, chunk, max_buffered);
+    ASSERT_EQ(jobs.size(), 100ul);
+    EXPECT_EQ(jobs[0].get_id(), "job-0");
+    EXPECT_EQ(jobs[99].get_id(), "job-99");
+    EXPECT_EQ(jobs[99].get_script_content().size(), 990ul);
+    EXPECT_EQ(jobs[42].get_priority(), 42ul);
+    if (chunk < 4096) {
+      EXPECT_LT(max_buffered, 2000ul);  // about one job, not the whole list
+    }
+  }
+}
+
+TEST(EtfStream, compressed) {
+  const auto data = encode_stream_jobs(100);
+  const std::string term = data.substr(1);
+  uLongf size = compressBound(static_cast<uLong>(term.size()));
+  std::string compressed(6 + size, '\0');
+  ASSERT_EQ(compress(reinterpret_cast<Bytef*>(&compressed[6]), &size,
+                     reinterpret_cast<const Bytef*>(term.data()), static_cast<uLong>(term.size())), Z_OK);
+  compressed.resize(6 + size);
+  compressed[0] = static_cast<char>(ERLANG_BINARY_FORMAT_VERSION);
+  compressed[1] = static_cast<char>(ERLANG_COMPRESSED_TAG);
+  const auto term_size = static_cast<uint32_t>(term.size());
+  for (int i = 0; i < 4; ++i) {
+    compressed[static_cast<size_t>(2 + i)] = static_cast<char>((term_size >> (24 - 8 * i)) & 0xff);
+  }
+
+  size_t max_buffered = 0;
+  const auto jobs = feed_stream_jobs(compressed, 13, max_buffered);
+  ASSERT_EQ(jobs.size(), 100ul);
+  EXPECT_EQ(jobs[77].get_id(), "job-77");
+
+  // The whole binary in one chunk is inflated by elements, not at once
+  swm::SwmEtfStream whole;
+  size_t elements = 0;
+  max_buffered = 0;
+  EXPECT_EQ(whole.feed(compressed.data(), compressed.size(), [&](const char*, int) {
+    max_buffered = std::max(max_buffered, whole.buffered());
+    ++elements;
+    return 0;
+  }), 0);
+  EXPECT_TRUE(whole.done());
+  EXPECT_EQ(elements, 100ul);
+  EXPECT_GT(term.size(), 50000ul);
+  EXPECT_LT(max_buffered, 8192ul);
+
+  // The same binary read from a stream
+  std::istringstream input(compressed);
+  swm::SwmEtfStream stream;
+  size_t count = 0;
+  EXPECT_EQ(swm::swm_read_etf_stream(&input, compressed.size(), stream, [&count](const char*, int) {
+    ++count;
+    return 0;
+  }), 0);
+  EXPECT_EQ(count, 100ul);
+}
+
+TEST(EtfStream, single_term) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new_with_version(&x), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 2), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "ok"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "value"), 0);
+
+  swm::SwmEtfStream stream;
+  int elements = 0;
+  EXPECT_EQ(stream.feed(x.buff, static_cast<size_t>(x.index), [&elements](const char* buf, int index) {
+    int arity = 0;
+    EXPECT_EQ(swm::etf_decode_tuple_header(buf, index, arity), 0);
+    EXPECT_EQ(arity, 2);
+    ++elements;
+    return 0;
+  }), 0);
+  EXPECT_EQ(elements, 1);
+  EXPECT_TRUE(stream.done());
+
+  // Version other than 131
+  swm::SwmEtfStream wrong;
+  EXPECT_EQ(wrong.feed("\x82\x6a", 2, [](const char*, int) { return 0; }), -1);
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "wm_entity_utils.h"
+#include "wm_id.h"
+#include "wm_job.h"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+TEST(Id, uuid) {
+  const std::string text = "7873a946-d85d-11ec-8529-6fdf37248ceb";
+  const size_t interned = swm::swm_ids_count();
+  const swm::SwmId id(text);
+  EXPECT_EQ(sizeof(id), 16ul);
+  EXPECT_TRUE(id.is_uuid());
+  EXPECT_EQ(id.str(), text);
+  EXPECT_EQ(id, text);
+  EXPECT_EQ(id, swm::SwmId(text));
+  EXPECT_NE(id, swm::SwmId("7873a946-d85d-11ec-8529-6fdf37248cec"));
+  EXPECT_EQ(swm::swm_ids_count(), interned);  // UUIDs are not interned
+}
+
+TEST(Id, other_strings) {
+  // Uppercase digits and other variants would not be restored as they are
+  const std::vector<std::string> texts = {
+    "job-1", "7873A946-D85D-11EC-8529-6FDF37248CEB", "7873a946-d85d-11ec-c529-6fdf37248ceb",
+    "7873a946d85d11ec85296fdf37248ceb", "7873a946-d85d-11ec-8529-6fdf37248ce"
+  };
+  std::unordered_set<swm::SwmId> ids;
+  for (const auto &text : texts) {
+    const swm::SwmId id(text);
+    EXPECT_FALSE(id.is_uuid()) << text;
+    EXPECT_EQ(id.str(), text);
+    EXPECT_EQ(id, swm::SwmId(text));  // interned once
+    ids.insert(id);
+  }
+  EXPECT_EQ(ids.size(), texts.size());
+  EXPECT_TRUE(swm::SwmId().empty());
+  EXPECT_EQ(swm::SwmId().str(), "");
+  EXPECT_EQ(swm::SwmId(""), swm::SwmId());
+}
+
+TEST(Id, find) {
+  const size_t interned = swm::swm_ids_count();
+  swm::SwmId id;
+  EXPECT_FALSE(swm::SwmId::find("never-made-id", id));
+  EXPECT_TRUE(swm::SwmId::find("7873a946-d85d-11ec-8529-6fdf37248ceb", id));
+  EXPECT_EQ(swm::swm_ids_count(), interned);
+
+  const swm::SwmId made("made-id");
+  EXPECT_TRUE(swm::SwmId::find("made-id", id));
+  EXPECT_EQ(id, made);
+}
+
+TEST(Id, etf) {
+  for (const auto text : {"7873a946-d85d-11ec-8529-6fdf37248ceb", "node-1", ""}) {
+    ei_x_buff x;
+    EXPECT_EQ(ei_x_new(&x), 0);
+    EXPECT_EQ(ei_x_encode_string(&x, text), 0);
+
+    int size = 0;
+    swm::encode_id(nullptr, size, swm::SwmId(text));
+    EXPECT_EQ(size, x.index) << text;  // the same term as the string
+    std::vector<char> buf(static_cast<size_t>(size));
+    int index = 0;
+    swm::encode_id(buf.data(), index, swm::SwmId(text));
+    EXPECT_EQ(std::string(buf.data(), buf.size()), std::string(x.buff, static_cast<size_t>(x.index)));
+
+    index = 0;
+    swm::SwmId id;
+    EXPECT_EQ(swm::ei_buffer_to_id(x.buff, index, id), 0);
+    EXPECT_EQ(id, text);
+    EXPECT_EQ(index, x.index);
+    ei_x_free(&x);
+  }
+
+  swm::SwmJob job;
+  job.set_id(swm::SwmId("7873a946-d85d-11ec-8529-6fdf37248ceb"));
+  job.set_cluster_id("cluster-1");
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(job.encode(x), 0);
+  int index = 0;
+  const swm::SwmJob decoded(x.buff, index);
+  EXPECT_EQ(decoded.get_id(), job.get_id());
+  EXPECT_EQ(decoded.get_cluster_id(), "cluster-1");
+  ei_x_free(&x);
+}
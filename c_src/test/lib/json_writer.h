@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include "wm_entity_fields.h"
+#include "wm_entity_terms.h"
+#include "wm_job.h"
+#include "wm_json_writer.h"
+
+#include <string>
+
+TEST(JsonWriter, escaping) {
+  // Long enough for the vector loops, special bytes at different offsets
+  const std::string plain(40, 'a');
+  EXPECT_EQ(swm::json_scan_plain(plain.data(), plain.size()), 40ul);
+  for (const size_t pos : {0ul, 15ul, 16ul, 31ul, 33ul, 39ul}) {
+    for (const char c : {'"', '\\', '\n', '\x01', '\x1f'}) {
+      std::string s = plain;
+      s[pos] = c;
+      EXPECT_EQ(swm::json_scan_plain(s.data(), s.size()), pos);
+    }
+  }
+  const std::string utf8 = "\xd0\xb6\xd0\xbe\xd0\xb1 \x7f";  // not escaped
+  EXPECT_EQ(swm::json_scan_plain(utf8.data(), utf8.size()), utf8.size());
+
+  swm::SwmJsonWriter writer(64);
+  writer.begin_object();
+  writer.key("s");
+  writer.value_str("a\"b\\c\nd\x01");
+  writer.key("l");
+  writer.begin_array();
+  writer.value_atom("true");
+  writer.value_atom("undefined");
+  writer.value_atom("cpus");
+  writer.value_int64(-3);
+  writer.value_double(0.5);
+  writer.end_array();
+  writer.end_object();
+  EXPECT_EQ(writer.str(), R"({"s":"a\"b\\c\nd\u0001","l":[true,null,"cpus",-3,0.5]})");
+}
+
+TEST(JsonWriter, entity) {
+  swm::SwmJob job;
+  job.set_id(swm::SwmId("job\"1"));
+  job.set_priority(7);
+  job.set_relocatable(swm::SwmAtom("false"));
+  job.set_nodes({"node1", "node2"});
+  job.set_env({{"HOME", "/home/user"}});
+  swm::SwmResource resource;
+  resource.set_name("cpus");
+  resource.set_count(2);
+  job.set_request({resource});
+
+  swm::SwmJsonWriter writer;
+  job.to_json(writer);
+  const auto &json = writer.str();
+  EXPECT_EQ(json.front(), '{');
+  EXPECT_EQ(json.back(), '}');
+  EXPECT_NE(json.find(R"("id":"job\"1")"), std::string::npos);
+  EXPECT_NE(json.find(R"("priority":7)"), std::string::npos);
+  EXPECT_NE(json.find(R"("relocatable":false)"), std::string::npos);
+  EXPECT_NE(json.find(R"("nodes":["node1","node2"])"), std::string::npos);
+  EXPECT_NE(json.find(R"("env":[["HOME","/home/user"]])"), std::string::npos);
+  EXPECT_NE(json.find(R"("request":[{"name":"cpus","count":2,)"), std::string::npos);
+
+  // The term is transcoded to the same JSON without decoding
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, 2), 0);
+  EXPECT_EQ(job.encode(x), 0);
+  EXPECT_EQ(job.encode(x), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+  int index = 0;
+  swm::SwmJsonWriter transcoded;
+  EXPECT_EQ(swm::entity_list_etf_to_json<swm::SwmJob>(x.buff, index, transcoded), 0);
+  EXPECT_EQ(index, x.index);
+  EXPECT_EQ(transcoded.str(), "[" + json + "," + json + "]");
+
+  // Not a job
+  index = 0;
+  EXPECT_EQ(swm::SwmJob::to_json(x.buff, index, transcoded), -1);
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
+
+TEST(JsonWriter, map_values) {
+  // #{"host" => "node1", "port" => 8080, "weight" => 0.5, "proto" => tcp}
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_map_header(&x, 4), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "host"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "node1"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "port"), 0);
+  EXPECT_EQ(ei_x_encode_long(&x, 8080), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "weight"), 0);
+  EXPECT_EQ(ei_x_encode_double(&x, 0.5), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "proto"), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "tcp"), 0);
+
+  int index = 0;
+  EXPECT_EQ(swm::SwmMapTerm::validate(x.buff, index), 0);
+  index = 0;
+  swm::SwmMapStrStr map;
+  EXPECT_EQ(swm::ei_buffer_to_map(x.buff, index, map), 0);
+  swm::SwmJsonWriter decoded;
+  swm::write_json(decoded, map);
+
+  // The term is transcoded to the same JSON as the decoded map
+  index = 0;
+  swm::SwmJsonWriter transcoded;
+  EXPECT_EQ(swm::SwmMapTerm::json(x.buff, index, transcoded), 0);
+  EXPECT_EQ(index, x.index);
+  EXPECT_EQ(transcoded.str(), decoded.str());
+  EXPECT_NE(transcoded.str().find(R"("port":"8080")"), std::string::npos);
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
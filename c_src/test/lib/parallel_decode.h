@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "wm_process.h"
+#include "wm_thread_pool.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+TEST(ThreadPool, parallel_for) {
+  swm::SwmThreadPool pool(4);
+  EXPECT_EQ(pool.size(), 4ul);
+
+  for (const size_t count : {0ul, 1ul, 63ul, 1000ul, 1001ul}) {
+    std::vector<int> visits(count, 0);
+    std::atomic<size_t> calls(0);
+    pool.parallel_for(count, [&](const size_t begin, const size_t end) {
+      ++calls;
+      for (size_t i = begin; i < end; ++i) {
+        ++visits[i];
+      }
+    }, 10);
+    for (const auto n : visits) {
+      EXPECT_EQ(n, 1);
+    }
+    EXPECT_LE(calls.load(), pool.size() * 4);
+  }
+}
+
+TEST(ThreadPool, decode_list) {
+  static const int processes_count = 1000;
+
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  EXPECT_EQ(ei_x_encode_list_header(&x, processes_count), 0);
+  for (int i = 0; i < processes_count; ++i) {
+    EXPECT_EQ(ei_x_encode_tuple_header(&x, 6), 0);
+    EXPECT_EQ(ei_x_encode_atom(&x, "process"), 0);
+    EXPECT_EQ(ei_x_encode_longlong(&x, i), 0);
+    EXPECT_EQ(ei_x_encode_string(&x, "R"), 0);
+    EXPECT_EQ(ei_x_encode_longlong(&x, 0), 0);
+    EXPECT_EQ(ei_x_encode_longlong(&x, 0), 0);
+    EXPECT_EQ(ei_x_encode_string(&x, ("process number " + std::to_string(i)).c_str()), 0);
+  }
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "next"), 0);
+
+  swm::SwmThreadPool pool(4);
+  int index = 0;
+  std::vector<swm::SwmProcess> parallel;
+  EXPECT_EQ(swm::ei_buffer_to_process(x.buff, index, parallel, pool), 0);
+  const int parallel_end = index;
+
+  index = 0;
+  std::vector<swm::SwmProcess> sequential;
+  EXPECT_EQ(swm::ei_buffer_to_process(x.buff, index, sequential), 0);
+  EXPECT_EQ(parallel_end, index);
+
+  ASSERT_EQ(parallel.size(), sequential.size());
+  for (size_t i = 0; i < parallel.size(); ++i) {
+    EXPECT_EQ(parallel[i].get_pid(), static_cast<int64_t>(i));
+    EXPECT_EQ(parallel[i].get_comment(), sequential[i].get_comment());
+  }
+
+  index = 1;  // not a list
+  std::vector<swm::SwmProcess> broken;
+  EXPECT_EQ(swm::ei_buffer_to_process(x.buff, index, broken, pool), -1);
+
+  EXPECT_EQ(ei_x_free(&x), 0);
+}
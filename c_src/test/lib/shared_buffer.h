@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include "wm_node.h"
+#include "wm_shared_buffer.h"
+
+#include <cstring>
+#include <string>
+
+static swm::SwmSharedBuffer share_buffer(const ei_x_buff &x) {
+  std::shared_ptr<char[]> buffer(new char[static_cast<size_t>(x.index)]);
+  std::memcpy(buffer.get(), x.buff, static_cast<size_t>(x.index));
+  return buffer;
+}
+
+static void encode_properties(ei_x_buff &x) {
+  EXPECT_EQ(ei_x_encode_list_header(&x, 3), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 2), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "flavor"), 0);
+  EXPECT_EQ(ei_x_encode_string(&x, "m1.tiny"), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 2), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "cores"), 0);
+  EXPECT_EQ(ei_x_encode_ulonglong(&x, 1ull << 40), 0);
+  EXPECT_EQ(ei_x_encode_tuple_header(&x, 2), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "state"), 0);
+  EXPECT_EQ(ei_x_encode_atom(&x, "up"), 0);
+  EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+}
+
+TEST(SharedBuffer, scoped_properties) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  encode_properties(x);
+  const auto buffer = share_buffer(x);
+  const int size = x.index;
+  EXPECT_EQ(ei_x_free(&x), 0);
+
+  std::vector<swm::SwmTupleAtomBuff> properties;
+  {
+    const swm::SwmSharedBufferScope scope(buffer, static_cast<size_t>(size));
+    EXPECT_EQ(*swm::SwmSharedBufferScope::find(buffer.get()), buffer);
+    int index = 0;
+    EXPECT_EQ(swm::ei_buffer_to_tuple_atom_buff(buffer.get(), index, properties), 0);
+    EXPECT_EQ(index, size);
+  }
+  EXPECT_EQ(swm::SwmSharedBufferScope::current(), nullptr);
+  EXPECT_EQ(buffer.use_count(), 4);  // the properties keep the buffer
+
+  ASSERT_EQ(properties.size(), 3ul);
+  const auto &flavor = properties[0].second;
+  EXPECT_GE(flavor.data(), buffer.get());
+  EXPECT_LT(flavor.data(), buffer.get() + size);
+
+  std::string s;
+  EXPECT_EQ(flavor.get_str(s), 0);
+  EXPECT_EQ(s, "m1.tiny");
+  uint64_t n = 0;
+  EXPECT_EQ(flavor.get_uint64(n), -1);
+  EXPECT_EQ(properties[1].second.get_uint64(n), 0);
+  EXPECT_EQ(n, 1ull << 40);
+  swm::SwmAtom a;
+  EXPECT_EQ(properties[2].second.get_atom(a), 0);
+  EXPECT_EQ(a, swm::SwmAtom("up"));
+
+  // The same terms are encoded back
+  std::vector<char> encoded(static_cast<size_t>(size));
+  int index = 0;
+  swm::encode_tuple_atom_buff(encoded.data(), index, std::pmr::vector<swm::SwmTupleAtomBuff>(properties.begin(), properties.end()));
+  EXPECT_EQ(index, size);
+  EXPECT_EQ(std::memcmp(encoded.data(), buffer.get(), static_cast<size_t>(size)), 0);
+}
+
+TEST(SharedBuffer, unscoped_copies) {
+  ei_x_buff x;
+  EXPECT_EQ(ei_x_new(&x), 0);
+  encode_properties(x);
+
+  int index = 0;
+  std::vector<swm::SwmTupleAtomBuff> properties;
+  EXPECT_EQ(swm::ei_buffer_to_tuple_atom_buff(x.buff, index, properties), 0);
+  ASSERT_EQ(properties.size(), 3ul);
+  EXPECT_FALSE(properties[0].second.data() >= x.buff && properties[0].second.data() < x.buff + x.index);
+  EXPECT_EQ(ei_x_free(&x), 0);
+
+  std::string s;
+  EXPECT_EQ(properties[0].second.get_str(s), 0);  // the copy outlives the input
+  EXPECT_EQ(s, "m1.tiny");
+  const auto copy = properties[0].second;
+  EXPECT_EQ(copy, properties[0].second);
+  EXPECT_FALSE(copy == properties[1].second);
+  EXPECT_TRUE(swm::SwmTermRef().empty());
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include "wm_grid.h"
+#include "wm_job.h"
+#include "wm_node.h"
+#include "wm_snapshot_file.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Appends a data type of the scheduler input: type, 4 bytes length, ETF
+static void add_scheduler_input(std::string &input, const uint32_t type, const ei_x_buff &x) {
+  const auto len = static_cast<uint32_t>(x.index);
+  input.push_back(static_cast<char>(type));
+  for (int i = 0; i < 4; ++i) {
+    input.push_back(static_cast<char>((len >> (24 - 8 * i)) & 0xff));
+  }
+  input.append(x.buff, static_cast<size_t>(x.index));
+}
+
+static std::string make_scheduler_input(const size_t jobs_count) {
+  std::string input = {0, static_cast<char>(swm::SWM_SNAPSHOT_SECTIONS)};
+  for (uint32_t type = 0; type < swm::SWM_SNAPSHOT_SECTIONS; ++type) {
+    ei_x_buff x;
+    EXPECT_EQ(ei_x_new_with_version(&x), 0);
+    if (type == swm::SWM_SNAPSHOT_JOBS) {
+      EXPECT_EQ(ei_x_encode_list_header(&x, static_cast<long>(jobs_count)), 0);
+      for (size_t i = 0; i < jobs_count; ++i) {
+        swm::SwmJob job;
+        job.set_id(swm::SwmId("job-" + std::to_string(i)));
+        job.set_priority(i);
+        EXPECT_EQ(job.encode(x), 0);
+      }
+      EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+    } else if (type == swm::SWM_SNAPSHOT_GRID) {
+      swm::SwmGrid grid;  // not a list
+      grid.set_id(swm::SwmId("grid_id"));
+      EXPECT_EQ(grid.encode(x), 0);
+    } else if (type == swm::SWM_SNAPSHOT_NODES) {
+      swm::SwmNode node;
+      node.set_id(swm::SwmId("node-1"));
+      ei_x_buff flavor;
+      EXPECT_EQ(ei_x_new(&flavor), 0);
+      EXPECT_EQ(ei_x_encode_string(&flavor, "m1.tiny"), 0);
+      int index = 0;
+      swm::SwmTermRef term;
+      EXPECT_EQ(term.assign(flavor.buff, index), 0);
+      EXPECT_EQ(ei_x_free(&flavor), 0);
+      node.emplace_properties("flavor", term);
+      EXPECT_EQ(ei_x_encode_list_header(&x, 1), 0);
+      EXPECT_EQ(node.encode(x), 0);
+      EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+    } else {
+      EXPECT_EQ(ei_x_encode_empty_list(&x), 0);
+    }
+    add_scheduler_input(input, type, x);
+    EXPECT_EQ(ei_x_free(&x), 0);
+  }
+  return input;
+}
+
+TEST(SnapshotFile, write_and_map) {
+  const std::string path = testing::TempDir() + "swm_snapshot_test.bin";
+  std::istringstream input(make_scheduler_input(1000));
+  swm::SwmSnapshotWriter writer(path);
+  ASSERT_EQ(swm::swm_write_snapshot(&input, writer), 0);
+
+  swm::SwmSnapshotFile file;
+  ASSERT_EQ(file.open(path), 0);
+  EXPECT_EQ(file.count(swm::SWM_SNAPSHOT_SCHEDULERS), 0ul);
+  EXPECT_EQ(file.count(swm::SWM_SNAPSHOT_JOBS), 1000ul);
+  EXPECT_EQ(file.count(swm::SWM_SNAPSHOT_GRID), 1ul);
+  EXPECT_EQ(file.count(swm::SWM_SNAPSHOT_NODES), 1ul);
+
+  const auto view = file.view<swm::SwmJobView>(swm::SWM_SNAPSHOT_JOBS, 777);
+  EXPECT_EQ(view.get_id(), "job-777");
+  EXPECT_EQ(view.get_priority(), 777ul);
+  EXPECT_EQ(file.view<swm::SwmGridView>(swm::SWM_SNAPSHOT_GRID, 0).get_id(), "grid_id");
+  int index = file.index(swm::SWM_SNAPSHOT_NODES, 0);
+  const swm::SwmNode node(file.terms(swm::SWM_SNAPSHOT_NODES), index);
+  EXPECT_EQ(node.get_id(), "node-1");
+
+  // Decoded properties refer to the mapping and keep it after close()
+  const auto decoded = file.decode<swm::SwmNode>(swm::SWM_SNAPSHOT_NODES, 0);
+  ASSERT_EQ(decoded.get_properties().size(), 1ul);
+  const auto &flavor = decoded.get_properties()[0].second;
+  const char* terms = file.terms(swm::SWM_SNAPSHOT_NODES);
+  EXPECT_GE(flavor.data(), terms);
+  EXPECT_LT(flavor.data(), terms + file.index(swm::SWM_SNAPSHOT_NODES, 1));
+  file.close();
+  std::string s;
+  EXPECT_EQ(flavor.get_str(s), 0);
+  EXPECT_EQ(s, "m1.tiny");
+
+  // Truncated file is not mapped
+  std::string data;
+  {
+    std::ifstream in(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size() - 8));
+  }
+  EXPECT_EQ(file.open(path), -1);
+  EXPECT_FALSE(file.is_open());
+  std::remove(path.c_str());
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include "wm_state_store.h"
+
+#include <set>
+#include <string>
+
+static swm::SwmJob make_store_job(const std::string &id, const char* state, const char* user_id, const uint64_t revision) {
+  swm::SwmJob job;
+  job.set_id(swm::SwmId(id));
+  job.set_state(state);
+  job.set_user_id(user_id);
+  job.set_revision(revision);
+  return job;
+}
+
+template <typename Store>
+static std::set<std::string> store_matches(const Store &store, const size_t index, const std::string &key) {
+  std::set<std::string> ids;
+  store.for_each(index, key, [&ids](const auto &entity) { ids.emplace(entity.get_id().str()); });
+  EXPECT_EQ(ids.size(), store.count(index, key));
+  return ids;
+}
+
+TEST(StateStore, hash_index) {
+  swm::SwmHashIndex<std::string, int> index;
+  for (int i = 0; i < 1000; ++i) {
+    index.insert("key-" + std::to_string(i)) = i;
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    EXPECT_TRUE(index.erase("key-" + std::to_string(i)));
+  }
+  EXPECT_FALSE(index.erase("key-0"));
+  EXPECT_EQ(index.size(), 500ul);
+  EXPECT_EQ(index.find("key-2"), nullptr);
+  ASSERT_NE(index.find("key-999"), nullptr);
+  EXPECT_EQ(*index.find("key-999"), 999);
+  index.insert("key-2") = -2;  // takes a deleted entry
+  EXPECT_EQ(*index.find("key-2"), -2);
+  EXPECT_EQ(index.erase_if([](const std::string&, int &value) { return value++ < 500; }), 251ul);
+  EXPECT_EQ(index.size(), 250ul);
+  EXPECT_EQ(index.find("key-2"), nullptr);
+  EXPECT_EQ(*index.find("key-999"), 1000);
+}
+
+TEST(StateStore, job_indexes) {
+  using swm::SwmStateStore;
+  SwmStateStore store;
+  auto &jobs = store.jobs();
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(jobs.update(make_store_job("job-" + std::to_string(i), i % 4 ? "Q" : "R", i % 2 ? "u1" : "u2", 1)));
+  }
+  EXPECT_EQ(jobs.size(), 100ul);
+  EXPECT_EQ(jobs.count(SwmStateStore::JOB_STATE, "R"), 25ul);
+  EXPECT_EQ(jobs.count(SwmStateStore::JOB_STATE, "Q"), 75ul);
+  EXPECT_EQ(jobs.count(SwmStateStore::JOB_USER_ID, "u1"), 50ul);
+  ASSERT_NE(jobs.find("job-5"), nullptr);
+  EXPECT_EQ(jobs.find("job-5")->get_state(), "Q");
+
+  // Only newer revisions are applied
+  EXPECT_FALSE(jobs.update(make_store_job("job-5", "R", "u1", 1)));
+  EXPECT_TRUE(jobs.update(make_store_job("job-5", "R", "u1", 2)));
+  EXPECT_EQ(jobs.find("job-5")->get_state(), "R");
+  EXPECT_EQ(jobs.count(SwmStateStore::JOB_STATE, "R"), 26ul);
+  EXPECT_EQ(jobs.count(SwmStateStore::JOB_USER_ID, "u1"), 50ul);
+  EXPECT_EQ(store_matches(jobs, SwmStateStore::JOB_STATE, "R").count("job-5"), 1ul);
+
+  EXPECT_TRUE(jobs.erase("job-0"));
+  EXPECT_FALSE(jobs.erase("job-0"));
+  EXPECT_EQ(jobs.find("job-0"), nullptr);
+  EXPECT_EQ(jobs.count(SwmStateStore::JOB_STATE, "R"), 25ul);
+  EXPECT_EQ(store_matches(jobs, SwmStateStore::JOB_STATE, "R").count("job-0"), 0ul);
+
+  // The freed slot is reused
+  EXPECT_TRUE(jobs.update(make_store_job("job-new", "F", "u3", 1)));
+  EXPECT_EQ(store_matches(jobs, SwmStateStore::JOB_STATE, "F"), std::set<std::string>{"job-new"});
+  EXPECT_EQ(jobs.size(), 100ul);
+  EXPECT_EQ(jobs.count(SwmStateStore::JOB_GANG_ID, ""), 100ul);
+}
+
+TEST(StateStore, nodes_by_partition) {
+  using swm::SwmStateStore;
+  SwmStateStore store;
+  for (int i = 0; i < 10; ++i) {
+    swm::SwmNode node;
+    node.set_id(swm::SwmId("node-" + std::to_string(i)));
+    node.set_subdivision_id(i < 3 ? "p1" : "p2");
+    EXPECT_TRUE(store.nodes().update(std::move(node)));
+  }
+  EXPECT_EQ(store_matches(store.nodes(), SwmStateStore::NODE_SUBDIVISION_ID, "p1"),
+            (std::set<std::string>{"node-0", "node-1", "node-2"}));
+  EXPECT_EQ(store.nodes().count(SwmStateStore::NODE_SUBDIVISION_ID, "p3"), 0ul);
+}
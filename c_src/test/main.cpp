@@ -1,7 +1,26 @@
 
 #include <gtest/gtest.h>
 
+#include "lib/atoms.h"
+#include "lib/cluster_snapshot.h"
+#include "lib/decode_cache.h"
 #include "lib/entities.h"
+#include "lib/entity_arena.h"
+#include "lib/entity_encode.h"
+#include "lib/entity_graph.h"
+#include "lib/entity_patch.h"
+#include "lib/entity_table.h"
+#include "lib/entity_validate.h"
+#include "lib/entity_views.h"
+#include "lib/etf_input.h"
+#include "lib/etf_reader.h"
+#include "lib/etf_stream.h"
+#include "lib/id.h"
+#include "lib/json_writer.h"
+#include "lib/parallel_decode.h"
+#include "lib/shared_buffer.h"
+#include "lib/snapshot_file.h"
+#include "lib/state_store.h"
 
 int main(int argc, char *argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -35,6 +35,10 @@ def main():
       run("%s -o %s %s" % (cmd, h_out_file, h_cog_file))
       run("%s -o %s %s" % (cmd, c_out_file, c_cog_file))
 
+    atoms_cog_file = os.path.join(lib_path, "wm_atom_ids.h.cog")
+    atoms_out_file = os.path.join(lib_path, "wm_atom_ids.h")
+    run("cog.py -U -z -d -e -c -o %s %s" % (atoms_out_file, atoms_cog_file))
+
 
 if __name__ == "__main__":
   main()
@@ -9,39 +9,43 @@ exclude = {"malfunction",
 }
 
 types_map = {
-     "atom()": "std::string",
+     "atom()": "SwmAtom",
      "any()": "char*",
-     "map()": "std::map<std::string, std::string>",
-     "string()": "std::string",
+     "map()": "SwmMapStrStr",
+     "price_map()": "SwmPriceMap",
+     "string()": "std::pmr::string",
      "binary()": "char*",
      "integer()": "int64_t",
      "pos_integer()": "uint64_t",
      "float()": "double",
+     "entity_id()": "SwmId",
 
      ## USER DEFINED TYPES
-     "remote_id()": "std::string",
-     "account_id()": "std::string",
-     "session_id()": "std::string",
-     "user_id()": "std::string",
-     "grid_id()": "std::string",
-     "cluster_id()": "std::string",
-     "partition_id()": "std::string",
-     "node_id()": "std::string",
-     "job_id()": "std::string",
-     "image_id()": "std::string",
+     "remote_id()": "std::pmr::string",
+     "account_id()": "std::pmr::string",
+     "session_id()": "std::pmr::string",
+     "user_id()": "std::pmr::string",
+     "grid_id()": "std::pmr::string",
+     "cluster_id()": "std::pmr::string",
+     "partition_id()": "std::pmr::string",
+     "node_id()": "std::pmr::string",
+     "job_id()": "std::pmr::string",
+     "image_id()": "std::pmr::string",
      "relocation_id()": "std::uint64_t",
-     "hook_id()": "std::string"
+     "hook_id()": "std::pmr::string"
 }
 
 type_suffix_map = {
      "atom()": "atom",
      "any()": "buff",
      "map()": "map",
+     "price_map()": "price_map",
      "string()": "str",
      "binary()": "buff",
      "integer()": "int64_t",
      "pos_integer()": "uint64_t",
      "float()": "double",
+     "entity_id()": "id",
 
      ## USER DEFINED TYPES SUFFIX
      "remote_id()": "str",
@@ -62,11 +66,13 @@ printer = {
      "atom()": "%s",
      "any()": "buff",
      "map()": "buff",
+     "price_map()": "buff",
      "binary()": "buff",
      "string()": "%s",
      "integer()": "%ld",
      "pos_integer()": "%ld",
      "float()": "%f",
+     "entity_id()": "%s",
 
      ## USER DEFINED PRINTERS
      "remote_id()": "%s",
@@ -84,6 +90,40 @@ printer = {
 }
 
 
+# Fields that are declared in the schema with a generic type, but are decoded
+# into a typed C++ container. The schema itself is shared with the erlang
+# code generator, so the C++ specific types are set here by field name.
+typed_fields = {
+     "prices": "price_map()"
+}
+
+# Own ids of entities (not references to other entities) that are strings
+# in the schema are kept as compact SwmId values.
+id_field = "id"
+
+
+def apply_typed_fields(data):
+    ''' Replaces schema types of fields listed in typed_fields and of string ids.
+    '''
+    for fields in data.values():
+        for name, meta in fields.items():
+            if not isinstance(meta, dict):
+                continue
+            if name in typed_fields:
+                meta["type"] = typed_fields[name]
+            elif name == id_field and types_map.get(meta["type"]) == "std::pmr::string":
+                meta["type"] = "entity_id()"
+    return data
+
+
+def is_allocator_aware(cpp_type):
+    ''' True for C++ field types that take an allocator (std::pmr containers and entities).
+    '''
+    if cpp_type in ["SwmAtom", "SwmId"]:
+        return False
+    return cpp_type.startswith("std::pmr::") or cpp_type.startswith("Swm")
+
+
 def struct_param_type(r):
     is_tuple = False
     if '#' in r:
@@ -116,3 +156,114 @@ def c_struct(pp):
         if len(p)>1:
             s += p.title()
     return s
+
+
+view_suffix_map = {
+     "str": "std::string_view",
+     "id": "std::string_view",
+     "atom": "std::string_view",
+     "uint64_t": "uint64_t",
+     "int64_t": "int64_t",
+     "double": "double",
+     "map": "SwmTermView",
+     "price_map": "SwmTermView",
+     "buff": "SwmTermView"
+}
+
+# Views keep typed maps as raw terms
+view_decoder_map = {
+     "price_map": "map",
+     "id": "str"
+}
+
+
+def view_type(schema_type):
+    ''' Returns (C++ view type, decoder function) for a schema type.
+    '''
+    if schema_type in type_suffix_map.keys():
+        suffix = type_suffix_map[schema_type]
+        return (view_suffix_map[suffix], "ei_buffer_to_" + view_decoder_map.get(suffix, suffix))
+    if '[' in schema_type:
+        item = schema_type[schema_type.find('[') + 1 : schema_type.rfind(']')]
+        (item_type, item_decoder) = view_type(item)
+        return ("SwmListView<%s, %s>" % (item_type, item_decoder), None)
+    if schema_type.startswith('#'):
+        (camel, plain, _) = struct_param_type(schema_type)
+        return (camel + "View", "ei_buffer_to_" + plain)
+    if '{' in schema_type:
+        pp = schema_type[schema_type.find('{') + 1 : schema_type.find('}')].split(',')
+        return (c_struct(pp) + "View", "ei_buffer_to_tuple" + get_tuple_type(pp))
+    raise Exception("Unknown schema type: %s" % schema_type)
+
+
+# Schema types of field values for validation of trusted input (wm_entity_terms.h)
+term_suffix_map = {
+     "str": "SwmStrTerm",
+     "id": "SwmIdTerm",
+     "atom": "SwmAtomTerm",
+     "uint64_t": "SwmUint64Term",
+     "int64_t": "SwmInt64Term",
+     "double": "SwmDoubleTerm",
+     "map": "SwmMapTerm",
+     "price_map": "SwmPriceMapTerm",
+     "buff": "SwmAnyTerm"
+}
+
+
+def term_type(schema_type):
+    ''' Returns the C++ term type that validates and decodes a schema type.
+    '''
+    if schema_type in type_suffix_map.keys():
+        return term_suffix_map[type_suffix_map[schema_type]]
+    if '[' in schema_type:
+        item = schema_type[schema_type.find('[') + 1 : schema_type.rfind(']')]
+        return "SwmListTerm<%s>" % term_type(item)
+    if schema_type.startswith('#'):
+        (camel, _, _) = struct_param_type(schema_type)
+        return "SwmEntityTerm<%s>" % camel
+    if '{' in schema_type:
+        pp = schema_type[schema_type.find('{') + 1 : schema_type.find('}')].split(',')
+        return "SwmTupleTerm<%s>" % ", ".join(term_type(p.strip()) for p in pp)
+    raise Exception("Unknown schema type: %s" % schema_type)
+
+
+# Atom values used by the core for state-like fields, they get fixed ids
+# in addition to the atom() defaults from the schema.
+known_atoms = [
+     "up",
+     "down",
+     "idle",
+     "busy",
+     "stopped",
+     "offline",
+     "creating",
+     "forwarded",
+     "enabled",
+     "disabled",
+     "true",
+     "false",
+     "grid",
+     "cluster",
+     "partition",
+     "local",
+     "cloud",
+     "container"
+]
+
+
+def get_known_atoms(data):
+    ''' Returns ordered list of atoms that get fixed ids in wm_atom_ids.h.
+    '''
+    atoms = []
+    for value in known_atoms:
+        if value not in atoms:
+            atoms.append(value)
+    for entity, fields in data.items():
+        if entity in exclude:
+            continue
+        for meta in fields.values():
+            value = meta.get("default")
+            if meta["type"] == "atom()" and isinstance(value, str) and value and value not in atoms:
+                atoms.append(value)
+    return atoms
+